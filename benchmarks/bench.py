@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Runs the benchmark suite through tpp-run and compares against a baseline.
+
+Each benchmark declared in the suite configuration (benchmarks.json) is run
+'repetitions' times, each run timing 'iterations' calls to the kernel after
+tpp-run's warm-up call. The mean time of each run is a sample: the samples are
+written to a JSON file and, if a baseline (a previous output of this script)
+is given, compared against it with Welch's t-test.
+
+A benchmark regresses when it's slower than the baseline by more than the
+'threshold' ratio and the slowdown is statistically significant at the
+'confidence' level. Any regression makes the script return non-zero.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import statistics
+import subprocess
+import sys
+
+# tpp-run prints the timer stats as a vector: ( mean, deviation )
+STATS_RE = re.compile(r"^\(\s*([-+.\deE]+),\s*([-+.\deE]+)\s*\)\s*$")
+
+
+def incomplete_beta(a, b, x):
+    """Regularized incomplete beta function, by continued fractions."""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    # Converges quickly for x < (a + 1) / (a + b + 2), use symmetry otherwise
+    if x > (a + 1.0) / (a + b + 2.0):
+        return 1.0 - incomplete_beta(b, a, 1.0 - x)
+    front = math.exp(
+        math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+        + a * math.log(x) + b * math.log(1.0 - x)) / a
+    tiny = 1e-30
+    f, c, d = 1.0, 1.0, 0.0
+    for i in range(200):
+        m = i // 2
+        if i == 0:
+            num = 1.0
+        elif i % 2 == 0:
+            num = (m * (b - m) * x) / ((a + 2.0 * m - 1.0) * (a + 2.0 * m))
+        else:
+            num = -((a + m) * (a + b + m) * x) / ((a + 2.0 * m) *
+                                                  (a + 2.0 * m + 1.0))
+        d = 1.0 + num * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + num / c
+        c = c if abs(c) > tiny else tiny
+        f *= c * d
+        if abs(1.0 - c * d) < 1e-12:
+            break
+    return front * (f - 1.0)
+
+
+def welch_p_value(baseline, current):
+    """One-sided p-value of 'current' being slower than 'baseline'."""
+    n1, n2 = len(baseline), len(current)
+    if n1 < 2 or n2 < 2:
+        return None
+    v1 = statistics.variance(baseline) / n1
+    v2 = statistics.variance(current) / n2
+    diff = statistics.mean(current) - statistics.mean(baseline)
+    if v1 + v2 == 0.0:
+        return 0.0 if diff > 0.0 else 1.0
+    t = diff / math.sqrt(v1 + v2)
+    dof = (v1 + v2) ** 2 / (v1 ** 2 / (n1 - 1) + v2 ** 2 / (n2 - 1))
+    # P(T > t) for a Student's t distribution with 'dof' degrees of freedom
+    tail = 0.5 * incomplete_beta(dof / 2.0, 0.5, dof / (dof + t * t))
+    return tail if t > 0.0 else 1.0 - tail
+
+
+def run_benchmark(bench, settings, args):
+    """Runs one benchmark 'repetitions' times, returns the mean of each run."""
+    source = os.path.join(args.root, bench["file"])
+    run_cmd = [
+        args.tpp_run, "-e", bench.get("entry", "entry"),
+        "-entry-point-result=void", "-print=none",
+        "-n", str(settings["iterations"]),
+        "-shared-libs=" + args.shared_libs
+    ] + bench.get("tpp-run", [])
+
+    samples = []
+    for _ in range(settings["repetitions"]):
+        if "tpp-opt" in bench:
+            opt = subprocess.run([args.tpp_opt, source] + bench["tpp-opt"],
+                                 check=True, capture_output=True, text=True)
+            run = subprocess.run(run_cmd, input=opt.stdout, check=True,
+                                 capture_output=True, text=True)
+        else:
+            run = subprocess.run(run_cmd + [source], check=True,
+                                 capture_output=True, text=True)
+        stats = [STATS_RE.match(line) for line in run.stdout.splitlines()]
+        stats = [m for m in stats if m]
+        if not stats:
+            raise RuntimeError("no timing in the output of " + bench["name"])
+        samples.append(float(stats[-1].group(1)))
+    return samples
+
+
+def summarize(samples):
+    return {
+        "mean": statistics.mean(samples),
+        "stdev": statistics.stdev(samples) if len(samples) > 1 else 0.0,
+        "min": min(samples),
+        "median": statistics.median(samples),
+        "samples": samples,
+    }
+
+
+def compare(results, baseline, settings):
+    """Prints a report against the baseline, returns the regressions."""
+    alpha = 1.0 - settings["confidence"]
+    regressions = []
+    print("{:<32} {:>12} {:>12} {:>8} {:>8}  {}".format(
+        "benchmark", "baseline", "current", "change", "p-value", "status"))
+    for name, current in sorted(results.items()):
+        base = baseline.get(name)
+        if base is None:
+            print("{:<32} {:>12} {:>12.4e} {:>8} {:>8}  new".format(
+                name, "-", current["mean"], "-", "-"))
+            continue
+        change = current["mean"] / base["mean"] - 1.0
+        p = welch_p_value(base["samples"], current["samples"])
+        status = "ok"
+        if change > settings["threshold"] and p is not None and p < alpha:
+            status = "REGRESSION"
+            regressions.append(name)
+        elif change < -settings["threshold"]:
+            status = "faster"
+        print("{:<32} {:>12.4e} {:>12.4e} {:>+7.1%} {:>8} {}".format(
+            name, base["mean"], current["mean"], change,
+            "-" if p is None else "{:.3f}".format(p), " " + status))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--config", required=True,
+                        help="suite configuration (benchmarks.json)")
+    parser.add_argument("--root", default=".",
+                        help="directory the benchmark files are relative to")
+    parser.add_argument("--tpp-run", default="tpp-run", dest="tpp_run")
+    parser.add_argument("--tpp-opt", default="tpp-opt", dest="tpp_opt")
+    parser.add_argument("--shared-libs", required=True, dest="shared_libs",
+                        help="comma separated runtime libraries for tpp-run")
+    parser.add_argument("--output", default="benchmark-results.json",
+                        help="where to write the results")
+    parser.add_argument("--baseline", help="results to compare against")
+    parser.add_argument("--filter", default="",
+                        help="only run benchmarks whose name matches")
+    args = parser.parse_args()
+
+    with open(args.config) as f:
+        config = json.load(f)
+    settings = config["settings"]
+
+    results = {}
+    for bench in config["benchmarks"]:
+        if not re.search(args.filter, bench["name"]):
+            continue
+        print("Running " + bench["name"], file=sys.stderr)
+        try:
+            results[bench["name"]] = summarize(
+                run_benchmark(bench, settings, args))
+        except (subprocess.CalledProcessError, RuntimeError) as e:
+            print("ERROR: {}: {}".format(bench["name"], e), file=sys.stderr)
+            if isinstance(e, subprocess.CalledProcessError):
+                print(e.stderr, file=sys.stderr)
+            return 1
+
+    with open(args.output, "w") as f:
+        json.dump({"settings": settings, "benchmarks": results}, f, indent=2)
+    print("Results written to " + args.output, file=sys.stderr)
+
+    if not args.baseline:
+        return 0
+    with open(args.baseline) as f:
+        baseline = json.load(f)["benchmarks"]
+    regressions = compare(results, baseline, settings)
+    if regressions:
+        print("Slower than the baseline: " + ", ".join(regressions))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,13 @@
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @matmul_relu(%A: tensor<64x64xf32>, %B: tensor<64x64xf32>,
+                       %C: tensor<64x64xf32>) -> tensor<64x64xf32> {
+  %c0 = arith.constant 0.0 : f32
+  %D = linalg.matmul ins(%A, %B: tensor<64x64xf32>, tensor<64x64xf32>) outs(%C: tensor<64x64xf32>) -> tensor<64x64xf32>
+  %E = linalg.generic {indexing_maps = [#map], iterator_types = ["parallel", "parallel"]} outs(%D : tensor<64x64xf32>) {
+  ^bb0(%arg0: f32):
+    %0 = arith.maxf %arg0, %c0 : f32
+    linalg.yield %0 : f32
+  } -> tensor<64x64xf32>
+  return %E : tensor<64x64xf32>
+}
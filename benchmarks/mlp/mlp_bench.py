@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""Compares the TPP pipeline on a multi-layer MLP against native LIBXSMM.
+
+The blocked MLP is generated with mlir-gen and timed with tpp-run through the
+TPP pipeline, one layer at a time (each distinct layer shape as a one layer
+MLP) and as a whole. The same network is timed with mlp_xsmm, the hand-written
+LIBXSMM BRGEMM implementation. The report gives the percentage of the native
+performance reached per layer and overall, i.e. the native time over the
+pipeline's time.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(
+    os.path.abspath(__file__))))
+from bench import STATS_RE  # noqa: E402
+
+# mlp_xsmm prints the time of a call to each layer, then to the whole MLP
+LAYER_RE = re.compile(r"^layer (\d+): \S+ time: ([-+.\deE]+) s")
+TOTAL_RE = re.compile(r"^mlp: \d+ layers time: ([-+.\deE]+) s")
+
+
+def run_mlir(k, layers, args):
+    """Times the MLP generated by mlir-gen, returns seconds per call."""
+    gen_cmd = [args.mlir_gen, "-kernel=mlp", "-m=" + str(args.m),
+               "-n=" + str(args.n), "-k=" + str(k),
+               "-layers=" + str(layers), "-block=" + args.block]
+    if args.bf16:
+        gen_cmd.append("-bf16")
+    gen = subprocess.run(gen_cmd, check=True, capture_output=True, text=True)
+
+    run_cmd = [args.tpp_run, "-e", "entry", "-entry-point-result=void",
+               "-print=none", "-n", str(args.iterations),
+               "-tpp-pipeline=" + args.pipeline,
+               "-shared-libs=" + args.shared_libs]
+    run = subprocess.run(run_cmd, input=gen.stdout, check=True,
+                         capture_output=True, text=True)
+    stats = [STATS_RE.match(line) for line in run.stdout.splitlines()]
+    stats = [m for m in stats if m]
+    if not stats:
+        raise RuntimeError("no timing in the output of tpp-run")
+    return float(stats[-1].group(1))
+
+
+def run_native(args):
+    """Times mlp_xsmm, returns seconds per call of each layer and overall."""
+    cmd = [args.native, str(args.m), str(args.n), str(args.k),
+           str(args.layers)] + args.block.split(",") + [str(args.iterations)]
+    if args.bf16:
+        cmd.append("bf16")
+    run = subprocess.run(cmd, check=True, capture_output=True, text=True)
+    layers, total = {}, None
+    for line in run.stdout.splitlines():
+        match = LAYER_RE.match(line)
+        if match:
+            layers[int(match.group(1))] = float(match.group(2))
+        match = TOTAL_RE.match(line)
+        if match:
+            total = float(match.group(1))
+    if total is None or len(layers) != args.layers:
+        raise RuntimeError("no timing in the output of " + args.native)
+    return [layers[l] for l in range(args.layers)], total
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--mlir-gen", default="mlir-gen", dest="mlir_gen")
+    parser.add_argument("--tpp-run", default="tpp-run", dest="tpp_run")
+    parser.add_argument("--native", default="mlp_xsmm",
+                        help="the LIBXSMM MLP driver")
+    parser.add_argument("--shared-libs", required=True, dest="shared_libs",
+                        help="comma separated runtime libraries for tpp-run")
+    parser.add_argument("--m", default=256, type=int, help="batch size")
+    parser.add_argument("--n", default=1024, type=int, help="layer width")
+    parser.add_argument("--k", default=1024, type=int,
+                        help="input features")
+    parser.add_argument("--layers", default=3, type=int)
+    parser.add_argument("--block", default="32,32,32",
+                        help="blocking factors, as bm,bn,bk")
+    parser.add_argument("--bf16", action="store_true")
+    parser.add_argument("--pipeline", default="default",
+                        choices=["default", "aggressive"])
+    parser.add_argument("--iterations", default=100, type=int)
+    parser.add_argument("--output", help="write the results as JSON")
+    args = parser.parse_args()
+
+    try:
+        native_layers, native_total = run_native(args)
+        # Layers after the first all have the same shape: time it once
+        mlir_by_k = {}
+        for k in [args.k] + ([args.n] if args.layers > 1 else []):
+            if k not in mlir_by_k:
+                mlir_by_k[k] = run_mlir(k, 1, args)
+        mlir_layers = [mlir_by_k[args.k if l == 0 else args.n]
+                       for l in range(args.layers)]
+        mlir_total = run_mlir(args.k, args.layers, args)
+    except (subprocess.CalledProcessError, RuntimeError) as e:
+        print("ERROR: {}".format(e), file=sys.stderr)
+        if isinstance(e, subprocess.CalledProcessError):
+            print(e.stderr, file=sys.stderr)
+        return 1
+
+    dtype = "bf16" if args.bf16 else "f32"
+    print("MLP {} M={} N={} K={} layers={} block={}".format(
+        dtype, args.m, args.n, args.k, args.layers, args.block))
+    print("{:<8} {:>16} {:>12} {:>12} {:>10} {:>11} {:>9}".format(
+        "layer", "MxNxK", "tpp (s)", "native (s)", "tpp GF/s", "native GF/s",
+        "% native"))
+
+    rows = []
+    for l in range(args.layers):
+        k = args.k if l == 0 else args.n
+        flops = 2.0 * args.m * args.n * k
+        rows.append(("layer " + str(l), "{}x{}x{}".format(args.m, args.n, k),
+                     flops, mlir_layers[l], native_layers[l]))
+    total_flops = sum(row[2] for row in rows)
+    rows.append(("total", "", total_flops, mlir_total, native_total))
+
+    results = []
+    for name, shape, flops, mlir, native in rows:
+        percent = native / mlir * 100.0
+        print("{:<8} {:>16} {:>12.4e} {:>12.4e} {:>10.1f} {:>11.1f} "
+              "{:>8.1f}%".format(name, shape, mlir, native, flops / mlir / 1e9,
+                                 flops / native / 1e9, percent))
+        results.append({"name": name, "shape": shape, "tpp": mlir,
+                        "native": native, "percent": percent})
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump({"dtype": dtype, "m": args.m, "n": args.n, "k": args.k,
+                       "layers": args.layers, "block": args.block,
+                       "results": results}, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -4,10 +4,10 @@
 #map3 = affine_map<(d0, d1, d2) -> (d2, d1)>
 #map4 = affine_map<(d0, d1, d2) -> (d0, d1)>
 module @predict_function  {
-  func.func @mlp(%arg0: tensor<4x8xf32>, 
-                  %arg1: tensor<8x16xf32> {stdx.const},
-                  %arg2: tensor<1x16xf32> {stdx.const},  
-                  %output: tensor<4x16xf32> {stdx.res}) -> tensor<4x16xf32> {
+  func.func @mlp(%arg0: tensor<4x8xf32>,
+                  %arg1: tensor<8x16xf32>,
+                  %arg2: tensor<1x16xf32>,
+                  %output: tensor<4x16xf32>) -> tensor<4x16xf32> {
     %c0 = arith.constant 0.0 : f32
     %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%arg2 : tensor<1x16xf32>) outs(%output : tensor<4x16xf32>) {
     ^bb0(%arg9: f32, %arg10: f32):
@@ -0,0 +1,18 @@
+#map0 = affine_map<(d0, d1) -> (d1)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @mlp_layer(%A: tensor<128x256xf32>, %B: tensor<256x512xf32>,
+                     %Bias: tensor<512xf32>, %C: tensor<128x512xf32>) -> tensor<128x512xf32> {
+  %c0 = arith.constant 0.0 : f32
+  %0 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%Bias : tensor<512xf32>) outs(%C : tensor<128x512xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):
+    linalg.yield %arg0 : f32
+  } -> tensor<128x512xf32>
+  %1 = linalg.matmul ins(%A, %B: tensor<128x256xf32>, tensor<256x512xf32>) outs(%0: tensor<128x512xf32>) -> tensor<128x512xf32>
+  %2 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel"]} outs(%1 : tensor<128x512xf32>) {
+  ^bb0(%arg0: f32):
+    %3 = arith.maxf %arg0, %c0 : f32
+    linalg.yield %3 : f32
+  } -> tensor<128x512xf32>
+  return %2 : tensor<128x512xf32>
+}
@@ -0,0 +1,308 @@
+/* Native LIBXSMM implementation of the blocked multi-layer MLP.
+ *
+ * Each layer computes out = relu(in * W + bias) in the same blocked layout
+ * mlir-gen uses for '-kernel=mlp -block=bm,bn,bk':
+ *   in   [M/bm][K/bk][bm][bk]
+ *   W    [N/bn][K/bk][bk][bn] (bf16: VNNI packed [N/bn][K/bk][bk/2][bn][2])
+ *   bias [N/bn][bn]
+ *   out  [M/bm][N/bn][bm][bn]
+ * with one BRGEMM over the K blocks per output block, after broadcasting the
+ * bias into it and followed by a relu, all with LIBXSMM kernels. This is the
+ * reference the TPP pipeline is compared against by mlp_bench.py.
+ *
+ * Usage: mlp_xsmm M N K layers bm bn bk [iterations] [bf16]
+ * Prints the time of a call to each layer, and of the whole forward pass.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libxsmm.h>
+
+struct mlp_kernels {
+  libxsmm_gemmfunction brgemm;
+  libxsmm_meltwfunction_unary bias;
+  libxsmm_meltwfunction_unary relu;
+};
+
+struct mlp_layer {
+  int64_t k;
+  char *weights;
+  char *bias;
+};
+
+struct mlp_config {
+  int64_t m, n, k, bm, bn, bk;
+  int layers;
+  libxsmm_datatype dtype;
+  size_t type_size;
+};
+
+/* Deterministic values in [-0.5, 0.5), so that the relu has work to do */
+static float init_value(int64_t i, int64_t seed) {
+  return (float)((i * 37 + seed * 11) % 101) / 101.0f - 0.5f;
+}
+
+/* Offset of element (row, col) of a [rows][cols] matrix, blocked by
+   [brows][bcols] */
+static int64_t blocked_index(int64_t row, int64_t col, int64_t cols,
+                             int64_t brows, int64_t bcols) {
+  return ((row / brows) * (cols / bcols) + col / bcols) * brows * bcols +
+         (row % brows) * bcols + col % bcols;
+}
+
+/* Offset of element (row, col) of the [K][N] weights, in the kernel layout:
+   blocked [N/bn][K/bk][bk][bn], with the bk rows VNNI packed for bf16 */
+static int64_t weight_index(const struct mlp_config *cfg, int64_t k,
+                            int64_t row, int64_t col) {
+  int64_t block =
+      ((col / cfg->bn) * (k / cfg->bk) + row / cfg->bk) * cfg->bk * cfg->bn;
+  int64_t r = row % cfg->bk, c = col % cfg->bn;
+  if (LIBXSMM_DATATYPE_BF16 == cfg->dtype)
+    return block + ((r / 2) * cfg->bn + c) * 2 + r % 2;
+  return block + r * cfg->bn + c;
+}
+
+/* Stores the f32 values in the buffer, converted to the data type */
+static void store_values(const struct mlp_config *cfg, const float *values,
+                         char *buffer, int64_t size) {
+  if (LIBXSMM_DATATYPE_BF16 == cfg->dtype)
+    libxsmm_rne_convert_fp32_bf16(values, (libxsmm_bfloat16 *)buffer,
+                                  (unsigned int)size);
+  else
+    memcpy(buffer, values, size * sizeof(float));
+}
+
+static int dispatch_kernels(const struct mlp_config *cfg,
+                            struct mlp_kernels *kernels) {
+  const libxsmm_datatype comp_type = LIBXSMM_DATATYPE_F32;
+  libxsmm_bitfield gemm_flags = LIBXSMM_GEMM_FLAGS('N', 'N');
+  libxsmm_gemm_batch_reduce_config brconfig;
+  libxsmm_gemm_shape gemm_shape;
+  libxsmm_meltw_unary_shape unary_shape;
+
+  if (LIBXSMM_DATATYPE_BF16 == cfg->dtype)
+    gemm_flags |= LIBXSMM_GEMM_FLAG_VNNI_A;
+
+  /* Row major to col major: swap the operands, and m with n */
+  gemm_shape = libxsmm_create_gemm_shape(cfg->bn, cfg->bm, cfg->bk, cfg->bn,
+                                         cfg->bk, cfg->bn, cfg->dtype,
+                                         cfg->dtype, cfg->dtype, comp_type);
+  brconfig.br_type = LIBXSMM_GEMM_BATCH_REDUCE_STRIDE;
+  brconfig.br_stride_a_hint = cfg->bk * cfg->bn * cfg->type_size;
+  brconfig.br_stride_b_hint = cfg->bm * cfg->bk * cfg->type_size;
+  brconfig.br_unroll_hint = 0;
+  kernels->brgemm = libxsmm_dispatch_brgemm_v2(gemm_shape, gemm_flags, 0,
+                                               brconfig);
+
+  unary_shape = libxsmm_create_meltw_unary_shape(
+      cfg->bn, cfg->bm, cfg->bn, cfg->bn, cfg->dtype, cfg->dtype, comp_type);
+  kernels->bias = libxsmm_dispatch_meltw_unary_v2(
+      LIBXSMM_MELTW_TYPE_UNARY_IDENTITY, unary_shape,
+      LIBXSMM_MELTW_FLAG_UNARY_BCAST_COL);
+  kernels->relu = libxsmm_dispatch_meltw_unary_v2(
+      LIBXSMM_MELTW_TYPE_UNARY_RELU, unary_shape,
+      LIBXSMM_MELTW_FLAG_UNARY_NONE);
+
+  return (NULL != kernels->brgemm && NULL != kernels->bias &&
+          NULL != kernels->relu)
+             ? EXIT_SUCCESS
+             : EXIT_FAILURE;
+}
+
+/* out = relu(in * W + bias), one output block at a time */
+static void run_layer(const struct mlp_config *cfg,
+                      const struct mlp_kernels *kernels,
+                      const struct mlp_layer *layer, const char *in,
+                      char *out) {
+  const int64_t mblocks = cfg->m / cfg->bm, nblocks = cfg->n / cfg->bn;
+  const int64_t kblocks = layer->k / cfg->bk;
+  const size_t in_block = cfg->bm * cfg->bk * cfg->type_size;
+  const size_t w_block = cfg->bk * cfg->bn * cfg->type_size;
+  const size_t out_block = cfg->bm * cfg->bn * cfg->type_size;
+  unsigned long long count = kblocks;
+
+  for (int64_t mb = 0; mb < mblocks; ++mb) {
+    for (int64_t nb = 0; nb < nblocks; ++nb) {
+      char *c = out + (mb * nblocks + nb) * out_block;
+      libxsmm_meltw_unary_param unary_param;
+      libxsmm_gemm_param gemm_param;
+
+      memset(&unary_param, 0, sizeof(unary_param));
+      unary_param.in.primary = layer->bias + nb * cfg->bn * cfg->type_size;
+      unary_param.out.primary = c;
+      kernels->bias(&unary_param);
+
+      memset(&gemm_param, 0, sizeof(gemm_param));
+      gemm_param.a.primary = layer->weights + nb * kblocks * w_block;
+      gemm_param.b.primary = (void *)(in + mb * kblocks * in_block);
+      gemm_param.c.primary = c;
+      gemm_param.op.tertiary = &count;
+      kernels->brgemm(&gemm_param);
+
+      unary_param.in.primary = c;
+      kernels->relu(&unary_param);
+    }
+  }
+}
+
+static void run_mlp(const struct mlp_config *cfg,
+                    const struct mlp_kernels *kernels,
+                    const struct mlp_layer *layers, char **acts) {
+  for (int l = 0; l < cfg->layers; ++l)
+    run_layer(cfg, kernels, &layers[l], acts[l], acts[l + 1]);
+}
+
+/* Plain loops on the f32 values, in the blocked layout */
+static void reference_mlp(const struct mlp_config *cfg, float **weights,
+                          float **biases, float **acts) {
+  for (int l = 0; l < cfg->layers; ++l) {
+    const int64_t k = (0 == l ? cfg->k : cfg->n);
+    for (int64_t i = 0; i < cfg->m; ++i) {
+      for (int64_t j = 0; j < cfg->n; ++j) {
+        float acc = biases[l][j];
+        for (int64_t p = 0; p < k; ++p)
+          acc += acts[l][blocked_index(i, p, k, cfg->bm, cfg->bk)] *
+                 weights[l][weight_index(cfg, k, p, j)];
+        acts[l + 1][blocked_index(i, j, cfg->n, cfg->bm, cfg->bn)] =
+            (0 < acc ? acc : 0);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  struct mlp_config cfg;
+  struct mlp_kernels kernels;
+  struct mlp_layer *layers = NULL;
+  char **acts = NULL;
+  float **ref_weights = NULL, **ref_biases = NULL, **ref_acts = NULL;
+  int iterations, result = EXIT_SUCCESS;
+  libxsmm_timer_tickint start;
+  double duration;
+
+  if (8 > argc) {
+    fprintf(stderr,
+            "Usage: %s M N K layers bm bn bk [iterations] [bf16]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  cfg.m = atoi(argv[1]);
+  cfg.n = atoi(argv[2]);
+  cfg.k = atoi(argv[3]);
+  cfg.layers = atoi(argv[4]);
+  cfg.bm = atoi(argv[5]);
+  cfg.bn = atoi(argv[6]);
+  cfg.bk = atoi(argv[7]);
+  iterations = (8 < argc ? atoi(argv[8]) : 100);
+  cfg.dtype = ((9 < argc && 0 == strcmp("bf16", argv[9]))
+                   ? LIBXSMM_DATATYPE_BF16
+                   : LIBXSMM_DATATYPE_F32);
+  cfg.type_size = (LIBXSMM_DATATYPE_BF16 == cfg.dtype ? 2 : 4);
+
+  if (0 >= cfg.layers || 0 >= iterations || 0 >= cfg.bm || 0 >= cfg.bn ||
+      0 >= cfg.bk || 0 != cfg.m % cfg.bm || 0 != cfg.n % cfg.bn ||
+      0 != cfg.k % cfg.bk || (1 < cfg.layers && cfg.bn != cfg.bk) ||
+      (LIBXSMM_DATATYPE_BF16 == cfg.dtype && 0 != cfg.bk % 2)) {
+    fputs("Invalid sizes: the blocks must divide the sizes, and bn must be "
+          "equal to bk for more than one layer\n",
+          stderr);
+    return EXIT_FAILURE;
+  }
+
+  libxsmm_init();
+  if (EXIT_SUCCESS != dispatch_kernels(&cfg, &kernels)) {
+    fputs("Failed to dispatch the LIBXSMM kernels\n", stderr);
+    return EXIT_FAILURE;
+  }
+
+  layers = calloc(cfg.layers, sizeof(*layers));
+  acts = calloc(cfg.layers + 1, sizeof(*acts));
+  ref_weights = calloc(cfg.layers, sizeof(*ref_weights));
+  ref_biases = calloc(cfg.layers, sizeof(*ref_biases));
+  ref_acts = calloc(cfg.layers + 1, sizeof(*ref_acts));
+
+  /* Inputs, then the weights, bias and output of each layer */
+  ref_acts[0] = malloc(cfg.m * cfg.k * sizeof(float));
+  acts[0] = libxsmm_aligned_malloc(cfg.m * cfg.k * cfg.type_size, 64);
+  for (int64_t i = 0; i < cfg.m * cfg.k; ++i)
+    ref_acts[0][i] = init_value(i, 0);
+  store_values(&cfg, ref_acts[0], acts[0], cfg.m * cfg.k);
+  for (int l = 0; l < cfg.layers; ++l) {
+    const int64_t k = (0 == l ? cfg.k : cfg.n);
+    layers[l].k = k;
+    ref_weights[l] = malloc(k * cfg.n * sizeof(float));
+    ref_biases[l] = malloc(cfg.n * sizeof(float));
+    ref_acts[l + 1] = malloc(cfg.m * cfg.n * sizeof(float));
+    layers[l].weights = libxsmm_aligned_malloc(k * cfg.n * cfg.type_size, 64);
+    layers[l].bias = libxsmm_aligned_malloc(cfg.n * cfg.type_size, 64);
+    acts[l + 1] = libxsmm_aligned_malloc(cfg.m * cfg.n * cfg.type_size, 64);
+    /* Scaled down, so that the activations don't grow with the layers */
+    for (int64_t i = 0; i < k * cfg.n; ++i)
+      ref_weights[l][i] = init_value(i, l + 1) / (float)k * 4.0f;
+    for (int64_t i = 0; i < cfg.n; ++i)
+      ref_biases[l][i] = init_value(i, l + 2);
+    store_values(&cfg, ref_weights[l], layers[l].weights, k * cfg.n);
+    store_values(&cfg, ref_biases[l], layers[l].bias, cfg.n);
+  }
+
+  /* Validate against the reference, on f32 only: bf16 rounds every layer */
+  run_mlp(&cfg, &kernels, layers, acts);
+  if (LIBXSMM_DATATYPE_F32 == cfg.dtype) {
+    const libxsmm_blasint ld = cfg.n, rows = cfg.m;
+    libxsmm_matdiff_info diff;
+    reference_mlp(&cfg, ref_weights, ref_biases, ref_acts);
+    libxsmm_matdiff(&diff, LIBXSMM_DATATYPE_F32, ld, rows,
+                    ref_acts[cfg.layers], acts[cfg.layers], &ld, &ld);
+    if (1e-4 < libxsmm_matdiff_epsilon(&diff)) {
+      fprintf(stderr, "Result differs from reference result: %g\n",
+              libxsmm_matdiff_epsilon(&diff));
+      result = EXIT_FAILURE;
+    }
+  }
+
+  /* Each layer alone, with warm caches as in the pipeline's layers */
+  for (int l = 0; l < cfg.layers && EXIT_SUCCESS == result; ++l) {
+    run_layer(&cfg, &kernels, &layers[l], acts[l], acts[l + 1]);
+    start = libxsmm_timer_tick();
+    for (int i = 0; i < iterations; ++i)
+      run_layer(&cfg, &kernels, &layers[l], acts[l], acts[l + 1]);
+    duration = libxsmm_timer_duration(start, libxsmm_timer_tick()) /
+               iterations;
+    printf("layer %d: %lldx%lldx%lld time: %e s, %.2f GFLOPS\n", l,
+           (long long)cfg.m, (long long)cfg.n, (long long)layers[l].k,
+           duration, 2.0 * cfg.m * cfg.n * layers[l].k / duration * 1e-9);
+  }
+
+  /* The whole forward pass */
+  if (EXIT_SUCCESS == result) {
+    double flops = 0;
+    for (int l = 0; l < cfg.layers; ++l)
+      flops += 2.0 * cfg.m * cfg.n * layers[l].k;
+    start = libxsmm_timer_tick();
+    for (int i = 0; i < iterations; ++i)
+      run_mlp(&cfg, &kernels, layers, acts);
+    duration = libxsmm_timer_duration(start, libxsmm_timer_tick()) /
+               iterations;
+    printf("mlp: %d layers time: %e s, %.2f GFLOPS\n", cfg.layers, duration,
+           flops / duration * 1e-9);
+  }
+
+  for (int l = 0; l < cfg.layers; ++l) {
+    libxsmm_free(layers[l].weights);
+    libxsmm_free(layers[l].bias);
+    libxsmm_free(acts[l + 1]);
+    free(ref_weights[l]);
+    free(ref_biases[l]);
+    free(ref_acts[l + 1]);
+  }
+  libxsmm_free(acts[0]);
+  free(ref_acts[0]);
+  free(layers);
+  free(acts);
+  free(ref_weights);
+  free(ref_biases);
+  free(ref_acts);
+  libxsmm_finalize();
+
+  return result;
+}
@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+"""Benchmarks every distinct ResNet-50 convolution, layer by layer.
+
+Each convolution shape of ResNet-50 (v1.5, with the stride on the 3x3
+convolutions) is generated as a kernel in the requested layout and data type,
+blocked with the transform dialect and run with tpp-run through the TPP
+pipeline:
+  * 1x1 unstrided convolutions are packed, collapsed and mapped to BRGEMM;
+  * the 7x7 stem, 3x3 and strided convolutions are packed and mapped to
+    matmuls over the output rows, inside the loops on the blocked channels
+    and the filter. Their image rows are strided or shifted by the filter,
+    which map-to-brgemm cannot express as a batch of equally spaced blocks.
+The two groups are reported separately, each with its own network figures,
+so that the matmul layers are not mistaken for BRGEMM performance.
+
+The 'nchw' and 'nhwc' layouts pack the operands in the kernel, 'blocked'
+takes them in the blocked layout already ([N][C'][H][W][c] images and
+[K'][C'][R][S][c][k] filters), so that only the convolution is timed.
+
+Images are given padded, padding is not part of the kernel. The stem has 3
+input channels, which cannot be blocked by the channel block: its channels
+are one block of 3, and it is always given in the blocked layout, whatever
+the requested layout. The whole network figures weight each layer by the
+number of times it appears in the network.
+
+bf16 GEMMs only go to LIBXSMM in the VNNI layout, which the pipeline does not
+produce: the flat bf16 BRGEMMs and matmuls run as vector code, accumulating
+in f32.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(
+    os.path.abspath(__file__))))
+from bench import STATS_RE  # noqa: E402
+
+# name: (output size, input channels, output channels, filter size, stride,
+#        occurrences in the network)
+LAYERS = [
+    ("conv1_7x7_3_64_s2", 112, 3, 64, 7, 2, 1),
+    ("conv2_1x1_64_64", 56, 64, 64, 1, 1, 1),
+    ("conv2_3x3_64", 56, 64, 64, 3, 1, 3),
+    ("conv2_1x1_64_256", 56, 64, 256, 1, 1, 4),
+    ("conv2_1x1_256_64", 56, 256, 64, 1, 1, 2),
+    ("conv3_1x1_256_128", 56, 256, 128, 1, 1, 1),
+    ("conv3_3x3_128_s2", 28, 128, 128, 3, 2, 1),
+    ("conv3_1x1_128_512", 28, 128, 512, 1, 1, 4),
+    ("conv3_1x1_256_512_s2", 28, 256, 512, 1, 2, 1),
+    ("conv3_1x1_512_128", 28, 512, 128, 1, 1, 3),
+    ("conv3_3x3_128", 28, 128, 128, 3, 1, 3),
+    ("conv4_1x1_512_256", 28, 512, 256, 1, 1, 1),
+    ("conv4_3x3_256_s2", 14, 256, 256, 3, 2, 1),
+    ("conv4_1x1_256_1024", 14, 256, 1024, 1, 1, 6),
+    ("conv4_1x1_512_1024_s2", 14, 512, 1024, 1, 2, 1),
+    ("conv4_1x1_1024_256", 14, 1024, 256, 1, 1, 5),
+    ("conv4_3x3_256", 14, 256, 256, 3, 1, 5),
+    ("conv5_1x1_1024_512", 14, 1024, 512, 1, 1, 1),
+    ("conv5_3x3_512_s2", 7, 512, 512, 3, 2, 1),
+    ("conv5_1x1_512_2048", 7, 512, 2048, 1, 1, 3),
+    ("conv5_1x1_1024_2048_s2", 7, 1024, 2048, 1, 2, 1),
+    ("conv5_1x1_2048_512", 7, 2048, 512, 1, 1, 2),
+    ("conv5_3x3_512", 7, 512, 512, 3, 1, 2),
+]
+
+BRGEMM_SCHEDULE = """
+    %2 = transform.structured.collapse %1 [[0], [1], [2], [3], [4], [5, 6, 7], [8]]
+    %3 = transform.structured.collapse %2 [[0], [1], [2, 3], [4], [5], [6]]
+    %4 = transform.structured.interchange %3 {{ iterator_interchange = [0, 1, 4, 2, 3, 5] }}
+    transform.structured.map_to_brgemm %4"""
+
+MATMUL_SCHEDULE = """
+    %2 = transform.structured.interchange %1 {{ iterator_interchange = [0, 1, 2, 5, 6, 7, 3, 4, 8] }}
+    transform.structured.map_conv_to_matmul %2"""
+
+
+def tensor(shape, dtype):
+    return "tensor<{}x{}>".format("x".join(str(d) for d in shape), dtype)
+
+
+def conv_flops(batch, out_size, c, k, r):
+    return 2 * batch * out_size * out_size * k * c * r * r
+
+
+def is_brgemm(layer):
+    """Whether the layer is mapped to BRGEMM, or else to matmuls."""
+    _, _, _, _, r, stride, _ = layer
+    return r == 1 and stride == 1
+
+
+def generate(layer, layout, dtype, batch, block):
+    """Returns the kernel of one layer, with its blocking schedule."""
+    _, out_size, c, k, r, stride, _ = layer
+    in_size = (out_size - 1) * stride + r
+    attrs = "{{dilations = dense<1> : tensor<2xi64>, " \
+            "strides = dense<{}> : tensor<2xi64>}}".format(stride)
+    # The stem's 3 channels are a single block, packing needs equal blocks
+    c_block = block if c % block == 0 else c
+    if c_block != block:
+        layout = "blocked"
+
+    if layout == "nchw":
+        image = tensor([batch, c, in_size, in_size], dtype)
+        filt = tensor([k, c, r, r], dtype)
+        out = tensor([batch, k, out_size, out_size], dtype)
+        op = "linalg.conv_2d_nchw_fchw"
+    elif layout == "nhwc":
+        image = tensor([batch, in_size, in_size, c], dtype)
+        filt = tensor([r, r, c, k], dtype)
+        out = tensor([batch, out_size, out_size, k], dtype)
+        op = "linalg.conv_2d_nhwc_hwcf"
+    else:
+        image = tensor([batch, c // c_block, in_size, in_size, c_block],
+                       dtype)
+        filt = tensor([k // block, c // c_block, r, r, c_block, block], dtype)
+        out = tensor([batch, k // block, out_size, out_size, block], dtype)
+        op = "linalg.generic"
+
+    lines = ["func.func @entry(%image: {0}, %filter: {1}, %out: {2}) -> {2} "
+             "{{".format(image, filt, out)]
+    if op == "linalg.generic":
+        # N K' P Q k C' R S c, as the packed convolution
+        dims = "(n, k1, p, q, k, c1, r, s, c)"
+        maps = [
+            "affine_map<{} -> (n, c1, p * {} + r, q * {} + s, c)>".format(
+                dims, stride, stride),
+            "affine_map<{} -> (k1, c1, r, s, c, k)>".format(dims),
+            "affine_map<{} -> (n, k1, p, q, k)>".format(dims),
+        ]
+        iterators = ", ".join(['"parallel"'] * 5 + ['"reduction"'] * 4)
+        lines += [
+            "  %0 = linalg.generic {{indexing_maps = [{}], "
+            "iterator_types = [{}]}}".format(", ".join(maps), iterators),
+            "    ins(%image, %filter : {}, {}) outs(%out : {}) {{".format(
+                image, filt, out),
+            "  ^bb0(%i: {0}, %f: {0}, %o: {0}):".format(dtype),
+            "    %1 = arith.mulf %i, %f : {}".format(dtype),
+            "    %2 = arith.addf %o, %1 : {}".format(dtype),
+            "    linalg.yield %2 : {}".format(dtype),
+            "  }} -> {}".format(out),
+        ]
+    else:
+        lines.append("  %0 = {} {} ins(%image, %filter : {}, {}) "
+                     "outs(%out : {}) -> {}".format(op, attrs, image, filt,
+                                                    out, out))
+    lines += ["  return %0 : {}".format(out), "}", ""]
+
+    # %1 is the blocked convolution, packed here for nchw and nhwc
+    lines += ["transform.sequence failures(propagate) {",
+              "  ^bb0(%arg1: !pdl.operation):"]
+    if op == "linalg.generic":
+        lines.append("    %1 = transform.structured.match "
+                     "ops{[\"linalg.generic\"]} in %arg1")
+    else:
+        lines += ["    %0 = transform.structured.match ops{{[\"{}\"]}} "
+                  "in %arg1".format(op),
+                  "    %1 = transform.structured.pack %0 "
+                  "{{ blocking_factors = [{0}, {0}] }}".format(block)]
+    schedule = BRGEMM_SCHEDULE if is_brgemm(layer) else MATMUL_SCHEDULE
+    lines += [schedule.format().lstrip("\n"), "}", ""]
+    return "\n".join(lines)
+
+
+def run_layer(layer, layout, dtype, batch, args):
+    """Times one layer, returns seconds per call."""
+    source = generate(layer, layout, dtype, batch, args.block)
+    opt = subprocess.run([args.tpp_opt, "-transform-dialect-interpreter",
+                          "-transform-drop-schedule"], input=source,
+                         check=True, capture_output=True, text=True)
+    run_cmd = [args.tpp_run, "-e", "entry", "-entry-point-result=void",
+               "-print=none", "-n", str(args.iterations),
+               "-tpp-pipeline=" + args.pipeline,
+               "-shared-libs=" + args.shared_libs]
+    run = subprocess.run(run_cmd, input=opt.stdout, check=True,
+                         capture_output=True, text=True)
+    stats = [STATS_RE.match(line) for line in run.stdout.splitlines()]
+    stats = [m for m in stats if m]
+    if not stats:
+        raise RuntimeError("no timing in the output of tpp-run")
+    return float(stats[-1].group(1))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--tpp-opt", default="tpp-opt", dest="tpp_opt")
+    parser.add_argument("--tpp-run", default="tpp-run", dest="tpp_run")
+    parser.add_argument("--shared-libs", required=True, dest="shared_libs",
+                        help="comma separated runtime libraries for tpp-run")
+    parser.add_argument("--layouts", default="nchw,nhwc",
+                        help="comma separated, among nchw, nhwc and blocked")
+    parser.add_argument("--dtypes", default="f32,bf16",
+                        help="comma separated, among f32 and bf16")
+    parser.add_argument("--batches", default="1,16",
+                        help="comma separated batch sizes")
+    parser.add_argument("--block", default=32, type=int,
+                        help="blocking factor of the channels")
+    parser.add_argument("--pipeline", default="default",
+                        choices=["default", "aggressive"])
+    parser.add_argument("--iterations", default=10, type=int)
+    parser.add_argument("--filter", default="",
+                        help="only run the layers whose name contains this")
+    parser.add_argument("--output", help="write the results as JSON")
+    args = parser.parse_args()
+
+    layouts = args.layouts.split(",")
+    dtypes = args.dtypes.split(",")
+    batches = [int(b) for b in args.batches.split(",")]
+    if any(l not in ("nchw", "nhwc", "blocked") for l in layouts) or \
+            any(d not in ("f32", "bf16") for d in dtypes):
+        parser.error("unknown layout or data type")
+    layers = [l for l in LAYERS if args.filter in l[0]]
+
+    results = []
+    failed = False
+    row = "{:<24} {:>18} {:>5} {:>12.4e} {:>10.1f}"
+    for layout in layouts:
+        for dtype in dtypes:
+            for batch in batches:
+                print("ResNet-50 {} {} batch={}".format(layout, dtype, batch))
+                network_time, network_flops = 0.0, 0
+                for path, brgemm in (("BRGEMM", True), ("matmul", False)):
+                    group = [l for l in layers if is_brgemm(l) == brgemm]
+                    if not group:
+                        continue
+                    print("{:<24} {:>18} {:>5} {:>12} {:>10}".format(
+                        "layer ({})".format(path), "HxW CxK RxS/s", "x",
+                        "time (s)", "GFLOPS"))
+                    total_time, total_flops = 0.0, 0
+                    for layer in group:
+                        name, out_size, c, k, r, stride, count = layer
+                        flops = conv_flops(batch, out_size, c, k, r)
+                        shape = "{0}x{0} {1}x{2} {3}x{3}/{4}".format(
+                            out_size, c, k, r, stride)
+                        try:
+                            time = run_layer(layer, layout, dtype, batch,
+                                             args)
+                        except (subprocess.CalledProcessError,
+                                RuntimeError) as e:
+                            print("{:<24} {:>18} {:>5} failed".format(
+                                name, shape, count))
+                            print("  {}".format(e), file=sys.stderr)
+                            if isinstance(e, subprocess.CalledProcessError):
+                                print(e.stderr, file=sys.stderr)
+                            failed = True
+                            continue
+                        total_time += count * time
+                        total_flops += count * flops
+                        print(row.format(name, shape, count, time,
+                                         flops / time / 1e9))
+                        results.append({"layout": layout, "dtype": dtype,
+                                        "batch": batch, "layer": name,
+                                        "path": path.lower(), "time": time,
+                                        "flops": flops})
+                    if total_time > 0.0:
+                        print(row.format("{} layers".format(path), "", "",
+                                         total_time,
+                                         total_flops / total_time / 1e9))
+                    network_time += total_time
+                    network_flops += total_flops
+                if network_time > 0.0:
+                    print(row.format("network", "", "", network_time,
+                                     network_flops / network_time / 1e9))
+                print()
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump({"layers": results}, f, indent=2)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
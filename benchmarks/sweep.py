@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Sweeps kernel shapes with mlir-gen and tpp-run, and plots a heat map.
+
+For every (M, N, K) in the grid, mlir-gen generates the kernel, tpp-run
+compiles it with the TPP pipeline and times it, and the GFLOPS (from the
+kernel's tpp.flops attribute) are written to a CSV file. The heat map has
+one M x N table per K: the cells far below the best of the sweep are where
+the TPP mapping heuristics underperform.
+
+The heat map is printed as text, and also saved as an image (sweep.png by
+default, see --plot) if matplotlib is installed, unless --no-plot is given.
+"""
+
+import argparse
+import csv
+import itertools
+import re
+import subprocess
+import sys
+
+from bench import STATS_RE
+
+FLOPS_RE = re.compile(r"tpp\.flops = (\d+)")
+
+# Text heat map, from slowest to fastest
+SHADES = " .:-=+*#%@"
+
+
+def parse_sizes(text):
+    return [int(size) for size in text.split(",")]
+
+
+def run_point(m, n, k, args):
+    """Generates, runs and times one kernel, returns its GFLOPS."""
+    gen_cmd = [args.mlir_gen, "-kernel=" + args.kernel, "-m=" + str(m),
+               "-n=" + str(n), "-k=" + str(k), "-batch=" + str(args.batch),
+               "-layers=" + str(args.layers)]
+    if args.block:
+        gen_cmd.append("-block=" + args.block)
+    if args.bf16:
+        gen_cmd.append("-bf16")
+    gen = subprocess.run(gen_cmd, check=True, capture_output=True, text=True)
+    flops = int(FLOPS_RE.search(gen.stdout).group(1))
+
+    run_cmd = [args.tpp_run, "-e", "entry", "-entry-point-result=void",
+               "-print=none", "-n", str(args.iterations),
+               "-tpp-pipeline=" + args.pipeline,
+               "-shared-libs=" + args.shared_libs]
+    run = subprocess.run(run_cmd, input=gen.stdout, check=True,
+                         capture_output=True, text=True)
+    stats = [STATS_RE.match(line) for line in run.stdout.splitlines()]
+    stats = [m for m in stats if m]
+    if not stats:
+        raise RuntimeError("no timing in the output of tpp-run")
+    return flops / float(stats[-1].group(1)) / 1e9
+
+
+def print_heat_map(results, ms, ns, ks, out=sys.stdout):
+    best = max(results.values())
+    for k in ks:
+        print("K = {} (GFLOPS, best of the sweep: {:.1f})".format(k, best),
+              file=out)
+        print("{:>8} ".format("M \\ N") +
+              " ".join("{:>9}".format(n) for n in ns), file=out)
+        for m in ms:
+            cells = []
+            for n in ns:
+                gflops = results.get((m, n, k))
+                if gflops is None:
+                    cells.append("{:>9}".format("-"))
+                    continue
+                shade = SHADES[min(len(SHADES) - 1,
+                                   int(gflops / best * len(SHADES)))]
+                cells.append("{:>7.1f} {}".format(gflops, shade))
+            print("{:>8} ".format(m) + " ".join(cells), file=out)
+        print(file=out)
+
+
+def plot_heat_map(results, ms, ns, ks, filename):
+    try:
+        import matplotlib
+    except ImportError:
+        print("matplotlib is not installed, not saving {}".format(filename),
+              file=sys.stderr)
+        return
+    matplotlib.use("Agg")
+    import matplotlib.pyplot as plt
+
+    fig, axes = plt.subplots(1, len(ks), figsize=(4 * len(ks), 4),
+                             squeeze=False)
+    best = max(results.values())
+    for ax, k in zip(axes[0], ks):
+        grid = [[results.get((m, n, k), 0.0) for n in ns] for m in ms]
+        image = ax.imshow(grid, vmin=0.0, vmax=best, cmap="viridis")
+        ax.set_title("K = {}".format(k))
+        ax.set_xticks(range(len(ns)), [str(n) for n in ns])
+        ax.set_yticks(range(len(ms)), [str(m) for m in ms])
+        ax.set_xlabel("N")
+        ax.set_ylabel("M")
+    fig.colorbar(image, ax=axes[0].tolist(), label="GFLOPS")
+    fig.savefig(filename)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--mlir-gen", default="mlir-gen", dest="mlir_gen")
+    parser.add_argument("--tpp-run", default="tpp-run", dest="tpp_run")
+    parser.add_argument("--shared-libs", required=True, dest="shared_libs",
+                        help="comma separated runtime libraries for tpp-run")
+    parser.add_argument("--kernel", default="matmul",
+                        choices=["matmul", "brgemm", "mlp", "conv"])
+    parser.add_argument("--m", default="32,64,128,256", type=parse_sizes)
+    parser.add_argument("--n", default="32,64,128,256", type=parse_sizes)
+    parser.add_argument("--k", default="32,64,128,256", type=parse_sizes)
+    parser.add_argument("--batch", default=1, type=int)
+    parser.add_argument("--layers", default=1, type=int)
+    parser.add_argument("--block", help="blocking factors, as bm,bn,bk")
+    parser.add_argument("--bf16", action="store_true")
+    parser.add_argument("--pipeline", default="default",
+                        choices=["default", "aggressive"])
+    parser.add_argument("--iterations", default=100, type=int)
+    parser.add_argument("--output", default="sweep.csv",
+                        help="where to write the results")
+    parser.add_argument("--plot", default="sweep.png",
+                        help="where to save the heat map image")
+    parser.add_argument("--no-plot", action="store_true", dest="no_plot",
+                        help="only print the heat map as text")
+    args = parser.parse_args()
+
+    results = {}
+    for m, n, k in itertools.product(args.m, args.n, args.k):
+        print("Running M={} N={} K={}".format(m, n, k), file=sys.stderr)
+        try:
+            results[(m, n, k)] = run_point(m, n, k, args)
+        except (subprocess.CalledProcessError, RuntimeError) as e:
+            # Shapes the generator or the pipeline reject stay empty
+            print("  failed: {}".format(e), file=sys.stderr)
+
+    if not results:
+        print("ERROR: no kernel ran", file=sys.stderr)
+        return 1
+
+    with open(args.output, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["M", "N", "K", "GFLOPS"])
+        for (m, n, k), gflops in sorted(results.items()):
+            writer.writerow([m, n, k, "{:.3f}".format(gflops)])
+
+    print_heat_map(results, args.m, args.n, args.k)
+    if not args.no_plot:
+        plot_heat_map(results, args.m, args.n, args.k, args.plot)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -25,6 +25,11 @@ namespace utils {
 // dimensions.
 bool hasStaticShape(linalg::LinalgOp linalgOp);
 
+// Returns true if the innermost dimension of all the operands of the linalg
+// operation is static. The other dimensions may be dynamic: tpp operations
+// pass them to the runtime.
+bool hasStaticInnermostDims(linalg::LinalgOp linalgOp);
+
 // Returns true if the linalg operation has been marked by the tpp detection
 // pass and the operation can be mapped to a tpp operation.
 bool hasTppMark(linalg::LinalgOp linalgOp);
@@ -70,12 +75,22 @@ bool isTppIdentity(linalg::GenericOp linalgOp);
 // 4. All loops are parallel and the number of loops is less than or equal to 2.
 bool isTppRelu(linalg::GenericOp linalgOp);
 
+// Returns true if the linalg.generic is a tpp.relu_backward:
+// 1. Buffer semantics.
+// 2. One output and two inputs: the gradient and the forward activation.
+// 3. A single region computing 'activation > 0 ? gradient : 0'.
+// 4. All loops are parallel and all the accesses are the identity.
+bool isTppReluBackward(linalg::GenericOp linalgOp);
+
 // Returns true if the linalg generic can be mapped to a tpp.identity.
 bool canMapToTppIdentity(linalg::GenericOp linalgOp);
 
 // Returns true if the linalg generic can be mapped to a tpp.relu.
 bool canMapToTppRelu(linalg::GenericOp linalgOp);
 
+// Returns true if the linalg generic can be mapped to a tpp.relu_backward.
+bool canMapToTppReluBackward(linalg::GenericOp linalgOp);
+
 // Returns true if the linalg generic can be mapped to a tpp.add.
 bool canMapToTppAdd(linalg::GenericOp linalgOp);
 
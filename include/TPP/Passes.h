@@ -18,9 +18,16 @@ class ModuleOp;
 namespace mlir {
 namespace func {
 class FuncOp;
+class FuncDialect;
 } // namespace func
 } // namespace mlir
 
+namespace mlir {
+namespace arith {
+class ArithDialect;
+} // namespace arith
+} // namespace mlir
+
 namespace mlir {
 namespace vector {
 class VectorDialect;
@@ -45,6 +52,24 @@ class MemRefDialect;
 } // namespace memref
 } // namespace mlir
 
+namespace mlir {
+namespace math {
+class MathDialect;
+} // namespace math
+} // namespace mlir
+
+namespace mlir {
+namespace tensor {
+class TensorDialect;
+} // namespace tensor
+} // namespace mlir
+
+namespace mlir {
+namespace linalgx {
+class LinalgXDialect;
+} // namespace linalgx
+} // namespace mlir
+
 namespace mlir {
 namespace xsmm {
 class XsmmDialect;
@@ -62,14 +87,46 @@ std::unique_ptr<OperationPass<func::FuncOp>> createConvertLinalgToTppPass();
 std::unique_ptr<OperationPass<func::FuncOp>>
 createConvertLinalgToTppPass(bool, bool, ArrayRef<int64_t> tiles = {});
 std::unique_ptr<OperationPass<func::FuncOp>> createConvertTppToLoopsPass();
+std::unique_ptr<OperationPass<func::FuncOp>> createConvertTppToVectorPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createConvertTppToVectorPass(ArrayRef<int64_t> registerTile);
 std::unique_ptr<OperationPass<ModuleOp>> createConvertXsmmToFuncPass();
+std::unique_ptr<OperationPass<func::FuncOp>> createConvertXsmmOpsToFuncPass();
 std::unique_ptr<OperationPass<ModuleOp>> createConvertCheckToFuncPass();
+std::unique_ptr<OperationPass<func::FuncOp>> createConvertCheckOpsToFuncPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createConvertTppTrainingToFuncPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createConvertTppTrainingOpsToFuncPass();
 std::unique_ptr<OperationPass<ModuleOp>> createConvertCheckToLoopsPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createConvertTppToXsmmPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createConvertTppToXsmmPass(int64_t inlineFlopsThreshold);
 std::unique_ptr<OperationPass<ModuleOp>>
 createTransformDialectInterpreterPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createLinalgXToLoopsPass();
 std::unique_ptr<OperationPass<ModuleOp>> createTransformDropSchedulePass();
+std::unique_ptr<OperationPass<func::FuncOp>> createPackMatmulPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createPackMatmulPass(ArrayRef<int64_t> blockingFactors);
+std::unique_ptr<OperationPass<func::FuncOp>> createPropagatePackUnPackPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createRewriteToBatchReduceGemmPass();
+std::unique_ptr<OperationPass<func::FuncOp>> createVectorizeLinalgPass();
+std::unique_ptr<OperationPass<func::FuncOp>> createPartitionBlockLoopsPass();
+std::unique_ptr<OperationPass<ModuleOp>> createDefaultTppPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createDefaultTppPass(bool aggressive, bool preDispatch = false,
+                     StringRef cacheDir = "");
+std::unique_ptr<OperationPass<ModuleOp>> createExternalizeConstantsPass();
+std::unique_ptr<OperationPass<ModuleOp>> createSpecializeShapesPass();
+std::unique_ptr<OperationPass<ModuleOp>> createStaticMemoryPlanningPass();
+std::unique_ptr<OperationPass<ModuleOp>> createHugePageAllocationPass();
+std::unique_ptr<OperationPass<ModuleOp>> createHoistXsmmDispatchPass();
+
+// Lowers what's left after the TPP pipeline (or tpp-opt) to the LLVM dialect.
+// With 'parallel', the parallel loops go to OpenMP.
+void addLLVMLoweringPasses(OpPassManager &passManager, bool parallel = false);
 
 } // namespace tpp
 } // namespace mlir
@@ -12,6 +12,7 @@
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/DenseMap.h"
 
 namespace mlir {
 class RewriterBase;
@@ -29,6 +30,10 @@ namespace vnni {
 class MatmulOp;
 }
 
+namespace func {
+class FuncOp;
+} // namespace func
+
 namespace linalgx {
 
 // Attempt to map the current linalgOp to a BRGEMM.
@@ -36,6 +41,14 @@ namespace linalgx {
 FailureOr<SmallVector<Value>> mapToBRGEMMOp(RewriterBase &rewriter,
                                             linalg::LinalgOp linalgOp);
 
+// Attempt to map the current linalgOp to a BRGEMM over the non-zero blocks
+// of its constant weights, if at least `minSparsity` of them are zero.
+// On success the returned values are the materialzed loops with the sparse
+// BRGEMM inside.
+FailureOr<SmallVector<Value>> mapToSparseBRGEMMOp(RewriterBase &rewriter,
+                                                  linalg::LinalgOp linalgOp,
+                                                  double minSparsity);
+
 // Map a convolution to a matmul operation. We support the following formats:
 // 1. [N][P][Q][K] += [N][H][W][C] * [R][S][C][K]
 // 2. [N][K’][P][Q][k] += [N][C’][H][W][c] * [K’][C’][R][S][c][k] (blocked)
@@ -57,6 +70,12 @@ FailureOr<linalg::GenericOp> packMatmulOp(RewriterBase &rewriter,
                                           linalg::MatmulOp linalgOp,
                                           ArrayRef<OpFoldResult> tiles);
 
+// Attempt to block a backward matmul: a linalg.generic matmul reading A or B
+// transposed (dX = dY * W^T, dW = X^T * dY).
+FailureOr<linalg::GenericOp>
+packTransposedMatmulOp(RewriterBase &rewriter, linalg::GenericOp linalgOp,
+                       ArrayRef<OpFoldResult> tiles);
+
 // Attempt to block a MatmulOp to VNNI format.
 FailureOr<vnni::MatmulOp> packVNNIMatmulOp(RewriterBase &rewriter,
                                            linalg::MatmulOp linalgOp,
@@ -80,10 +99,38 @@ void populateConvertLinalgToTppPatterns(RewritePatternSet &patterns,
                                         bool useParallelLoops);
 void populateMapLinalgToTppPatterns(RewritePatternSet &patterns);
 void populateTppToXsmmPatterns(RewritePatternSet &patterns);
+void populateTppToLoopsPatterns(RewritePatternSet &patterns);
+// The subset of the above for tpp.sgd_update and tpp.adam_update.
+void populateTppOptimizerToLoopsPatterns(RewritePatternSet &patterns);
+
+// Lower a tpp.matmul or tpp.brgemm to register-blocked vector micro-kernels,
+// with a tile of TM x TN of C in registers and k unrolled by TK.
+LogicalResult lowerToVectorMicroKernels(RewriterBase &rewriter, Operation *op,
+                                        ArrayRef<int64_t> registerTile);
+
 void populateXsmmToFuncPatterns(RewritePatternSet &patterns,
                                 bool useExtractMetaData);
 void populateCheckToFuncPatterns(RewritePatternSet &patterns);
+void populateTppTrainingToFuncPatterns(RewritePatternSet &patterns);
+
+// Declare the runtime functions the XSMM (check) operations of 'module' lower
+// to, so that the patterns above can then run on each function in parallel.
+void declareXsmmRuntimeFunctions(ModuleOp module, bool useExtractMetaData);
+void declareCheckRuntimeFunctions(ModuleOp module);
+// Same for the tpp training operations (tpp.sgd_update, tpp.dropout, ..).
+void declareTppTrainingRuntimeFunctions(ModuleOp module);
+
 void populateSinkPackPatterns(RewritePatternSet &patterns);
+
+// Parse a shape binding of the form argN:DxD.. (e.g. arg0:128x512).
+LogicalResult parseShapeBinding(StringRef binding, unsigned &argNum,
+                                SmallVectorImpl<int64_t> &shape);
+
+// Give the arguments of 'func' bound in 'shapes' a static shape and propagate
+// it through the body. Updates the function's type, but not its callers.
+LogicalResult
+specializeShapes(func::FuncOp func,
+                 const llvm::DenseMap<unsigned, SmallVector<int64_t>> &shapes);
 } // namespace tpp
 } // namespace mlir
 
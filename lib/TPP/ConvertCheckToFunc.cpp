@@ -12,6 +12,7 @@
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
 using namespace mlir;
@@ -56,55 +57,18 @@ static SmallVector<Value> getMemRefOperands(OpBuilder &b, Location loc,
   return res;
 }
 
-static func::CallOp buildExpectTrueCall(Location loc, Operation *op,
-                                        ModuleOp module,
-                                        FlatSymbolRefAttr fnName,
-                                        PatternRewriter &rewriter) {
-  auto libFnType =
-      rewriter.getFunctionType(extractOperandTypes(op->getOperands()), None);
-
-  if (!module.lookupSymbol(fnName)) {
-    OpBuilder::InsertionGuard guard(rewriter);
-    // Insert before module terminator.
-    rewriter.setInsertionPoint(module.getBody(),
-                               std::prev(module.getBody()->end()));
-    func::FuncOp funcOp =
-        rewriter.create<func::FuncOp>(loc, fnName.getValue(), libFnType);
-
-    funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
-                    UnitAttr::get(rewriter.getContext()));
-
-    funcOp.setPrivate();
-  }
-
-  auto call = rewriter.create<func::CallOp>(
-      loc, fnName.getValue(), TypeRange(),
-      getMemRefOperands(rewriter, loc, op->getOperands()));
-  return call;
+// Name of the runtime function a check operation lowers to.
+static StringRef getCheckFuncName(Operation *op) {
+  if (isa<ExpectTrueOp>(op))
+    return "expect_true";
+  return "expect_almost_equals";
 }
 
-
-static func::CallOp buildExpectAlmostEqualsCall(Location loc, Operation *op,
-                                                ModuleOp module,
-                                                FlatSymbolRefAttr fnName,
-                                                PatternRewriter &rewriter) {
-  auto libFnType =
-      rewriter.getFunctionType(extractOperandTypes(op->getOperands()), None);
-
-  if (!module.lookupSymbol(fnName.getAttr())) {
-    OpBuilder::InsertionGuard guard(rewriter);
-    // Insert before module terminator.
-    rewriter.setInsertionPoint(module.getBody(),
-                               std::prev(module.getBody()->end()));
-    func::FuncOp funcOp =
-        rewriter.create<func::FuncOp>(loc, fnName.getValue(), libFnType);
-    funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
-                    UnitAttr::get(rewriter.getContext()));
-    funcOp.setPrivate();
-  }
-
-  func::CallOp call = rewriter.create<func::CallOp>(
-      loc, fnName.getValue(), TypeRange(),
+static func::CallOp buildCheckCall(Location loc, Operation *op,
+                                   PatternRewriter &rewriter) {
+  // The callee is declared by tpp::declareCheckRuntimeFunctions.
+  auto call = rewriter.create<func::CallOp>(
+      loc, getCheckFuncName(op), TypeRange(),
       getMemRefOperands(rewriter, loc, op->getOperands()));
   return call;
 }
@@ -115,15 +79,7 @@ struct ConvertExpectTrue : public OpRewritePattern<ExpectTrueOp> {
 
   LogicalResult matchAndRewrite(ExpectTrueOp expectTrueOp,
                                 PatternRewriter &rewriter) const override {
-    Location loc = expectTrueOp.getLoc();
-    std::string kindAsString = "expect_true";
-
-    FlatSymbolRefAttr fnName =
-        SymbolRefAttr::get(rewriter.getContext(), kindAsString);
-
-    ModuleOp module = expectTrueOp->getParentOfType<ModuleOp>();
-
-    buildExpectTrueCall(loc, expectTrueOp, module, fnName, rewriter);
+    buildCheckCall(expectTrueOp.getLoc(), expectTrueOp, rewriter);
     rewriter.eraseOp(expectTrueOp);
     return success();
   }
@@ -135,22 +91,16 @@ struct ConvertAlmostEquals : public OpRewritePattern<ExpectAlmostEqOp> {
 
   LogicalResult matchAndRewrite(ExpectAlmostEqOp almostEqualsOp,
                                 PatternRewriter &rewriter) const override {
-    Location loc = almostEqualsOp.getLoc();
-    std::string kindAsString = "expect_almost_equals";
-
-    FlatSymbolRefAttr fnName =
-        SymbolRefAttr::get(rewriter.getContext(), kindAsString);
-
-    ModuleOp module = almostEqualsOp->getParentOfType<ModuleOp>();
-
-    buildExpectAlmostEqualsCall(loc, almostEqualsOp, module, fnName, rewriter);
+    buildCheckCall(almostEqualsOp.getLoc(), almostEqualsOp, rewriter);
     rewriter.eraseOp(almostEqualsOp);
     return success();
   }
 };
 
-struct ConvertCheckToFunc : public ConvertCheckToFuncBase<ConvertCheckToFunc> {
-  ConvertCheckToFunc() = default;
+// Rewrite the check operations of a function to calls. Runs on each function
+// in parallel, the runtime functions must already be declared.
+struct ConvertCheckOpsToFunc
+    : public ConvertCheckOpsToFuncBase<ConvertCheckOpsToFunc> {
   void runOnOperation() override {
     RewritePatternSet patterns(&getContext());
     mlir::tpp::populateCheckToFuncPatterns(patterns);
@@ -159,13 +109,58 @@ struct ConvertCheckToFunc : public ConvertCheckToFuncBase<ConvertCheckToFunc> {
   }
 };
 
+// Declare the runtime functions in one module step, then convert the
+// functions in parallel.
+struct ConvertCheckToFunc : public ConvertCheckToFuncBase<ConvertCheckToFunc> {
+  ConvertCheckToFunc() = default;
+  void runOnOperation() override {
+    mlir::tpp::declareCheckRuntimeFunctions(getOperation());
+    OpPassManager pm(ModuleOp::getOperationName());
+    pm.addNestedPass<func::FuncOp>(std::make_unique<ConvertCheckOpsToFunc>());
+    if (failed(runPipeline(pm, getOperation())))
+      signalPassFailure();
+  }
+};
+
 } // namespace
 
 void mlir::tpp::populateCheckToFuncPatterns(RewritePatternSet &patterns) {
   patterns.add<ConvertAlmostEquals, ConvertExpectTrue>(patterns.getContext());
 }
 
+void mlir::tpp::declareCheckRuntimeFunctions(ModuleOp module) {
+  SmallVector<Operation *> checks;
+  module.walk([&](Operation *op) {
+    if (isa<ExpectTrueOp, ExpectAlmostEqOp>(op))
+      checks.push_back(op);
+  });
+  if (checks.empty())
+    return;
+
+  // Insert before the last operation of the module, the last use first.
+  OpBuilder builder(module.getContext());
+  builder.setInsertionPoint(module.getBody(),
+                            std::prev(module.getBody()->end()));
+  for (Operation *op : llvm::reverse(checks)) {
+    StringRef name = getCheckFuncName(op);
+    if (module.lookupSymbol(name))
+      continue;
+    auto libFnType =
+        builder.getFunctionType(extractOperandTypes(op->getOperands()), None);
+    func::FuncOp funcOp =
+        builder.create<func::FuncOp>(op->getLoc(), name, libFnType);
+    funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                    builder.getUnitAttr());
+    funcOp.setPrivate();
+  }
+}
+
 std::unique_ptr<OperationPass<ModuleOp>>
 mlir::tpp::createConvertCheckToFuncPass() {
   return std::make_unique<ConvertCheckToFunc>();
 }
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createConvertCheckOpsToFuncPass() {
+  return std::make_unique<ConvertCheckOpsToFunc>();
+}
@@ -6,6 +6,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "TPP/Dialect/LinalgX/LinalgXOps.h"
 #include "TPP/Dialect/Tpp/TppOps.h"
 #include "TPP/Dialect/Tpp/TppUtils.h"
 #include "TPP/Passes.h"
@@ -251,13 +252,14 @@ Value getOperandForTpp(Value operand, PatternRewriter &rewriter, Location loc) {
 }
 
 // Given an operand 'operand' check if it is a scalar
-// or a static shape type with rank <= 2.
+// or a shaped type with rank <= 2 and a static innermost dimension.
 LogicalResult checkOperandForTpp(Value operand) {
   Type operandType = operand.getType();
   if (!operandType.isa<ShapedType>())
     return success();
   if (auto shapedType = operandType.dyn_cast_or_null<ShapedType>()) {
-    if (!shapedType.hasStaticShape())
+    if (shapedType.getRank() > 0 &&
+        ShapedType::isDynamic(shapedType.getShape().back()))
       return failure();
     unsigned rank = shapedType.getRank();
     if (rank > 2)
@@ -286,6 +288,11 @@ struct ConvertGenericOpToTpp : public OpRewritePattern<linalg::GenericOp> {
       rewriter.replaceOpWithNewOp<tpp::ReluOp>(linalgOp, operands[0]);
       return success();
     }
+    if (tpp::utils::isTppReluBackward(linalgOp)) {
+      rewriter.replaceOpWithNewOp<tpp::ReluBackwardOp>(
+          linalgOp, operands[0], operands[1], operands[2]);
+      return success();
+    }
     if (tpp::utils::isTppAdd(linalgOp)) {
       rewriter.replaceOpWithNewOp<tpp::AddOp>(linalgOp, operands[0],
                                               operands[1]);
@@ -304,7 +311,17 @@ struct ConvertGenericOpToTpp : public OpRewritePattern<linalg::GenericOp> {
                                 PatternRewriter &rewriter) const override {
     if (!linalgOp.hasBufferSemantics())
       return rewriter.notifyMatchFailure(linalgOp, "Expect buffer semantics");
-    if (!tpp::utils::hasStaticShape(linalgOp))
+    if (!tpp::utils::hasStaticInnermostDims(linalgOp))
+      return rewriter.notifyMatchFailure(
+          linalgOp, "Expect static innermost dimensions when mapping to tpp");
+    // The broadcasts of tpp.identity and the rank-reducing subviews are
+    // computed from the shapes.
+    if (!tpp::utils::hasStaticShape(linalgOp) &&
+        (tpp::utils::isTppIdentity(linalgOp) ||
+         llvm::any_of(linalgOp->getOperands(), [](Value operand) {
+           auto shapedType = operand.getType().dyn_cast<ShapedType>();
+           return shapedType && shapedType.getRank() > 2;
+         })))
       return rewriter.notifyMatchFailure(
           linalgOp, "Expect static shape when mapping to tpp");
 
@@ -331,9 +348,9 @@ struct ConvertBrgemmToTpp
     if (!brMatmulOp.hasBufferSemantics())
       return rewriter.notifyMatchFailure(
           brMatmulOp, "Expect buffer semantics when mapping to tpp");
-    if (!tpp::utils::hasStaticShape(brMatmulOp))
+    if (!tpp::utils::hasStaticInnermostDims(brMatmulOp))
       return rewriter.notifyMatchFailure(
-          brMatmulOp, "Expect static shape when mapping to tpp");
+          brMatmulOp, "Expect static innermost dimensions when mapping to tpp");
     SmallVector<Value> inputs = brMatmulOp.getDpsInputOperands();
     SmallVector<Value> outputs = brMatmulOp.getDpsInitOperands();
     rewriter.replaceOpWithNewOp<tpp::BrgemmOp>(brMatmulOp, inputs, outputs[0]);
@@ -341,6 +358,33 @@ struct ConvertBrgemmToTpp
   }
 };
 
+// Convert a linalgx.sparse_brgemm to a tpp.sparse_brgemm.
+struct ConvertSparseBrgemmToTpp
+    : public OpRewritePattern<linalgx::SparseBrgemmOp> {
+  using OpRewritePattern<linalgx::SparseBrgemmOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalgx::SparseBrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    if (!llvm::all_of(brgemmOp->getOperandTypes(),
+                      [](Type type) { return type.isa<MemRefType>(); }))
+      return rewriter.notifyMatchFailure(
+          brgemmOp, "Expect buffer semantics when mapping to tpp");
+    if (llvm::any_of(
+            ValueRange{brgemmOp.getBatchMatrixA(), brgemmOp.getBatchMatrixB(),
+                       brgemmOp.getMatrixC()},
+            [](Value operand) {
+              return ShapedType::isDynamic(
+                  operand.getType().cast<MemRefType>().getShape().back());
+            }))
+      return rewriter.notifyMatchFailure(
+          brgemmOp, "Expect static innermost dimensions when mapping to tpp");
+    rewriter.replaceOpWithNewOp<tpp::SparseBrgemmOp>(
+        brgemmOp, brgemmOp.getBatchMatrixA(), brgemmOp.getBatchMatrixB(),
+        brgemmOp.getIndices(), brgemmOp.getMatrixC());
+    return success();
+  }
+};
+
 // Convert a linalg.matmul to a tpp.matmul.
 struct ConvertMatmulToTpp : public OpRewritePattern<linalg::MatmulOp> {
   using OpRewritePattern<linalg::MatmulOp>::OpRewritePattern;
@@ -350,9 +394,9 @@ struct ConvertMatmulToTpp : public OpRewritePattern<linalg::MatmulOp> {
     if (!matmulOp.hasBufferSemantics())
       return rewriter.notifyMatchFailure(
           matmulOp, "Expect buffer semantics when mapping to tpp");
-    if (!tpp::utils::hasStaticShape(matmulOp))
+    if (!tpp::utils::hasStaticInnermostDims(matmulOp))
       return rewriter.notifyMatchFailure(
-          matmulOp, "Expect static shape when mapping to tpp");
+          matmulOp, "Expect static innermost dimensions when mapping to tpp");
     SmallVector<Value> inputs = matmulOp.getDpsInputOperands();
     SmallVector<Value> outputs = matmulOp.getDpsInitOperands();
     rewriter.replaceOpWithNewOp<tpp::MatmulOp>(matmulOp, inputs, outputs[0]);
@@ -489,6 +533,7 @@ void mlir::tpp::populateConvertLinalgToTppPatterns(RewritePatternSet &patterns,
   // clang-format off
   patterns.add<ConvertGenericOpToTpp,
                ConvertBrgemmToTpp,
+               ConvertSparseBrgemmToTpp,
                ConvertMatmulToTpp>(patterns.getContext());
   patterns.add<ReshapeGenericOpForTpp>(patterns.getContext(), useParallelLoops);
   populateSubViewFoldingPatterns(patterns);
@@ -8,8 +8,10 @@
 
 #include "TPP/Dialect/Tpp/TppOps.h"
 #include "TPP/Passes.h"
+#include "TPP/Transforms.h"
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Math/IR/Math.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -59,8 +61,7 @@ struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
     SmallVector<Value> ubs;
     size_t rank = addOp.getLhs().getType().cast<MemRefType>().getRank();
     for (size_t idx = 0; idx < rank; idx++) {
-      Value dim = rewriter.create<arith::ConstantIndexOp>(
-          loc, addOp.getLhs().getType().cast<MemRefType>().getShape()[idx]);
+      Value dim = rewriter.create<memref::DimOp>(loc, addOp.getOutput(), idx);
       ubs.push_back(dim);
     }
     Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
@@ -113,11 +114,9 @@ struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
     // Handle memref.
     SmallVector<Value> ubs;
     size_t rank = identityOp.getOutput().getType().cast<MemRefType>().getRank();
-    ArrayRef<int64_t> shapeOutput =
-        identityOp.getOutput().getType().cast<MemRefType>().getShape();
     for (size_t idx = 0; idx < rank; idx++) {
       Value dim =
-          rewriter.create<arith::ConstantIndexOp>(loc, shapeOutput[idx]);
+          rewriter.create<memref::DimOp>(loc, identityOp.getOutput(), idx);
       ubs.push_back(dim);
     }
     Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
@@ -178,8 +177,7 @@ struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
     SmallVector<Value> ubs;
     size_t rank = reluOp.getOutput().getType().cast<MemRefType>().getRank();
     for (size_t idx = 0; idx < rank; idx++) {
-      Value dim = rewriter.create<arith::ConstantIndexOp>(
-          loc, reluOp.getOutput().getType().cast<MemRefType>().getShape()[idx]);
+      Value dim = rewriter.create<memref::DimOp>(loc, reluOp.getOutput(), idx);
       ubs.push_back(dim);
     }
     Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
@@ -208,6 +206,163 @@ struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
   }
 };
 
+// Convert relu backward to loops: out = input > 0 ? grad : 0.
+struct ConvertTppReluBackwardOp : public OpRewritePattern<ReluBackwardOp> {
+  using OpRewritePattern<ReluBackwardOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(ReluBackwardOp reluOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = reluOp.getLoc();
+    MemRefType outputType = reluOp.getOutput().getType().cast<MemRefType>();
+    SmallVector<Value> ubs;
+    for (int64_t idx = 0, rank = outputType.getRank(); idx < rank; idx++)
+      ubs.push_back(
+          rewriter.create<memref::DimOp>(loc, reluOp.getOutput(), idx));
+    Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
+    SmallVector<Value> lbs(outputType.getRank(), zero);
+    Value one = rewriter.create<arith::ConstantIndexOp>(loc, 1);
+    SmallVector<Value> steps(outputType.getRank(), one);
+
+    Type elementType = outputType.getElementType();
+    Value zeroConstant = rewriter.create<arith::ConstantOp>(
+        loc, elementType, rewriter.getFloatAttr(elementType, 0));
+
+    (void)scf::buildLoopNest(
+        rewriter, loc, lbs, ubs, steps,
+        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+          Value scalarGrad =
+              b.create<memref::LoadOp>(loc, reluOp.getGrad(), localIvs);
+          Value scalarInput =
+              b.create<memref::LoadOp>(loc, reluOp.getInput(), localIvs);
+          Value mask = b.create<arith::CmpFOp>(loc, arith::CmpFPredicate::OGT,
+                                               scalarInput, zeroConstant);
+          Value scalarOut =
+              b.create<arith::SelectOp>(loc, mask, scalarGrad, zeroConstant);
+          b.create<memref::StoreOp>(loc, scalarOut, reluOp.getOutput(),
+                                    localIvs);
+        });
+
+    rewriter.eraseOp(reluOp);
+    return success();
+  }
+};
+
+// Build a loop nest over all the elements of 'shaped', with 'bodyBuilder' as
+// the body. Used by the element-wise optimizer updates, which may have any
+// rank.
+static void
+buildElementwiseLoopNest(PatternRewriter &rewriter, Location loc,
+                         Value shaped,
+                         function_ref<void(OpBuilder &, Location, ValueRange)>
+                             bodyBuilder) {
+  int64_t rank = shaped.getType().cast<MemRefType>().getRank();
+  SmallVector<Value> ubs;
+  for (int64_t idx = 0; idx < rank; idx++)
+    ubs.push_back(rewriter.create<memref::DimOp>(loc, shaped, idx));
+  Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
+  SmallVector<Value> lbs(rank, zero);
+  Value one = rewriter.create<arith::ConstantIndexOp>(loc, 1);
+  SmallVector<Value> steps(rank, one);
+  (void)scf::buildLoopNest(rewriter, loc, lbs, ubs, steps, bodyBuilder);
+}
+
+// Convert sgd_update to loops.
+struct ConvertTppSgdUpdateOp : public OpRewritePattern<SgdUpdateOp> {
+  using OpRewritePattern<SgdUpdateOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(SgdUpdateOp sgdOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = sgdOp.getLoc();
+    Value momentum =
+        rewriter.create<arith::ConstantOp>(loc, sgdOp.getMomentumAttr());
+    Value weightDecay =
+        rewriter.create<arith::ConstantOp>(loc, sgdOp.getWeightDecayAttr());
+    Value lr = sgdOp.getLearningRate();
+
+    buildElementwiseLoopNest(
+        rewriter, loc, sgdOp.getParam(),
+        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+          Value grad = b.create<memref::LoadOp>(loc, sgdOp.getGrad(), localIvs);
+          Value param =
+              b.create<memref::LoadOp>(loc, sgdOp.getParam(), localIvs);
+          Value velocity =
+              b.create<memref::LoadOp>(loc, sgdOp.getVelocity(), localIvs);
+          Value decay = b.create<arith::MulFOp>(loc, weightDecay, param);
+          grad = b.create<arith::AddFOp>(loc, grad, decay);
+          velocity = b.create<arith::MulFOp>(loc, momentum, velocity);
+          velocity = b.create<arith::AddFOp>(loc, velocity, grad);
+          Value step = b.create<arith::MulFOp>(loc, lr, velocity);
+          param = b.create<arith::SubFOp>(loc, param, step);
+          b.create<memref::StoreOp>(loc, velocity, sgdOp.getVelocity(),
+                                    localIvs);
+          b.create<memref::StoreOp>(loc, param, sgdOp.getParam(), localIvs);
+        });
+
+    rewriter.eraseOp(sgdOp);
+    return success();
+  }
+};
+
+// Convert adam_update to loops.
+struct ConvertTppAdamUpdateOp : public OpRewritePattern<AdamUpdateOp> {
+  using OpRewritePattern<AdamUpdateOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(AdamUpdateOp adamOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = adamOp.getLoc();
+    auto getConstant = [&](float value) -> Value {
+      return rewriter.create<arith::ConstantOp>(
+          loc, rewriter.getF32FloatAttr(value));
+    };
+    float beta1 = adamOp.getBeta1().convertToFloat();
+    float beta2 = adamOp.getBeta2().convertToFloat();
+    Value beta1Val = getConstant(beta1);
+    Value beta2Val = getConstant(beta2);
+    Value oneMinusBeta1 = getConstant(1.0f - beta1);
+    Value oneMinusBeta2 = getConstant(1.0f - beta2);
+    Value epsilon = getConstant(adamOp.getEpsilon().convertToFloat());
+    Value weightDecay = getConstant(adamOp.getWeightDecay().convertToFloat());
+    Value lr = adamOp.getLearningRate();
+    Value step = adamOp.getStepSize();
+
+    buildElementwiseLoopNest(
+        rewriter, loc, adamOp.getParam(),
+        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+          Value grad =
+              b.create<memref::LoadOp>(loc, adamOp.getGrad(), localIvs);
+          Value param =
+              b.create<memref::LoadOp>(loc, adamOp.getParam(), localIvs);
+          Value m = b.create<memref::LoadOp>(loc, adamOp.getM(), localIvs);
+          Value v = b.create<memref::LoadOp>(loc, adamOp.getV(), localIvs);
+          // m = beta1 * m + (1 - beta1) * grad
+          m = b.create<arith::AddFOp>(
+              loc, b.create<arith::MulFOp>(loc, beta1Val, m),
+              b.create<arith::MulFOp>(loc, oneMinusBeta1, grad));
+          // v = beta2 * v + (1 - beta2) * grad * grad
+          Value gradSquare = b.create<arith::MulFOp>(loc, grad, grad);
+          v = b.create<arith::AddFOp>(
+              loc, b.create<arith::MulFOp>(loc, beta2Val, v),
+              b.create<arith::MulFOp>(loc, oneMinusBeta2, gradSquare));
+          // param -= lr * weight_decay * param
+          //        + step * m / (sqrt(v) + epsilon)
+          Value denom = b.create<arith::AddFOp>(
+              loc, b.create<math::SqrtOp>(loc, v), epsilon);
+          Value decay = b.create<arith::MulFOp>(
+              loc, lr, b.create<arith::MulFOp>(loc, weightDecay, param));
+          Value update = b.create<arith::MulFOp>(
+              loc, step, b.create<arith::DivFOp>(loc, m, denom));
+          param = b.create<arith::SubFOp>(
+              loc, param, b.create<arith::AddFOp>(loc, decay, update));
+          b.create<memref::StoreOp>(loc, m, adamOp.getM(), localIvs);
+          b.create<memref::StoreOp>(loc, v, adamOp.getV(), localIvs);
+          b.create<memref::StoreOp>(loc, param, adamOp.getParam(), localIvs);
+        });
+
+    rewriter.eraseOp(adamOp);
+    return success();
+  }
+};
+
 // Convert matmul to loops.
 struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
   using OpRewritePattern<MatmulOp>::OpRewritePattern;
@@ -215,14 +370,14 @@ struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
   LogicalResult matchAndRewrite(MatmulOp matmulOp,
                                 PatternRewriter &rewriter) const override {
     Location loc = matmulOp.getLoc();
-    ArrayRef<int64_t> shapeC = matmulOp.getMatrixCType().getShape();
     ArrayRef<int64_t> shapeA =
         matmulOp.getMatrixA().getType().cast<MemRefType>().getShape();
     if (shapeA.size() == 3)
       return rewriter.notifyMatchFailure(matmulOp, "Packed BF16 loops unsupported");
-    Value i = rewriter.create<arith::ConstantIndexOp>(loc, shapeC[0]);
-    Value j = rewriter.create<arith::ConstantIndexOp>(loc, shapeC[1]);
-    Value k = rewriter.create<arith::ConstantIndexOp>(loc, shapeA[1]);
+    // The outer dimensions may be dynamic, read the bounds from the operands
+    Value i = rewriter.create<memref::DimOp>(loc, matmulOp.getMatrixC(), 0);
+    Value j = rewriter.create<memref::DimOp>(loc, matmulOp.getMatrixC(), 1);
+    Value k = rewriter.create<memref::DimOp>(loc, matmulOp.getMatrixA(), 1);
     SmallVector<Value> ubs = {i, j, k};
     Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
     SmallVector<Value> lbs = {zero, zero, zero};
@@ -259,12 +414,13 @@ struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
   LogicalResult matchAndRewrite(BrgemmOp brgemmOp,
                                 PatternRewriter &rewriter) const override {
     Location loc = brgemmOp.getLoc();
-    ArrayRef<int64_t> shapeC = brgemmOp.getMatrixCType().getShape();
-    ArrayRef<int64_t> shapeA = brgemmOp.getBatchMatrixAType().getShape();
-    Value i = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeC[0]);
-    Value j = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeC[1]);
-    Value k = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeA[2]);
-    Value b = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeA[0]);
+    // The outer dimensions may be dynamic, read the bounds from the operands
+    Value matrixC = brgemmOp.getMatrixC();
+    Value batchA = brgemmOp.getBatchMatrixA();
+    Value i = rewriter.createOrFold<memref::DimOp>(loc, matrixC, 0);
+    Value j = rewriter.createOrFold<memref::DimOp>(loc, matrixC, 1);
+    Value k = rewriter.createOrFold<memref::DimOp>(loc, batchA, 2);
+    Value b = rewriter.createOrFold<memref::DimOp>(loc, batchA, 0);
     SmallVector<Value> ubs = {b, i, j, k};
     Value zero = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 0);
     SmallVector<Value> lbs = {zero, zero, zero, zero};
@@ -297,20 +453,207 @@ struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
   }
 };
 
-void populateTppToLoopsPatterns(RewritePatternSet &patterns) {
-  // clang-format off
-  patterns.add<ConvertTppAddOp, 
-               ConvertTppIdentityOp,
-               ConvertTppMatmulOp,
-               ConvertTppBrgemmOp,
-               ConvertTppReluOp>(patterns.getContext());
-  // clang-format on
+// C(i, j) += zext(A(i, k0 * 4 + k1)) * sext(B(k0, j, k1)), A is unsigned, B
+// is signed and in VNNI4 format.
+static void buildQuantizedMacc(OpBuilder &b, Location loc, Value matrixA,
+                               ValueRange indicesA, Value matrixB,
+                               ValueRange indicesB, Value matrixC,
+                               ValueRange indicesC) {
+  Type i32 = b.getI32Type();
+  Value scalarA = b.create<memref::LoadOp>(loc, matrixA, indicesA);
+  Value scalarB = b.create<memref::LoadOp>(loc, matrixB, indicesB);
+  Value scalarC = b.create<memref::LoadOp>(loc, matrixC, indicesC);
+  scalarA = b.create<arith::ExtUIOp>(loc, i32, scalarA);
+  scalarB = b.create<arith::ExtSIOp>(loc, i32, scalarB);
+  Value scalarMul = b.create<arith::MulIOp>(loc, scalarA, scalarB);
+  Value scalarAdd = b.create<arith::AddIOp>(loc, scalarC, scalarMul);
+  b.create<memref::StoreOp>(loc, scalarAdd, matrixC, indicesC);
 }
 
+struct ConvertTppQuantizedMatmulOp
+    : public OpRewritePattern<QuantizedMatmulOp> {
+  using OpRewritePattern<QuantizedMatmulOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(QuantizedMatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = matmulOp.getLoc();
+    ArrayRef<int64_t> shapeC = matmulOp.getMatrixCType().getShape();
+    ArrayRef<int64_t> shapeB = matmulOp.getMatrixBType().getShape();
+    Value i = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeC[0]);
+    Value j = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeC[1]);
+    Value k0 = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeB[0]);
+    Value k1 = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeB[2]);
+    SmallVector<Value> ubs = {i, j, k0, k1};
+    Value zero = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 0);
+    SmallVector<Value> lbs = {zero, zero, zero, zero};
+    Value one = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 1);
+    SmallVector<Value> steps = {one, one, one, one};
+
+    (void)scf::buildLoopNest(
+        rewriter, loc, lbs, ubs, steps,
+        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+          assert(localIvs.size() == 4);
+          Value localI = localIvs[0];
+          Value localJ = localIvs[1];
+          Value localK0 = localIvs[2];
+          Value localK1 = localIvs[3];
+          Value localK = b.create<arith::AddIOp>(
+              loc, b.create<arith::MulIOp>(loc, localK0, k1), localK1);
+          buildQuantizedMacc(b, loc, matmulOp.getMatrixA(), {localI, localK},
+                             matmulOp.getMatrixB(), {localK0, localJ, localK1},
+                             matmulOp.getMatrixC(), {localI, localJ});
+        });
+    rewriter.eraseOp(matmulOp);
+    return success();
+  }
+};
+
+struct ConvertTppQuantizedBrgemmOp
+    : public OpRewritePattern<QuantizedBrgemmOp> {
+  using OpRewritePattern<QuantizedBrgemmOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(QuantizedBrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = brgemmOp.getLoc();
+    ArrayRef<int64_t> shapeC = brgemmOp.getMatrixCType().getShape();
+    ArrayRef<int64_t> shapeB = brgemmOp.getBatchMatrixBType().getShape();
+    Value batch =
+        rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeB[0]);
+    Value i = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeC[0]);
+    Value j = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeC[1]);
+    Value k0 = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeB[1]);
+    Value k1 = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeB[3]);
+    SmallVector<Value> ubs = {batch, i, j, k0, k1};
+    Value zero = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 0);
+    SmallVector<Value> lbs = {zero, zero, zero, zero, zero};
+    Value one = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 1);
+    SmallVector<Value> steps = {one, one, one, one, one};
+
+    (void)scf::buildLoopNest(
+        rewriter, loc, lbs, ubs, steps,
+        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+          assert(localIvs.size() == 5);
+          Value localB = localIvs[0];
+          Value localI = localIvs[1];
+          Value localJ = localIvs[2];
+          Value localK0 = localIvs[3];
+          Value localK1 = localIvs[4];
+          Value localK = b.create<arith::AddIOp>(
+              loc, b.create<arith::MulIOp>(loc, localK0, k1), localK1);
+          buildQuantizedMacc(
+              b, loc, brgemmOp.getBatchMatrixA(), {localB, localI, localK},
+              brgemmOp.getBatchMatrixB(), {localB, localK0, localJ, localK1},
+              brgemmOp.getMatrixC(), {localI, localJ});
+        });
+    rewriter.eraseOp(brgemmOp);
+    return success();
+  }
+};
+
+//
+// tpp.requantize ins(%acc) out(%out)
+//
+// Converts to:
+//
+// scf.for %i, %j
+//   %0 = sitofp %acc[%i, %j]
+//   %1 = round(%0 * scale) + zero_point
+//   %2 = clamp(%1, min, max)
+//   %out[%i, %j] = trunci(fptosi %2)
+//
+// The clamp is done in f32, so that the conversion never overflows.
+struct ConvertTppRequantizeOp : public OpRewritePattern<RequantizeOp> {
+  using OpRewritePattern<RequantizeOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(RequantizeOp requantizeOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = requantizeOp.getLoc();
+    auto getConstant = [&](float value) -> Value {
+      return rewriter.create<arith::ConstantOp>(
+          loc, rewriter.getF32FloatAttr(value));
+    };
+    Value scale =
+        rewriter.create<arith::ConstantOp>(loc, requantizeOp.getScaleAttr());
+    Value zeroPoint = getConstant(requantizeOp.getZeroPointAttr().getInt());
+    Value min = getConstant(requantizeOp.getMinAttr().getInt());
+    Value max = getConstant(requantizeOp.getMaxAttr().getInt());
+
+    buildElementwiseLoopNest(
+        rewriter, loc, requantizeOp.getOutput(),
+        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+          Value acc =
+              b.create<memref::LoadOp>(loc, requantizeOp.getInput(), localIvs);
+          Value value = b.create<arith::SIToFPOp>(loc, b.getF32Type(), acc);
+          value = b.create<arith::MulFOp>(loc, value, scale);
+          value = b.create<math::RoundOp>(loc, value);
+          value = b.create<arith::AddFOp>(loc, value, zeroPoint);
+          value = b.create<arith::MaxFOp>(loc, value, min);
+          value = b.create<arith::MinFOp>(loc, value, max);
+          value = b.create<arith::FPToSIOp>(loc, b.getI32Type(), value);
+          value = b.create<arith::TruncIOp>(loc, b.getI8Type(), value);
+          b.create<memref::StoreOp>(loc, value, requantizeOp.getOutput(),
+                                    localIvs);
+        });
+
+    rewriter.eraseOp(requantizeOp);
+    return success();
+  }
+};
+
+// C(i, j) += A(indices(b), i, k) * B(b, k, j). The batch is the number of
+// non-zero blocks and is only known at runtime.
+struct ConvertTppSparseBrgemmOp : public OpRewritePattern<SparseBrgemmOp> {
+  using OpRewritePattern<SparseBrgemmOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(SparseBrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = brgemmOp.getLoc();
+    Value matrixC = brgemmOp.getMatrixC();
+    Value i = rewriter.createOrFold<memref::DimOp>(loc, matrixC, 0);
+    Value j = rewriter.createOrFold<memref::DimOp>(loc, matrixC, 1);
+    Value k = rewriter.createOrFold<memref::DimOp>(
+        loc, brgemmOp.getBatchMatrixA(), 2);
+    Value b = rewriter.createOrFold<memref::DimOp>(
+        loc, brgemmOp.getBatchMatrixB(), 0);
+    SmallVector<Value> ubs = {b, i, j, k};
+    Value zero = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 0);
+    SmallVector<Value> lbs = {zero, zero, zero, zero};
+    Value one = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 1);
+    SmallVector<Value> steps = {one, one, one, one};
+
+    (void)scf::buildLoopNest(
+        rewriter, loc, lbs, ubs, steps,
+        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+          assert(localIvs.size() == 4);
+          Value localB = localIvs[0];
+          Value localI = localIvs[1];
+          Value localJ = localIvs[2];
+          Value localK = localIvs[3];
+          Value blockA = b.create<memref::LoadOp>(loc, brgemmOp.getIndices(),
+                                                  ValueRange{localB});
+          blockA = b.create<arith::IndexCastOp>(loc, b.getIndexType(), blockA);
+          Value scalarA =
+              b.create<memref::LoadOp>(loc, brgemmOp.getBatchMatrixA(),
+                                       ValueRange{blockA, localI, localK});
+          Value scalarB =
+              b.create<memref::LoadOp>(loc, brgemmOp.getBatchMatrixB(),
+                                       ValueRange{localB, localK, localJ});
+          Value scalarC = b.create<memref::LoadOp>(loc, brgemmOp.getMatrixC(),
+                                                   ValueRange{localI, localJ});
+          Value scalarMul = b.create<arith::MulFOp>(loc, scalarA, scalarB);
+          Value scalarAdd = b.create<arith::AddFOp>(loc, scalarC, scalarMul);
+          b.create<memref::StoreOp>(loc, scalarAdd, brgemmOp.getMatrixC(),
+                                    ValueRange{localI, localJ});
+        });
+    rewriter.eraseOp(brgemmOp);
+    return success();
+  }
+};
+
 struct ConvertTppToLoops : public ConvertTppToLoopsBase<ConvertTppToLoops> {
   void runOnOperation() override {
     RewritePatternSet patterns(&getContext());
-    populateTppToLoopsPatterns(patterns);
+    tpp::populateTppToLoopsPatterns(patterns);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
@@ -318,6 +661,28 @@ struct ConvertTppToLoops : public ConvertTppToLoopsBase<ConvertTppToLoops> {
 
 } // namespace
 
+void mlir::tpp::populateTppToLoopsPatterns(RewritePatternSet &patterns) {
+  // clang-format off
+  patterns.add<ConvertTppAddOp, 
+               ConvertTppIdentityOp,
+               ConvertTppMatmulOp,
+               ConvertTppBrgemmOp,
+               ConvertTppReluOp,
+               ConvertTppReluBackwardOp,
+               ConvertTppQuantizedMatmulOp,
+               ConvertTppQuantizedBrgemmOp,
+               ConvertTppRequantizeOp,
+               ConvertTppSparseBrgemmOp>(patterns.getContext());
+  // clang-format on
+  populateTppOptimizerToLoopsPatterns(patterns);
+}
+
+void mlir::tpp::populateTppOptimizerToLoopsPatterns(
+    RewritePatternSet &patterns) {
+  patterns.add<ConvertTppSgdUpdateOp, ConvertTppAdamUpdateOp>(
+      patterns.getContext());
+}
+
 std::unique_ptr<OperationPass<func::FuncOp>>
 mlir::tpp::createConvertTppToLoopsPass() {
   return std::make_unique<ConvertTppToLoops>();
@@ -0,0 +1,503 @@
+//===- ConvertTppToVector.cpp -----------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Dialect/Tpp/TppOps.h"
+#include "TPP/Passes.h"
+#include "TPP/Transforms.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+using namespace mlir;
+using namespace mlir::tpp;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+namespace {
+
+// Register tile used when none is given: 4 rows of C by 16 columns (one
+// 512-bit vector of f32), one k per step.
+constexpr int64_t kDefaultRegisterTile[] = {4, 16, 1};
+
+static Value createIndex(OpBuilder &b, Location loc, int64_t value) {
+  return b.create<arith::ConstantIndexOp>(loc, value);
+}
+
+// Reads the vector of 'operand' at the output indices 'ivs', along the
+// innermost dimension. Scalars, lower ranks and dimensions of size 1 are
+// broadcast, the same way tpp.identity broadcasts.
+static Value readOperand(OpBuilder &b, Location loc, Value operand,
+                         ArrayRef<int64_t> outShape, ValueRange ivs,
+                         VectorType vecType) {
+  auto memrefType = operand.getType().dyn_cast<MemRefType>();
+  if (!memrefType)
+    return b.create<vector::BroadcastOp>(loc, vecType, operand);
+
+  ArrayRef<int64_t> inShape = memrefType.getShape();
+  size_t offset = outShape.size() - inShape.size();
+  Value zero = createIndex(b, loc, 0);
+  SmallVector<Value> indices;
+  for (size_t idx = 0; idx < inShape.size(); idx++) {
+    bool broadcast = inShape[idx] == 1 && outShape[idx + offset] != 1;
+    indices.push_back(broadcast ? zero : ivs[idx + offset]);
+  }
+  if (inShape.empty() || (inShape.back() == 1 && outShape.back() != 1)) {
+    Value scalar = b.create<memref::LoadOp>(loc, operand, indices);
+    return b.create<vector::BroadcastOp>(loc, vecType, scalar);
+  }
+  bool inBounds = outShape.back() % vecType.getDimSize(0) == 0;
+  return b.create<vector::TransferReadOp>(
+      loc, vecType, operand, indices,
+      AffineMap::getMinorIdentityMap(inShape.size(), 1, b.getContext()),
+      ArrayRef<bool>{inBounds});
+}
+
+// Rewrites an element-wise operation writing 'output' to vectors of 'width'
+// elements along the innermost dimension. 'compute' returns the vector to
+// store at the output indices. The tail, if 'width' does not divide the
+// innermost dimension, is read padded and written masked.
+static void buildElementwise(
+    OpBuilder &builder, Location loc, Value output, int64_t width,
+    function_ref<Value(OpBuilder &, Location, ValueRange, VectorType)>
+        compute) {
+  auto outType = output.getType().cast<MemRefType>();
+  ArrayRef<int64_t> shape = outType.getShape();
+  VectorType vecType = VectorType::get({width}, outType.getElementType());
+
+  SmallVector<Value> ubs;
+  for (int64_t dim : shape)
+    ubs.push_back(createIndex(builder, loc, dim));
+  Value zero = createIndex(builder, loc, 0);
+  SmallVector<Value> lbs(shape.size(), zero);
+  SmallVector<Value> steps(shape.size(), createIndex(builder, loc, 1));
+  steps.back() = createIndex(builder, loc, width);
+  bool inBounds = shape.back() % width == 0;
+
+  (void)scf::buildLoopNest(
+      builder, loc, lbs, ubs, steps,
+      [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+        Value result = compute(b, loc, localIvs, vecType);
+        b.create<vector::TransferWriteOp>(
+            loc, result, output, localIvs,
+            AffineMap::getMinorIdentityMap(shape.size(), 1, b.getContext()),
+            ArrayRef<bool>{inBounds});
+      });
+}
+
+static bool isVectorizable(Value output) {
+  auto memrefType = output.getType().dyn_cast<MemRefType>();
+  return memrefType && memrefType.hasStaticShape() &&
+         memrefType.getRank() > 0 &&
+         memrefType.getElementType().isa<FloatType>();
+}
+
+//
+// tpp.add ins(%a) out(%b)
+//
+// Converts to:
+//
+// scf.for %i
+//   scf.for %j step W
+//     %0 = vector.transfer_read %a[%i, %j] : vector<W>
+//     %1 = vector.transfer_read %b[%i, %j] : vector<W>
+//     %2 = arith.addf %0, %1
+//     vector.transfer_write %2, %b[%i, %j]
+//
+struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
+  ConvertTppAddOp(MLIRContext *context, int64_t width)
+      : OpRewritePattern<AddOp>(context, /*benefit=*/2), width(width) {}
+
+  LogicalResult matchAndRewrite(AddOp addOp,
+                                PatternRewriter &rewriter) const override {
+    if (!isVectorizable(addOp.getOutput()))
+      return rewriter.notifyMatchFailure(addOp, "Expect static float memref");
+    ArrayRef<int64_t> shape =
+        addOp.getOutput().getType().cast<MemRefType>().getShape();
+    buildElementwise(
+        rewriter, addOp.getLoc(), addOp.getOutput(), width,
+        [&](OpBuilder &b, Location loc, ValueRange ivs, VectorType vecType) {
+          Value lhs =
+              readOperand(b, loc, addOp.getLhs(), shape, ivs, vecType);
+          Value rhs =
+              readOperand(b, loc, addOp.getRhs(), shape, ivs, vecType);
+          return b.create<arith::AddFOp>(loc, lhs, rhs);
+        });
+    rewriter.eraseOp(addOp);
+    return success();
+  }
+
+  int64_t width;
+};
+
+// Converts identity op, broadcasting the input.
+struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
+  ConvertTppIdentityOp(MLIRContext *context, int64_t width)
+      : OpRewritePattern<IdentityOp>(context, /*benefit=*/2), width(width) {}
+
+  LogicalResult matchAndRewrite(IdentityOp identityOp,
+                                PatternRewriter &rewriter) const override {
+    if (!isVectorizable(identityOp.getOutput()))
+      return rewriter.notifyMatchFailure(identityOp,
+                                         "Expect static float memref");
+    ArrayRef<int64_t> shape =
+        identityOp.getOutput().getType().cast<MemRefType>().getShape();
+    buildElementwise(
+        rewriter, identityOp.getLoc(), identityOp.getOutput(), width,
+        [&](OpBuilder &b, Location loc, ValueRange ivs, VectorType vecType) {
+          return readOperand(b, loc, identityOp.getInput(), shape, ivs,
+                             vecType);
+        });
+    rewriter.eraseOp(identityOp);
+    return success();
+  }
+
+  int64_t width;
+};
+
+// Convert relu to a vector max with zero.
+struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
+  ConvertTppReluOp(MLIRContext *context, int64_t width)
+      : OpRewritePattern<ReluOp>(context, /*benefit=*/2), width(width) {}
+
+  LogicalResult matchAndRewrite(ReluOp reluOp,
+                                PatternRewriter &rewriter) const override {
+    if (!isVectorizable(reluOp.getOutput()))
+      return rewriter.notifyMatchFailure(reluOp, "Expect static float memref");
+    ArrayRef<int64_t> shape =
+        reluOp.getOutput().getType().cast<MemRefType>().getShape();
+    buildElementwise(
+        rewriter, reluOp.getLoc(), reluOp.getOutput(), width,
+        [&](OpBuilder &b, Location loc, ValueRange ivs, VectorType vecType) {
+          Value input =
+              readOperand(b, loc, reluOp.getOutput(), shape, ivs, vecType);
+          Value zero =
+              b.create<arith::ConstantOp>(loc, b.getZeroAttr(vecType));
+          return b.create<arith::MaxFOp>(loc, input, zero);
+        });
+    rewriter.eraseOp(reluOp);
+    return success();
+  }
+
+  int64_t width;
+};
+
+// Convert relu backward to a vector select of the gradient or zero.
+struct ConvertTppReluBackwardOp : public OpRewritePattern<ReluBackwardOp> {
+  ConvertTppReluBackwardOp(MLIRContext *context, int64_t width)
+      : OpRewritePattern<ReluBackwardOp>(context, /*benefit=*/2),
+        width(width) {}
+
+  LogicalResult matchAndRewrite(ReluBackwardOp reluOp,
+                                PatternRewriter &rewriter) const override {
+    if (!isVectorizable(reluOp.getOutput()) ||
+        !isVectorizable(reluOp.getGrad()) ||
+        !isVectorizable(reluOp.getInput()))
+      return rewriter.notifyMatchFailure(reluOp, "Expect static float memref");
+    ArrayRef<int64_t> shape =
+        reluOp.getOutput().getType().cast<MemRefType>().getShape();
+    buildElementwise(
+        rewriter, reluOp.getLoc(), reluOp.getOutput(), width,
+        [&](OpBuilder &b, Location loc, ValueRange ivs, VectorType vecType) {
+          Value grad =
+              readOperand(b, loc, reluOp.getGrad(), shape, ivs, vecType);
+          Value input =
+              readOperand(b, loc, reluOp.getInput(), shape, ivs, vecType);
+          Value zero =
+              b.create<arith::ConstantOp>(loc, b.getZeroAttr(vecType));
+          Value mask = b.create<arith::CmpFOp>(loc, arith::CmpFPredicate::OGT,
+                                               input, zero);
+          return b.create<arith::SelectOp>(loc, mask, grad, zero);
+        });
+    rewriter.eraseOp(reluOp);
+    return success();
+  }
+
+  int64_t width;
+};
+
+// Convert requantize to vectors of f32: scale, round, shift by the zero
+// point and clamp, then narrow to int8. Following the GEMM on the same tile,
+// it reads the accumulator while it is still in cache.
+struct ConvertTppRequantizeOp : public OpRewritePattern<RequantizeOp> {
+  ConvertTppRequantizeOp(MLIRContext *context, int64_t width)
+      : OpRewritePattern<RequantizeOp>(context, /*benefit=*/2), width(width) {}
+
+  LogicalResult matchAndRewrite(RequantizeOp requantizeOp,
+                                PatternRewriter &rewriter) const override {
+    ArrayRef<int64_t> shape =
+        requantizeOp.getOutput().getType().cast<MemRefType>().getShape();
+    buildElementwise(
+        rewriter, requantizeOp.getLoc(), requantizeOp.getOutput(), width,
+        [&](OpBuilder &b, Location loc, ValueRange ivs, VectorType vecType) {
+          VectorType accType = VectorType::get({width}, b.getI32Type());
+          VectorType floatType = VectorType::get({width}, b.getF32Type());
+          auto getSplat = [&](float value) -> Value {
+            return b.create<arith::ConstantOp>(
+                loc, DenseElementsAttr::get(floatType, value));
+          };
+          Value acc = readOperand(b, loc, requantizeOp.getInput(), shape, ivs,
+                                  accType);
+          Value value = b.create<arith::SIToFPOp>(loc, floatType, acc);
+          value = b.create<arith::MulFOp>(
+              loc, value,
+              getSplat(requantizeOp.getScale().convertToFloat()));
+          value = b.create<math::RoundOp>(loc, value);
+          value = b.create<arith::AddFOp>(
+              loc, value, getSplat(requantizeOp.getZeroPointAttr().getInt()));
+          value = b.create<arith::MaxFOp>(
+              loc, value, getSplat(requantizeOp.getMinAttr().getInt()));
+          value = b.create<arith::MinFOp>(
+              loc, value, getSplat(requantizeOp.getMaxAttr().getInt()));
+          // Through i32: [128, 255] does not fit a signed i8.
+          value = b.create<arith::FPToSIOp>(loc, accType, value);
+          return b.create<arith::TruncIOp>(loc, vecType, value);
+        });
+    rewriter.eraseOp(requantizeOp);
+    return success();
+  }
+
+  int64_t width;
+};
+
+//
+// Register-blocked micro-kernel for C += A * B, with an optional batch
+// dimension on A and B (BRGEMM):
+//
+// scf.for %i step TM
+//   scf.for %j step TN
+//     %acc = vector.transfer_read %C[%i, %j] : vector<TMxTN>
+//     %res = scf.for %b, %k step TK iter_args(%acc)
+//       %a = vector.transfer_read %A[%b, %i, %k] : vector<TM> (column)
+//       %b = vector.transfer_read %B[%b, %k, %j] : vector<TN> (row)
+//       vector.outerproduct %a, %b, %acc
+//     vector.transfer_write %res, %C[%i, %j]
+//
+// The C tile stays in registers across the whole reduction. The outer
+// product lowers to TM broadcasts and FMAs. Tails of M and N are read padded
+// and written masked. If TK does not divide K, k is not unrolled. Types
+// narrower than f32 (bf16) are extended on read and accumulate in f32, C is
+// truncated once, when it is written back.
+//
+static LogicalResult buildMicroKernels(RewriterBase &rewriter,
+                                       Operation *op, Value matA, Value matB,
+                                       Value matC,
+                                       ArrayRef<int64_t> registerTile) {
+  auto typeA = matA.getType().dyn_cast<MemRefType>();
+  auto typeB = matB.getType().dyn_cast<MemRefType>();
+  auto typeC = matC.getType().dyn_cast<MemRefType>();
+  if (!typeA || !typeB || !typeC || !typeA.hasStaticShape() ||
+      !typeB.hasStaticShape() || !typeC.hasStaticShape())
+    return rewriter.notifyMatchFailure(op, "Expect static memrefs");
+  if (typeA.getRank() != typeB.getRank() || typeC.getRank() != 2)
+    return rewriter.notifyMatchFailure(op, "VNNI layout unsupported");
+  Type elementType = typeC.getElementType();
+  if (!elementType.isa<FloatType>() ||
+      typeA.getElementType() != elementType ||
+      typeB.getElementType() != elementType)
+    return rewriter.notifyMatchFailure(op, "Expect the same float type");
+
+  Location loc = op->getLoc();
+  MLIRContext *ctx = rewriter.getContext();
+  int64_t rank = typeA.getRank();
+  bool batched = rank == 3;
+  int64_t m = typeC.getShape()[0];
+  int64_t n = typeC.getShape()[1];
+  int64_t k = typeA.getShape().back();
+  int64_t tm = registerTile[0], tn = registerTile[1], tk = registerTile[2];
+  if (k % tk != 0)
+    tk = 1;
+  bool mInBounds = m % tm == 0;
+  bool nInBounds = n % tn == 0;
+
+  Type accElementType = elementType.getIntOrFloatBitWidth() < 32
+                            ? rewriter.getF32Type()
+                            : elementType;
+  VectorType accType = VectorType::get({tm, tn}, accElementType);
+  VectorType colType = VectorType::get({tm}, elementType);
+  VectorType rowType = VectorType::get({tn}, elementType);
+  auto extend = [&](OpBuilder &b, Location loc, Value vector) -> Value {
+    if (accElementType == elementType)
+      return vector;
+    auto type = vector.getType().cast<VectorType>();
+    return b.create<arith::ExtFOp>(
+        loc, VectorType::get(type.getShape(), accElementType), vector);
+  };
+  // A column of A is read along i, a row of B along j.
+  AffineMap colMap =
+      AffineMap::get(rank, 0, rewriter.getAffineDimExpr(rank - 2), ctx);
+  AffineMap rowMap = AffineMap::getMinorIdentityMap(rank, 1, ctx);
+
+  Value zero = createIndex(rewriter, loc, 0);
+  SmallVector<Value> lbs = {zero, zero};
+  SmallVector<Value> ubs = {createIndex(rewriter, loc, m),
+                            createIndex(rewriter, loc, n)};
+  SmallVector<Value> steps = {createIndex(rewriter, loc, tm),
+                              createIndex(rewriter, loc, tn)};
+
+  SmallVector<Value> redLbs = {zero};
+  SmallVector<Value> redUbs = {createIndex(rewriter, loc, k)};
+  SmallVector<Value> redSteps = {createIndex(rewriter, loc, tk)};
+  if (batched) {
+    redLbs.insert(redLbs.begin(), zero);
+    redUbs.insert(redUbs.begin(),
+                  createIndex(rewriter, loc, typeA.getShape()[0]));
+    redSteps.insert(redSteps.begin(), createIndex(rewriter, loc, 1));
+  }
+
+  (void)scf::buildLoopNest(
+      rewriter, loc, lbs, ubs, steps,
+      [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+        Value localI = localIvs[0];
+        Value localJ = localIvs[1];
+        Value acc = b.create<vector::TransferReadOp>(
+            loc, VectorType::get({tm, tn}, elementType), matC,
+            ValueRange{localI, localJ}, b.getMultiDimIdentityMap(2),
+            ArrayRef<bool>{mInBounds, nInBounds});
+        acc = extend(b, loc, acc);
+
+        scf::LoopNest reduction = scf::buildLoopNest(
+            b, loc, redLbs, redUbs, redSteps, ValueRange{acc},
+            [&](OpBuilder &b, Location loc, ValueRange redIvs,
+                ValueRange iterArgs) -> scf::ValueVector {
+              Value tile = iterArgs[0];
+              SmallVector<Value> batch;
+              if (batched)
+                batch.push_back(redIvs[0]);
+              for (int64_t kk = 0; kk < tk; kk++) {
+                Value localK = redIvs.back();
+                if (kk > 0)
+                  localK = b.create<arith::AddIOp>(loc, localK,
+                                                   createIndex(b, loc, kk));
+                SmallVector<Value> indicesA(batch), indicesB(batch);
+                indicesA.append({localI, localK});
+                indicesB.append({localK, localJ});
+                Value col = b.create<vector::TransferReadOp>(
+                    loc, colType, matA, indicesA, colMap,
+                    ArrayRef<bool>{mInBounds});
+                Value row = b.create<vector::TransferReadOp>(
+                    loc, rowType, matB, indicesB, rowMap,
+                    ArrayRef<bool>{nInBounds});
+                col = extend(b, loc, col);
+                row = extend(b, loc, row);
+                tile = b.create<vector::OuterProductOp>(
+                            loc, TypeRange{accType}, ValueRange{col, row, tile},
+                            ArrayRef<NamedAttribute>{})
+                           .getResult();
+              }
+              return {tile};
+            });
+
+        Value result = reduction.loops.front().getResult(0);
+        if (accElementType != elementType)
+          result = b.create<arith::TruncFOp>(
+              loc, VectorType::get({tm, tn}, elementType), result);
+        b.create<vector::TransferWriteOp>(
+            loc, result, matC, ValueRange{localI, localJ},
+            b.getMultiDimIdentityMap(2),
+            ArrayRef<bool>{mInBounds, nInBounds});
+      });
+  rewriter.eraseOp(op);
+  return success();
+}
+
+struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
+  ConvertTppMatmulOp(MLIRContext *context, ArrayRef<int64_t> registerTile)
+      : OpRewritePattern<MatmulOp>(context, /*benefit=*/2),
+        registerTile(registerTile.begin(), registerTile.end()) {}
+
+  LogicalResult matchAndRewrite(MatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    return buildMicroKernels(rewriter, matmulOp, matmulOp.getMatrixA(),
+                             matmulOp.getMatrixB(), matmulOp.getMatrixC(),
+                             registerTile);
+  }
+
+  SmallVector<int64_t, 3> registerTile;
+};
+
+struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
+  ConvertTppBrgemmOp(MLIRContext *context, ArrayRef<int64_t> registerTile)
+      : OpRewritePattern<BrgemmOp>(context, /*benefit=*/2),
+        registerTile(registerTile.begin(), registerTile.end()) {}
+
+  LogicalResult matchAndRewrite(BrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    return buildMicroKernels(rewriter, brgemmOp, brgemmOp.getBatchMatrixA(),
+                             brgemmOp.getBatchMatrixB(),
+                             brgemmOp.getMatrixC(), registerTile);
+  }
+
+  SmallVector<int64_t, 3> registerTile;
+};
+
+struct ConvertTppToVector : public ConvertTppToVectorBase<ConvertTppToVector> {
+  ConvertTppToVector() = default;
+  ConvertTppToVector(ArrayRef<int64_t> registerTile) {
+    this->registerTile = registerTile;
+  }
+
+  void runOnOperation() override {
+    SmallVector<int64_t> tile(registerTile.begin(), registerTile.end());
+    if (tile.empty())
+      tile.assign(std::begin(kDefaultRegisterTile),
+                  std::end(kDefaultRegisterTile));
+    if (tile.size() != 3 || llvm::any_of(tile, [](int64_t t) {
+          return t <= 0;
+        })) {
+      getOperation().emitError("Expect three positive register tile sizes");
+      return signalPassFailure();
+    }
+
+    RewritePatternSet patterns(&getContext());
+    // clang-format off
+    patterns.add<ConvertTppAddOp,
+                 ConvertTppIdentityOp,
+                 ConvertTppReluOp,
+                 ConvertTppReluBackwardOp,
+                 ConvertTppRequantizeOp>(patterns.getContext(), tile[1]);
+    patterns.add<ConvertTppMatmulOp,
+                 ConvertTppBrgemmOp>(patterns.getContext(), tile);
+    // clang-format on
+    // Scalar operands and the VNNI layout go to loops.
+    tpp::populateTppToLoopsPatterns(patterns);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+    return;
+  }
+};
+
+} // namespace
+
+LogicalResult
+mlir::tpp::lowerToVectorMicroKernels(RewriterBase &rewriter, Operation *op,
+                                     ArrayRef<int64_t> registerTile) {
+  assert(registerTile.size() == 3 && "expect TM, TN and TK");
+  if (auto matmulOp = dyn_cast<MatmulOp>(op))
+    return buildMicroKernels(rewriter, op, matmulOp.getMatrixA(),
+                             matmulOp.getMatrixB(), matmulOp.getMatrixC(),
+                             registerTile);
+  if (auto brgemmOp = dyn_cast<BrgemmOp>(op))
+    return buildMicroKernels(rewriter, op, brgemmOp.getBatchMatrixA(),
+                             brgemmOp.getBatchMatrixB(),
+                             brgemmOp.getMatrixC(), registerTile);
+  return failure();
+}
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createConvertTppToVectorPass() {
+  return std::make_unique<ConvertTppToVector>();
+}
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createConvertTppToVectorPass(ArrayRef<int64_t> registerTile) {
+  return std::make_unique<ConvertTppToVector>(registerTile);
+}
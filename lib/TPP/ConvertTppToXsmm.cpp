@@ -15,6 +15,7 @@
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Dialect/Utils/ReshapeOpsUtils.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -32,14 +33,31 @@ static FailureOr<int64_t> getLeadingDim(MemRefType memref, size_t pos = 0) {
   int64_t offset;
   if (failed(getStridesAndOffset(memref, strides, offset)))
     return failure();
-  // fail if the strides are non-constant
-  if (llvm::any_of(strides, [](int64_t stride) {
-        return stride == ShapedType::kDynamic;
-      }))
+  // fail if the stride is non-constant
+  if (ShapedType::isDynamic(strides[pos]))
     return failure();
   return strides[pos];
 }
 
+// Size 'dim' of 'memref' at runtime, as i64.
+static Value getDynamicDim(Location loc, Value memref, int64_t dim,
+                           PatternRewriter &rewriter) {
+  Value size = rewriter.create<memref::DimOp>(loc, memref, dim);
+  return rewriter.create<arith::IndexCastOp>(loc, rewriter.getI64Type(), size);
+}
+
+// Append size 'dim' of 'memref' to the dispatch inputs. A dynamic size stays
+// dynamic in the inputs and is passed to the dispatch as an operand.
+static void appendDim(Location loc, Value memref, int64_t dim,
+                      SmallVectorImpl<int64_t> &inputs,
+                      SmallVectorImpl<Value> &dynamicInputs,
+                      PatternRewriter &rewriter) {
+  int64_t size = memref.getType().cast<MemRefType>().getShape()[dim];
+  inputs.push_back(size);
+  if (ShapedType::isDynamic(size))
+    dynamicInputs.push_back(getDynamicDim(loc, memref, dim, rewriter));
+}
+
 struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
   using OpRewritePattern<MatmulOp>::OpRewritePattern;
 
@@ -50,9 +68,10 @@ struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
     MemRefType memrefC = matmulOp.getMatrixCType();
     MemRefType memrefA = matmulOp.getMatrixAType();
     MemRefType memrefB = matmulOp.getMatrixBType();
-    int64_t m = memrefC.getShape()[0];
-    int64_t n = memrefC.getShape()[1];
-    int64_t k = memrefA.getShape()[1];
+    // LIBXSMM only takes bf16 in the VNNI layout, see tpp.vnni_matmul.
+    if (!memrefA.getElementType().isF32() ||
+        !memrefB.getElementType().isF32() || !memrefC.getElementType().isF32())
+      return rewriter.notifyMatchFailure(matmulOp, "Expect f32 operands");
     auto ldaDim = getLeadingDim(memrefA);
     if (failed(ldaDim))
       return rewriter.notifyMatchFailure(matmulOp, "Cannot compute lda");
@@ -68,15 +87,23 @@ struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
       return rewriter.notifyMatchFailure(matmulOp, "Cannot compute ldc");
     int64_t ldc = *ldcDim;
 
+    // m, n and k.
+    SmallVector<int64_t> inputs;
+    SmallVector<Value> dynamicInputs;
+    appendDim(loc, matmulOp.getMatrixC(), 0, inputs, dynamicInputs, rewriter);
+    appendDim(loc, matmulOp.getMatrixC(), 1, inputs, dynamicInputs, rewriter);
+    appendDim(loc, matmulOp.getMatrixA(), 1, inputs, dynamicInputs, rewriter);
+    inputs.append({lda, ldb, ldc});
+
     IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
-    DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
-        rewriter.getContext(), ArrayRef<int64_t>{m, n, k, lda, ldb, ldc});
+    DenseI64ArrayAttr dims =
+        DenseI64ArrayAttr::get(rewriter.getContext(), inputs);
     xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
         matmulOp.getContext(), xsmm::TernaryKind::MATMUL);
     xsmm::DataTypeAttr dtype =
         xsmm::DataTypeAttr::get(matmulOp.getContext(), xsmm::DataType::F32);
     Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
-        loc, integer64, attr, dims, dtype);
+        loc, integer64, attr, dims, dtype, dynamicInputs);
 
     SmallVector<Value, 6> invokeOperands;
     invokeOperands.push_back(dispatched);
@@ -128,7 +155,7 @@ struct ConvertTpp_VNNI_MatmulOp : public OpRewritePattern<VNNI_MatmulOp> {
     xsmm::DataTypeAttr dtype =
         xsmm::DataTypeAttr::get(matmulOp.getContext(), xsmm::DataType::BF16);
     Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
-        loc, integer64, attr, dims, dtype);
+        loc, integer64, attr, dims, dtype, /*dynamicInputs=*/ValueRange());
 
     SmallVector<Value, 6> invokeOperands;
     invokeOperands.push_back(dispatched);
@@ -150,9 +177,10 @@ struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
     MemRefType memrefC = brgemmOp.getMatrixCType();
     MemRefType memrefA = brgemmOp.getBatchMatrixAType();
     MemRefType memrefB = brgemmOp.getBatchMatrixBType();
-    int64_t m = memrefC.getShape()[0];
-    int64_t n = memrefC.getShape()[1];
-    int64_t k = memrefA.getShape()[2];
+    // LIBXSMM only takes bf16 in the VNNI layout, see tpp.vnni_brgemm.
+    if (!memrefA.getElementType().isF32() ||
+        !memrefB.getElementType().isF32() || !memrefC.getElementType().isF32())
+      return rewriter.notifyMatchFailure(brgemmOp, "Expect f32 operands");
     int64_t batchSize = memrefB.getShape()[0];
 
     auto ldaDim = getLeadingDim(memrefA, 1);
@@ -169,18 +197,32 @@ struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
       return rewriter.notifyMatchFailure(brgemmOp, "Cannot compute ldc");
     int64_t ldc = *ldcDim;
 
+    // m, n and k.
+    SmallVector<int64_t> inputs;
+    SmallVector<Value> dynamicInputs;
+    appendDim(loc, brgemmOp.getMatrixC(), 0, inputs, dynamicInputs, rewriter);
+    appendDim(loc, brgemmOp.getMatrixC(), 1, inputs, dynamicInputs, rewriter);
+    appendDim(loc, brgemmOp.getBatchMatrixA(), 2, inputs, dynamicInputs,
+              rewriter);
+    inputs.append({lda, ldb, ldc});
+
     IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
-    DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
-        rewriter.getContext(), ArrayRef<int64_t>{m, n, k, lda, ldb, ldc});
+    DenseI64ArrayAttr dims =
+        DenseI64ArrayAttr::get(rewriter.getContext(), inputs);
     xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
         brgemmOp.getContext(), xsmm::TernaryKind::BRGEMM);
     xsmm::DataTypeAttr dtype =
         xsmm::DataTypeAttr::get(brgemmOp.getContext(), xsmm::DataType::F32);
 
     Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
-        loc, integer64, attr, dims, dtype);
-    Value batchDim = rewriter.create<arith::ConstantOp>(
-        loc, integer64, rewriter.getIntegerAttr(integer64, batchSize));
+        loc, integer64, attr, dims, dtype, dynamicInputs);
+    // The batch size is an operand of the invoke, not part of the kernel.
+    Value batchDim =
+        ShapedType::isDynamic(batchSize)
+            ? getDynamicDim(loc, brgemmOp.getBatchMatrixB(), 0, rewriter)
+            : rewriter.create<arith::ConstantOp>(
+                  loc, integer64,
+                  rewriter.getIntegerAttr(integer64, batchSize));
     SmallVector<Value, 6> invokeOperands;
     invokeOperands.push_back(dispatched);
     invokeOperands.append(brgemmOp->getOperands().begin(),
@@ -192,6 +234,73 @@ struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
   }
 };
 
+// The kernel is a brgemm whose batch is given by offsets: the runtime walks
+// `indices` to find the block of A that multiplies each block of B.
+struct ConvertTppSparseBrgemmOp : public OpRewritePattern<SparseBrgemmOp> {
+  using OpRewritePattern<SparseBrgemmOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(SparseBrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = brgemmOp.getLoc();
+
+    MemRefType memrefC = brgemmOp.getMatrixCType();
+    MemRefType memrefA = brgemmOp.getBatchMatrixAType();
+    MemRefType memrefB = brgemmOp.getBatchMatrixBType();
+    if (!memrefC.getElementType().isF32())
+      return rewriter.notifyMatchFailure(brgemmOp, "Expect f32 operands");
+    int64_t batchSize = memrefB.getShape()[0];
+
+    auto ldaDim = getLeadingDim(memrefA, 1);
+    if (failed(ldaDim))
+      return rewriter.notifyMatchFailure(brgemmOp, "Cannot compute lda");
+    int64_t lda = *ldaDim;
+    auto ldbDim = getLeadingDim(memrefB, 1);
+    if (failed(ldbDim))
+      return rewriter.notifyMatchFailure(brgemmOp, "Cannot compute ldb");
+    int64_t ldb = *ldbDim;
+
+    auto ldcDim = getLeadingDim(memrefC);
+    if (failed(ldcDim))
+      return rewriter.notifyMatchFailure(brgemmOp, "Cannot compute ldc");
+    int64_t ldc = *ldcDim;
+
+    // m, n and k.
+    SmallVector<int64_t> inputs;
+    SmallVector<Value> dynamicInputs;
+    appendDim(loc, brgemmOp.getMatrixC(), 0, inputs, dynamicInputs, rewriter);
+    appendDim(loc, brgemmOp.getMatrixC(), 1, inputs, dynamicInputs, rewriter);
+    appendDim(loc, brgemmOp.getBatchMatrixA(), 2, inputs, dynamicInputs,
+              rewriter);
+    inputs.append({lda, ldb, ldc});
+
+    IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
+    DenseI64ArrayAttr dims =
+        DenseI64ArrayAttr::get(rewriter.getContext(), inputs);
+    xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
+        brgemmOp.getContext(), xsmm::TernaryKind::SPARSE_BRGEMM);
+    xsmm::DataTypeAttr dtype =
+        xsmm::DataTypeAttr::get(brgemmOp.getContext(), xsmm::DataType::F32);
+
+    Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
+        loc, integer64, attr, dims, dtype, dynamicInputs);
+    // The number of non-zero blocks.
+    Value batchDim =
+        ShapedType::isDynamic(batchSize)
+            ? getDynamicDim(loc, brgemmOp.getBatchMatrixB(), 0, rewriter)
+            : rewriter.create<arith::ConstantOp>(
+                  loc, integer64,
+                  rewriter.getIntegerAttr(integer64, batchSize));
+    SmallVector<Value, 7> invokeOperands;
+    invokeOperands.push_back(dispatched);
+    invokeOperands.append(brgemmOp->getOperands().begin(),
+                          brgemmOp->getOperands().end());
+    invokeOperands.push_back(batchDim);
+    rewriter.replaceOpWithNewOp<xsmm::TernaryOp>(brgemmOp, dtype, attr,
+                                                 invokeOperands);
+    return success();
+  }
+};
+
 struct ConvertTpp_VNNI_BrgemmOp : public OpRewritePattern<VNNI_BrgemmOp> {
   using OpRewritePattern<VNNI_BrgemmOp>::OpRewritePattern;
 
@@ -235,7 +344,118 @@ struct ConvertTpp_VNNI_BrgemmOp : public OpRewritePattern<VNNI_BrgemmOp> {
         xsmm::DataTypeAttr::get(brgemmOp.getContext(), xsmm::DataType::BF16);
 
     Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
-        loc, integer64, attr, dims, dtype);
+        loc, integer64, attr, dims, dtype, /*dynamicInputs=*/ValueRange());
+    Value batchDim = rewriter.create<arith::ConstantOp>(
+        loc, integer64, rewriter.getIntegerAttr(integer64, batchSize));
+    SmallVector<Value, 6> invokeOperands;
+    invokeOperands.push_back(dispatched);
+    invokeOperands.append(brgemmOp->getOperands().begin(),
+                          brgemmOp->getOperands().end());
+    invokeOperands.push_back(batchDim);
+    rewriter.replaceOpWithNewOp<xsmm::TernaryOp>(brgemmOp, dtype, attr,
+                                                 invokeOperands);
+    return success();
+  }
+};
+
+// The leading dimension of B in VNNI4 format, [K/4][N][4], counts the
+// columns, LIBXSMM steps over the four k of a column itself.
+struct ConvertTppQuantizedMatmulOp
+    : public OpRewritePattern<QuantizedMatmulOp> {
+  using OpRewritePattern<QuantizedMatmulOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(QuantizedMatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = matmulOp.getLoc();
+
+    MemRefType memrefC = matmulOp.getMatrixCType();
+    MemRefType memrefA = matmulOp.getMatrixAType();
+    MemRefType memrefB = matmulOp.getMatrixBType();
+    int64_t m = memrefC.getShape()[0];
+    int64_t n = memrefC.getShape()[1];
+    int64_t k = memrefA.getShape()[1];
+    auto ldaDim = getLeadingDim(memrefA);
+    if (failed(ldaDim))
+      return rewriter.notifyMatchFailure(matmulOp, "Cannot compute lda");
+    int64_t lda = *ldaDim;
+
+    auto ldbDim = getLeadingDim(memrefB);
+    if (failed(ldbDim))
+      return rewriter.notifyMatchFailure(matmulOp, "Cannot compute ldb");
+    auto divLdbDim = getLeadingDim(memrefB, 1);
+    if (failed(divLdbDim))
+      return rewriter.notifyMatchFailure(matmulOp, "Cannot compute ldb");
+    int64_t ldb = *ldbDim / *divLdbDim;
+
+    auto ldcDim = getLeadingDim(memrefC);
+    if (failed(ldcDim))
+      return rewriter.notifyMatchFailure(matmulOp, "Cannot compute ldc");
+    int64_t ldc = *ldcDim;
+
+    IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
+    DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
+        rewriter.getContext(), ArrayRef<int64_t>{m, n, k, lda, ldb, ldc});
+    xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
+        matmulOp.getContext(), xsmm::TernaryKind::MATMUL);
+    xsmm::DataTypeAttr dtype =
+        xsmm::DataTypeAttr::get(matmulOp.getContext(), xsmm::DataType::I8);
+    Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
+        loc, integer64, attr, dims, dtype, /*dynamicInputs=*/ValueRange());
+
+    SmallVector<Value, 6> invokeOperands;
+    invokeOperands.push_back(dispatched);
+    invokeOperands.append(matmulOp->getOperands().begin(),
+                          matmulOp->getOperands().end());
+    rewriter.replaceOpWithNewOp<xsmm::TernaryOp>(matmulOp, dtype, attr,
+                                                 invokeOperands);
+    return success();
+  }
+};
+
+struct ConvertTppQuantizedBrgemmOp
+    : public OpRewritePattern<QuantizedBrgemmOp> {
+  using OpRewritePattern<QuantizedBrgemmOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(QuantizedBrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = brgemmOp.getLoc();
+
+    MemRefType memrefC = brgemmOp.getMatrixCType();
+    MemRefType memrefA = brgemmOp.getBatchMatrixAType();
+    MemRefType memrefB = brgemmOp.getBatchMatrixBType();
+    int64_t m = memrefC.getShape()[0];
+    int64_t n = memrefC.getShape()[1];
+    int64_t k = memrefA.getShape()[2];
+    int64_t batchSize = memrefB.getShape()[0];
+
+    auto ldaDim = getLeadingDim(memrefA, 1);
+    if (failed(ldaDim))
+      return rewriter.notifyMatchFailure(brgemmOp, "Cannot compute lda");
+    int64_t lda = *ldaDim;
+
+    auto ldbDim = getLeadingDim(memrefB, 1);
+    if (failed(ldbDim))
+      return rewriter.notifyMatchFailure(brgemmOp, "Cannot compute ldb");
+    auto divLdbDim = getLeadingDim(memrefB, 2);
+    if (failed(divLdbDim))
+      return rewriter.notifyMatchFailure(brgemmOp, "Cannot compute ldb");
+    int64_t ldb = *ldbDim / *divLdbDim;
+
+    auto ldcDim = getLeadingDim(memrefC);
+    if (failed(ldcDim))
+      return rewriter.notifyMatchFailure(brgemmOp, "Cannot compute ldc");
+    int64_t ldc = *ldcDim;
+
+    IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
+    DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
+        rewriter.getContext(), ArrayRef<int64_t>{m, n, k, lda, ldb, ldc});
+    xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
+        brgemmOp.getContext(), xsmm::TernaryKind::BRGEMM);
+    xsmm::DataTypeAttr dtype =
+        xsmm::DataTypeAttr::get(brgemmOp.getContext(), xsmm::DataType::I8);
+
+    Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
+        loc, integer64, attr, dims, dtype, /*dynamicInputs=*/ValueRange());
     Value batchDim = rewriter.create<arith::ConstantOp>(
         loc, integer64, rewriter.getIntegerAttr(integer64, batchSize));
     SmallVector<Value, 6> invokeOperands;
@@ -345,6 +565,12 @@ struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
     MemRefType outputMemRefType = outputType.dyn_cast<MemRefType>();
     if (!outputMemRefType || outputMemRefType.getRank() != 2)
       return rewriter.notifyMatchFailure(identityOp, "not a 2-D memref type");
+    // The broadcast flags are derived from the shapes.
+    auto inputMemRefType =
+        identityOp.getInput().getType().dyn_cast<MemRefType>();
+    if (!outputMemRefType.hasStaticShape() ||
+        (inputMemRefType && !inputMemRefType.hasStaticShape()))
+      return rewriter.notifyMatchFailure(identityOp, "not a static shape");
 
     int64_t outputOffset;
     SmallVector<int64_t> outputStrides;
@@ -382,7 +608,8 @@ struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
     }
 
     Value dispatched = rewriter.create<xsmm::UnaryDispatchOp>(
-        loc, integer64, attr, dims, bCastAttr, dtype);
+        loc, integer64, attr, dims, bCastAttr, dtype,
+        /*dynamicInputs=*/ValueRange());
 
     SmallVector<Value, 6> invokeOperands;
     invokeOperands.push_back(dispatched);
@@ -408,16 +635,22 @@ struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
                                          "Expected a non-scalar operation");
 
     MemRefType outputMemRef = outputType.cast<MemRefType>();
-    int64_t m = outputMemRef.getShape()[0];
+    // n is the innermost, static, dimension.
     int64_t n = outputMemRef.getShape()[1];
     int64_t ldo = n;
     int64_t ldi = n;
 
+    // m and n.
+    SmallVector<int64_t> inputs;
+    SmallVector<Value> dynamicInputs;
+    appendDim(loc, reluOp.getOutput(), 0, inputs, dynamicInputs, rewriter);
+    inputs.append({n, ldi, ldo});
+
     xsmm::UnaryFlags bCast = xsmm::UnaryFlags::NONE;
     xsmm::UnaryKindAttr attr =
         xsmm::UnaryKindAttr::get(reluOp.getContext(), xsmm::UnaryKind::RELU);
-    DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
-        rewriter.getContext(), ArrayRef<int64_t>{m, n, ldi, ldo});
+    DenseI64ArrayAttr dims =
+        DenseI64ArrayAttr::get(rewriter.getContext(), inputs);
     xsmm::UnaryFlagsAttr bCastAttr =
         xsmm::UnaryFlagsAttr::get(reluOp.getContext(), bCast);
     IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
@@ -432,7 +665,71 @@ struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
     }
 
     Value dispatched = rewriter.create<xsmm::UnaryDispatchOp>(
-        loc, integer64, attr, dims, bCastAttr, dtype);
+        loc, integer64, attr, dims, bCastAttr, dtype, dynamicInputs);
+
+    SmallVector<Value, 6> invokeOperands;
+    invokeOperands.push_back(dispatched);
+    invokeOperands.append(reluOp->getOperands().begin(),
+                          reluOp->getOperands().end());
+
+    rewriter.replaceOpWithNewOp<xsmm::UnaryOp>(reluOp, dtype, attr,
+                                               invokeOperands);
+    return success();
+  }
+};
+
+// Relu backward maps to LIBXSMM's RELU_INV, reading the forward activation
+// as secondary input with the same leading dimension as the gradient.
+struct ConvertTppReluBackwardOp : public OpRewritePattern<ReluBackwardOp> {
+  using OpRewritePattern<ReluBackwardOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(ReluBackwardOp reluOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = reluOp.getLoc();
+    MemRefType outputMemRef = reluOp.getOutput().getType().cast<MemRefType>();
+    if (outputMemRef.getRank() != 2)
+      return rewriter.notifyMatchFailure(reluOp, "not a 2-D memref type");
+
+    auto ldiDim = getLeadingDim(reluOp.getGrad().getType().cast<MemRefType>());
+    if (failed(ldiDim))
+      return rewriter.notifyMatchFailure(reluOp, "Cannot compute ldi");
+    int64_t ldi = *ldiDim;
+    auto ldiInputDim =
+        getLeadingDim(reluOp.getInput().getType().cast<MemRefType>());
+    if (failed(ldiInputDim) || *ldiInputDim != ldi)
+      return rewriter.notifyMatchFailure(
+          reluOp, "Expect the same ldi for the gradient and the input");
+    auto ldoDim = getLeadingDim(outputMemRef);
+    if (failed(ldoDim))
+      return rewriter.notifyMatchFailure(reluOp, "Cannot compute ldo");
+    int64_t ldo = *ldoDim;
+
+    // m and n.
+    SmallVector<int64_t> inputs;
+    SmallVector<Value> dynamicInputs;
+    appendDim(loc, reluOp.getOutput(), 0, inputs, dynamicInputs, rewriter);
+    appendDim(loc, reluOp.getOutput(), 1, inputs, dynamicInputs, rewriter);
+    inputs.append({ldi, ldo});
+
+    xsmm::UnaryKindAttr attr = xsmm::UnaryKindAttr::get(
+        reluOp.getContext(), xsmm::UnaryKind::RELU_INV);
+    DenseI64ArrayAttr dims =
+        DenseI64ArrayAttr::get(rewriter.getContext(), inputs);
+    xsmm::UnaryFlagsAttr bCastAttr =
+        xsmm::UnaryFlagsAttr::get(reluOp.getContext(), xsmm::UnaryFlags::NONE);
+    IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
+    xsmm::DataTypeAttr dtype;
+    if (outputMemRef.getElementType().isBF16()) {
+      dtype =
+          xsmm::DataTypeAttr::get(reluOp.getContext(), xsmm::DataType::BF16);
+    } else {
+      assert(outputMemRef.getElementType().isF32() &&
+             "Element type neither bf16 nor f32");
+      dtype = xsmm::DataTypeAttr::get(reluOp.getContext(), xsmm::DataType::F32);
+    }
+
+    Value dispatched = rewriter.create<xsmm::UnaryDispatchOp>(
+        loc, integer64, attr, dims, bCastAttr, dtype, dynamicInputs);
 
     SmallVector<Value, 6> invokeOperands;
     invokeOperands.push_back(dispatched);
@@ -457,8 +754,6 @@ struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
       return failure();
 
     MemRefType outputMemRef = outputType.cast<MemRefType>();
-    int64_t m = outputMemRef.getShape()[0];
-    int64_t n = outputMemRef.getShape()[1];
     auto ldiLhsDim = getLeadingDim(addOp.getLhs().getType().cast<MemRefType>());
     if (failed(ldiLhsDim))
       return rewriter.notifyMatchFailure(addOp, "Cannot compute ldi on lhs");
@@ -474,11 +769,18 @@ struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
       return rewriter.notifyMatchFailure(addOp, "Cannot compute ldo");
     int64_t ldo = *ldoDim;
 
+    // m and n.
+    SmallVector<int64_t> inputs;
+    SmallVector<Value> dynamicInputs;
+    appendDim(loc, addOp.getOutput(), 0, inputs, dynamicInputs, rewriter);
+    appendDim(loc, addOp.getOutput(), 1, inputs, dynamicInputs, rewriter);
+    inputs.append({ldiLhs, ldiRhs, ldo});
+
     xsmm::BinaryFlags bCast = xsmm::BinaryFlags::NONE;
     xsmm::BinaryKindAttr attr =
         xsmm::BinaryKindAttr::get(addOp.getContext(), xsmm::BinaryKind::ADD);
-    DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
-        rewriter.getContext(), ArrayRef<int64_t>{m, n, ldiLhs, ldiRhs, ldo});
+    DenseI64ArrayAttr dims =
+        DenseI64ArrayAttr::get(rewriter.getContext(), inputs);
     xsmm::BinaryFlagsAttr bCastAttr =
         xsmm::BinaryFlagsAttr::get(addOp.getContext(), bCast);
     IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
@@ -492,7 +794,7 @@ struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
     }
 
     Value dispatched = rewriter.create<xsmm::BinaryDispatchOp>(
-        loc, integer64, attr, dims, bCastAttr, dtype);
+        loc, integer64, attr, dims, bCastAttr, dtype, dynamicInputs);
 
     SmallVector<Value, 6> invokeOperands;
     invokeOperands.push_back(dispatched);
@@ -504,13 +806,79 @@ struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
   }
 };
 
+// Largest k the inlined GEMMs unroll completely.
+constexpr int64_t kMaxInlineUnroll = 32;
+
+// Largest tile of C the inlined GEMMs keep in registers, 8 rows of 32 f32:
+// 16 AVX-512 or 32 AVX2 registers, the rest of C is looped over.
+constexpr int64_t kMaxInlineTileM = 8;
+constexpr int64_t kMaxInlineTileN = 32;
+
+// FLOPs of a statically shaped tpp.matmul or tpp.brgemm.
+static Optional<int64_t> getGemmFlops(Operation *op) {
+  SmallVector<MemRefType> types;
+  for (Value operand : op->getOperands()) {
+    auto memrefType = operand.getType().dyn_cast<MemRefType>();
+    if (!memrefType || !memrefType.hasStaticShape())
+      return None;
+    types.push_back(memrefType);
+  }
+  // C is MxN, A is [B]xMxK.
+  ArrayRef<int64_t> shapeA = types[0].getShape();
+  ArrayRef<int64_t> shapeC = types[2].getShape();
+  int64_t batch = shapeA.size() == 3 ? shapeA[0] : 1;
+  return 2 * batch * shapeC[0] * shapeC[1] * shapeA.back();
+}
+
 struct ConvertTppToXsmm : public ConvertTppToXsmmBase<ConvertTppToXsmm> {
+  ConvertTppToXsmm() = default;
+  ConvertTppToXsmm(int64_t inlineFlopsThreshold) {
+    this->inlineFlopsThreshold = inlineFlopsThreshold;
+  }
+
   void runOnOperation() override {
+    if (inlineFlopsThreshold > 0)
+      inlineTinyGemms();
+
     RewritePatternSet patterns(&getContext());
     tpp::populateTppToXsmmPatterns(patterns);
+    // Fold the single-iteration loops of the inlined GEMMs.
+    if (inlineFlopsThreshold > 0)
+      scf::ForOp::getCanonicalizationPatterns(patterns, &getContext());
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
+
+private:
+  // Below the threshold, the call and the dispatch cost more than the
+  // compute: lower the GEMM to vector code, with k fully unrolled, so that
+  // LLVM schedules it with the surrounding code. A tall or wide C, which a
+  // small k lets under the threshold, is tiled rather than held whole in
+  // registers.
+  void inlineTinyGemms() {
+    SmallVector<Operation *> tinyGemms;
+    getOperation().walk([&](Operation *op) {
+      if (!isa<MatmulOp, BrgemmOp>(op))
+        return;
+      Optional<int64_t> flops = getGemmFlops(op);
+      if (flops && *flops <= inlineFlopsThreshold)
+        tinyGemms.push_back(op);
+    });
+
+    IRRewriter rewriter(&getContext());
+    for (Operation *op : tinyGemms) {
+      ArrayRef<int64_t> shapeC =
+          op->getOperands().back().getType().cast<MemRefType>().getShape();
+      int64_t k =
+          op->getOperand(0).getType().cast<MemRefType>().getShape().back();
+      int64_t registerTile[] = {std::min(shapeC[0], kMaxInlineTileM),
+                                std::min(shapeC[1], kMaxInlineTileN),
+                                k <= kMaxInlineUnroll ? k : 1};
+      rewriter.setInsertionPoint(op);
+      // VNNI and mixed types stay calls.
+      (void)tpp::lowerToVectorMicroKernels(rewriter, op, registerTile);
+    }
+  }
 };
 
 } // namespace
@@ -519,11 +887,15 @@ void mlir::tpp::populateTppToXsmmPatterns(RewritePatternSet &patterns) {
   // clang-format off
   patterns.add<ConvertTppIdentityOp,
                ConvertTppReluOp,
+               ConvertTppReluBackwardOp,
                ConvertTppAddOp,
                ConvertTppMatmulOp,
 	       ConvertTpp_VNNI_MatmulOp,
                ConvertTppBrgemmOp,
-	       ConvertTpp_VNNI_BrgemmOp>(patterns.getContext());
+	       ConvertTpp_VNNI_BrgemmOp,
+               ConvertTppQuantizedMatmulOp,
+               ConvertTppQuantizedBrgemmOp,
+               ConvertTppSparseBrgemmOp>(patterns.getContext());
   // clang-format on
 }
 
@@ -531,3 +903,8 @@ std::unique_ptr<OperationPass<func::FuncOp>>
 mlir::tpp::createConvertTppToXsmmPass() {
   return std::make_unique<ConvertTppToXsmm>();
 }
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createConvertTppToXsmmPass(int64_t inlineFlopsThreshold) {
+  return std::make_unique<ConvertTppToXsmm>(inlineFlopsThreshold);
+}
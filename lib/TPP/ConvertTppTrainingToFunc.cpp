@@ -0,0 +1,196 @@
+//===- ConvertTppTrainingToFunc.cpp ------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Dialect/Tpp/TppOps.h"
+#include "TPP/Passes.h"
+#include "TPP/Transforms.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+using namespace mlir;
+using namespace mlir::tpp;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+namespace {
+
+// The runtime sweeps the memrefs as flat arrays: they must be contiguous.
+// The optimizer updates that are not lower to loops instead, the dropout
+// verifier rejects them.
+static bool hasContiguousOperands(Operation *op) {
+  return llvm::all_of(op->getOperandTypes(), [](Type type) {
+    auto memrefType = type.dyn_cast<MemRefType>();
+    return !memrefType || memrefType.getLayout().isIdentity();
+  });
+}
+
+static bool isTrainingOp(Operation *op) {
+  return isa<SgdUpdateOp, AdamUpdateOp, DropoutOp, DropoutBackwardOp>(op) &&
+         hasContiguousOperands(op);
+}
+
+// Name of the runtime function a training operation lowers to.
+static StringRef getTrainingFuncName(Operation *op) {
+  if (isa<SgdUpdateOp>(op))
+    return "tpp_sgd_update";
+  if (isa<AdamUpdateOp>(op))
+    return "tpp_adam_update";
+  if (isa<DropoutOp>(op))
+    return "tpp_dropout";
+  return "tpp_dropout_backward";
+}
+
+// The hyperparameters, passed after the operands.
+static SmallVector<FloatAttr> getHyperParams(Operation *op) {
+  if (auto sgdOp = dyn_cast<SgdUpdateOp>(op))
+    return {sgdOp.getMomentumAttr(), sgdOp.getWeightDecayAttr()};
+  if (auto adamOp = dyn_cast<AdamUpdateOp>(op))
+    return {adamOp.getBeta1Attr(), adamOp.getBeta2Attr(),
+            adamOp.getEpsilonAttr(), adamOp.getWeightDecayAttr()};
+  if (auto dropoutOp = dyn_cast<DropoutOp>(op))
+    return {dropoutOp.getProbabilityAttr()};
+  return {cast<DropoutBackwardOp>(op).getProbabilityAttr()};
+}
+
+static UnrankedMemRefType getUnrankedType(MemRefType memrefType) {
+  return UnrankedMemRefType::get(memrefType.getElementType(),
+                                 memrefType.getMemorySpace());
+}
+
+// The operands of the call: the operands of the operation, memrefs cast to
+// unranked, then its hyperparameters.
+static SmallVector<Value> getCallOperands(OpBuilder &b, Operation *op) {
+  Location loc = op->getLoc();
+  SmallVector<Value> operands;
+  for (Value operand : op->getOperands()) {
+    auto memrefType = operand.getType().dyn_cast<MemRefType>();
+    if (!memrefType) {
+      operands.push_back(operand);
+      continue;
+    }
+    operands.push_back(
+        b.create<memref::CastOp>(loc, getUnrankedType(memrefType), operand));
+  }
+  for (FloatAttr hyperParam : getHyperParams(op))
+    operands.push_back(b.create<arith::ConstantOp>(loc, hyperParam));
+  return operands;
+}
+
+static SmallVector<Type> getCallOperandTypes(Operation *op) {
+  SmallVector<Type> types;
+  for (Type type : op->getOperandTypes()) {
+    if (auto memrefType = type.dyn_cast<MemRefType>())
+      types.push_back(getUnrankedType(memrefType));
+    else
+      types.push_back(type);
+  }
+  for (FloatAttr hyperParam : getHyperParams(op))
+    types.push_back(hyperParam.getType());
+  return types;
+}
+
+template <typename OpTy>
+struct ConvertTrainingOp : public OpRewritePattern<OpTy> {
+  using OpRewritePattern<OpTy>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(OpTy trainingOp,
+                                PatternRewriter &rewriter) const override {
+    if (!hasContiguousOperands(trainingOp))
+      return rewriter.notifyMatchFailure(trainingOp,
+                                         "Expect contiguous memrefs");
+    // The callee is declared by tpp::declareTppTrainingRuntimeFunctions.
+    rewriter.create<func::CallOp>(trainingOp.getLoc(),
+                                  getTrainingFuncName(trainingOp), TypeRange(),
+                                  getCallOperands(rewriter, trainingOp));
+    rewriter.eraseOp(trainingOp);
+    return success();
+  }
+};
+
+// Rewrite the training operations of a function to calls, and the strided
+// optimizer updates to loops. Runs on each function in parallel, the runtime
+// functions must already be declared.
+struct ConvertTppTrainingOpsToFunc
+    : public ConvertTppTrainingOpsToFuncBase<ConvertTppTrainingOpsToFunc> {
+  void runOnOperation() override {
+    RewritePatternSet patterns(&getContext());
+    mlir::tpp::populateTppTrainingToFuncPatterns(patterns);
+    mlir::tpp::populateTppOptimizerToLoopsPatterns(patterns);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+    return;
+  }
+};
+
+// Declare the runtime functions in one module step, then convert the
+// functions in parallel.
+struct ConvertTppTrainingToFunc
+    : public ConvertTppTrainingToFuncBase<ConvertTppTrainingToFunc> {
+  void runOnOperation() override {
+    mlir::tpp::declareTppTrainingRuntimeFunctions(getOperation());
+    OpPassManager pm(ModuleOp::getOperationName());
+    pm.addNestedPass<func::FuncOp>(
+        std::make_unique<ConvertTppTrainingOpsToFunc>());
+    if (failed(runPipeline(pm, getOperation())))
+      signalPassFailure();
+  }
+};
+
+} // namespace
+
+void mlir::tpp::populateTppTrainingToFuncPatterns(RewritePatternSet &patterns) {
+  // Tried before the loops, when both are in the set.
+  // clang-format off
+  patterns.add<ConvertTrainingOp<SgdUpdateOp>,
+               ConvertTrainingOp<AdamUpdateOp>,
+               ConvertTrainingOp<DropoutOp>,
+               ConvertTrainingOp<DropoutBackwardOp>>(patterns.getContext(),
+                                                     /*benefit=*/2);
+  // clang-format on
+}
+
+void mlir::tpp::declareTppTrainingRuntimeFunctions(ModuleOp module) {
+  SmallVector<Operation *> trainingOps;
+  module.walk([&](Operation *op) {
+    if (isTrainingOp(op))
+      trainingOps.push_back(op);
+  });
+  if (trainingOps.empty())
+    return;
+
+  OpBuilder builder(module.getContext());
+  builder.setInsertionPoint(module.getBody(),
+                            std::prev(module.getBody()->end()));
+  for (Operation *op : trainingOps) {
+    StringRef name = getTrainingFuncName(op);
+    if (module.lookupSymbol(name))
+      continue;
+    auto libFnType = builder.getFunctionType(getCallOperandTypes(op), None);
+    func::FuncOp funcOp =
+        builder.create<func::FuncOp>(op->getLoc(), name, libFnType);
+    funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                    builder.getUnitAttr());
+    funcOp.setPrivate();
+  }
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createConvertTppTrainingToFuncPass() {
+  return std::make_unique<ConvertTppTrainingToFunc>();
+}
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createConvertTppTrainingOpsToFuncPass() {
+  return std::make_unique<ConvertTppTrainingOpsToFunc>();
+}
@@ -14,6 +14,7 @@
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 using namespace mlir;
 using namespace mlir::xsmm;
@@ -25,7 +26,7 @@ namespace {
 
 // Cast memref to unranked memref and leave all the other operands as they are.
 static SmallVector<Type> extractInvokeOperandTypes(OperandRange operands,
-                                                   PatternRewriter &rewriter) {
+                                                   Builder &rewriter) {
   SmallVector<Type> results;
   // One extra operand for datatype
   results.reserve(operands.size() + 1);
@@ -45,7 +46,7 @@ static SmallVector<Type> extractInvokeOperandTypes(OperandRange operands,
 
 static SmallVector<Type>
 extractInvokeOperandTypesForMeta(OperandRange operands, IndexType indexType,
-                                 PatternRewriter &rewriter) {
+                                 Builder &rewriter) {
   SmallVector<Type> results;
   // One extra operand for datatype
   IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
@@ -129,38 +130,74 @@ static SmallVector<Value> getMemRefOperandsUsingMetadata(OpBuilder &builder,
   return res;
 }
 
-static LogicalResult buildInvokeCall(Location loc, std::string funcName,
-                                     Operation *op, bool useMeta,
-                                     PatternRewriter &rewriter,
-                                     IntegerAttr typeAttr) {
-  FlatSymbolRefAttr fnName = SymbolRefAttr::get(op->getContext(), funcName);
-  ModuleOp module = op->getParentOfType<ModuleOp>();
-  auto libFnType = rewriter.getFunctionType(
+// Name of the runtime function an XSMM invoke lowers to.
+static std::string getInvokeFuncName(Operation *op) {
+  // Int8 GEMMs accumulate in i32, their operands do not have the same
+  // element type as the floating point ones: give them their own declaration.
+  if (auto ternaryOp = dyn_cast<TernaryOp>(op)) {
+    std::string funcName =
+        "xsmm_" + stringifyEnum(ternaryOp.getCallee()).str() + "_invoke";
+    if (ternaryOp.getDataType() == xsmm::DataType::I8)
+      funcName = funcName + "_i8";
+    return funcName;
+  }
+  if (isa<BinaryOp>(op))
+    return "xsmm_binary_invoke";
+  // Handle the scalar case. There is no operator overloading
+  // in MLIR (thus we need to change the function name from
+  // "unary" to "unary_scalar"). We also don't want to convert
+  // the scalar to a memref by using an alloc/alloca.
+  auto unaryOp = cast<UnaryOp>(op);
+  std::string funcName = "xsmm_unary_invoke";
+  if (unaryOp.hasScalarInput())
+    funcName = "xsmm_unary_scalar_invoke";
+  // The kernel pointer, two inputs and the output.
+  if (unaryOp.getInputs().size() == 4)
+    funcName = "xsmm_unary_secondary_invoke";
+  if (unaryOp.getCallee() == xsmm::UnaryKind::RELU)
+    funcName = funcName + "_inline";
+  return funcName;
+}
+
+static FunctionType getInvokeFuncType(Operation *op, bool useMeta,
+                                      Builder &builder) {
+  return builder.getFunctionType(
       (useMeta == false)
-          ? extractInvokeOperandTypes(op->getOperands(), rewriter)
+          ? extractInvokeOperandTypes(op->getOperands(), builder)
           : extractInvokeOperandTypesForMeta(op->getOperands(),
-                                             rewriter.getIndexType(), rewriter),
+                                             builder.getIndexType(), builder),
       {});
+}
 
-  if (!module.lookupSymbol(fnName)) {
-    OpBuilder::InsertionGuard guard(rewriter);
-    // Insert before module terminator.
-    rewriter.setInsertionPoint(module.getBody(),
-                               std::prev(module.getBody()->end()));
-    func::FuncOp funcOp =
-        rewriter.create<func::FuncOp>(loc, fnName.getValue(), libFnType);
-    if (!useMeta) {
-      // Insert a function attribute that will trigger the emission of the
-      // corresponding `_mlir_ciface_xxx` interface so that external libraries
-      // see a normalized ABI.
-      funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
-                      UnitAttr::get(op->getContext()));
-    }
-    funcOp.setPrivate();
-  }
+// Name of the runtime function an XSMM dispatch lowers to.
+static std::string getDispatchFuncName(Operation *op) {
+  if (auto dispatchOp = dyn_cast<TernaryDispatchOp>(op))
+    return "xsmm_" + stringifyEnum(dispatchOp.getKind()).str() + "_dispatch";
+  if (isa<BinaryDispatchOp>(op))
+    return "xsmm_binary_dispatch";
+  return "xsmm_unary_dispatch";
+}
 
+// Dispatches take the data type and the shape, unary and binary ones also
+// the kind of operation and of broadcast, all as i64.
+static FunctionType getDispatchFuncType(Operation *op, Builder &builder) {
+  ArrayRef<int64_t> inputs =
+      op->getAttrOfType<DenseI64ArrayAttr>("inputs").asArrayRef();
+  size_t numOperands = 1 + inputs.size();
+  if (!isa<TernaryDispatchOp>(op))
+    numOperands += 2;
+  IntegerType integer64 = builder.getI64Type();
+  return builder.getFunctionType(SmallVector<Type>(numOperands, integer64),
+                                 integer64);
+}
+
+static LogicalResult buildInvokeCall(Location loc, std::string funcName,
+                                     Operation *op, bool useMeta,
+                                     PatternRewriter &rewriter,
+                                     IntegerAttr typeAttr) {
+  // The callee is declared by tpp::declareXsmmRuntimeFunctions.
   rewriter.create<func::CallOp>(
-      loc, fnName.getValue(), TypeRange(),
+      loc, funcName, TypeRange(),
       (useMeta == false)
           ? getMemRefOperands(rewriter, loc, op->getOperands(), typeAttr)
           : getMemRefOperandsUsingMetadata(rewriter, loc, op->getOperands(),
@@ -177,8 +214,7 @@ struct ConvertTernaryXsmmOp : public OpRewritePattern<TernaryOp> {
                                 PatternRewriter &rewriter) const override {
     auto type = (uint64_t)ternaryOp.getDataType();
     IntegerAttr typeAttr = IntegerAttr::get(rewriter.getI64Type(), type);
-    std::string funcName =
-        "xsmm_" + stringifyEnum(ternaryOp.getCallee()).str() + "_invoke";
+    std::string funcName = getInvokeFuncName(ternaryOp);
     if (succeeded(buildInvokeCall(ternaryOp.getLoc(), funcName, ternaryOp,
                                   useMeta, rewriter, typeAttr))) {
       rewriter.eraseOp(ternaryOp);
@@ -198,18 +234,9 @@ struct ConvertUnaryXsmmOp : public OpRewritePattern<UnaryOp> {
 
   LogicalResult matchAndRewrite(UnaryOp unaryOp,
                                 PatternRewriter &rewriter) const override {
-    // Handle the scalar case. There is no operator overloading
-    // in MLIR (thus we need to change the function name from
-    // "unary" to "unary_scalar"). We also don't want to convert
-    // the scalar to a memref by using an alloc/alloca.
     auto type = (uint64_t)unaryOp.getDataType();
     IntegerAttr typeAttr = IntegerAttr::get(rewriter.getI64Type(), type);
-    std::string funcName = "xsmm_unary_invoke";
-    if (unaryOp.hasScalarInput())
-      funcName = "xsmm_unary_scalar_invoke";
-    if (unaryOp.getCallee() == xsmm::UnaryKind::RELU) {
-      funcName = funcName + "_inline";
-    }
+    std::string funcName = getInvokeFuncName(unaryOp);
     if (succeeded(buildInvokeCall(unaryOp.getLoc(), funcName, unaryOp, useMeta,
                                   rewriter, typeAttr))) {
       rewriter.eraseOp(unaryOp);
@@ -232,7 +259,7 @@ struct ConvertBinaryXsmmOp : public OpRewritePattern<BinaryOp> {
     auto type = (uint64_t)binaryOp.getDataType();
     IntegerAttr typeAttr = IntegerAttr::get(rewriter.getI64Type(), type);
 
-    std::string funcName = "xsmm_binary_invoke";
+    std::string funcName = getInvokeFuncName(binaryOp);
     if (succeeded(buildInvokeCall(binaryOp.getLoc(), funcName, binaryOp,
                                   useMeta, rewriter, typeAttr))) {
       rewriter.eraseOp(binaryOp);
@@ -247,35 +274,34 @@ private:
 
 static func::CallOp buildDispatchCall(Location loc,
                                       ArrayRef<Value> dispatchOperands,
-                                      ArrayRef<Type> dispatchOperandTypes,
-                                      ModuleOp module, FlatSymbolRefAttr fnName,
-                                      bool useMeta, PatternRewriter &rewriter) {
-  auto libFnType = rewriter.getFunctionType(
-      dispatchOperandTypes, IntegerType::get(rewriter.getContext(), 64));
-
-  if (!module.lookupSymbol(fnName.getAttr())) {
-    OpBuilder::InsertionGuard guard(rewriter);
-    // Insert before module terminator.
-    rewriter.setInsertionPoint(module.getBody(),
-                               std::prev(module.getBody()->end()));
-    func::FuncOp funcOp =
-        rewriter.create<func::FuncOp>(loc, fnName.getValue(), libFnType);
-    if (!useMeta) {
-      // Insert a function attribute that will trigger the emission of the
-      // corresponding `_mlir_ciface_xxx` interface so that external libraries
-      // see a normalized ABI.
-      funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
-                      UnitAttr::get(rewriter.getContext()));
-    }
-    funcOp.setPrivate();
-  }
-
+                                      StringRef fnName,
+                                      PatternRewriter &rewriter) {
+  // The callee is declared by tpp::declareXsmmRuntimeFunctions.
   func::CallOp call = rewriter.create<func::CallOp>(
-      loc, fnName.getValue(), IntegerType::get(rewriter.getContext(), 64),
+      loc, fnName, IntegerType::get(rewriter.getContext(), 64),
       dispatchOperands);
   return call;
 }
 
+// Static dispatch inputs become constants, the dynamic ones (ShapedType's
+// kDynamic) are the i64 operands of the dispatch, in order.
+static void appendDispatchInputs(Location loc, ArrayRef<int64_t> inputs,
+                                 ValueRange dynamicInputs,
+                                 SmallVectorImpl<Value> &dispatchOperands,
+                                 PatternRewriter &rewriter) {
+  IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
+  auto dynamicInput = dynamicInputs.begin();
+  for (int64_t input : inputs) {
+    if (ShapedType::isDynamic(input)) {
+      dispatchOperands.push_back(*dynamicInput++);
+      continue;
+    }
+    IntegerAttr attr = IntegerAttr::get(integer64, input);
+    dispatchOperands.push_back(
+        rewriter.create<arith::ConstantOp>(loc, integer64, attr));
+  }
+}
+
 struct ConvertTernaryDispatch : public OpRewritePattern<TernaryDispatchOp> {
   ConvertTernaryDispatch(MLIRContext *context, bool useMeta,
                          PatternBenefit benefit = 1)
@@ -285,32 +311,20 @@ struct ConvertTernaryDispatch : public OpRewritePattern<TernaryDispatchOp> {
   LogicalResult matchAndRewrite(TernaryDispatchOp dispatchOp,
                                 PatternRewriter &rewriter) const override {
     Location loc = dispatchOp.getLoc();
-    std::string kindAsString = stringifyEnum(dispatchOp.getKind()).str();
+    std::string fnName = getDispatchFuncName(dispatchOp);
     auto type = (uint64_t)(dispatchOp.getDataType());
-    kindAsString = "xsmm_" + kindAsString + "_dispatch";
-    FlatSymbolRefAttr fnName =
-        SymbolRefAttr::get(rewriter.getContext(), kindAsString);
 
-    ModuleOp module = dispatchOp->getParentOfType<ModuleOp>();
     SmallVector<Value, 10> dispatchOperands;
-    SmallVector<Type, 10> dispatchOperandTypes;
     IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
     IntegerAttr typeAttr = IntegerAttr::get(rewriter.getI64Type(), type);
     dispatchOperands.push_back(
         rewriter.create<arith::ConstantOp>(loc, integer64, typeAttr));
-    dispatchOperandTypes.push_back(integer64);
-
-    ArrayRef<int64_t> integers = dispatchOp.getInputsAttr().asArrayRef();
-    size_t arrayAttrSize = integers.size();
-    for (size_t idx = 0; idx < arrayAttrSize; idx++) {
-      IntegerAttr attr = IntegerAttr::get(rewriter.getI64Type(), integers[idx]);
-      dispatchOperands.push_back(
-          rewriter.create<arith::ConstantOp>(loc, integer64, attr));
-      dispatchOperandTypes.push_back(integer64);
-    }
+
+    appendDispatchInputs(loc, dispatchOp.getInputsAttr().asArrayRef(),
+                         dispatchOp.getDynamicInputs(), dispatchOperands,
+                         rewriter);
     func::CallOp call =
-        buildDispatchCall(loc, dispatchOperands, dispatchOperandTypes, module,
-                          fnName, useMeta, rewriter);
+        buildDispatchCall(loc, dispatchOperands, fnName, rewriter);
     rewriter.replaceOp(dispatchOp, call.getResult(0));
     return success();
   }
@@ -328,44 +342,31 @@ struct ConvertBinaryDispatch : public OpRewritePattern<BinaryDispatchOp> {
   LogicalResult matchAndRewrite(BinaryDispatchOp dispatchOp,
                                 PatternRewriter &rewriter) const override {
     Location loc = dispatchOp.getLoc();
-    std::string kindAsString = "xsmm_binary_dispatch";
-    FlatSymbolRefAttr fnName =
-        SymbolRefAttr::get(rewriter.getContext(), kindAsString);
+    std::string fnName = getDispatchFuncName(dispatchOp);
 
     auto type = (uint64_t)(dispatchOp.getDataType());
 
-    ModuleOp module = dispatchOp->getParentOfType<ModuleOp>();
     SmallVector<Value, 10> dispatchOperands;
-    SmallVector<Type, 10> dispatchOperandTypes;
     IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
 
     IntegerAttr typeAttr = IntegerAttr::get(rewriter.getI64Type(), type);
     dispatchOperands.push_back(
         rewriter.create<arith::ConstantOp>(loc, integer64, typeAttr));
-    dispatchOperandTypes.push_back(integer64);
-
-    ArrayRef<int64_t> integers = dispatchOp.getInputsAttr().asArrayRef();
-    size_t arrayAttrSize = integers.size();
-    for (size_t idx = 0; idx < arrayAttrSize; idx++) {
-      IntegerAttr attr = IntegerAttr::get(rewriter.getI64Type(), integers[idx]);
-      dispatchOperands.push_back(
-          rewriter.create<arith::ConstantOp>(loc, integer64, attr));
-      dispatchOperandTypes.push_back(integer64);
-    }
+
+    appendDispatchInputs(loc, dispatchOp.getInputsAttr().asArrayRef(),
+                         dispatchOp.getDynamicInputs(), dispatchOperands,
+                         rewriter);
 
     // kind of operation to invoke.
     dispatchOperands.push_back(rewriter.create<arith::ConstantOp>(
         loc, integer64, dispatchOp.getKindAttr()));
-    dispatchOperandTypes.push_back(integer64);
 
     // kind of broadcast
     dispatchOperands.push_back(rewriter.create<arith::ConstantOp>(
         loc, integer64, dispatchOp.getFlagsAttr()));
-    dispatchOperandTypes.push_back(integer64);
 
     func::CallOp call =
-        buildDispatchCall(loc, dispatchOperands, dispatchOperandTypes, module,
-                          fnName, useMeta, rewriter);
+        buildDispatchCall(loc, dispatchOperands, fnName, rewriter);
     rewriter.replaceOp(dispatchOp, call.getResult(0));
     return success();
   }
@@ -382,44 +383,30 @@ struct ConvertUnaryDispatch : public OpRewritePattern<UnaryDispatchOp> {
   LogicalResult matchAndRewrite(UnaryDispatchOp dispatchOp,
                                 PatternRewriter &rewriter) const override {
     Location loc = dispatchOp.getLoc();
-    std::string kindAsString = "xsmm_unary_dispatch";
+    std::string fnName = getDispatchFuncName(dispatchOp);
     auto type = (uint64_t)dispatchOp.getDataType();
 
-    FlatSymbolRefAttr fnName =
-        SymbolRefAttr::get(rewriter.getContext(), kindAsString);
-
-    ModuleOp module = dispatchOp->getParentOfType<ModuleOp>();
     SmallVector<Value, 10> dispatchOperands;
-    SmallVector<Type, 10> dispatchOperandTypes;
     IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
 
     IntegerAttr typeAttr = IntegerAttr::get(rewriter.getI64Type(), type);
     dispatchOperands.push_back(
         rewriter.create<arith::ConstantOp>(loc, integer64, typeAttr));
-    dispatchOperandTypes.push_back(integer64);
-
-    ArrayRef<int64_t> integers = dispatchOp.getInputsAttr().asArrayRef();
-    size_t arrayAttrSize = integers.size();
-    for (size_t idx = 0; idx < arrayAttrSize; idx++) {
-      IntegerAttr attr = IntegerAttr::get(rewriter.getI64Type(), integers[idx]);
-      dispatchOperands.push_back(
-          rewriter.create<arith::ConstantOp>(loc, integer64, attr));
-      dispatchOperandTypes.push_back(integer64);
-    }
+
+    appendDispatchInputs(loc, dispatchOp.getInputsAttr().asArrayRef(),
+                         dispatchOp.getDynamicInputs(), dispatchOperands,
+                         rewriter);
 
     // kind of operation to invoke.
     dispatchOperands.push_back(rewriter.create<arith::ConstantOp>(
         loc, integer64, dispatchOp.getKindAttr()));
-    dispatchOperandTypes.push_back(integer64);
 
     // kind of broadcast
     dispatchOperands.push_back(rewriter.create<arith::ConstantOp>(
         loc, integer64, dispatchOp.getFlagsAttr()));
-    dispatchOperandTypes.push_back(integer64);
 
     func::CallOp call =
-        buildDispatchCall(loc, dispatchOperands, dispatchOperandTypes, module,
-                          fnName, useMeta, rewriter);
+        buildDispatchCall(loc, dispatchOperands, fnName, rewriter);
     rewriter.replaceOp(dispatchOp, call.getResult(0));
     return success();
   }
@@ -428,9 +415,12 @@ private:
   bool useMeta = false;
 };
 
-struct ConvertXsmmToFunc : public ConvertXsmmToFuncBase<ConvertXsmmToFunc> {
-  ConvertXsmmToFunc() = default;
-  ConvertXsmmToFunc(bool useExtractMetaData) {
+// Rewrite the XSMM operations of a function to calls. Runs on each function
+// in parallel, the runtime functions must already be declared.
+struct ConvertXsmmOpsToFunc
+    : public ConvertXsmmOpsToFuncBase<ConvertXsmmOpsToFunc> {
+  ConvertXsmmOpsToFunc() = default;
+  ConvertXsmmOpsToFunc(bool useExtractMetaData) {
     this->useExtractMetaData = useExtractMetaData;
   }
   void runOnOperation() override {
@@ -441,6 +431,23 @@ struct ConvertXsmmToFunc : public ConvertXsmmToFuncBase<ConvertXsmmToFunc> {
   }
 };
 
+// Declare the runtime functions in one module step, then convert the
+// functions in parallel.
+struct ConvertXsmmToFunc : public ConvertXsmmToFuncBase<ConvertXsmmToFunc> {
+  ConvertXsmmToFunc() = default;
+  ConvertXsmmToFunc(bool useExtractMetaData) {
+    this->useExtractMetaData = useExtractMetaData;
+  }
+  void runOnOperation() override {
+    tpp::declareXsmmRuntimeFunctions(getOperation(), useExtractMetaData);
+    OpPassManager pm(ModuleOp::getOperationName());
+    pm.addNestedPass<func::FuncOp>(
+        std::make_unique<ConvertXsmmOpsToFunc>(useExtractMetaData));
+    if (failed(runPipeline(pm, getOperation())))
+      signalPassFailure();
+  }
+};
+
 } // namespace
 
 void mlir::tpp::populateXsmmToFuncPatterns(RewritePatternSet &patterns,
@@ -452,7 +459,46 @@ void mlir::tpp::populateXsmmToFuncPatterns(RewritePatternSet &patterns,
           patterns.getContext(), useExtractMetaData);
 }
 
+void mlir::tpp::declareXsmmRuntimeFunctions(ModuleOp module,
+                                            bool useExtractMetaData) {
+  SmallVector<std::pair<std::string, FunctionType>> decls;
+  OpBuilder builder(module.getContext());
+  module.walk([&](Operation *op) {
+    if (isa<TernaryOp, BinaryOp, UnaryOp>(op))
+      decls.emplace_back(getInvokeFuncName(op),
+                         getInvokeFuncType(op, useExtractMetaData, builder));
+    else if (isa<TernaryDispatchOp, BinaryDispatchOp, UnaryDispatchOp>(op))
+      decls.emplace_back(getDispatchFuncName(op),
+                         getDispatchFuncType(op, builder));
+  });
+  if (decls.empty())
+    return;
+
+  // Insert before the last operation of the module, the last use first.
+  builder.setInsertionPoint(module.getBody(),
+                            std::prev(module.getBody()->end()));
+  for (auto &decl : llvm::reverse(decls)) {
+    if (module.lookupSymbol(decl.first))
+      continue;
+    func::FuncOp funcOp =
+        builder.create<func::FuncOp>(module.getLoc(), decl.first, decl.second);
+    if (!useExtractMetaData) {
+      // Insert a function attribute that will trigger the emission of the
+      // corresponding `_mlir_ciface_xxx` interface so that external libraries
+      // see a normalized ABI.
+      funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                      builder.getUnitAttr());
+    }
+    funcOp.setPrivate();
+  }
+}
+
 std::unique_ptr<OperationPass<ModuleOp>>
 mlir::tpp::createConvertXsmmToFuncPass() {
   return std::make_unique<ConvertXsmmToFunc>();
 }
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createConvertXsmmOpsToFuncPass() {
+  return std::make_unique<ConvertXsmmOpsToFunc>();
+}
@@ -0,0 +1,417 @@
+//===- DefaultTppPasses.cpp --------------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Passes.h"
+#include "mlir/Dialect/Bufferization/IR/BufferizableOpInterface.h"
+#include "mlir/Dialect/Bufferization/Transforms/Passes.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/DialectResourceBlobManager.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+#include <limits>
+
+using namespace mlir;
+using namespace mlir::tpp;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "default-tpp-passes"
+
+namespace {
+
+// Blocking factors used by the aggressive pipeline to pack matmuls. 32 is the
+// same factor convert-linalg-to-tpp picks for the non-SIMD dimension.
+constexpr int64_t kBlockingFactors[] = {32, 32, 32};
+
+// GEMMs up to 16x16x8 are cheaper inline than through a LIBXSMM call.
+constexpr int64_t kInlineFlopsThreshold = 2 * 16 * 16 * 8;
+
+// The commits of TPP and of LLVM we build, see lib/TPP/CMakeLists.txt.
+#ifndef TPP_REVISION
+#define TPP_REVISION "unknown"
+#endif
+#ifndef TPP_LLVM_REVISION
+#define TPP_LLVM_REVISION "unknown"
+#endif
+
+// The cache must not depend on the --mlir-print-* command line options: the
+// key needs every element of the constants and the entries must parse back.
+static OpPrintingFlags getCachePrintingFlags() {
+  OpPrintingFlags flags;
+  flags.enableDebugInfo(/*enable=*/false);
+  flags.elideLargeElementsAttrs(std::numeric_limits<int64_t>::max());
+  flags.printGenericOpForm();
+  return flags;
+}
+
+// Same declaration of an external function, made by more than one unit.
+static bool isSameDeclaration(Operation *lhs, Operation *rhs) {
+  auto lhsFunc = dyn_cast<func::FuncOp>(lhs);
+  auto rhsFunc = dyn_cast<func::FuncOp>(rhs);
+  return lhsFunc && rhsFunc && lhsFunc.isDeclaration() &&
+         rhsFunc.isDeclaration() &&
+         lhsFunc.getFunctionType() == rhsFunc.getFunctionType();
+}
+
+struct DefaultTppPasses : public DefaultTppPassesBase<DefaultTppPasses> {
+  DefaultTppPasses() = default;
+  DefaultTppPasses(bool aggressive, bool preDispatch, StringRef cacheDir) {
+    this->aggressive = aggressive;
+    this->preDispatch = preDispatch;
+    this->cacheDir = cacheDir.str();
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    // The nested pipeline runs on the same context, all the dialects it
+    // produces must be loaded upfront.
+    OpPassManager pm(ModuleOp::getOperationName());
+    constructPipeline(pm);
+    pm.getDependentDialects(registry);
+  }
+
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    OpPassManager unitPm(ModuleOp::getOperationName());
+    constructUnitPipeline(unitPm);
+    OpPassManager modulePm(ModuleOp::getOperationName());
+    constructModulePipeline(modulePm);
+    if (cacheDir.empty()) {
+      if (failed(runPipeline(unitPm, module)) ||
+          failed(runPipeline(modulePm, module)))
+        signalPassFailure();
+      return;
+    }
+
+    // Canonicalize first, so that the key does not depend on how the input
+    // was written.
+    OpPassManager canonicalize(ModuleOp::getOperationName());
+    canonicalize.addNestedPass<func::FuncOp>(createCanonicalizerPass());
+    if (failed(runPipeline(canonicalize, module)))
+      return signalPassFailure();
+
+    // Every unit is cached on its own, so that changing a function only
+    // recompiles that function (and the ones it calls or is called by).
+    std::string pipeline;
+    llvm::raw_string_ostream os(pipeline);
+    unitPm.printAsTextualPipeline(os);
+    SmallVector<OwningOpRef<ModuleOp>> units = splitIntoUnits(module);
+    for (OwningOpRef<ModuleOp> &unit : units) {
+      Optional<std::string> key = getCacheKey(*unit, os.str());
+      SmallString<128> path(cacheDir);
+      if (key) {
+        llvm::sys::path::append(path, *key + ".mlir");
+        if (succeeded(loadFromCache(path, *unit)))
+          continue;
+      }
+      // Nested while it compiles, pipelines only run on the pass' operation
+      // or below.
+      module.push_back(*unit);
+      LogicalResult result = runPipeline(unitPm, *unit);
+      (*unit)->remove();
+      if (failed(result))
+        return signalPassFailure();
+      if (key)
+        storeToCache(path, *unit);
+    }
+
+    if (failed(mergeUnits(module, units)) ||
+        failed(runPipeline(modulePm, module)))
+      signalPassFailure();
+  }
+
+private:
+  // Moves the operations of the module to units the pipeline compiles
+  // independently: each function with the functions and globals it
+  // references, transitively. Operations that are not symbols share a unit.
+  SmallVector<OwningOpRef<ModuleOp>> splitIntoUnits(ModuleOp module) const {
+    llvm::EquivalenceClasses<Operation *> classes;
+    Operation *anonymous = nullptr;
+    for (Operation &op : *module.getBody()) {
+      classes.insert(&op);
+      if (!isa<SymbolOpInterface>(op)) {
+        if (anonymous)
+          classes.unionSets(anonymous, &op);
+        anonymous = &op;
+      }
+      Optional<SymbolTable::UseRange> uses = SymbolTable::getSymbolUses(&op);
+      if (!uses)
+        continue;
+      for (const SymbolTable::SymbolUse &use : *uses) {
+        Operation *symbol = module.lookupSymbol(
+            use.getSymbolRef().getRootReference());
+        if (symbol)
+          classes.unionSets(&op, symbol);
+      }
+    }
+
+    SmallVector<OwningOpRef<ModuleOp>> units;
+    llvm::DenseMap<Operation *, ModuleOp> unitOf;
+    for (Operation &op : llvm::make_early_inc_range(*module.getBody())) {
+      ModuleOp &unit = unitOf[classes.getLeaderValue(&op)];
+      if (!unit) {
+        unit = ModuleOp::create(module.getLoc());
+        unit->setAttrs(module->getAttrDictionary());
+        units.emplace_back(unit);
+      }
+      op.remove();
+      unit.push_back(&op);
+    }
+    return units;
+  }
+
+  // Moves the compiled units back into the module. Declarations more than
+  // one unit made (e.g. of runtime functions) are merged, the other private
+  // symbols that clash (e.g. constants) are renamed.
+  LogicalResult mergeUnits(ModuleOp module,
+                           ArrayRef<OwningOpRef<ModuleOp>> units) const {
+    SymbolTable symbols(module);
+    for (const OwningOpRef<ModuleOp> &ownedUnit : units) {
+      ModuleOp unit = ownedUnit.get();
+      for (NamedAttribute attr : unit->getAttrs())
+        module->setAttr(attr.getName(), attr.getValue());
+
+      for (Operation &op : llvm::make_early_inc_range(*unit.getBody())) {
+        auto symbol = dyn_cast<SymbolOpInterface>(op);
+        if (!symbol)
+          continue;
+        Operation *existing = symbols.lookup(symbol.getNameAttr());
+        if (!existing)
+          continue;
+        if (isSameDeclaration(existing, &op)) {
+          op.erase();
+          continue;
+        }
+        if (!symbol.isPrivate())
+          return op.emitError("symbol defined by more than one unit");
+        std::string name;
+        unsigned suffix = 0;
+        do {
+          name = (symbol.getName() + "_" + Twine(suffix++)).str();
+        } while (symbols.lookup(name) || unit.lookupSymbol(name));
+        auto nameAttr = StringAttr::get(module.getContext(), name);
+        if (failed(SymbolTable::replaceAllSymbolUses(&op, nameAttr, unit)))
+          return op.emitError("cannot rename symbol");
+        SymbolTable::setSymbolName(&op, nameAttr);
+      }
+
+      for (Operation &op : llvm::make_early_inc_range(*unit.getBody())) {
+        op.remove();
+        if (isa<SymbolOpInterface>(op))
+          symbols.insert(&op);
+        else
+          module.push_back(&op);
+      }
+    }
+    return success();
+  }
+
+  // Hash of the unit, the pipeline, the compiler and the host CPU. None if
+  // the unit cannot be cached.
+  Optional<std::string> getCacheKey(ModuleOp unit, StringRef pipeline) const {
+    llvm::SHA1 hasher;
+    hasher.update(pipeline);
+    hasher.update(TPP_REVISION);
+    hasher.update(LLVM_VERSION_STRING);
+    hasher.update(TPP_LLVM_REVISION);
+    hasher.update(llvm::sys::getHostCPUName());
+    llvm::StringMap<bool> features;
+    if (llvm::sys::getHostCPUFeatures(features)) {
+      SmallVector<StringRef> enabled;
+      for (const auto &feature : features)
+        if (feature.getValue())
+          enabled.push_back(feature.getKey());
+      llvm::sort(enabled);
+      for (StringRef feature : enabled)
+        hasher.update(feature);
+    }
+    // Without locations: moving or renaming the source file does not change
+    // the key. Each operation in its own scope, so that printing them one by
+    // one stays linear.
+    OpPrintingFlags flags = getCachePrintingFlags();
+    flags.useLocalScope();
+    for (Operation &op : *unit.getBody()) {
+      std::string text;
+      llvm::raw_string_ostream os(text);
+      op.print(os, flags);
+      hasher.update(os.str());
+    }
+    // The printed form only names the dense resources, hash their content.
+    // Resources without a blob live outside of the module (e.g. the side file
+    // of -externalize-constants) and cannot be hashed.
+    bool hashable = true;
+    unit.walk([&](Operation *op) {
+      for (NamedAttribute attr : op->getAttrs()) {
+        auto resource = attr.getValue().dyn_cast<DenseResourceElementsAttr>();
+        if (!resource)
+          continue;
+        AsmResourceBlob *blob = resource.getRawHandle().getBlob();
+        if (!blob) {
+          hashable = false;
+          return WalkResult::interrupt();
+        }
+        ArrayRef<char> data = blob->getData();
+        hasher.update(resource.getRawHandle().getKey());
+        hasher.update(StringRef(data.data(), data.size()));
+      }
+      return WalkResult::advance();
+    });
+    if (!hashable) {
+      LLVM_DEBUG(llvm::dbgs() << "Not caching: external dense resources\n");
+      return llvm::None;
+    }
+    std::string attrs;
+    llvm::raw_string_ostream os(attrs);
+    unit->getAttrDictionary().print(os);
+    hasher.update(os.str());
+    return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+  }
+
+  // Replace the unit's content with the cached output, if any.
+  LogicalResult loadFromCache(StringRef path, ModuleOp unit) const {
+    if (!llvm::sys::fs::exists(path))
+      return failure();
+    ParserConfig config(unit.getContext());
+    OwningOpRef<ModuleOp> cached = parseSourceFile<ModuleOp>(path, config);
+    if (!cached) {
+      LLVM_DEBUG(llvm::dbgs() << "Cannot parse cache entry " << path << "\n");
+      return failure();
+    }
+    LLVM_DEBUG(llvm::dbgs() << "Cache hit " << path << "\n");
+    for (Operation &op : llvm::make_early_inc_range(*unit.getBody()))
+      op.erase();
+    unit.getBody()->getOperations().splice(
+        unit.getBody()->end(), cached->getBody()->getOperations());
+    unit->setAttrs(cached->getOperation()->getAttrDictionary());
+    return success();
+  }
+
+  // Best effort: a cache we cannot write to only costs the next compilation.
+  // Entries are written under a unique name and renamed, so that concurrent
+  // compilations never read a partial entry. The unit is detached, so that it
+  // prints as a top-level module, with its dense resources.
+  void storeToCache(StringRef path, ModuleOp unit) const {
+    SmallString<128> tmpPath;
+    int fd;
+    if (llvm::sys::fs::create_directories(cacheDir) ||
+        llvm::sys::fs::createUniqueFile(path + "-%%%%%%.tmp", fd, tmpPath))
+      return;
+    {
+      llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+      unit->print(os, getCachePrintingFlags());
+      if (os.has_error()) {
+        os.clear_error();
+        llvm::sys::fs::remove(tmpPath);
+        return;
+      }
+    }
+    if (llvm::sys::fs::rename(tmpPath, path))
+      llvm::sys::fs::remove(tmpPath);
+    LLVM_DEBUG(llvm::dbgs() << "Cached " << path << "\n");
+  }
+
+  void constructPipeline(OpPassManager &pm) const {
+    constructUnitPipeline(pm);
+    constructModulePipeline(pm);
+  }
+
+  // Everything that only looks at a function and at what it calls, which
+  // the cache can run on each unit on its own.
+  void constructUnitPipeline(OpPassManager &pm) const {
+    // Pack matmuls and map the blocked layout to BRGEMM.
+    if (aggressive) {
+      pm.addNestedPass<func::FuncOp>(
+          createPackMatmulPass(llvm::makeArrayRef(kBlockingFactors)));
+      pm.addNestedPass<func::FuncOp>(createPropagatePackUnPackPass());
+      pm.addNestedPass<func::FuncOp>(createCanonicalizerPass());
+      pm.addNestedPass<func::FuncOp>(createRewriteToBatchReduceGemmPass());
+    }
+
+    // Annotate linalg.generic with the tpp operation they map to.
+    pm.addNestedPass<func::FuncOp>(createMapLinalgToTppPass());
+
+    // Bufferize, the same way the tests do on the command line.
+    bufferization::OneShotBufferizationOptions buffOpts;
+    buffOpts.bufferizeFunctionBoundaries = true;
+    buffOpts.allowReturnAllocs = true;
+    buffOpts.functionBoundaryTypeConversion =
+        bufferization::BufferizationOptions::LayoutMapOption::IdentityLayoutMap;
+    pm.addNestedPass<func::FuncOp>(
+        bufferization::createEmptyTensorToAllocTensorPass());
+    pm.addPass(bufferization::createOneShotBufferizePass(buffOpts));
+    pm.addNestedPass<func::FuncOp>(createCanonicalizerPass());
+    pm.addPass(bufferization::createDropEquivalentBufferResultsPass());
+    pm.addNestedPass<func::FuncOp>(
+        bufferization::createFinalizingBufferizePass());
+
+    // Convert to tpp and then to xsmm, tiny GEMMs inline. Dispatches are
+    // pure, hoist them out of the loops so that we only JIT each kernel once.
+    pm.addNestedPass<func::FuncOp>(createConvertLinalgToTppPass(
+        /*enableTiling=*/true, /*useParallelLoops=*/true));
+    pm.addNestedPass<func::FuncOp>(
+        createConvertTppToXsmmPass(kInlineFlopsThreshold));
+    // Optimizer steps and dropout: one fused sweep per tensor.
+    pm.addPass(createConvertTppTrainingToFuncPass());
+    // The tpp operations XSMM has no kernel for (requantize): vector code or,
+    // failing that, loops.
+    pm.addNestedPass<func::FuncOp>(createConvertTppToVectorPass());
+    pm.addNestedPass<func::FuncOp>(createLoopInvariantCodeMotionPass());
+
+    // Place the intermediate buffers (packing creates one per blocked
+    // operand) in a reusable arena, so that calls don't allocate. Planning
+    // must come first, the buffers it leaves go in huge pages.
+    pm.addPass(createStaticMemoryPlanningPass());
+    // Large buffers go in huge pages, BRGEMMs walk many pages per tile.
+    pm.addPass(createHugePageAllocationPass());
+
+    // Whatever did not map to tpp: lower linalgx to linalg and vectorize.
+    pm.addNestedPass<func::FuncOp>(createLinalgXToLoopsPass());
+    pm.addNestedPass<func::FuncOp>(createVectorizeLinalgPass());
+
+    // Partition the block loops, packing and fills the same way across
+    // threads, so that each block is first touched by the thread using it.
+    pm.addNestedPass<func::FuncOp>(createPartitionBlockLoopsPass());
+  }
+
+  // Passes collecting the kernels of the whole module, which run after the
+  // units are merged back.
+  void constructModulePipeline(OpPassManager &pm) const {
+    // Serving: JIT all the kernels once, when the module is loaded.
+    if (preDispatch)
+      pm.addPass(createHoistXsmmDispatchPass());
+
+    pm.addPass(createConvertXsmmToFuncPass());
+    pm.addNestedPass<func::FuncOp>(createCanonicalizerPass());
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<ModuleOp>> mlir::tpp::createDefaultTppPass() {
+  return std::make_unique<DefaultTppPasses>();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createDefaultTppPass(bool aggressive, bool preDispatch,
+                                StringRef cacheDir) {
+  return std::make_unique<DefaultTppPasses>(aggressive, preDispatch, cacheDir);
+}
@@ -131,6 +131,50 @@ struct UnPackLayoutInterface
   }
 };
 
+// A, B and the indices are read, C is updated in place.
+struct SparseBrgemmInterface
+    : public BufferizableOpInterface::ExternalModel<SparseBrgemmInterface,
+                                                    linalgx::SparseBrgemmOp> {
+  bool bufferizesToMemoryRead(Operation *op, OpOperand &opOperand,
+                              const AnalysisState &state) const {
+    return true;
+  }
+
+  bool bufferizesToMemoryWrite(Operation *op, OpOperand &opOperand,
+                               const AnalysisState &state) const {
+    return opOperand.getOperandNumber() == 3;
+  }
+
+  SmallVector<OpResult> getAliasingOpResult(Operation *op, OpOperand &opOperand,
+                                            const AnalysisState &state) const {
+    if (opOperand.getOperandNumber() != 3)
+      return {};
+    return {op->getResult(0)};
+  }
+
+  BufferRelation bufferRelation(Operation *op, OpResult opResult,
+                                const AnalysisState &state) const {
+    return BufferRelation::Equivalent;
+  }
+
+  LogicalResult bufferize(Operation *op, RewriterBase &rewriter,
+                          const BufferizationOptions &options) const {
+    SmallVector<Value> buffers;
+    for (Value operand : op->getOperands()) {
+      FailureOr<Value> maybeBuffer = getBuffer(rewriter, operand, options);
+      if (failed(maybeBuffer))
+        return failure();
+      buffers.push_back(*maybeBuffer);
+    }
+
+    rewriter.create<linalgx::SparseBrgemmOp>(op->getLoc(), TypeRange(),
+                                             buffers[0], buffers[1],
+                                             buffers[2], buffers[3]);
+    replaceOpWithBufferizedValues(rewriter, op, buffers[3]);
+    return success();
+  }
+};
+
 } // namespace
 } // namespace linalgx
 } // namespace mlir
@@ -141,5 +185,6 @@ void mlir::linalgx::registerBufferizableOpInterfaceExternalModels(
       +[](MLIRContext *ctx, linalgx::LinalgXDialect *dialect) {
         PackOp::attachInterface<linalgx::PackLayoutInterface>(*ctx);
         UnPackOp::attachInterface<linalgx::UnPackLayoutInterface>(*ctx);
+        SparseBrgemmOp::attachInterface<linalgx::SparseBrgemmInterface>(*ctx);
       });
 }
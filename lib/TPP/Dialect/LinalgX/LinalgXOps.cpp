@@ -903,5 +903,57 @@ void UnPackOp::getEffects(
                  outputBuffers);
 }
 
+//===----------------------------------------------------------------------===//
+// SparseBrgemmOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult SparseBrgemmOp::verify() {
+  ShapedType typeA = getBatchMatrixA().getType().cast<ShapedType>();
+  ShapedType typeB = getBatchMatrixB().getType().cast<ShapedType>();
+  ShapedType typeIndices = getIndices().getType().cast<ShapedType>();
+  ShapedType typeC = getMatrixC().getType().cast<ShapedType>();
+  if (typeA.getRank() != 3 || typeB.getRank() != 3 || typeC.getRank() != 2)
+    return emitOpError("expects 3d batch matrices and a 2d output");
+  if (typeIndices.getRank() != 1 ||
+      !typeIndices.getElementType().isSignlessInteger(64))
+    return emitOpError("expects 1d i64 block indices");
+
+  // C(m, n) += A(b, m, k) * B(b, k, n), one index per block of B.
+  auto isCompatibleDim = [](int64_t lhs, int64_t rhs) {
+    return ShapedType::isDynamic(lhs) || ShapedType::isDynamic(rhs) ||
+           lhs == rhs;
+  };
+  ArrayRef<int64_t> shapeA = typeA.getShape();
+  ArrayRef<int64_t> shapeB = typeB.getShape();
+  ArrayRef<int64_t> shapeC = typeC.getShape();
+  if (!isCompatibleDim(typeIndices.getShape()[0], shapeB[0]) ||
+      !isCompatibleDim(shapeA[1], shapeC[0]) ||
+      !isCompatibleDim(shapeA[2], shapeB[1]) ||
+      !isCompatibleDim(shapeB[2], shapeC[1]))
+    return emitOpError("fails to verify operands dimensions mismatch");
+
+  if (typeC.isa<RankedTensorType>()) {
+    if (getResults().size() != 1 || getResults()[0].getType() != typeC)
+      return emitOpError("expects one result of the type of the output");
+  } else if (!getResults().empty()) {
+    return emitOpError("expects no result with buffer semantics");
+  }
+  return success();
+}
+
+void SparseBrgemmOp::getEffects(
+    SmallVectorImpl<SideEffects::EffectInstance<MemoryEffects::Effect>>
+        &effects) {
+  SmallVector<Value> inputBuffers;
+  for (Value input : {getBatchMatrixA(), getBatchMatrixB(), getIndices()})
+    if (input.getType().isa<MemRefType>())
+      inputBuffers.push_back(input);
+  SmallVector<Value> outputBuffers;
+  if (getMatrixC().getType().isa<MemRefType>())
+    outputBuffers.push_back(getMatrixC());
+  getEffectsImpl(effects, getOperation()->getResults(), inputBuffers,
+                 outputBuffers);
+}
+
 #define GET_OP_CLASSES
 #include "TPP/Dialect/LinalgX/LinalgXOps.cpp.inc"
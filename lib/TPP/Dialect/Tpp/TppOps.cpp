@@ -16,6 +16,11 @@
 using namespace mlir;
 using namespace mlir::tpp;
 
+// A dynamic dimension is only known at runtime: it matches any size.
+static bool isCompatibleDim(int64_t lhs, int64_t rhs) {
+  return lhs == rhs || ShapedType::isDynamic(lhs) || ShapedType::isDynamic(rhs);
+}
+
 //===----------------------------------------------------------------------===//
 // IdentityOp
 //===----------------------------------------------------------------------===//
@@ -46,7 +51,7 @@ LogicalResult IdentityOp::verify() {
     int64_t inputDim = shapeInput[i];
     int64_t outputDim = shapeOutput[j];
 
-    if (inputDim == outputDim)
+    if (isCompatibleDim(inputDim, outputDim))
       continue;
     if (inputDim == 1 && outputDim > 1)
       continue;
@@ -55,6 +60,29 @@ LogicalResult IdentityOp::verify() {
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// ReluBackwardOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult ReluBackwardOp::verify() {
+  MemRefType gradType = getGrad().getType().cast<MemRefType>();
+  MemRefType inputType = getInput().getType().cast<MemRefType>();
+  MemRefType outputType = getOutput().getType().cast<MemRefType>();
+  if (gradType.getElementType() != outputType.getElementType() ||
+      inputType.getElementType() != outputType.getElementType())
+    return emitOpError("expects all operands to have the same element type");
+  if (gradType.getRank() != outputType.getRank() ||
+      inputType.getRank() != outputType.getRank())
+    return emitOpError("expects all operands to have the same rank");
+  for (int64_t dim = 0, rank = outputType.getRank(); dim < rank; dim++) {
+    int64_t size = outputType.getShape()[dim];
+    if (!isCompatibleDim(gradType.getShape()[dim], size) ||
+        !isCompatibleDim(inputType.getShape()[dim], size))
+      return emitOpError("fails to verify operands dimensions mismatch");
+  }
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // MatmulOp
 //===----------------------------------------------------------------------===//
@@ -74,7 +102,8 @@ static bool verifyMatmulOperandsDims(ArrayRef<int64_t> shapeA,
   int64_t n = shapeC[1];
   int64_t k = shapeA[1];
   // Verify C(m, n) = A(m, k) B(k, n)
-  if (shapeB[0] != k || shapeB[1] != n || shapeA[0] != m)
+  if (!isCompatibleDim(shapeB[0], k) || !isCompatibleDim(shapeB[1], n) ||
+      !isCompatibleDim(shapeA[0], m))
     return false;
   return true;
 }
@@ -118,7 +147,7 @@ LogicalResult BrgemmOp::verify() {
   if (!verifyBRGemmShape(tensorA, tensorB, matrixC))
     return emitOpError("fails to verify operands shapes");
   // Check batch dimension.
-  if (tensorA.getShape()[0] != tensorB.getShape()[0])
+  if (!isCompatibleDim(tensorA.getShape()[0], tensorB.getShape()[0]))
     return emitOpError("fails to verify operands dimensions mismatch");
   // Check all others that must be 'matmul' like.
   if (!verifyMatmulOperandsDims(tensorA.getShape().drop_front(),
@@ -217,3 +246,141 @@ void VNNI_BrgemmOp::build(OpBuilder &builder, OperationState &state,
                           ValueRange inputs, Value output) {
   VNNI_BrgemmOp::build(builder, state, inputs[0], inputs[1], output);
 }
+
+//===----------------------------------------------------------------------===//
+// SgdUpdateOp and AdamUpdateOp
+//===----------------------------------------------------------------------===//
+
+// The parameter, its gradient and its optimizer state have the same shape.
+static LogicalResult verifyParamOperands(Operation *op, Value param,
+                                         ValueRange state) {
+  MemRefType paramType = param.getType().cast<MemRefType>();
+  for (Value operand : state) {
+    MemRefType operandType = operand.getType().cast<MemRefType>();
+    if (operandType.getRank() != paramType.getRank())
+      return op->emitOpError("expects all operands to have the same rank");
+    for (int64_t dim = 0, rank = paramType.getRank(); dim < rank; dim++) {
+      if (!isCompatibleDim(operandType.getShape()[dim],
+                           paramType.getShape()[dim]))
+        return op->emitOpError("fails to verify operands dimensions mismatch");
+    }
+  }
+  return success();
+}
+
+LogicalResult SgdUpdateOp::verify() {
+  return verifyParamOperands(*this, getParam(), {getGrad(), getVelocity()});
+}
+
+LogicalResult AdamUpdateOp::verify() {
+  return verifyParamOperands(*this, getParam(), {getGrad(), getM(), getV()});
+}
+
+//===----------------------------------------------------------------------===//
+// DropoutOp and DropoutBackwardOp
+//===----------------------------------------------------------------------===//
+
+// The runtime walks the tensors and the mask as flat arrays.
+static LogicalResult verifyDropout(Operation *op, Value input, Value output,
+                                   Value mask, APFloat probability) {
+  MemRefType inputType = input.getType().cast<MemRefType>();
+  MemRefType outputType = output.getType().cast<MemRefType>();
+  MemRefType maskType = mask.getType().cast<MemRefType>();
+  float p = probability.convertToFloat();
+  if (!(p >= 0.0f && p < 1.0f))
+    return op->emitOpError("expects a probability in [0, 1)");
+  if (!inputType.getLayout().isIdentity() ||
+      !outputType.getLayout().isIdentity() ||
+      !maskType.getLayout().isIdentity())
+    return op->emitOpError("expects contiguous memrefs");
+  if (failed(verifyParamOperands(op, output, input)))
+    return failure();
+  // One bit per element, rounded up to bytes.
+  if (outputType.hasStaticShape() && maskType.hasStaticShape() &&
+      maskType.getShape()[0] != (outputType.getNumElements() + 7) / 8)
+    return op->emitOpError("expects a mask of ")
+           << (outputType.getNumElements() + 7) / 8 << " bytes";
+  return success();
+}
+
+LogicalResult DropoutOp::verify() {
+  return verifyDropout(*this, getInput(), getOutput(), getMask(),
+                       getProbability());
+}
+
+LogicalResult DropoutBackwardOp::verify() {
+  return verifyDropout(*this, getGrad(), getOutput(), getMask(),
+                       getProbability());
+}
+
+//===----------------------------------------------------------------------===//
+// QuantizedMatmulOp and QuantizedBrgemmOp
+//===----------------------------------------------------------------------===//
+
+// Verify C(m, n) = A(m, k) B(k / 4, n, 4).
+static LogicalResult verifyQuantizedMatmulDims(Operation *op,
+                                               ArrayRef<int64_t> shapeA,
+                                               ArrayRef<int64_t> shapeB,
+                                               ArrayRef<int64_t> shapeC) {
+  if (shapeB.back() != 4)
+    return op->emitOpError("expects matrix B in VNNI4 format");
+  if (shapeA[0] != shapeC[0] || shapeB[1] != shapeC[1] ||
+      shapeB[0] * 4 != shapeA[1])
+    return op->emitOpError("fails to verify operands dimensions mismatch");
+  return success();
+}
+
+LogicalResult QuantizedMatmulOp::verify() {
+  return verifyQuantizedMatmulDims(*this, getMatrixAType().getShape(),
+                                   getMatrixBType().getShape(),
+                                   getMatrixCType().getShape());
+}
+
+LogicalResult QuantizedBrgemmOp::verify() {
+  ArrayRef<int64_t> shapeA = getBatchMatrixAType().getShape();
+  ArrayRef<int64_t> shapeB = getBatchMatrixBType().getShape();
+  if (shapeA[0] != shapeB[0])
+    return emitOpError("fails to verify operands dimensions mismatch");
+  return verifyQuantizedMatmulDims(*this, shapeA.drop_front(),
+                                   shapeB.drop_front(),
+                                   getMatrixCType().getShape());
+}
+
+//===----------------------------------------------------------------------===//
+// RequantizeOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult RequantizeOp::verify() {
+  MemRefType inputType = getInput().getType().cast<MemRefType>();
+  MemRefType outputType = getOutput().getType().cast<MemRefType>();
+  if (inputType.getShape() != outputType.getShape())
+    return emitOpError("fails to verify operands dimensions mismatch");
+  // The output is either signed or unsigned int8, not a mix of both.
+  int64_t min = getMinAttr().getInt();
+  int64_t max = getMaxAttr().getInt();
+  bool isSigned = min >= -128 && max <= 127;
+  bool isUnsigned = min >= 0 && max <= 255;
+  if (min > max || (!isSigned && !isUnsigned))
+    return emitOpError("expects min <= max within [-128, 127] or [0, 255]");
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// SparseBrgemmOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult SparseBrgemmOp::verify() {
+  MemRefType tensorA = getBatchMatrixAType();
+  MemRefType tensorB = getBatchMatrixBType();
+  MemRefType matrixC = getMatrixCType();
+  if (!verifyBRGemmShape(tensorA, tensorB, matrixC))
+    return emitOpError("fails to verify operands shapes");
+  // One block index per block of B.
+  if (!isCompatibleDim(getIndicesType().getShape()[0], tensorB.getShape()[0]))
+    return emitOpError("expects one index per block of matrix B");
+  if (!verifyMatmulOperandsDims(tensorA.getShape().drop_front(),
+                                tensorB.getShape().drop_front(),
+                                matrixC.getShape()))
+    return emitOpError("fails to verify operands dimensions mismatch");
+  return success();
+}
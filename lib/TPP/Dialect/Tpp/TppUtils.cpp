@@ -111,6 +111,14 @@ bool hasStaticShape(linalg::LinalgOp linalgOp) {
   return !linalgOp.hasDynamicShape();
 }
 
+bool hasStaticInnermostDims(linalg::LinalgOp linalgOp) {
+  return llvm::all_of(linalgOp->getOperands(), [](Value operand) {
+    auto shapedType = operand.getType().dyn_cast<ShapedType>();
+    return !shapedType || shapedType.getRank() == 0 ||
+           !ShapedType::isDynamic(shapedType.getShape().back());
+  });
+}
+
 bool hasTppMark(linalg::LinalgOp linalgOp) {
   // Here we are abusing a bit the linalg library name machinery.
   // Main asserts if we query the name at tensor level. Inspect
@@ -303,7 +311,7 @@ bool isTppMatmul(linalg::GenericOp linalgOp) {
 bool canMapToTppAdd(linalg::GenericOp linalgOp) {
   if (!linalg::isElementwise(linalgOp))
     return false;
-  if (!hasStaticShape(linalgOp) || !hasOneInputOneOutput(linalgOp))
+  if (!hasStaticInnermostDims(linalgOp) || !hasOneInputOneOutput(linalgOp))
     return false;
   return hasOnlyScalarElementwiseOp<arith::AddFOp>(linalgOp.getRegion());
 }
@@ -322,7 +330,7 @@ bool isTppAdd(linalg::GenericOp linalgOp) {
 bool canMapToTppRelu(linalg::GenericOp linalgOp) {
   if (!linalg::isElementwise(linalgOp))
     return false;
-  if (!hasStaticShape(linalgOp) || !hasMaxfZeroOp(linalgOp))
+  if (!hasStaticInnermostDims(linalgOp) || !hasMaxfZeroOp(linalgOp))
     return false;
   return hasOnlyScalarElementwiseOp<arith::MaxFOp>(linalgOp.getRegion());
 }
@@ -338,6 +346,64 @@ bool isTppRelu(linalg::GenericOp linalgOp) {
   return hasOnlyScalarElementwiseOp<arith::MaxFOp>(linalgOp.getRegion());
 }
 
+// Returns true if the region computes 'activation > 0 ? gradient : 0', with
+// the gradient as first input and the activation as second input.
+static bool hasReluBackwardBody(linalg::GenericOp linalgOp) {
+  Region &region = linalgOp.getRegion();
+  if (!region.hasOneBlock())
+    return false;
+  Block &block = region.front();
+  if (block.getNumArguments() != 3)
+    return false;
+  // The zeros may be materialized in the body.
+  if (llvm::count_if(block, [](Operation &op) {
+        return !isa<arith::ConstantOp>(op);
+      }) != 3)
+    return false;
+  auto yieldOp = cast<linalg::YieldOp>(block.getTerminator());
+  if (yieldOp.getNumOperands() != 1)
+    return false;
+  auto selectOp = yieldOp.getOperand(0).getDefiningOp<arith::SelectOp>();
+  if (!selectOp || selectOp.getTrueValue() != block.getArgument(0) ||
+      !isValConstZero(selectOp.getFalseValue()))
+    return false;
+  auto cmpOp = selectOp.getCondition().getDefiningOp<arith::CmpFOp>();
+  if (!cmpOp)
+    return false;
+  if (cmpOp.getPredicate() == arith::CmpFPredicate::OGT)
+    return cmpOp.getLhs() == block.getArgument(1) &&
+           isValConstZero(cmpOp.getRhs());
+  if (cmpOp.getPredicate() == arith::CmpFPredicate::OLT)
+    return cmpOp.getRhs() == block.getArgument(1) &&
+           isValConstZero(cmpOp.getLhs());
+  return false;
+}
+
+bool canMapToTppReluBackward(linalg::GenericOp linalgOp) {
+  if (!linalg::isElementwise(linalgOp))
+    return false;
+  if ((linalgOp.getNumDpsInputs() != 2) || (linalgOp.getNumDpsInits() != 1))
+    return false;
+  if (!hasStaticInnermostDims(linalgOp) ||
+      !llvm::all_of(linalgOp.getIndexingMapsArray(),
+                    [](AffineMap map) { return map.isIdentity(); }))
+    return false;
+  return hasReluBackwardBody(linalgOp);
+}
+
+bool isTppReluBackward(linalg::GenericOp linalgOp) {
+  if (linalgOp.getNumLoops() != linalgOp.getNumParallelLoops())
+    return false;
+  if ((linalgOp.getNumDpsInputs() != 2) || (linalgOp.getNumDpsInits() != 1))
+    return false;
+  if (linalgOp.hasTensorSemantics())
+    return false;
+  if (!llvm::all_of(linalgOp.getIndexingMapsArray(),
+                    [](AffineMap map) { return map.isIdentity(); }))
+    return false;
+  return hasReluBackwardBody(linalgOp);
+}
+
 bool canMapToTppIdentity(linalg::GenericOp linalgOp) {
   if (!linalg::isElementwise(linalgOp))
     return false;
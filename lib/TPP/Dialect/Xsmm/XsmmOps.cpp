@@ -23,3 +23,28 @@ LogicalResult TernaryOp::verify() { return success(); }
 LogicalResult BinaryOp::verify() { return success(); }
 
 LogicalResult UnaryOp::verify() { return success(); }
+
+// Every dynamic entry of 'inputs' needs its runtime value.
+static LogicalResult verifyDispatchInputs(Operation *op,
+                                          ArrayRef<int64_t> inputs,
+                                          ValueRange dynamicInputs) {
+  int64_t numDynamic = llvm::count_if(
+      inputs, [](int64_t input) { return ShapedType::isDynamic(input); });
+  if (numDynamic != static_cast<int64_t>(dynamicInputs.size()))
+    return op->emitOpError("expected ")
+           << numDynamic << " dynamic inputs, but got "
+           << dynamicInputs.size();
+  return success();
+}
+
+LogicalResult TernaryDispatchOp::verify() {
+  return verifyDispatchInputs(*this, getInputs(), getDynamicInputs());
+}
+
+LogicalResult BinaryDispatchOp::verify() {
+  return verifyDispatchInputs(*this, getInputs(), getDynamicInputs());
+}
+
+LogicalResult UnaryDispatchOp::verify() {
+  return verifyDispatchInputs(*this, getInputs(), getDynamicInputs());
+}
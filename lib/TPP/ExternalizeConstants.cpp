@@ -0,0 +1,143 @@
+//===- ExternalizeConstants.cpp ----------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Passes.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/DialectResourceBlobManager.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "externalize-constants"
+
+namespace {
+
+// Alignment of each constant in the side file, enough for any vector load.
+constexpr uint64_t kAlignment = 64;
+
+struct ExternalizeConstants
+    : public ExternalizeConstantsBase<ExternalizeConstants> {
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    MLIRContext *ctx = &getContext();
+    if (file.empty()) {
+      module.emitError("externalize-constants requires a side file");
+      return signalPassFailure();
+    }
+
+    // Recorded as an absolute path, so that the module can be run from any
+    // directory.
+    SmallString<128> path(file);
+    if (std::error_code ec = llvm::sys::fs::make_absolute(path)) {
+      module.emitError("cannot resolve '" + file + "': " + ec.message());
+      return signalPassFailure();
+    }
+
+    // Opened on the first constant to move, so that a module without any
+    // doesn't truncate the file.
+    std::unique_ptr<llvm::raw_fd_ostream> os;
+    bool openFailed = false;
+    auto getStream = [&]() -> llvm::raw_fd_ostream * {
+      if (!os && !openFailed) {
+        std::error_code ec;
+        os = std::make_unique<llvm::raw_fd_ostream>(path, ec);
+        if (ec) {
+          module.emitError("cannot open '" + path + "': " + ec.message());
+          os.reset();
+          openFailed = true;
+        }
+      }
+      return os.get();
+    };
+
+    auto &manager = DenseResourceElementsHandle::getManagerInterface(ctx);
+    SmallVector<NamedAttribute> offsets;
+    uint64_t fileOffset = 0;
+
+    // Returns the resource replacing 'attr', or nullptr if it stays inline.
+    auto externalize = [&](Attribute attr) -> DenseResourceElementsAttr {
+      auto dense = attr.dyn_cast_or_null<DenseElementsAttr>();
+      if (!dense || dense.isSplat())
+        return nullptr;
+      // Sub-byte types (i1) are bit-packed in the raw data.
+      if (dense.getElementType().getIntOrFloatBitWidth() % 8 != 0)
+        return nullptr;
+      ArrayRef<char> rawData = dense.getRawData();
+      if (static_cast<int64_t>(rawData.size()) < threshold)
+        return nullptr;
+      llvm::raw_fd_ostream *stream = getStream();
+      if (!stream)
+        return nullptr;
+
+      uint64_t alignedOffset = llvm::alignTo(fileOffset, kAlignment);
+      stream->write_zeros(alignedOffset - fileOffset);
+      stream->write(rawData.data(), rawData.size());
+      fileOffset = alignedOffset + rawData.size();
+
+      // No blob: the data is only in the side file.
+      DenseResourceElementsHandle handle = manager.insert("tpp_external");
+      offsets.push_back(NamedAttribute(
+          StringAttr::get(ctx, handle.getKey()),
+          IntegerAttr::get(IntegerType::get(ctx, 64), alignedOffset)));
+      return DenseResourceElementsAttr::get(dense.getType(), handle);
+    };
+
+    module.walk([&](Operation *op) {
+      if (auto constOp = dyn_cast<arith::ConstantOp>(op)) {
+        if (auto resource = externalize(constOp.getValue()))
+          constOp->setAttr(constOp.getValueAttrName(), resource);
+      } else if (auto global = dyn_cast<memref::GlobalOp>(op)) {
+        auto init = global.getInitialValue();
+        if (!init)
+          return;
+        if (auto resource = externalize(*init))
+          global.setInitialValueAttr(resource);
+      }
+    });
+
+    if (openFailed)
+      return signalPassFailure();
+    if (offsets.empty())
+      return;
+
+    // Write errors (e.g. a full disk) only show up on the stream.
+    os->close();
+    if (os->has_error()) {
+      module.emitError("cannot write '" + path +
+                       "': " + os->error().message());
+      os->clear_error();
+      return signalPassFailure();
+    }
+
+    // Recorded for tpp-run, see MLIRBench::loadExternalInputs.
+    NamedAttribute entries[] = {
+        NamedAttribute(StringAttr::get(ctx, "file"),
+                       StringAttr::get(ctx, path)),
+        NamedAttribute(StringAttr::get(ctx, "offsets"),
+                       DictionaryAttr::get(ctx, offsets))};
+    module->setAttr("tpp.external_resources",
+                    DictionaryAttr::get(ctx, entries));
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createExternalizeConstantsPass() {
+  return std::make_unique<ExternalizeConstants>();
+}
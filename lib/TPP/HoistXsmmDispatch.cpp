@@ -0,0 +1,116 @@
+//===- HoistXsmmDispatch.cpp -------------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Dialect/Xsmm/XsmmOps.h"
+#include "TPP/Passes.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "llvm/ADT/DenseMap.h"
+
+using namespace mlir;
+using namespace mlir::xsmm;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "hoist-xsmm-dispatch"
+
+namespace {
+
+// Module initializer, called once before any other function (see tpp-engine).
+constexpr StringLiteral kInitFnName = "tpp_init";
+
+static func::FuncOp getOrCreateInitFn(ModuleOp module, OpBuilder &builder) {
+  if (auto init = module.lookupSymbol<func::FuncOp>(kInitFnName))
+    return init;
+
+  OpBuilder::InsertionGuard guard(builder);
+  builder.setInsertionPointToEnd(module.getBody());
+  auto init = builder.create<func::FuncOp>(module.getLoc(), kInitFnName,
+                                           builder.getFunctionType({}, {}));
+  init->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                builder.getUnitAttr());
+  builder.setInsertionPointToEnd(init.addEntryBlock());
+  builder.create<func::ReturnOp>(module.getLoc());
+  return init;
+}
+
+struct HoistXsmmDispatch : public HoistXsmmDispatchBase<HoistXsmmDispatch> {
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    OpBuilder builder(&getContext());
+
+    SmallVector<Operation *> dispatches;
+    module.walk([&](Operation *op) {
+      if (!isa<TernaryDispatchOp, BinaryDispatchOp, UnaryDispatchOp>(op))
+        return;
+      // Dispatches on runtime sizes depend on values of the function.
+      if (op->getNumOperands() != 0)
+        return;
+      auto func = op->getParentOfType<func::FuncOp>();
+      if (func && func.getName() != kInitFnName)
+        dispatches.push_back(op);
+    });
+    if (dispatches.empty())
+      return;
+
+    func::FuncOp init = getOrCreateInitFn(module, builder);
+    if (init.isExternal()) {
+      init.emitError("expected a body for the module initializer");
+      return signalPassFailure();
+    }
+
+    // Dispatches are pure and only take attributes: one global per distinct
+    // kernel, shared by all the functions calling it.
+    auto globalType = MemRefType::get({}, builder.getI64Type());
+    llvm::DenseMap<std::pair<Attribute, Attribute>, memref::GlobalOp> globals;
+    unsigned counter = 0;
+    for (Operation *dispatch : dispatches) {
+      auto key = std::make_pair<Attribute, Attribute>(
+          dispatch->getName().getIdentifier(), dispatch->getAttrDictionary());
+      memref::GlobalOp global = globals.lookup(key);
+      if (!global) {
+        std::string name;
+        do {
+          name = "__xsmm_dispatch_" + std::to_string(counter++);
+        } while (module.lookupSymbol(name));
+        builder.setInsertionPoint(init);
+        global = builder.create<memref::GlobalOp>(
+            dispatch->getLoc(), name, builder.getStringAttr("private"),
+            globalType, /*initial_value=*/builder.getUnitAttr(),
+            /*constant=*/false, /*alignment=*/nullptr);
+        globals[key] = global;
+
+        // Dispatch once, in the initializer.
+        builder.setInsertionPoint(init.getBody().front().getTerminator());
+        Operation *clone = builder.clone(*dispatch);
+        Value address = builder.create<memref::GetGlobalOp>(
+            dispatch->getLoc(), globalType, global.getSymName());
+        builder.create<memref::StoreOp>(dispatch->getLoc(),
+                                        clone->getResult(0), address);
+      }
+
+      builder.setInsertionPoint(dispatch);
+      Value address = builder.create<memref::GetGlobalOp>(
+          dispatch->getLoc(), globalType, global.getSymName());
+      Value kernel = builder.create<memref::LoadOp>(dispatch->getLoc(), address);
+      dispatch->getResult(0).replaceAllUsesWith(kernel);
+      dispatch->erase();
+    }
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createHoistXsmmDispatchPass() {
+  return std::make_unique<HoistXsmmDispatch>();
+}
@@ -0,0 +1,173 @@
+//===- HugePageAllocation.cpp ------------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Passes.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Interfaces/CallInterfaces.h"
+#include "mlir/Interfaces/LoopLikeInterface.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "huge-page-allocation"
+
+namespace {
+
+// Runtime functions allocating and releasing huge page buffers (see tpp-rt).
+constexpr StringLiteral kAllocFnName = "tpp_huge_alloc";
+constexpr StringLiteral kFreeFnName = "tpp_huge_free";
+
+// Size in bytes of a statically shaped allocation, which a memref.view of a
+// byte buffer can replace.
+static FailureOr<int64_t> getAllocSize(memref::AllocOp alloc) {
+  MemRefType type = alloc.getType();
+  if (!type.hasStaticShape() || !type.getLayout().isIdentity() ||
+      type.getMemorySpace() || !type.getElementType().isIntOrFloat() ||
+      !alloc.getSymbolOperands().empty())
+    return failure();
+  int64_t bits = type.getNumElements() * type.getElementTypeBitWidth();
+  return static_cast<int64_t>(llvm::divideCeil(bits, 8));
+}
+
+// Whether the buffer leaves the function through this use: returned, passed
+// to a call, stored in memory or turned into a pointer. Whoever gets it could
+// keep it, or release it with free.
+static bool isEscapingUse(OpOperand &use) {
+  Operation *user = use.getOwner();
+  if (isa<func::ReturnOp, CallOpInterface,
+          memref::ExtractAlignedPointerAsIndexOp>(user))
+    return true;
+  if (auto store = dyn_cast<memref::StoreOp>(user))
+    return store.getValueToStore() == use.get();
+  return false;
+}
+
+// Collect the deallocations of the allocation and of its aliases. Fails if
+// the buffer escapes the function.
+static LogicalResult
+collectDeallocs(memref::AllocOp alloc,
+                SmallVectorImpl<memref::DeallocOp> &deallocs) {
+  SmallVector<Value> worklist = {alloc.getResult()};
+  llvm::DenseSet<Value> visited = {alloc.getResult()};
+  auto addAliases = [&](ResultRange results) {
+    for (Value result : results)
+      if (result.getType().isa<BaseMemRefType>() &&
+          visited.insert(result).second)
+        worklist.push_back(result);
+  };
+
+  while (!worklist.empty()) {
+    Value value = worklist.pop_back_val();
+    for (OpOperand &use : value.getUses()) {
+      Operation *user = use.getOwner();
+      if (isEscapingUse(use))
+        return failure();
+      if (auto dealloc = dyn_cast<memref::DeallocOp>(user)) {
+        deallocs.push_back(dealloc);
+        continue;
+      }
+      addAliases(user->getResults());
+      // Yielded out of a region: the parent's results may alias it.
+      if (user->hasTrait<OpTrait::IsTerminator>())
+        addAliases(user->getParentOp()->getResults());
+    }
+  }
+  return success();
+}
+
+// Declare a runtime function with the C interface, unless it already is.
+static func::FuncOp getOrCreateRuntimeFn(ModuleOp module, OpBuilder &builder,
+                                         StringRef name,
+                                         FunctionType type) {
+  if (auto func = module.lookupSymbol<func::FuncOp>(name))
+    return func;
+
+  OpBuilder::InsertionGuard guard(builder);
+  builder.setInsertionPointToEnd(module.getBody());
+  auto func = builder.create<func::FuncOp>(module.getLoc(), name, type);
+  func->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                builder.getUnitAttr());
+  func.setPrivate();
+  return func;
+}
+
+struct HugePageAllocation
+    : public HugePageAllocationBase<HugePageAllocation> {
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    OpBuilder builder(&getContext());
+
+    // Collect first, the rewrite declares the runtime functions in the module.
+    // Allocations in loops are left alone, mapping and unmapping on every
+    // iteration costs more than the TLB misses saved.
+    SmallVector<memref::AllocOp> allocs;
+    module.walk([&](memref::AllocOp alloc) {
+      if (alloc->getParentOfType<LoopLikeOpInterface>())
+        return;
+      FailureOr<int64_t> size = getAllocSize(alloc);
+      if (succeeded(size) && *size >= threshold)
+        allocs.push_back(alloc);
+    });
+
+    // memref<?xi8> tpp_huge_alloc(i64 size), tpp_huge_free(memref<?xi8>)
+    auto bufferType =
+        MemRefType::get({ShapedType::kDynamic}, builder.getI8Type());
+    FunctionType allocType =
+        builder.getFunctionType({builder.getI64Type()}, {bufferType});
+    FunctionType freeType = builder.getFunctionType({bufferType}, {});
+
+    for (memref::AllocOp alloc : allocs) {
+      SmallVector<memref::DeallocOp> deallocs;
+      if (failed(collectDeallocs(alloc, deallocs)))
+        continue;
+      int64_t size = *getAllocSize(alloc);
+      func::FuncOp allocFn =
+          getOrCreateRuntimeFn(module, builder, kAllocFnName, allocType);
+      func::FuncOp freeFn =
+          getOrCreateRuntimeFn(module, builder, kFreeFnName, freeType);
+      LLVM_DEBUG(llvm::dbgs() << "Huge page allocation of " << size
+                              << " bytes: " << alloc << "\n");
+
+      Location loc = alloc.getLoc();
+      builder.setInsertionPoint(alloc);
+      Value sizeVal = builder.create<arith::ConstantIntOp>(loc, size, 64);
+      Value buffer =
+          builder.create<func::CallOp>(loc, allocFn, ValueRange{sizeVal})
+              .getResult(0);
+      Value offset = builder.create<arith::ConstantIndexOp>(loc, 0);
+      Value view = builder.create<memref::ViewOp>(loc, alloc.getType(), buffer,
+                                                  offset, ValueRange{});
+      alloc.getResult().replaceAllUsesWith(view);
+      alloc.erase();
+
+      for (memref::DeallocOp dealloc : deallocs) {
+        builder.setInsertionPoint(dealloc);
+        builder.create<func::CallOp>(dealloc.getLoc(), freeFn,
+                                     ValueRange{buffer});
+        dealloc.erase();
+      }
+    }
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createHugePageAllocationPass() {
+  return std::make_unique<HugePageAllocation>();
+}
@@ -0,0 +1,48 @@
+//===- LLVMLoweringPipeline.cpp ----------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Passes.h"
+#include "mlir/Conversion/Passes.h"
+#include "mlir/Dialect/Arith/Transforms/Passes.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/Passes.h"
+#include "mlir/Dialect/Tensor/Transforms/Passes.h"
+#include "mlir/Dialect/Vector/Transforms/Passes.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Transforms/Passes.h"
+
+using namespace mlir;
+
+void mlir::tpp::addLLVMLoweringPasses(OpPassManager &passManager,
+                                      bool parallel) {
+  // Bufferization, if needed
+  passManager.addNestedPass<func::FuncOp>(createTensorBufferizePass());
+  passManager.addNestedPass<func::FuncOp>(vector::createVectorBufferizePass());
+  passManager.addNestedPass<func::FuncOp>(createLinalgBufferizePass());
+
+  // Partial Lowering
+  passManager.addPass(tpp::createConvertCheckToLoopsPass());
+  passManager.addPass(createConvertTensorToLinalgPass());
+  passManager.addNestedPass<func::FuncOp>(createConvertLinalgToLoopsPass());
+  passManager.addPass(arith::createArithExpandOpsPass());
+  passManager.addPass(createConvertVectorToSCFPass());
+  if (parallel)
+    passManager.addPass(createConvertSCFToOpenMPPass());
+  passManager.addPass(createConvertSCFToCFPass());
+
+  // Lower to LLVM
+  passManager.addPass(createConvertVectorToLLVMPass());
+  passManager.addPass(createConvertFuncToLLVMPass());
+  passManager.addPass(createMemRefToLLVMConversionPass());
+  if (parallel)
+    passManager.addPass(createConvertOpenMPToLLVMPass());
+  passManager.addPass(createConvertMathToLLVMPass());
+  passManager.addNestedPass<func::FuncOp>(createArithToLLVMConversionPass());
+  passManager.addNestedPass<func::FuncOp>(createCanonicalizerPass());
+  passManager.addPass(createReconcileUnrealizedCastsPass());
+}
@@ -26,8 +26,9 @@ using namespace mlir;
 
 static FailureOr<linalg::GenericOp>
 mapLinalgToTppImpl(RewriterBase &rewriter, linalg::GenericOp linalgOp) {
-  if (!tpp::utils::hasStaticShape(linalgOp))
-    return rewriter.notifyMatchFailure(linalgOp, "shape is not static");
+  if (!tpp::utils::hasStaticInnermostDims(linalgOp))
+    return rewriter.notifyMatchFailure(linalgOp,
+                                       "innermost dimension is not static");
 
   if (linalgOp.getLibraryCallAttr())
     return rewriter.notifyMatchFailure(linalgOp,
@@ -54,6 +55,14 @@ mapLinalgToTppImpl(RewriterBase &rewriter, linalg::GenericOp linalgOp) {
     return linalgOp;
   }
 
+  if (tpp::utils::canMapToTppReluBackward(linalgOp)) {
+    StringAttr tppMicroKernelName =
+        rewriter.getStringAttr("tpp.relu_backward");
+    rewriter.updateRootInPlace(
+        linalgOp, [&]() { linalgOp.setLibraryCallAttr(tppMicroKernelName); });
+    return linalgOp;
+  }
+
   if (tpp::utils::canMapToTppAdd(linalgOp)) {
     StringAttr tppMicroKernelName = rewriter.getStringAttr("tpp.add");
     rewriter.updateRootInPlace(
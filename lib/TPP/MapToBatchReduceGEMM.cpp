@@ -6,17 +6,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "TPP/Dialect/LinalgX/LinalgXOps.h"
 #include "TPP/Dialect/Tpp/TppUtils.h"
 #include "TPP/Passes.h"
 #include "TPP/TransformUtils.h"
 #include "TPP/Transforms.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Utils/Utils.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/IR/DialectResourceBlobManager.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "llvm/Support/Debug.h"
+#include <cstring>
 
 using namespace mlir;
 
@@ -217,3 +224,275 @@ mlir::linalgx::mapToBRGEMMOp(RewriterBase &rewriter,
                                              : tensorResults);
   return outermostLoop ? outermostLoop->getResults() : tensorResults;
 }
+
+// Return the values of `operand` if it is a f32 constant, possibly packed by a
+// linalgx.pack. The pack is folded here, on the values: it is not folded in
+// the IR, and we need to look at the blocked layout. Dense resources are read
+// from their blob; the ones without a blob (e.g. moved to a side file by
+// -externalize-constants) are only known at runtime and are not matched.
+static FailureOr<SmallVector<float>> getConstantWeights(Value operand) {
+  auto getValues = [](Value value) -> FailureOr<SmallVector<float>> {
+    Attribute constant;
+    if (!matchPattern(value, m_Constant(&constant)))
+      return failure();
+    if (auto resource = constant.dyn_cast<DenseResourceElementsAttr>()) {
+      ShapedType type = resource.getType();
+      AsmResourceBlob *blob = resource.getRawHandle().getBlob();
+      if (!type.getElementType().isF32() || !blob)
+        return failure();
+      ArrayRef<char> data = blob->getData();
+      if (static_cast<int64_t>(data.size()) !=
+          type.getNumElements() * static_cast<int64_t>(sizeof(float)))
+        return failure();
+      SmallVector<float> values(type.getNumElements());
+      std::memcpy(values.data(), data.data(), data.size());
+      return values;
+    }
+    auto attr = constant.dyn_cast<DenseElementsAttr>();
+    if (!attr || !attr.getElementType().isF32() || attr.isSplat())
+      return failure();
+    return llvm::to_vector(attr.getValues<float>());
+  };
+  auto packOp = operand.getDefiningOp<linalgx::PackOp>();
+  if (!packOp)
+    return getValues(operand);
+  if (packOp.getPaddingValue())
+    return failure();
+  FailureOr<SmallVector<float>> input = getValues(packOp.getInput());
+  if (failed(input))
+    return failure();
+
+  SmallVector<int64_t> tiles = packOp.getStaticTiles();
+  if (llvm::any_of(tiles, ShapedType::isDynamic) ||
+      !packOp.getInputType().hasStaticShape() ||
+      !packOp.getOutputType().hasStaticShape())
+    return failure();
+  SmallVector<int64_t> innerDimsPos =
+      extractFromI64ArrayAttr(packOp.getInnerDimsPos());
+  SmallVector<int64_t> outerDimsPerm =
+      extractFromI64ArrayAttr(packOp.getOuterDimsPerm());
+  ArrayRef<int64_t> inputShape = packOp.getInputShape();
+  ArrayRef<int64_t> outputShape = packOp.getOutputShape();
+  int64_t inputRank = inputShape.size();
+
+  // Outer dimension `p` of the output walks dimension `outerDimsPerm[p]` of
+  // the input, tile `t` walks dimension `innerDimsPos[t]`.
+  SmallVector<float> packed(packOp.getOutputType().getNumElements());
+  SmallVector<int64_t> outputIdx(outputShape.size(), 0);
+  SmallVector<int64_t> inputIdx(inputRank);
+  for (float &value : packed) {
+    for (int64_t dim = 0; dim < inputRank; dim++)
+      inputIdx[outerDimsPerm.empty() ? dim : outerDimsPerm[dim]] =
+          outputIdx[dim];
+    for (auto tile : llvm::enumerate(tiles)) {
+      int64_t dim = innerDimsPos[tile.index()];
+      inputIdx[dim] =
+          inputIdx[dim] * tile.value() + outputIdx[inputRank + tile.index()];
+    }
+    int64_t linearIdx = 0;
+    for (int64_t dim = 0; dim < inputRank; dim++)
+      linearIdx = linearIdx * inputShape[dim] + inputIdx[dim];
+    value = (*input)[linearIdx];
+    // Next index of the output, row-major.
+    for (int64_t dim = outputShape.size() - 1; dim >= 0; dim--) {
+      if (++outputIdx[dim] < outputShape[dim])
+        break;
+      outputIdx[dim] = 0;
+    }
+  }
+  return packed;
+}
+
+// Map a blocked matmul whose weights are a constant with zero blocks to a
+// BRGEMM over the non-zero blocks only. On top of the BRGEMM conditions:
+// 1. The generic has tensor semantics.
+// 2. B is a [N][K][k][n] f32 constant, possibly packed by a linalgx.pack, and
+// its outermost dimension is an outer parallel loop.
+// 3. At least `minSparsity` of the [k][n] blocks of B are zero.
+//
+// For each block column `j` of B, the non-zero blocks are compressed in
+// `blocks[rowPtr[j] to rowPtr[j + 1])` and `indices` gives the block of A
+// they multiply. The loop nest is the one of `mapToBRGEMMOp`, the body is a
+// linalgx.sparse_brgemm on the slice of the current column.
+FailureOr<SmallVector<Value>>
+mlir::linalgx::mapToSparseBRGEMMOp(RewriterBase &rewriter,
+                                   linalg::LinalgOp linalgOp,
+                                   double minSparsity) {
+  if (!isa<linalg::GenericOp>(linalgOp) || !linalgOp.hasTensorSemantics())
+    return rewriter.notifyMatchFailure(
+        linalgOp, "expects a linalg.generic with tensor semantics");
+
+  if (failed(checkStructure(linalgOp)) ||
+      failed(checkAccessPatterns(linalgOp)) || failed(checkBody(linalgOp)))
+    return rewriter.notifyMatchFailure(linalgOp, "expects a BRGEMM");
+
+  unsigned upTo = linalgOp.getNumLoops() - /*BRGEMM loops=*/4;
+  OpOperand *operandB = linalgOp.getDpsInputOperands()[1];
+  AffineMap mapB = linalgOp.getMatchingIndexingMap(operandB);
+  auto typeB = operandB->get().getType().cast<RankedTensorType>();
+  auto outerDimB = mapB.getResult(0).dyn_cast<AffineDimExpr>();
+  if (typeB.getRank() != 4 || !typeB.hasStaticShape() || !outerDimB ||
+      outerDimB.getPosition() >= upTo)
+    return rewriter.notifyMatchFailure(
+        linalgOp, "expects [N][K][k][n] weights indexed by an outer loop");
+
+  FailureOr<SmallVector<float>> weights =
+      getConstantWeights(operandB->get());
+  if (failed(weights))
+    return rewriter.notifyMatchFailure(linalgOp, "expects constant weights");
+
+  // Find the non-zero blocks.
+  ArrayRef<int64_t> shapeB = typeB.getShape();
+  int64_t blockSize = shapeB[2] * shapeB[3];
+  SmallVector<int64_t> rowPtr = {0};
+  SmallVector<int64_t> indices;
+  SmallVector<float> blocks;
+  for (int64_t j = 0; j < shapeB[0]; j++) {
+    for (int64_t k = 0; k < shapeB[1]; k++) {
+      const float *block = weights->data() + (j * shapeB[1] + k) * blockSize;
+      if (llvm::all_of(ArrayRef<float>(block, blockSize),
+                       [](float value) { return value == 0.0f; }))
+        continue;
+      indices.push_back(k);
+      blocks.append(block, block + blockSize);
+    }
+    rowPtr.push_back(indices.size());
+  }
+  int64_t numBlocks = shapeB[0] * shapeB[1];
+  int64_t nnz = indices.size();
+  if (nnz == 0 || numBlocks - nnz < minSparsity * numBlocks)
+    return rewriter.notifyMatchFailure(linalgOp,
+                                       "weights are not sparse enough");
+
+  // materialize outer loops
+  FailureOr<SmallVector<Range>> maybeLoopRanges =
+      mlir::utils::getLoopsToMaterialize(rewriter, linalgOp, upTo);
+  if (failed(maybeLoopRanges))
+    return failure();
+  SmallVector<Range> loopRanges = *maybeLoopRanges;
+
+  Location loc = linalgOp.getLoc();
+  Type i64 = rewriter.getI64Type();
+  auto getI64Constant = [&](ArrayRef<int64_t> values) -> Value {
+    auto type = RankedTensorType::get({static_cast<int64_t>(values.size())},
+                                      i64);
+    return rewriter.create<arith::ConstantOp>(
+        loc, DenseElementsAttr::get(type, values));
+  };
+  Value rowPtrCst = getI64Constant(rowPtr);
+  Value indicesCst = getI64Constant(indices);
+  Value blocksCst = rewriter.create<arith::ConstantOp>(
+      loc, DenseElementsAttr::get(
+               RankedTensorType::get({nnz, shapeB[2], shapeB[3]},
+                                     typeB.getElementType()),
+               ArrayRef<float>(blocks)));
+
+  // replace linalgOp with the sparse BRGEMM.
+  SmallVector<Value> ivs, tensorResults;
+  auto brgemmBuilder = [&](OpBuilder &builder, Location loc,
+                           ValueRange localIvs,
+                           ValueRange operandValuesToUse) -> scf::ValueVector {
+    ivs.assign(localIvs.begin(), localIvs.end());
+    OpOperand *operandA = linalgOp.getDpsInputOperands()[0];
+    OpOperand *operandC = linalgOp.getDpsInitOperands()[0];
+    FailureOr<Value> sliceA = utils::getSliceOperand(
+        builder, operandA, linalgOp, localIvs, operandValuesToUse, 3);
+    FailureOr<Value> sliceC = utils::getSliceOperand(
+        builder, operandC, linalgOp, localIvs, operandValuesToUse, 2);
+    if (failed(sliceA) || failed(sliceC)) {
+      assert(0 && "failed to generate loops");
+      return {};
+    }
+
+    // The non-zero blocks of the current block column.
+    Value column = localIvs[outerDimB.getPosition()];
+    Value one = builder.create<arith::ConstantIndexOp>(loc, 1);
+    Value nextColumn = builder.create<arith::AddIOp>(loc, column, one);
+    auto getRowPtr = [&](Value idx) -> Value {
+      Value ptr = builder.create<tensor::ExtractOp>(loc, rowPtrCst, idx);
+      return builder.create<arith::IndexCastOp>(loc, builder.getIndexType(),
+                                                ptr);
+    };
+    Value start = getRowPtr(column);
+    Value count =
+        builder.create<arith::SubIOp>(loc, getRowPtr(nextColumn), start);
+    OpFoldResult zero = builder.getIndexAttr(0);
+    OpFoldResult unit = builder.getIndexAttr(1);
+    Value sliceB = builder.create<tensor::ExtractSliceOp>(
+        loc, blocksCst,
+        ArrayRef<OpFoldResult>{start, zero, zero},
+        ArrayRef<OpFoldResult>{count, builder.getIndexAttr(shapeB[2]),
+                               builder.getIndexAttr(shapeB[3])},
+        ArrayRef<OpFoldResult>{unit, unit, unit});
+    Value sliceIndices = builder.create<tensor::ExtractSliceOp>(
+        loc, indicesCst, ArrayRef<OpFoldResult>{start},
+        ArrayRef<OpFoldResult>{count}, ArrayRef<OpFoldResult>{unit});
+
+    auto brgemm = builder.create<linalgx::SparseBrgemmOp>(
+        loc, sliceC->getType(), *sliceA, sliceB, sliceIndices, *sliceC);
+
+    SmallVector<Value> slicedOperands = {*sliceA, sliceB, *sliceC};
+    tensorResults = insertSlicesBack(builder, loc, linalgOp, slicedOperands,
+                                     brgemm->getResults());
+
+    return scf::ValueVector(tensorResults.begin(), tensorResults.end());
+  };
+  linalg::GenerateLoopNest<scf::ForOp>::doit(
+      rewriter, loc, loopRanges, linalgOp, linalgOp.getIteratorTypesArray(),
+      brgemmBuilder);
+
+  // get the tensor results from the outermost loop.
+  Operation *outermostLoop = nullptr;
+  for (Value iv : ivs) {
+    if (auto arg = iv.dyn_cast<BlockArgument>()) {
+      outermostLoop = arg.getOwner()->getParentOp();
+      break;
+    }
+  }
+
+  rewriter.replaceOp(linalgOp, outermostLoop ? outermostLoop->getResults()
+                                             : tensorResults);
+  return outermostLoop ? outermostLoop->getResults() : tensorResults;
+}
+
+namespace {
+
+struct RewriteToBatchReduceGemmImpl
+    : public OpRewritePattern<linalg::GenericOp> {
+  RewriteToBatchReduceGemmImpl(MLIRContext *context, double minBlockSparsity)
+      : OpRewritePattern<linalg::GenericOp>(context),
+        minBlockSparsity(minBlockSparsity) {}
+
+  LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    // Pruned constant weights: skip the zero blocks.
+    if (succeeded(mlir::linalgx::mapToSparseBRGEMMOp(rewriter, linalgOp,
+                                                     minBlockSparsity)))
+      return success();
+    FailureOr<SmallVector<Value>> brgemmLoops =
+        mlir::linalgx::mapToBRGEMMOp(rewriter, linalgOp);
+    if (failed(brgemmLoops))
+      return failure();
+    return success();
+  }
+
+private:
+  double minBlockSparsity;
+};
+
+struct RewriteToBatchReduceGemm
+    : public RewriteToBatchReduceGemmBase<RewriteToBatchReduceGemm> {
+  void runOnOperation() override {
+    RewritePatternSet patterns(&getContext());
+    patterns.add<RewriteToBatchReduceGemmImpl>(patterns.getContext(),
+                                               minBlockSparsity);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createRewriteToBatchReduceGemmPass() {
+  return std::make_unique<RewriteToBatchReduceGemm>();
+}
@@ -0,0 +1,295 @@
+//===- PartitionBlockLoops.cpp -----------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Dialect/Xsmm/XsmmOps.h"
+#include "TPP/Passes.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Linalg/Transforms/Transforms.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Interfaces/ViewLikeInterface.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "partition-block-loops"
+
+namespace {
+
+// A memory access of a loop's body: the buffer it goes to, through views, and
+// whether it stays within the slice of the buffer's outermost dimension
+// indexed by the loop's induction variable.
+struct Access {
+  Value root;
+  bool owned = false;
+  bool write = false;
+};
+
+// Follow the views of 'memref' up to the buffer. The access is owned if the
+// view closest to the buffer is the [iv, iv + 1) slice of its outermost
+// dimension, or if there is no view and the outermost index is 'iv'. Views of
+// an arena (memref.view) are buffers of their own: the planner gives distinct
+// offsets to the buffers a loop uses.
+static Access getAccess(Value memref, Value iv, bool write,
+                        Value outerIndex = nullptr) {
+  Access access;
+  access.write = write;
+  access.owned = outerIndex && outerIndex == iv;
+  Value value = memref;
+  while (Operation *def = value.getDefiningOp()) {
+    if (isa<memref::ViewOp>(def))
+      break;
+    if (auto subview = dyn_cast<memref::SubViewOp>(def)) {
+      OpFoldResult offset = subview.getMixedOffsets().front();
+      Optional<int64_t> size =
+          getConstantIntValue(subview.getMixedSizes().front());
+      access.owned = offset.dyn_cast<Value>() == iv && size && *size == 1;
+      value = subview.getSource();
+      continue;
+    }
+    if (auto cast = dyn_cast<memref::CastOp>(def)) {
+      value = cast.getSource();
+      continue;
+    }
+    // Reshapes and other views: the outermost dimension changes meaning.
+    auto view = dyn_cast<ViewLikeOpInterface>(def);
+    if (!view)
+      break;
+    access.owned = false;
+    value = view.getViewSource();
+  }
+  access.root = value;
+  return access;
+}
+
+// The outermost index of a vector transfer, if the transfer stays at that
+// index. It does not if the vector spans the outermost dimension, and there
+// is no such index on a rank-0 buffer.
+template <typename TransferOp>
+static Value getOuterIndex(TransferOp transfer) {
+  if (transfer.getIndices().empty() ||
+      transfer.getPermutationMap().isFunctionOfDim(0))
+    return nullptr;
+  return transfer.getIndices()[0];
+}
+
+// Collect the memory accesses of 'op'. Fails on operations whose accesses we
+// don't know.
+static LogicalResult collectAccesses(Operation *op, Value iv,
+                                     SmallVectorImpl<Access> &accesses) {
+  auto isMemRef = [](Value value) {
+    return value.getType().isa<MemRefType>();
+  };
+
+  if (auto load = dyn_cast<memref::LoadOp>(op)) {
+    Value index = load.getIndices().empty() ? nullptr : load.getIndices()[0];
+    accesses.push_back(getAccess(load.getMemRef(), iv, false, index));
+    return success();
+  }
+  if (auto store = dyn_cast<memref::StoreOp>(op)) {
+    Value index = store.getIndices().empty() ? nullptr : store.getIndices()[0];
+    accesses.push_back(getAccess(store.getMemRef(), iv, true, index));
+    return success();
+  }
+  if (auto read = dyn_cast<vector::TransferReadOp>(op)) {
+    if (!isMemRef(read.getSource()))
+      return success();
+    accesses.push_back(
+        getAccess(read.getSource(), iv, false, getOuterIndex(read)));
+    return success();
+  }
+  if (auto write = dyn_cast<vector::TransferWriteOp>(op)) {
+    if (!isMemRef(write.getSource()))
+      return success();
+    accesses.push_back(
+        getAccess(write.getSource(), iv, true, getOuterIndex(write)));
+    return success();
+  }
+  if (auto copy = dyn_cast<memref::CopyOp>(op)) {
+    accesses.push_back(getAccess(copy.getSource(), iv, false));
+    accesses.push_back(getAccess(copy.getTarget(), iv, true));
+    return success();
+  }
+  if (auto linalgOp = dyn_cast<linalg::LinalgOp>(op)) {
+    if (!linalgOp.hasBufferSemantics())
+      return failure();
+    for (OpOperand *input : linalgOp.getDpsInputOperands())
+      if (isMemRef(input->get()))
+        accesses.push_back(getAccess(input->get(), iv, false));
+    for (OpOperand *output : linalgOp.getDpsInitOperands())
+      accesses.push_back(getAccess(output->get(), iv, true));
+    return success();
+  }
+  // XSMM invokes write their last memref operand and read the others.
+  if (isa<xsmm::TernaryOp, xsmm::BinaryOp, xsmm::UnaryOp>(op)) {
+    SmallVector<Value> memrefs;
+    for (Value operand : op->getOperands())
+      if (isMemRef(operand))
+        memrefs.push_back(operand);
+    for (auto en : llvm::enumerate(memrefs))
+      accesses.push_back(
+          getAccess(en.value(), iv, en.index() + 1 == memrefs.size()));
+    return success();
+  }
+  // Loops and their terminators, their bodies are visited on their own.
+  if (isa<scf::ForOp, scf::ParallelOp, scf::IfOp, scf::YieldOp>(op))
+    return success();
+  return success(isMemoryEffectFree(op));
+}
+
+// Iterations of 'forOp' are independent if each of them only writes its own
+// slice of the outermost dimension of the buffers, and reads the buffers it
+// writes only in that same slice.
+static bool hasIndependentIterations(scf::ForOp forOp) {
+  if (forOp.getNumIterOperands() != 0)
+    return false;
+
+  Value iv = forOp.getInductionVar();
+  SmallVector<Access> accesses;
+  WalkResult result = forOp.getBody()->walk<WalkOrder::PreOrder>(
+      [&](Operation *op) {
+        if (failed(collectAccesses(op, iv, accesses)))
+          return WalkResult::interrupt();
+        // Linalg bodies work on scalars.
+        if (isa<linalg::LinalgOp>(op))
+          return WalkResult::skip();
+        return WalkResult::advance();
+      });
+  if (result.wasInterrupted())
+    return false;
+
+  llvm::SmallDenseSet<Value> written;
+  for (const Access &access : accesses) {
+    if (!access.write)
+      continue;
+    if (!access.owned)
+      return false;
+    written.insert(access.root);
+  }
+  return llvm::all_of(accesses, [&](const Access &access) {
+    return access.owned || !written.contains(access.root);
+  });
+}
+
+// scf.for -> 1-D scf.parallel with the same body.
+static void convertToParallel(RewriterBase &rewriter, scf::ForOp forOp) {
+  rewriter.setInsertionPoint(forOp);
+  auto parallel = rewriter.create<scf::ParallelOp>(
+      forOp.getLoc(), forOp.getLowerBound(), forOp.getUpperBound(),
+      forOp.getStep());
+  Block *body = parallel.getBody();
+  forOp.getInductionVar().replaceAllUsesWith(parallel.getInductionVars()[0]);
+  Block *forBody = forOp.getBody();
+  body->getOperations().splice(body->getTerminator()->getIterator(),
+                               forBody->getOperations(), forBody->begin(),
+                               forBody->getTerminator()->getIterator());
+  rewriter.eraseOp(forOp);
+}
+
+// Keep only the outermost dimension of a multi-dimensional scf.parallel, the
+// others become sequential loops inside it.
+static void keepOuterDimension(RewriterBase &rewriter,
+                               scf::ParallelOp parallelOp) {
+  Location loc = parallelOp.getLoc();
+  rewriter.setInsertionPoint(parallelOp);
+  auto outer = rewriter.create<scf::ParallelOp>(
+      loc, parallelOp.getLowerBound().front(),
+      parallelOp.getUpperBound().front(), parallelOp.getStep().front());
+  rewriter.setInsertionPoint(outer.getBody()->getTerminator());
+  scf::LoopNest nest = scf::buildLoopNest(
+      rewriter, loc, parallelOp.getLowerBound().drop_front(),
+      parallelOp.getUpperBound().drop_front(),
+      parallelOp.getStep().drop_front());
+
+  ValueRange ivs = parallelOp.getInductionVars();
+  ivs.front().replaceAllUsesWith(outer.getInductionVars().front());
+  for (auto en : llvm::enumerate(nest.loops))
+    ivs[en.index() + 1].replaceAllUsesWith(en.value().getInductionVar());
+
+  Block *inner = nest.loops.back().getBody();
+  Block *body = parallelOp.getBody();
+  inner->getOperations().splice(inner->getTerminator()->getIterator(),
+                                body->getOperations(), body->begin(),
+                                body->getTerminator()->getIterator());
+  rewriter.eraseOp(parallelOp);
+}
+
+// Fill the slices of the outermost dimension in parallel, if the buffer has
+// at least 'minBytes': a smaller fill is not worth waking up the threads.
+static LogicalResult partitionFill(RewriterBase &rewriter, linalg::FillOp fill,
+                                   int64_t minBytes) {
+  auto type = fill.getDpsInitOperand(0)->get().getType().dyn_cast<MemRefType>();
+  if (!type || type.getRank() < 2 || !type.hasStaticShape() ||
+      type.getDimSize(0) < 2)
+    return failure();
+  int64_t bytes =
+      type.getNumElements() *
+      llvm::divideCeil(type.getElementType().getIntOrFloatBitWidth(), 8);
+  if (bytes < minBytes)
+    return failure();
+
+  SmallVector<int64_t> tileSizes(type.getRank(), 0);
+  tileSizes[0] = 1;
+  linalg::LinalgTilingOptions options;
+  options.setLoopType(linalg::LinalgTilingLoopType::ParallelLoops)
+      .setTileSizes(tileSizes);
+  rewriter.setInsertionPoint(fill);
+  FailureOr<linalg::TiledLinalgOp> tiled =
+      linalg::tileLinalgOp(rewriter, fill, options);
+  if (failed(tiled))
+    return failure();
+  rewriter.eraseOp(fill);
+  return success();
+}
+
+struct PartitionBlockLoops
+    : public PartitionBlockLoopsBase<PartitionBlockLoops> {
+  void runOnOperation() override {
+    func::FuncOp func = getOperation();
+    IRRewriter rewriter(&getContext());
+
+    // Only the loops at the top of the function: nested parallelism would be
+    // serialized by the runtime anyway.
+    SmallVector<Operation *> topLevel;
+    for (Block &block : func.getBody())
+      for (Operation &op : block)
+        if (isa<scf::ForOp, scf::ParallelOp, linalg::FillOp>(op))
+          topLevel.push_back(&op);
+
+    for (Operation *op : topLevel) {
+      if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+        if (!hasIndependentIterations(forOp))
+          continue;
+        LLVM_DEBUG(llvm::dbgs() << "Partitioning " << forOp << "\n");
+        convertToParallel(rewriter, forOp);
+      } else if (auto parallelOp = dyn_cast<scf::ParallelOp>(op)) {
+        if (parallelOp.getNumLoops() < 2 || parallelOp.getNumReductions() != 0)
+          continue;
+        keepOuterDimension(rewriter, parallelOp);
+      } else {
+        (void)partitionFill(rewriter, cast<linalg::FillOp>(op), minFillBytes);
+      }
+    }
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createPartitionBlockLoopsPass() {
+  return std::make_unique<PartitionBlockLoops>();
+}
@@ -0,0 +1,161 @@
+//===- SpecializeShapes.cpp --------------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Passes.h"
+#include "TPP/Transforms.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "specialize-shapes"
+
+LogicalResult mlir::tpp::parseShapeBinding(StringRef binding,
+                                           unsigned &argNum,
+                                           SmallVectorImpl<int64_t> &shape) {
+  StringRef arg, dims;
+  std::tie(arg, dims) = binding.split(':');
+  if (!arg.consume_front("arg") || arg.getAsInteger(10, argNum) ||
+      dims.empty())
+    return failure();
+
+  SmallVector<StringRef> sizes;
+  dims.split(sizes, 'x');
+  shape.clear();
+  for (StringRef size : sizes) {
+    int64_t dim;
+    if (size.getAsInteger(10, dim) || dim <= 0)
+      return failure();
+    shape.push_back(dim);
+  }
+  return success();
+}
+
+// Return 'type' with 'shape', if it's compatible: same rank and same size on
+// the static dimensions. Only identity layouts for memrefs.
+static FailureOr<Type> getSpecializedType(Type type, ArrayRef<int64_t> shape) {
+  auto shapedType = type.dyn_cast<ShapedType>();
+  if (!shapedType || !shapedType.hasRank() ||
+      shapedType.getRank() != static_cast<int64_t>(shape.size()))
+    return failure();
+  for (auto dims : llvm::zip(shapedType.getShape(), shape)) {
+    if (!ShapedType::isDynamic(std::get<0>(dims)) &&
+        std::get<0>(dims) != std::get<1>(dims))
+      return failure();
+  }
+
+  if (auto tensorType = type.dyn_cast<RankedTensorType>())
+    return Type(RankedTensorType::get(shape, tensorType.getElementType(),
+                                      tensorType.getEncoding()));
+  auto memRefType = type.cast<MemRefType>();
+  if (!memRefType.getLayout().isIdentity())
+    return failure();
+  return Type(MemRefType::get(shape, memRefType.getElementType(), AffineMap(),
+                              memRefType.getMemorySpace()));
+}
+
+LogicalResult mlir::tpp::specializeShapes(
+    func::FuncOp func,
+    const llvm::DenseMap<unsigned, SmallVector<int64_t>> &shapes) {
+  if (func.isExternal())
+    return func.emitError("cannot specialize a function declaration");
+
+  // Make the arguments static, and cast them back to their original type
+  // for the users. The canonicalizations below fold the casts away.
+  MLIRContext *ctx = func.getContext();
+  Block &entryBlock = func.getBody().front();
+  OpBuilder builder = OpBuilder::atBlockBegin(&entryBlock);
+  for (auto &binding : shapes) {
+    unsigned argNum = binding.first;
+    if (argNum >= func.getNumArguments())
+      return func.emitError() << "no argument " << argNum << " to specialize";
+
+    BlockArgument arg = func.getArgument(argNum);
+    Type dynamicType = arg.getType();
+    auto staticType = getSpecializedType(dynamicType, binding.second);
+    if (failed(staticType))
+      return func.emitError() << "cannot specialize argument " << argNum
+                              << " of type " << dynamicType;
+    if (*staticType == dynamicType)
+      continue;
+
+    arg.setType(*staticType);
+    Operation *argCast;
+    if (staticType->isa<RankedTensorType>())
+      argCast = builder.create<tensor::CastOp>(arg.getLoc(), dynamicType, arg);
+    else
+      argCast = builder.create<memref::CastOp>(arg.getLoc(), dynamicType, arg);
+    arg.replaceAllUsesExcept(argCast->getResult(0), argCast);
+  }
+  func.setType(FunctionType::get(ctx, entryBlock.getArgumentTypes(),
+                                 func.getResultTypes()));
+
+  // Propagate the static shapes, the same way the canonicalizer does.
+  RewritePatternSet patterns(ctx);
+  for (Dialect *dialect : ctx->getLoadedDialects())
+    dialect->getCanonicalizationPatterns(patterns);
+  for (RegisteredOperationName op : ctx->getRegisteredOperations())
+    op.getCanonicalizationPatterns(patterns, ctx);
+  (void)applyPatternsAndFoldGreedily(func, std::move(patterns));
+
+  // Return the static values, when the body now produces them.
+  if (!func.getBody().hasOneBlock())
+    return success();
+  auto returnOp = cast<func::ReturnOp>(func.getBody().front().getTerminator());
+  for (OpOperand &operand : returnOp->getOpOperands()) {
+    if (auto castOp = operand.get().getDefiningOp<tensor::CastOp>())
+      operand.set(castOp.getSource());
+    else if (auto castOp = operand.get().getDefiningOp<memref::CastOp>())
+      operand.set(castOp.getSource());
+  }
+  func.setType(FunctionType::get(ctx, func.getArgumentTypes(),
+                                 returnOp.getOperandTypes()));
+
+  return success();
+}
+
+namespace {
+
+struct SpecializeShapes : public SpecializeShapesBase<SpecializeShapes> {
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    auto func = module.lookupSymbol<func::FuncOp>(entry);
+    if (!func) {
+      module.emitError() << "function '" << entry << "' not found";
+      return signalPassFailure();
+    }
+
+    llvm::DenseMap<unsigned, SmallVector<int64_t>> bindings;
+    for (StringRef binding : shapes) {
+      unsigned argNum;
+      SmallVector<int64_t> shape;
+      if (failed(tpp::parseShapeBinding(binding, argNum, shape))) {
+        module.emitError() << "invalid shape binding '" << binding
+                           << "', expected argN:DxD..";
+        return signalPassFailure();
+      }
+      bindings[argNum] = shape;
+    }
+
+    if (failed(tpp::specializeShapes(func, bindings)))
+      signalPassFailure();
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createSpecializeShapesPass() {
+  return std::make_unique<SpecializeShapes>();
+}
@@ -0,0 +1,284 @@
+//===- StaticMemoryPlanning.cpp ----------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Passes.h"
+#include "mlir/Analysis/CallGraph.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/CallInterfaces.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "static-memory-planning"
+
+namespace {
+
+// Alignment of the arena and of each buffer in it, in bytes.
+constexpr int64_t kAlignment = 64;
+
+// Runtime function returning the arena of a function (see tpp-rt).
+constexpr StringLiteral kArenaFnName = "tpp_arena_get";
+
+// An allocation to place in the arena. It's live from 'start' to 'end', the
+// positions in the function's body of the allocation and of its last use.
+struct PlannedBuffer {
+  memref::AllocOp alloc;
+  int64_t size = 0;
+  unsigned start = 0;
+  unsigned end = 0;
+  int64_t offset = 0;
+  SmallVector<memref::DeallocOp> deallocs;
+};
+
+// Size in bytes of a statically shaped allocation, which a memref.view of the
+// arena can replace.
+static FailureOr<int64_t> getAllocSize(memref::AllocOp alloc) {
+  MemRefType type = alloc.getType();
+  if (!type.hasStaticShape() || !type.getLayout().isIdentity() ||
+      type.getMemorySpace() || !type.getElementType().isIntOrFloat() ||
+      !alloc.getSymbolOperands().empty())
+    return failure();
+  int64_t bits = type.getNumElements() * type.getElementTypeBitWidth();
+  return static_cast<int64_t>(llvm::divideCeil(bits, 8));
+}
+
+// Whether the buffer leaves the function through this use: returned, passed
+// to a call, stored in memory or turned into a pointer. Whoever gets it could
+// still use it when the arena holds another buffer, or the next call.
+static bool isEscapingUse(OpOperand &use) {
+  Operation *user = use.getOwner();
+  if (isa<func::ReturnOp, CallOpInterface,
+          memref::ExtractAlignedPointerAsIndexOp>(user))
+    return true;
+  if (auto store = dyn_cast<memref::StoreOp>(user))
+    return store.getValueToStore() == use.get();
+  return false;
+}
+
+// Extend the live range of 'buffer' to the last use of the allocation and of
+// its aliases, at the level of the function's body: a use nested in a loop
+// keeps the buffer alive for the whole loop. Fails if the buffer escapes the
+// function. Anything producing a memref from the buffer may alias it.
+static LogicalResult
+computeLiveRange(PlannedBuffer &buffer, Block &body,
+                 const DenseMap<Operation *, unsigned> &positions) {
+  SmallVector<Value> worklist = {buffer.alloc.getResult()};
+  llvm::DenseSet<Value> visited;
+  buffer.end = buffer.start;
+  auto addAliases = [&](ResultRange results) {
+    for (Value result : results)
+      if (result.getType().isa<BaseMemRefType>() &&
+          visited.insert(result).second)
+        worklist.push_back(result);
+  };
+  visited.insert(buffer.alloc.getResult());
+
+  while (!worklist.empty()) {
+    Value value = worklist.pop_back_val();
+    for (OpOperand &use : value.getUses()) {
+      Operation *user = use.getOwner();
+      if (isEscapingUse(use))
+        return failure();
+      Operation *ancestor = body.findAncestorOpInBlock(*user);
+      if (!ancestor)
+        return failure();
+      buffer.end = std::max(buffer.end, positions.lookup(ancestor));
+
+      if (auto dealloc = dyn_cast<memref::DeallocOp>(user)) {
+        buffer.deallocs.push_back(dealloc);
+        continue;
+      }
+      addAliases(user->getResults());
+      // Yielded out of a region: the parent's results may alias it.
+      if (user->hasTrait<OpTrait::IsTerminator>() && user != ancestor)
+        addAliases(user->getParentOp()->getResults());
+    }
+  }
+  return success();
+}
+
+// Place the buffers, largest first, each at the lowest aligned offset where it
+// doesn't overlap the buffers already placed that are live at the same time.
+// Returns the size of the arena.
+static int64_t assignOffsets(MutableArrayRef<PlannedBuffer> buffers) {
+  SmallVector<PlannedBuffer *> order;
+  for (PlannedBuffer &buffer : buffers)
+    order.push_back(&buffer);
+  llvm::stable_sort(order, [](PlannedBuffer *lhs, PlannedBuffer *rhs) {
+    return lhs->size > rhs->size;
+  });
+
+  SmallVector<PlannedBuffer *> placed;
+  int64_t arenaSize = 0;
+  for (PlannedBuffer *buffer : order) {
+    SmallVector<PlannedBuffer *> live;
+    for (PlannedBuffer *other : placed)
+      if (other->start <= buffer->end && buffer->start <= other->end)
+        live.push_back(other);
+    llvm::sort(live, [](PlannedBuffer *lhs, PlannedBuffer *rhs) {
+      return lhs->offset < rhs->offset;
+    });
+
+    int64_t offset = 0;
+    for (PlannedBuffer *other : live) {
+      if (offset + buffer->size <= other->offset)
+        break;
+      offset = std::max(offset, static_cast<int64_t>(llvm::alignTo(
+                                    other->offset + other->size, kAlignment)));
+    }
+    buffer->offset = offset;
+    arenaSize = std::max(arenaSize, static_cast<int64_t>(llvm::alignTo(
+                                        offset + buffer->size, kAlignment)));
+    placed.push_back(buffer);
+  }
+  return arenaSize;
+}
+
+// Declare: memref<?xi8> tpp_arena_get(memref<i64> key, i64 size)
+static func::FuncOp getOrCreateArenaFn(ModuleOp module, OpBuilder &builder) {
+  if (auto arenaFn = module.lookupSymbol<func::FuncOp>(kArenaFnName))
+    return arenaFn;
+
+  OpBuilder::InsertionGuard guard(builder);
+  builder.setInsertionPointToEnd(module.getBody());
+  Type i64 = builder.getI64Type();
+  auto keyType = MemRefType::get({}, i64);
+  auto arenaType = MemRefType::get({ShapedType::kDynamic}, builder.getI8Type());
+  auto arenaFn = builder.create<func::FuncOp>(
+      module.getLoc(), kArenaFnName,
+      builder.getFunctionType({keyType, i64}, {arenaType}));
+  arenaFn->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                   builder.getUnitAttr());
+  arenaFn.setPrivate();
+  return arenaFn;
+}
+
+// Declare the private global whose address keys the arena of 'func'. Every
+// instance of the module has its own, so functions of the same name in
+// different modules never share an arena.
+static memref::GlobalOp createArenaKey(ModuleOp module, SymbolTable &symbols,
+                                       func::FuncOp func, OpBuilder &builder) {
+  OpBuilder::InsertionGuard guard(builder);
+  builder.setInsertionPointToStart(module.getBody());
+  auto keyType = MemRefType::get({}, builder.getI64Type());
+  auto key = builder.create<memref::GlobalOp>(
+      func.getLoc(), ("__tpp_arena_" + func.getName()).str(),
+      builder.getStringAttr("private"), keyType,
+      DenseElementsAttr::get(keyType, builder.getI64IntegerAttr(0)),
+      /*constant=*/false, /*alignment=*/nullptr);
+  symbols.insert(key);
+  return key;
+}
+
+static void planFunction(ModuleOp module, SymbolTable &symbols,
+                         func::FuncOp func) {
+  Region &region = func.getBody();
+  if (!region.hasOneBlock())
+    return;
+  Block &body = region.front();
+
+  DenseMap<Operation *, unsigned> positions;
+  unsigned position = 0;
+  for (Operation &op : body)
+    positions[&op] = position++;
+
+  SmallVector<PlannedBuffer> buffers;
+  for (memref::AllocOp alloc : body.getOps<memref::AllocOp>()) {
+    FailureOr<int64_t> size = getAllocSize(alloc);
+    if (failed(size))
+      continue;
+    PlannedBuffer buffer;
+    buffer.alloc = alloc;
+    buffer.size = *size;
+    buffer.start = positions[alloc];
+    if (failed(computeLiveRange(buffer, body, positions)))
+      continue;
+    buffers.push_back(std::move(buffer));
+  }
+  if (buffers.empty())
+    return;
+
+  int64_t arenaSize = assignOffsets(buffers);
+  LLVM_DEBUG(llvm::dbgs() << "Function " << func.getName() << ": "
+                          << buffers.size() << " buffers in " << arenaSize
+                          << " bytes\n");
+
+  // Each function has its own arena, keyed by the address of its global.
+  OpBuilder builder(func.getContext());
+  func::FuncOp arenaFn = getOrCreateArenaFn(module, builder);
+  memref::GlobalOp keyGlobal = createArenaKey(module, symbols, func, builder);
+  builder.setInsertionPointToStart(&body);
+  Location loc = func.getLoc();
+  Value key = builder.create<memref::GetGlobalOp>(loc, keyGlobal.getType(),
+                                                  keyGlobal.getSymName());
+  Value size = builder.create<arith::ConstantIntOp>(loc, arenaSize, 64);
+  Value arena =
+      builder.create<func::CallOp>(loc, arenaFn, ValueRange{key, size})
+          .getResult(0);
+
+  for (PlannedBuffer &buffer : buffers) {
+    memref::AllocOp alloc = buffer.alloc;
+    builder.setInsertionPoint(alloc);
+    Value offset =
+        builder.create<arith::ConstantIndexOp>(alloc.getLoc(), buffer.offset);
+    Value view = builder.create<memref::ViewOp>(
+        alloc.getLoc(), alloc.getType(), arena, offset, ValueRange{});
+    alloc.getResult().replaceAllUsesWith(view);
+    alloc.erase();
+    for (memref::DeallocOp dealloc : buffer.deallocs)
+      dealloc.erase();
+  }
+}
+
+struct StaticMemoryPlanning
+    : public StaticMemoryPlanningBase<StaticMemoryPlanning> {
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+
+    // A call that re-enters a function on the same thread would get the
+    // arena its caller is still using: leave the recursive functions alone.
+    llvm::DenseSet<Operation *> recursive;
+    CallGraph &callGraph = getAnalysis<CallGraph>();
+    for (auto scc = llvm::scc_begin<const CallGraph *>(&callGraph);
+         !scc.isAtEnd(); ++scc) {
+      if (!scc.hasCycle())
+        continue;
+      for (CallGraphNode *node : *scc)
+        if (!node->isExternal())
+          recursive.insert(node->getCallableRegion()->getParentOp());
+    }
+
+    // Planning declares symbols in the module, collect the functions first.
+    SmallVector<func::FuncOp> funcs;
+    for (func::FuncOp func : module.getOps<func::FuncOp>())
+      if (!func.isExternal() && !recursive.contains(func))
+        funcs.push_back(func);
+    SymbolTable symbols(module);
+    for (func::FuncOp func : funcs)
+      planFunction(module, symbols, func);
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createStaticMemoryPlanningPass() {
+  return std::make_unique<StaticMemoryPlanning>();
+}
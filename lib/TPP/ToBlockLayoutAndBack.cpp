@@ -5,6 +5,7 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 //
 //===----------------------------------------------------------------------===//
+#include "TPP/Dialect/LinalgX/LinalgXDialect.h"
 #include "TPP/Dialect/LinalgX/LinalgXOps.h"
 #include "TPP/Dialect/Tpp/TppUtils.h"
 #include "TPP/Dialect/VNNI/VNNIOps.h"
@@ -143,13 +144,52 @@ static Value fromPackLayoutNCHWc_NCHW(Location loc, Value input, Value output,
   return handleLayoutNCHW_NCHWc(loc, input, output, tiles, builder);
 }
 
-// Helper function to pack from KC to CKkc.
-static Value toPackLayoutKC_CKkc(Location loc, Value input,
+static Value handleLayoutKC_CKkc(Location loc, Value input, Value output,
                                  ArrayRef<OpFoldResult> tiles,
                                  OpBuilder &builder, bool useAlloc = false) {
   assert(tiles.size() == 2 && "expect two tiles size for KC_CKkc");
   SmallVector<int64_t> innerDimPos = {0, 1};
   SmallVector<int64_t> outerDimPerm = {1, 0};
+  if (!output)
+    return toPackLayoutImpl(loc, input, tiles, innerDimPos, outerDimPerm,
+                            builder, useAlloc);
+  return toUnPackLayoutImpl(loc, input, output, tiles, innerDimPos,
+                            outerDimPerm, builder);
+}
+
+// Helper function to pack from KC to CKkc.
+static Value toPackLayoutKC_CKkc(Location loc, Value input,
+                                 ArrayRef<OpFoldResult> tiles,
+                                 OpBuilder &builder, bool useAlloc = false) {
+  return handleLayoutKC_CKkc(loc, input, nullptr, tiles, builder, useAlloc);
+}
+
+// Helper function to unpack from CKkc to KC.
+static Value fromPackLayoutCKkc_KC(Location loc, Value input, Value output,
+                                   ArrayRef<OpFoldResult> tiles,
+                                   OpBuilder &builder) {
+  return handleLayoutKC_CKkc(loc, input, output, tiles, builder);
+}
+
+// Helper function to pack from CK to CKkc, i.e. a KC matrix stored
+// transposed. 'tiles' are the tile sizes for k and c.
+static Value toPackLayoutCK_CKkc(Location loc, Value input,
+                                 ArrayRef<OpFoldResult> tiles,
+                                 OpBuilder &builder, bool useAlloc = false) {
+  assert(tiles.size() == 2 && "expect two tiles size for CK_CKkc");
+  SmallVector<int64_t> innerDimPos = {1, 0};
+  return toPackLayoutImpl(loc, input, tiles, innerDimPos, {}, builder,
+                          useAlloc);
+}
+
+// Helper function to pack from CN to NCnc, i.e. an NC matrix stored
+// transposed. 'tiles' are the tile sizes for n and c.
+static Value toPackLayoutCN_NCnc(Location loc, Value input,
+                                 ArrayRef<OpFoldResult> tiles,
+                                 OpBuilder &builder, bool useAlloc = false) {
+  assert(tiles.size() == 2 && "expect two tiles size for CN_NCnc");
+  SmallVector<int64_t> innerDimPos = {1, 0};
+  SmallVector<int64_t> outerDimPerm = {1, 0};
   return toPackLayoutImpl(loc, input, tiles, innerDimPos, outerDimPerm, builder,
                           useAlloc);
 }
@@ -390,6 +430,130 @@ mlir::linalgx::packMatmulOp(RewriterBase &rewriter, linalg::MatmulOp matmulOp,
   return replacementOp;
 }
 
+//===----------------------------------------------------------------------===//
+// Backward MatmulOp
+//===----------------------------------------------------------------------===//
+//
+// The backward pass of C = A * B reads one of the operands transposed:
+//
+// dA = dC * B^T: [i][j] += [i][k] * [j][k]
+// dB = A^T * dC: [i][j] += [k][i] * [k][j] (k is the batch, N, of the MLP)
+//
+// The transpose is folded into the packing, so that the blocked contraction
+// is the same as for a forward matmul and maps to BRGEMM:
+//
+// dA: [I][J][i][j] += [I][K][i][k] * [J][K][k][j]
+// dB: [J][I][i][j] += [I][K][i][k] * [J][K][k][j]
+//
+// dB is a weight gradient: it is blocked like the weights (KC to CKkc), so
+// that the weight update runs on the packed layout.
+namespace {
+enum class TransposedOperand { A, B };
+} // namespace
+
+static FailureOr<TransposedOperand>
+getTransposedOperand(linalg::GenericOp linalgOp) {
+  if (linalgOp.getNumDpsInputs() != 2 || linalgOp.getNumDpsInits() != 1)
+    return failure();
+  SmallVector<utils::IteratorType> iteratorTypes =
+      linalgOp.getIteratorTypesArray();
+  if (iteratorTypes.size() != 3 ||
+      !linalg::isParallelIterator(iteratorTypes[0]) ||
+      !linalg::isParallelIterator(iteratorTypes[1]) ||
+      !linalg::isReductionIterator(iteratorTypes[2]))
+    return failure();
+  if (!tpp::utils::hasMatmulBody(linalgOp))
+    return failure();
+  using MapList = ArrayRef<ArrayRef<AffineExpr>>;
+  auto infer = [](MapList m) { return AffineMap::inferFromExprList(m); };
+  AffineExpr i, j, k;
+  bindDims(linalgOp.getContext(), i, j, k);
+  SmallVector<AffineMap> maps = linalgOp.getIndexingMapsArray();
+  if (maps == infer({{k, i}, {k, j}, {i, j}}))
+    return TransposedOperand::A;
+  if (maps == infer({{i, k}, {j, k}, {i, j}}))
+    return TransposedOperand::B;
+  return failure();
+}
+
+FailureOr<linalg::GenericOp>
+mlir::linalgx::packTransposedMatmulOp(RewriterBase &rewriter,
+                                      linalg::GenericOp matmulOp,
+                                      ArrayRef<OpFoldResult> tiles) {
+  if (tiles.size() != 3)
+    return rewriter.notifyMatchFailure(matmulOp, "require 3 tile factors");
+
+  if (matmulOp.hasDynamicShape())
+    return rewriter.notifyMatchFailure(matmulOp, "require static shape");
+
+  if (matmulOp.hasBufferSemantics())
+    return rewriter.notifyMatchFailure(matmulOp, "require tensor semantics");
+
+  FailureOr<TransposedOperand> transposed = getTransposedOperand(matmulOp);
+  if (failed(transposed))
+    return rewriter.notifyMatchFailure(matmulOp,
+                                       "require a transposed matmul");
+
+  OpFoldResult tileOnI = tiles[0];
+  OpFoldResult tileOnJ = tiles[1];
+  OpFoldResult tileOnK = tiles[2];
+  SmallVector<OpFoldResult, 2> tilesOnC = {tileOnI, tileOnJ};
+
+  Location loc = matmulOp.getLoc();
+  Value matrixA = matmulOp.getInputs()[0];
+  Value matrixB = matmulOp.getInputs()[1];
+  Value matrixC = matmulOp.getOutputs()[0];
+  Value packedMatrixA, packedMatrixB, packedMatrixC;
+  if (*transposed == TransposedOperand::A) {
+    packedMatrixA =
+        toPackLayoutCN_NCnc(loc, matrixA, {tileOnI, tileOnK}, rewriter);
+    packedMatrixB =
+        toPackLayoutKC_CKkc(loc, matrixB, {tileOnK, tileOnJ}, rewriter);
+    packedMatrixC = toPackLayoutKC_CKkc(loc, matrixC, tilesOnC, rewriter);
+  } else {
+    packedMatrixA =
+        toPackLayoutNC_NCnc(loc, matrixA, {tileOnI, tileOnK}, rewriter);
+    packedMatrixB =
+        toPackLayoutCK_CKkc(loc, matrixB, {tileOnK, tileOnJ}, rewriter);
+    packedMatrixC = toPackLayoutNC_NCnc(loc, matrixC, tilesOnC, rewriter);
+  }
+  SmallVector<Value> packedInputs = {packedMatrixA, packedMatrixB};
+
+  // swap the matmul with a blocked linalg.generic.
+  MLIRContext *ctx = matmulOp.getContext();
+  AffineExpr p1, p2, r1, p3, p4, r2;
+  bindDims(ctx, p1, p2, r1, p3, p4, r2);
+  AffineMap mapA =
+      AffineMap::get(/*dims=*/6, /*symbols=*/0, {p1, r1, p3, r2}, ctx);
+  AffineMap mapB =
+      AffineMap::get(/*dims=*/6, /*symbols=*/0, {p2, r1, r2, p4}, ctx);
+  AffineMap mapC =
+      (*transposed == TransposedOperand::A)
+          ? AffineMap::get(/*dims=*/6, /*symbols=*/0, {p2, p1, p3, p4}, ctx)
+          : AffineMap::get(/*dims=*/6, /*symbols=*/0, {p1, p2, p3, p4}, ctx);
+  linalg::GenericOp replacementOp = rewriter.create<linalg::GenericOp>(
+      loc, packedMatrixC.getType(), packedInputs, ValueRange{packedMatrixC},
+      ArrayRef<AffineMap>{mapA, mapB, mapC},
+      ArrayRef<utils::IteratorType>{
+          utils::IteratorType::parallel, utils::IteratorType::parallel,
+          utils::IteratorType::reduction, utils::IteratorType::parallel,
+          utils::IteratorType::parallel, utils::IteratorType::reduction},
+      /*doc=*/"", /*libraryCall=*/"");
+  rewriter.inlineRegionBefore(matmulOp.getRegion(), replacementOp.getRegion(),
+                              replacementOp.getRegion().begin());
+
+  // convert back from pack layout.
+  Value outPackTensor = replacementOp.getResult(0);
+  Value outReplacement =
+      (*transposed == TransposedOperand::A)
+          ? fromPackLayoutCKkc_KC(loc, outPackTensor, matrixC, tilesOnC,
+                                  rewriter)
+          : fromPackLayoutNCnc_NC(loc, outPackTensor, matrixC, tilesOnC,
+                                  rewriter);
+  rewriter.replaceOp(matmulOp, outReplacement);
+  return replacementOp;
+}
+
 FailureOr<vnni::MatmulOp>
 mlir::linalgx::packVNNIMatmulOp(RewriterBase &rewriter,
                                 linalg::MatmulOp matmulOp,
@@ -771,3 +935,119 @@ void mlir::tpp::populateSinkPackPatterns(RewritePatternSet &patterns) {
   patterns.add<PropagateThroughElementWiseOp, PropagateThroughPadOp>(
       patterns.getContext());
 }
+
+namespace {
+
+// Pack a linalg.matmul if all its dimensions are multiple of the blocking
+// factors. Partial blocks would require padding, which we do not handle yet.
+struct PackMatmul : public OpRewritePattern<linalg::MatmulOp> {
+  PackMatmul(MLIRContext *context, ArrayRef<int64_t> blockingFactors,
+             PatternBenefit benefit = 1)
+      : OpRewritePattern<linalg::MatmulOp>(context, benefit),
+        blockingFactors(blockingFactors) {}
+
+  LogicalResult matchAndRewrite(linalg::MatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    if (blockingFactors.size() != 3)
+      return rewriter.notifyMatchFailure(matmulOp, "require 3 tile factors");
+    if (!tpp::utils::hasStaticShape(matmulOp))
+      return rewriter.notifyMatchFailure(matmulOp, "require static shape");
+
+    // [i, k] * [k, j] -> [i, j]
+    ArrayRef<int64_t> shapeA =
+        matmulOp.getInputs()[0].getType().cast<ShapedType>().getShape();
+    ArrayRef<int64_t> shapeB =
+        matmulOp.getInputs()[1].getType().cast<ShapedType>().getShape();
+    if (shapeA[0] % blockingFactors[0] != 0 ||
+        shapeB[1] % blockingFactors[1] != 0 ||
+        shapeA[1] % blockingFactors[2] != 0)
+      return rewriter.notifyMatchFailure(matmulOp, "require full blocks");
+
+    SmallVector<OpFoldResult> tiles =
+        getAsOpFoldResult(rewriter.getI64ArrayAttr(blockingFactors));
+    if (failed(linalgx::packMatmulOp(rewriter, matmulOp, tiles)))
+      return failure();
+    return success();
+  }
+
+private:
+  SmallVector<int64_t> blockingFactors;
+};
+
+// Pack the backward matmuls, under the same full-block condition.
+struct PackTransposedMatmul : public OpRewritePattern<linalg::GenericOp> {
+  PackTransposedMatmul(MLIRContext *context, ArrayRef<int64_t> blockingFactors,
+                       PatternBenefit benefit = 1)
+      : OpRewritePattern<linalg::GenericOp>(context, benefit),
+        blockingFactors(blockingFactors) {}
+
+  LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    if (blockingFactors.size() != 3)
+      return rewriter.notifyMatchFailure(linalgOp, "require 3 tile factors");
+    if (!tpp::utils::hasStaticShape(linalgOp))
+      return rewriter.notifyMatchFailure(linalgOp, "require static shape");
+    if (failed(getTransposedOperand(linalgOp)))
+      return rewriter.notifyMatchFailure(linalgOp,
+                                         "require a transposed matmul");
+
+    // Loops are [i, j, k].
+    SmallVector<int64_t> loopRanges = linalgOp.getStaticLoopRanges();
+    for (auto en : llvm::enumerate(blockingFactors))
+      if (loopRanges[en.index()] % en.value() != 0)
+        return rewriter.notifyMatchFailure(linalgOp, "require full blocks");
+
+    SmallVector<OpFoldResult> tiles =
+        getAsOpFoldResult(rewriter.getI64ArrayAttr(blockingFactors));
+    if (failed(linalgx::packTransposedMatmulOp(rewriter, linalgOp, tiles)))
+      return failure();
+    return success();
+  }
+
+private:
+  SmallVector<int64_t> blockingFactors;
+};
+
+struct PackMatmulPass : public PackMatmulBase<PackMatmulPass> {
+  PackMatmulPass() = default;
+  PackMatmulPass(ArrayRef<int64_t> blockingFactors) {
+    this->blockingFactors = blockingFactors;
+  }
+
+  void runOnOperation() override {
+    MLIRContext *ctx = &getContext();
+    if (blockingFactors.empty())
+      return;
+    RewritePatternSet patterns(ctx);
+    patterns.add<PackMatmul, PackTransposedMatmul>(ctx, blockingFactors);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+  }
+};
+
+struct PropagatePackUnPack
+    : public PropagatePackUnPackBase<PropagatePackUnPack> {
+  void runOnOperation() override {
+    MLIRContext *ctx = &getContext();
+    RewritePatternSet patterns(ctx);
+    tpp::populateSinkPackPatterns(patterns);
+    linalgx::PackOp::getCanonicalizationPatterns(patterns, ctx);
+    linalgx::UnPackOp::getCanonicalizationPatterns(patterns, ctx);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<func::FuncOp>> mlir::tpp::createPackMatmulPass() {
+  return std::make_unique<PackMatmulPass>();
+}
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createPackMatmulPass(ArrayRef<int64_t> blockingFactors) {
+  return std::make_unique<PackMatmulPass>(blockingFactors);
+}
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createPropagatePackUnPackPass() {
+  return std::make_unique<PropagatePackUnPack>();
+}
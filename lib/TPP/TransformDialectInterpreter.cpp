@@ -15,6 +15,7 @@
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Transform/IR/TransformInterfaces.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
 
 using namespace mlir;
 using namespace mlir::tpp;
@@ -28,13 +29,31 @@ struct TransformDialectInterpreter
     : TransformDialectInterpreterBase<TransformDialectInterpreter> {
   void runOnOperation() override {
     ModuleOp module = getOperation();
-    for (auto op :
-         module.getBody()->getOps<transform::TransformOpInterface>()) {
-      if (failed(transform::applyTransforms(
-              module, op,
-              transform::TransformOptions().enableExpensiveChecks(true))))
-        return signalPassFailure();
+    auto options = transform::TransformOptions().enableExpensiveChecks(true);
+    if (!perFunction) {
+      for (auto op :
+           module.getBody()->getOps<transform::TransformOpInterface>()) {
+        if (failed(transform::applyTransforms(module, op, options)))
+          return signalPassFailure();
+      }
+      return;
     }
+
+    // Each function is a payload of its own, the schedule is only read.
+    SmallVector<transform::TransformOpInterface> schedule(
+        module.getBody()->getOps<transform::TransformOpInterface>());
+    SmallVector<func::FuncOp> funcs;
+    for (auto func : module.getOps<func::FuncOp>())
+      if (!func.isExternal())
+        funcs.push_back(func);
+    if (failed(failableParallelForEach(
+            &getContext(), funcs, [&](func::FuncOp func) {
+              for (auto op : schedule)
+                if (failed(transform::applyTransforms(func, op, options)))
+                  return failure();
+              return success();
+            })))
+      signalPassFailure();
   }
 };
 
@@ -0,0 +1,104 @@
+//===- VectorizeLinalg.cpp ---------------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Dialect/Tpp/TppUtils.h"
+#include "TPP/Passes.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Linalg/Transforms/Transforms.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "vectorize-linalg"
+
+namespace {
+
+// Tile sizes bringing the iteration space under 'maxElements': the innermost
+// loops are kept whole as long as they fit, the next one is tiled to its
+// largest divisor that fits and the outer ones to 1. Divisors keep the tiles
+// static, which the vectorizer needs. 0 leaves a loop untiled.
+static SmallVector<int64_t> getTileSizes(ArrayRef<int64_t> ranges,
+                                         int64_t maxElements) {
+  SmallVector<int64_t> tileSizes(ranges.size(), 1);
+  int64_t budget = maxElements;
+  for (int64_t dim = ranges.size() - 1; dim >= 0; dim--) {
+    int64_t range = ranges[dim];
+    if (range <= budget) {
+      tileSizes[dim] = 0;
+      budget /= range;
+      continue;
+    }
+    int64_t tile = budget;
+    while (range % tile)
+      tile--;
+    tileSizes[dim] = tile;
+    break;
+  }
+  return tileSizes;
+}
+
+// Vectorize statically shaped linalg operations that fit in 'maxElements'.
+// Larger ones are tiled with scf.for first, and the tiles vectorized.
+struct VectorizeLinalgOp
+    : public OpInterfaceRewritePattern<linalg::LinalgOp> {
+  VectorizeLinalgOp(MLIRContext *context, int64_t maxElements,
+                    PatternBenefit benefit = 1)
+      : OpInterfaceRewritePattern<linalg::LinalgOp>(context, benefit),
+        maxElements(maxElements) {}
+
+  LogicalResult matchAndRewrite(linalg::LinalgOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    if (!tpp::utils::hasStaticShape(linalgOp))
+      return rewriter.notifyMatchFailure(linalgOp, "shape is not static");
+
+    SmallVector<int64_t> ranges = linalgOp.getStaticLoopRanges();
+    int64_t numElements = 1;
+    for (int64_t range : ranges)
+      numElements *= range;
+    if (numElements <= maxElements)
+      return linalg::vectorize(rewriter, linalgOp);
+
+    // Only tile what the vectorizer takes, a tiled convolution would only
+    // end up in more loops.
+    if (failed(linalg::vectorizeLinalgOpPrecondition(linalgOp)))
+      return rewriter.notifyMatchFailure(linalgOp, "cannot vectorize");
+    linalg::LinalgTilingOptions options;
+    options.setLoopType(linalg::LinalgTilingLoopType::Loops)
+        .setTileSizes(getTileSizes(ranges, maxElements));
+    FailureOr<linalg::TiledLinalgOp> tiled =
+        linalg::tileLinalgOp(rewriter, linalgOp, options);
+    if (failed(tiled))
+      return rewriter.notifyMatchFailure(linalgOp, "cannot tile");
+    rewriter.replaceOp(linalgOp, tiled->tensorResults);
+    return success();
+  }
+
+private:
+  int64_t maxElements;
+};
+
+struct VectorizeLinalg : public VectorizeLinalgBase<VectorizeLinalg> {
+  void runOnOperation() override {
+    RewritePatternSet patterns(&getContext());
+    patterns.add<VectorizeLinalgOp>(patterns.getContext(), maxElements);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+  }
+};
+
+} // end namespace
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createVectorizeLinalgPass() {
+  return std::make_unique<VectorizeLinalg>();
+}
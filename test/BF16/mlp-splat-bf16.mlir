@@ -0,0 +1,30 @@
+// RUN: tpp-run %s -tpp-pipeline=default -print=checksum -n 1 \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// A bf16 MLP layer on the default inputs: every global is a bf16 splat of
+// ones, as the MLP benchmark's bf16 runs use.
+
+#map0 = affine_map<(d0, d1) -> (d1)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @entry(%A: tensor<32x64xbf16>, %B: tensor<64x32xbf16>,
+                 %Bias: tensor<32xbf16>, %C: tensor<32x32xbf16>) -> tensor<32x32xbf16> {
+  %c0 = arith.constant 0.0 : bf16
+  %0 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%Bias : tensor<32xbf16>) outs(%C : tensor<32x32xbf16>) {
+  ^bb0(%arg0: bf16, %arg1: bf16):
+    linalg.yield %arg0 : bf16
+  } -> tensor<32x32xbf16>
+  %1 = linalg.matmul ins(%A, %B: tensor<32x64xbf16>, tensor<64x32xbf16>) outs(%0: tensor<32x32xbf16>) -> tensor<32x32xbf16>
+  %2 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel"]} outs(%1 : tensor<32x32xbf16>) {
+  ^bb0(%arg0: bf16):
+    %3 = arith.maxf %arg0, %c0 : bf16
+    linalg.yield %3 : bf16
+  } -> tensor<32x32xbf16>
+  return %2 : tensor<32x32xbf16>
+}
+
+// 1 + 64 * 1 * 1 = 65, exact in bf16
+// CHECK: Checksum: 1024 elements, sum: 6.656000e+04, sum sq: 4.326400e+06, max: 6.500000e+01
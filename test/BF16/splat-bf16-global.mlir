@@ -0,0 +1,23 @@
+// RUN: tpp-run %s -print=checksum -n 1 \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// Without a seed the bf16 input is a splat of ones, which must be built in
+// bf16 semantics. See mlp-splat-bf16.mlir for a whole bf16 layer.
+
+#map = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+
+func.func @entry(%A: memref<2x3x4x8xbf16>, %B: memref<2x3x4x8xf32>) {
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%A : memref<2x3x4x8xbf16>) outs(%B : memref<2x3x4x8xf32>) {
+  ^bb0(%a: bf16, %b: f32):
+    %0 = arith.extf %a : bf16 to f32
+    %1 = arith.addf %0, %b : f32
+    linalg.yield %1 : f32
+  }
+  return
+}
+
+// All ones in, 2.0 out
+// CHECK: Checksum: 192 elements, sum: 3.840000e+02, sum sq: 7.680000e+02, max: 2.000000e+00
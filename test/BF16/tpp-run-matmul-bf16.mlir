@@ -0,0 +1,27 @@
+// RUN: tpp-run %s -tpp-pipeline=default -print=checksum -n 1 \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// A flat bf16 matmul through the TPP pipeline: LIBXSMM needs the VNNI
+// layout, so it runs as vector code accumulating in f32. The output is
+// extended to f32 for the checksum.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @entry(%A: tensor<64x64xbf16>, %B: tensor<64x64xbf16>,
+                 %C: tensor<64x64xbf16>, %O: tensor<64x64xf32>) -> tensor<64x64xf32> {
+  %D = linalg.matmul ins(%A, %B : tensor<64x64xbf16>, tensor<64x64xbf16>)
+                     outs(%C : tensor<64x64xbf16>) -> tensor<64x64xbf16>
+  %E = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+    ins(%D : tensor<64x64xbf16>) outs(%O : tensor<64x64xf32>) {
+  ^bb0(%d: bf16, %o: f32):
+    %0 = arith.extf %d : bf16 to f32
+    linalg.yield %0 : f32
+  } -> tensor<64x64xf32>
+  return %E : tensor<64x64xf32>
+}
+
+// All ones in, 64 + 1 out
+// CHECK: Checksum: 4096 elements, sum: 2.662400e+05, sum sq: 1.730560e+07, max: 6.500000e+01
@@ -0,0 +1,19 @@
+// RUN: tpp-run %s -tpp-pipeline=default -verify-against=loops -seed=123 \
+// RUN:  -verify-rel-threshold=5e-2 -print=checksum -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// A bf16 result is verified, and summed, in f32. The kernel accumulates in
+// f32 and rounds once, the loops round after every step: the relative
+// threshold covers the difference.
+
+func.func @entry(%A: tensor<32x32xbf16>, %B: tensor<32x32xbf16>,
+                 %C: tensor<32x32xbf16>) -> tensor<32x32xbf16> {
+  %D = linalg.matmul ins(%A, %B : tensor<32x32xbf16>, tensor<32x32xbf16>)
+                     outs(%C : tensor<32x32xbf16>) -> tensor<32x32xbf16>
+  return %D : tensor<32x32xbf16>
+}
+
+// CHECK: Verification: PASS
+// CHECK: Checksum: 1024 elements
@@ -0,0 +1,26 @@
+# Writes a 4x4 f32 .npy file, every row is 1, 2, 3, 4. The version, the header
+# dictionary and the size can be changed, to test malformed files.
+#
+# Usage: npy.py out.npy [--version=N] [--header=DICT] [--truncate=BYTES]
+
+import argparse
+import struct
+
+parser = argparse.ArgumentParser()
+parser.add_argument('output')
+parser.add_argument('--version', type=int, default=1)
+parser.add_argument('--header',
+                    default="{'descr': '<f4', 'fortran_order': False, "
+                            "'shape': (4, 4), }")
+parser.add_argument('--truncate', type=int)
+args = parser.parse_args()
+
+header = (args.header + '\n').encode()
+data = b'\x93NUMPY' + bytes([args.version, 0])
+data += struct.pack('<H' if args.version == 1 else '<I', len(header))
+data += header + struct.pack('<16f', *([1.0, 2.0, 3.0, 4.0] * 4))
+if args.truncate is not None:
+    data = data[:args.truncate]
+
+with open(args.output, 'wb') as f:
+    f.write(data)
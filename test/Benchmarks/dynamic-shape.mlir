@@ -0,0 +1,26 @@
+// RUN: tpp-run %s -tpp-pipeline=default \
+// RUN:  -shape=arg0:4x8 -shape=arg1:8x4 -shape=arg2:4x4 \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// Same kernel, another batch size
+// RUN: tpp-run %s -tpp-pipeline=default \
+// RUN:  -shape=arg0:2x8 -shape=arg1:8x4 -shape=arg2:2x4 \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s -check-prefix=SMALL
+//
+
+func.func @entry(%A: tensor<?x8xf32>, %B: tensor<8x4xf32>,
+                 %C: tensor<?x4xf32>) -> tensor<?x4xf32> {
+  %D = linalg.matmul ins(%A, %B: tensor<?x8xf32>, tensor<8x4xf32>) outs(%C: tensor<?x4xf32>) -> tensor<?x4xf32>
+  return %D : tensor<?x4xf32>
+}
+
+// CHECK-COUNT-4: ( 9, 9, 9, 9 )
+// CHECK-NOT: ( 9, 9, 9, 9 )
+
+// SMALL-COUNT-2: ( 9, 9, 9, 9 )
+// SMALL-NOT: ( 9, 9, 9, 9 )
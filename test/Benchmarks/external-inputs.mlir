@@ -0,0 +1,51 @@
+// Move the weights to a side file, loaded at runtime
+// RUN: tpp-opt %s -externalize-constants="file=%t.bin threshold=0" | \
+// RUN: tpp-run -tpp-pipeline=default -n 1 \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// The side file is raw data, it can be bound to an argument as well
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -input=arg0:%t.bin \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s -check-prefix=INPUT
+//
+
+// The globals are declarations, which the JIT binds to the file's mapping
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -input=arg0:%t.bin \
+// RUN:  -e entry -entry-point-result=void -mlir-print-ir-before=convert-func-to-llvm \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext 2>&1 | \
+// RUN: FileCheck %s -check-prefix=DECL
+//
+
+// The output writes to a private copy of the pages, the file stays the same
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -input=arg1:%t.bin \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s -check-prefix=OUTPUT
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -input=arg1:%t.bin \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s -check-prefix=OUTPUT
+//
+
+func.func @entry(%A: tensor<4x4xf32>, %C: tensor<4x4xf32>) -> tensor<4x4xf32> {
+  %W = arith.constant dense<[
+      [ 1.0, 2.0, 3.0, 4.0 ],
+      [ 1.0, 2.0, 3.0, 4.0 ],
+      [ 1.0, 2.0, 3.0, 4.0 ],
+      [ 1.0, 2.0, 3.0, 4.0 ]
+    ]> : tensor<4x4xf32>
+  %D = linalg.matmul ins(%A, %W: tensor<4x4xf32>, tensor<4x4xf32>) outs(%C: tensor<4x4xf32>) -> tensor<4x4xf32>
+  return %D : tensor<4x4xf32>
+}
+
+// CHECK-COUNT-4: ( 5, 9, 13, 17 )
+
+// INPUT-COUNT-4: ( 11, 21, 31, 41 )
+
+// DECL: memref.global @__wrapper_{{[0-9]+}} : memref<4x4xf32>{{$}}
+
+// OUTPUT-COUNT-4: ( 5, 10, 15, 20 )
@@ -0,0 +1,19 @@
+// RUN: tpp-run %s -print=checksum -n 2 -huge-page-globals \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+#map = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+
+func.func @entry(%A: memref<2x3x4x8xf32>, %B: memref<2x3x4x8xf32>) {
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%A : memref<2x3x4x8xf32>) outs(%B : memref<2x3x4x8xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %0 = arith.addf %a, %b : f32
+    linalg.yield %0 : f32
+  }
+  return
+}
+
+// The kernel runs on copies of the globals, in huge page buffers
+// CHECK: Checksum: 192 elements, sum: 3.840000e+02, sum sq: 7.680000e+02, max: 2.000000e+00
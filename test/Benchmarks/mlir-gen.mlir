@@ -0,0 +1,34 @@
+// RUN: mlir-gen -kernel=matmul -m=4 -n=8 -k=16 | FileCheck %s -check-prefix=MATMUL
+// RUN: mlir-gen -kernel=mlp -m=8 -n=16 -k=8 -layers=2 -block=4,4,4 | FileCheck %s -check-prefix=MLP
+// RUN: mlir-gen -kernel=conv -m=6 -n=4 -k=2 | FileCheck %s -check-prefix=CONV
+//
+
+// RUN: mlir-gen -kernel=matmul -m=4 -n=8 -k=16 | \
+// RUN: tpp-run -tpp-pipeline=default \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: mlir-gen -kernel=mlp -m=8 -n=16 -k=8 -layers=2 -block=4,4,4 | \
+// RUN: tpp-run -tpp-pipeline=default -print=checksum \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s -check-prefix=MLP-RUN
+//
+
+// MATMUL: module attributes {tpp.flops = 1024 : i64}
+// MATMUL: func.func @entry(%{{.+}}: tensor<4x16xf32>, %{{.+}}: tensor<16x8xf32>, %{{.+}}: tensor<4x8xf32>) -> tensor<4x8xf32>
+// MATMUL: linalg.matmul
+
+// MLP: module attributes {tpp.flops = 6144 : i64}
+// MLP: func.func @entry(%{{.+}}: tensor<2x2x4x4xf32>, %{{.+}}: tensor<4x2x4x4xf32>, %{{.+}}: tensor<4x4xf32>, %{{.+}}: tensor<2x4x4x4xf32>, %{{.+}}: tensor<4x4x4x4xf32>, %{{.+}}: tensor<4x4xf32>, %{{.+}}: tensor<2x4x4x4xf32>) -> tensor<2x4x4x4xf32>
+// MLP-COUNT-2: arith.maxf
+
+// CONV: module attributes {tpp.flops = 2304 : i64}
+// CONV: linalg.conv_2d_nhwc_hwcf
+
+// CHECK-COUNT-4: ( 17, 17, 17, 17, 17, 17, 17, 17 )
+
+// Layer 1: 8 + 1 = 9, layer 2: 16 * 9 + 1 = 145, on 128 elements
+// MLP-RUN: Checksum: 128 elements, sum: 1.856000e+04, sum sq: 2.691200e+06, max: 1.450000e+02
@@ -0,0 +1,54 @@
+// Version 1 and version 2 headers
+// RUN: %python %S/Inputs/npy.py %t.v1.npy
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -input=arg0:%t.v1.npy \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+// RUN: %python %S/Inputs/npy.py %t.v2.npy --version=2
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -input=arg0:%t.v2.npy \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// A version 2 file cut in its header length
+// RUN: %python %S/Inputs/npy.py %t.short.npy --version=2 --truncate=11
+// RUN: not tpp-run %s -tpp-pipeline=default -n 1 -input=arg0:%t.short.npy \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext 2>&1 | \
+// RUN: FileCheck %s -check-prefix=SHORT
+//
+
+// A header that ends right after the 'shape' key
+// RUN: %python %S/Inputs/npy.py %t.shape.npy \
+// RUN:  --header="{'descr': '<f4', 'fortran_order': False, 'shape':"
+// RUN: not tpp-run %s -tpp-pipeline=default -n 1 -input=arg0:%t.shape.npy \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext 2>&1 | \
+// RUN: FileCheck %s -check-prefix=SHAPE
+//
+
+// An unknown version
+// RUN: %python %S/Inputs/npy.py %t.version.npy --version=9
+// RUN: not tpp-run %s -tpp-pipeline=default -n 1 -input=arg0:%t.version.npy \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext 2>&1 | \
+// RUN: FileCheck %s -check-prefix=VERSION
+//
+
+func.func @entry(%A: tensor<4x4xf32>, %C: tensor<4x4xf32>) -> tensor<4x4xf32> {
+  %W = arith.constant dense<[
+      [ 1.0, 2.0, 3.0, 4.0 ],
+      [ 1.0, 2.0, 3.0, 4.0 ],
+      [ 1.0, 2.0, 3.0, 4.0 ],
+      [ 1.0, 2.0, 3.0, 4.0 ]
+    ]> : tensor<4x4xf32>
+  %D = linalg.matmul ins(%A, %W: tensor<4x4xf32>, tensor<4x4xf32>) outs(%C: tensor<4x4xf32>) -> tensor<4x4xf32>
+  return %D : tensor<4x4xf32>
+}
+
+// CHECK-COUNT-4: ( 11, 21, 31, 41 )
+
+// SHORT: error: Cannot load input '{{.*}}short.npy': truncated .npy header
+// SHAPE: error: Cannot load input '{{.*}}shape.npy': malformed .npy shape
+// VERSION: error: Cannot load input '{{.*}}version.npy': unsupported .npy version
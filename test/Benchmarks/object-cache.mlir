@@ -0,0 +1,45 @@
+// RUN: rm -rf %t
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -cache-dir=%t \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+// RUN: ls %t | FileCheck %s -check-prefix=OBJECT
+//
+// Same output, from the cached object file.
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -cache-dir=%t \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+// RUN: ls %t | FileCheck %s -check-prefix=OBJECT
+//
+// Another optimization level, another object file.
+// RUN: tpp-run %s -tpp-pipeline=default -n 1 -cache-dir=%t -O3 \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+// RUN: ls %t | FileCheck %s -check-prefix=OBJECTS
+//
+// A hit loads the cached object: empty ones fail to load.
+// RUN: truncate -s 0 %t/*.o
+// RUN: not tpp-run %s -tpp-pipeline=default -n 1 -cache-dir=%t \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext 2>&1 | \
+// RUN: FileCheck %s -check-prefix=HIT
+//
+
+func.func @entry(%A: tensor<4x4xf32>, %B: tensor<4x4xf32>,
+                 %C: tensor<4x4xf32>) -> tensor<4x4xf32> {
+  %D = linalg.matmul ins(%A, %B: tensor<4x4xf32>, tensor<4x4xf32>)
+                     outs(%C: tensor<4x4xf32>) -> tensor<4x4xf32>
+  return %D : tensor<4x4xf32>
+}
+
+// CHECK-COUNT-4: ( 5, 5, 5, 5 )
+
+// OBJECT-COUNT-1: .o
+// OBJECT-NOT: .o
+
+// OBJECTS-COUNT-2: .o
+// OBJECTS-NOT: .o
+
+// HIT: ERROR:
@@ -0,0 +1,32 @@
+// REQUIRES: openmp
+// RUN: tpp-run %s -print=checksum -n 1 -parallel \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext,%ompruntime | \
+// RUN: FileCheck %s
+//
+// RUN: tpp-run %s -print=checksum -n 1 -parallel -numa-node=0 \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext,%ompruntime | \
+// RUN: FileCheck %s
+//
+
+// The rows are split across the OpenMP threads.
+func.func @entry(%A: memref<8x4xf32>, %B: memref<8x4xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c8 = arith.constant 8 : index
+  scf.parallel (%i) = (%c0) to (%c8) step (%c1) {
+    scf.for %j = %c0 to %c4 step %c1 {
+      %a = memref.load %A[%i, %j] : memref<8x4xf32>
+      %b = memref.load %B[%i, %j] : memref<8x4xf32>
+      %0 = arith.addf %a, %b : f32
+      memref.store %0, %B[%i, %j] : memref<8x4xf32>
+    }
+    scf.yield
+  }
+  return
+}
+
+// All ones in, 2.0 out
+// CHECK: Checksum: 32 elements, sum: 6.400000e+01, sum sq: 1.280000e+02, max: 2.000000e+00
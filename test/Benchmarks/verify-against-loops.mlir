@@ -0,0 +1,46 @@
+// RUN: tpp-run %s -tpp-pipeline=default -verify-against=loops -seed=123 \
+// RUN:  -print=none -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: tpp-run %s -tpp-pipeline=aggressive -verify-against=loops -seed=123 \
+// RUN:  -print=none -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// Verification needs random inputs: without a seed it picks one, and it
+// rejects all ones.
+// RUN: tpp-run %s -tpp-pipeline=default -verify-against=loops \
+// RUN:  -print=none -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+// RUN: not tpp-run %s -tpp-pipeline=default -verify-against=loops -seed=0 \
+// RUN:  -print=none -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext 2>&1 | \
+// RUN: FileCheck %s -check-prefix=SEED
+//
+
+#map0 = affine_map<(d0, d1) -> (d1)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @entry(%A: tensor<128x256xf32>, %B: tensor<256x512xf32>,
+                 %Bias: tensor<512xf32>, %C: tensor<128x512xf32>) -> tensor<128x512xf32> {
+  %c0 = arith.constant 0.0 : f32
+  %0 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%Bias : tensor<512xf32>) outs(%C : tensor<128x512xf32>) {
+  ^bb0(%arg0: f32, %arg1: f32):
+    linalg.yield %arg0 : f32
+  } -> tensor<128x512xf32>
+  %1 = linalg.matmul ins(%A, %B: tensor<128x256xf32>, tensor<256x512xf32>) outs(%0: tensor<128x512xf32>) -> tensor<128x512xf32>
+  %2 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel"]} outs(%1 : tensor<128x512xf32>) {
+  ^bb0(%arg0: f32):
+    %3 = arith.maxf %arg0, %c0 : f32
+    linalg.yield %3 : f32
+  } -> tensor<128x512xf32>
+  return %2 : tensor<128x512xf32>
+}
+
+// CHECK: Verification: PASS
+
+// SEED: error: -verify-against needs random inputs, -seed=0 makes them all ones
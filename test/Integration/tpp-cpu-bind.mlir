@@ -0,0 +1,32 @@
+// RUN: tpp-run %s -print=none -e entry -entry-point-result=void \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// tpp_cpu_bind, as TPPInstances calls it, on the main thread: the process'
+// CPUs are those of the main thread, so once it is bound to one of them,
+// tpp_num_cpus returns 1.
+
+func.func private @tpp_num_cpus() -> i64 attributes {llvm.emit_c_interface}
+func.func private @tpp_cpu_bind(i64, i64) -> i64 attributes {llvm.emit_c_interface}
+
+func.func @entry(%A: memref<4xf32>) {
+  %c0 = arith.constant 0 : i64
+  %c1 = arith.constant 1 : i64
+  %cpus = call @tpp_num_cpus() : () -> i64
+  %any = arith.cmpi sge, %cpus, %c1 : i64
+  check.expect_true(%any) : i1
+
+  // A range past the last CPU is empty, the thread is not bound.
+  // CHECK: -1
+  %past = call @tpp_cpu_bind(%cpus, %c1) : (i64, i64) -> i64
+  vector.print %past : i64
+
+  // CHECK-NEXT: 0
+  %bound = call @tpp_cpu_bind(%c0, %c1) : (i64, i64) -> i64
+  vector.print %bound : i64
+  // CHECK-NEXT: 1
+  %after = call @tpp_num_cpus() : () -> i64
+  vector.print %after : i64
+  return
+}
@@ -0,0 +1,87 @@
+// RUN: tpp-run %s -tpp-pipeline=default -print=none \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// The input is all ones. 63 * 129 = 8127 elements: the vector body covers
+// 253 steps of 32 elements, the scalar tail ends on a partial mask byte.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#reduce = affine_map<(d0, d1) -> ()>
+
+func.func @count_kept(%out: memref<63x129xf32>) -> i64 {
+  %zero = arith.constant 0.0 : f32
+  %c0 = arith.constant 0 : i64
+  %count = memref.alloc() : memref<i64>
+  memref.store %c0, %count[] : memref<i64>
+  linalg.generic {indexing_maps = [#map, #reduce], iterator_types = ["reduction", "reduction"]}
+    ins(%out : memref<63x129xf32>) outs(%count : memref<i64>) {
+  ^bb0(%x: f32, %acc: i64):
+    %0 = arith.cmpf ogt, %x, %zero : f32
+    %1 = arith.extui %0 : i1 to i64
+    %2 = arith.addi %acc, %1 : i64
+    linalg.yield %2 : i64
+  }
+  %kept = memref.load %count[] : memref<i64>
+  memref.dealloc %count : memref<i64>
+  return %kept : i64
+}
+
+func.func @entry(%I: memref<63x129xf32>, %O: memref<63x129xf32>) {
+  %zero = arith.constant 0.0 : f32
+  %seed = arith.constant 42 : i64
+  %otherSeed = arith.constant 43 : i64
+
+  %out = memref.alloc() : memref<63x129xf32>
+  %mask = memref.alloc() : memref<1016xi8>
+  tpp.dropout ins(%I: memref<63x129xf32>, %seed: i64)
+              out(%out: memref<63x129xf32>, %mask: memref<1016xi8>)
+              {probability = 0.25 : f32}
+
+  // The same seed gives the same output and the same mask, which
+  // dropout_backward applies to the ones of the input.
+  %again = memref.alloc() : memref<63x129xf32>
+  %againMask = memref.alloc() : memref<1016xi8>
+  tpp.dropout ins(%I: memref<63x129xf32>, %seed: i64)
+              out(%again: memref<63x129xf32>, %againMask: memref<1016xi8>)
+              {probability = 0.25 : f32}
+  check.expect_almost_eq(%out, %again, %zero)
+    : memref<63x129xf32>, memref<63x129xf32>, f32
+  %back = memref.alloc() : memref<63x129xf32>
+  tpp.dropout_backward ins(%I: memref<63x129xf32>, %againMask: memref<1016xi8>)
+                       out(%back: memref<63x129xf32>)
+                       {probability = 0.25 : f32}
+  check.expect_almost_eq(%out, %back, %zero)
+    : memref<63x129xf32>, memref<63x129xf32>, f32
+
+  // About 1 - p of the elements are kept, with a 0.5% standard deviation.
+  // CHECK: 6117
+  %kept = call @count_kept(%out) : (memref<63x129xf32>) -> i64
+  vector.print %kept : i64
+  %numElements = arith.constant 8127.0 : f32
+  %expected = arith.constant 0.75 : f32
+  %tolerance = arith.constant 0.02 : f32
+  %keptF = arith.sitofp %kept : i64 to f32
+  %fraction = arith.divf %keptF, %numElements : f32
+  %diff = arith.subf %fraction, %expected : f32
+  %absDiff = math.absf %diff : f32
+  %close = arith.cmpf olt, %absDiff, %tolerance : f32
+  check.expect_true(%close) : i1
+
+  // Another seed, another mask.
+  // CHECK: 6027
+  tpp.dropout ins(%I: memref<63x129xf32>, %otherSeed: i64)
+              out(%again: memref<63x129xf32>, %againMask: memref<1016xi8>)
+              {probability = 0.25 : f32}
+  %otherKept = call @count_kept(%again) : (memref<63x129xf32>) -> i64
+  vector.print %otherKept : i64
+
+  memref.copy %out, %O : memref<63x129xf32> to memref<63x129xf32>
+  memref.dealloc %out : memref<63x129xf32>
+  memref.dealloc %mask : memref<1016xi8>
+  memref.dealloc %again : memref<63x129xf32>
+  memref.dealloc %againMask : memref<1016xi8>
+  memref.dealloc %back : memref<63x129xf32>
+  return
+}
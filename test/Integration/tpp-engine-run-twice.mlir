@@ -0,0 +1,35 @@
+// RUN: tpp-engine-run %s -entry=entry -compiles=2 -runs=2 \
+// RUN: -shared-libs=%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+// The second engine reads the first one's output from the pipeline cache.
+// RUN: rm -rf %t
+// RUN: tpp-engine-run %s -entry=entry -compiles=2 -runs=2 -cache-dir=%t \
+// RUN: -shared-libs=%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// Each call reuses the pre-dispatched kernels and the arena holding %tmp.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @entry(%A: memref<16x16xf32>, %B: memref<16x16xf32>,
+                 %C: memref<16x16xf32>) {
+  %cst = arith.constant 0.000000e+00 : f32
+  %tmp = memref.alloc() : memref<16x16xf32>
+  linalg.fill ins(%cst : f32) outs(%tmp : memref<16x16xf32>)
+  linalg.matmul ins(%A, %B : memref<16x16xf32>, memref<16x16xf32>)
+                outs(%tmp : memref<16x16xf32>)
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]} ins(%tmp : memref<16x16xf32>) outs(%C : memref<16x16xf32>) {
+  ^bb0(%t: f32, %c: f32):
+    %0 = arith.addf %t, %c : f32
+    linalg.yield %0 : f32
+  }
+  memref.dealloc %tmp : memref<16x16xf32>
+  return
+}
+
+// CHECK: compile 0 run 0: sum 8.960000e+02
+// CHECK-NEXT: compile 0 run 1: sum 8.960000e+02
+// CHECK-NEXT: compile 1 run 0: sum 8.960000e+02
+// CHECK-NEXT: compile 1 run 1: sum 8.960000e+02
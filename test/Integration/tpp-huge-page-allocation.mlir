@@ -0,0 +1,29 @@
+// REQUIRES: huge-pages
+// RUN: env TPP_HUGE_PAGE_STATS=1 tpp-run %s -tpp-pipeline=default -print=none \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext 2>&1 | \
+// RUN: FileCheck %s
+//
+
+// The 4MB temporary is planned in the kernel's arena, which is large enough
+// to go in huge pages, and the pages the kernel touches are huge ones: the
+// runtime reports them when it frees the arena, as the thread exits.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @entry(%A: memref<1024x1024xf32>, %B: memref<1024x1024xf32>) {
+  %cst = arith.constant 2.0 : f32
+  %tmp = memref.alloc() : memref<1024x1024xf32>
+  linalg.fill ins(%cst : f32) outs(%tmp : memref<1024x1024xf32>)
+  linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]}
+    ins(%A, %tmp : memref<1024x1024xf32>, memref<1024x1024xf32>)
+    outs(%B : memref<1024x1024xf32>) {
+  ^bb0(%a: f32, %t: f32, %b: f32):
+    %0 = arith.addf %a, %t : f32
+    linalg.yield %0 : f32
+  }
+  memref.dealloc %tmp : memref<1024x1024xf32>
+  return
+}
+
+// CHECK: tpp_huge_free: 4194304 bytes, {{[1-9][0-9]*}} in huge pages
@@ -0,0 +1,24 @@
+// RUN: tpp-run %s -tpp-pipeline=default -verify-against=loops -seed=123 \
+// RUN:  -print=none -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+// RUN: tpp-opt %s -default-tpp-passes | FileCheck %s -check-prefix=INLINE
+//
+
+// A GEMM small enough to be inlined (2 * 11 * 36 * 5 flops), and larger than
+// the 8x32 register tile of the inlined GEMMs, with a 3x4 tail, against the
+// loops.
+
+func.func @entry(%A: tensor<11x5xf32>, %B: tensor<5x36xf32>,
+                 %C: tensor<11x36xf32>) -> tensor<11x36xf32> {
+  %0 = linalg.matmul ins(%A, %B: tensor<11x5xf32>, tensor<5x36xf32>)
+                     outs(%C: tensor<11x36xf32>) -> tensor<11x36xf32>
+  return %0 : tensor<11x36xf32>
+}
+
+// CHECK: Verification: PASS
+
+// INLINE-LABEL: func.func @entry(
+// INLINE-NOT: xsmm_matmul_invoke
+// INLINE: vector.outerproduct
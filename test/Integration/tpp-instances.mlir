@@ -0,0 +1,40 @@
+// RUN: tpp-engine-run %s -entry=entry -compiles=1 -runs=2 \
+// RUN: -instances=2 -weights=1 \
+// RUN: -shared-libs=%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+// RUN: tpp-serve-bench %s -entry=entry -instances=1,2 -weights=1 \
+// RUN: -warmup=1 -iterations=2 \
+// RUN: -shared-libs=%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s -check-prefix=BENCH
+//
+
+// Each instance runs on its own thread and CPUs, with its own copy of the
+// weights (%B) and its own arena (%tmp): all get the direct call's result.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @entry(%A: memref<16x16xf32>, %B: memref<16x16xf32>,
+                 %C: memref<16x16xf32>) {
+  %cst = arith.constant 0.000000e+00 : f32
+  %tmp = memref.alloc() : memref<16x16xf32>
+  linalg.fill ins(%cst : f32) outs(%tmp : memref<16x16xf32>)
+  linalg.matmul ins(%A, %B : memref<16x16xf32>, memref<16x16xf32>)
+                outs(%tmp : memref<16x16xf32>)
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]} ins(%tmp : memref<16x16xf32>) outs(%C : memref<16x16xf32>) {
+  ^bb0(%t: f32, %c: f32):
+    %0 = arith.addf %t, %c : f32
+    linalg.yield %0 : f32
+  }
+  memref.dealloc %tmp : memref<16x16xf32>
+  return
+}
+
+// CHECK: compile 0 instance 0 run 0: sum 8.960000e+02
+// CHECK-NEXT: compile 0 instance 0 run 1: sum 8.960000e+02
+// CHECK-NEXT: compile 0 instance 1 run 0: sum 8.960000e+02
+// CHECK-NEXT: compile 0 instance 1 run 1: sum 8.960000e+02
+
+// BENCH: instances cpus latency (ms) calls/s speedup
+// BENCH-NEXT: {{^ +}}1 {{[0-9]+ [0-9.]+ [0-9.]+}} 1.00{{$}}
+// BENCH-NEXT: {{^ +}}2 {{[0-9]+ [0-9.]+ [0-9.]+ [0-9.]+$}}
@@ -0,0 +1,66 @@
+// RUN: tpp-run %s -tpp-pipeline=default -verify-against=loops -seed=123 \
+// RUN:  -print=none -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// The contiguous updates call the fused runtime kernels, the strided one
+// lowers to loops, all are compared against convert-tpp-to-loops. The kernel
+// updates copies of its inputs, which the reference shares.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @entry(%G: memref<16x64xf32>, %P: memref<16x64xf32>,
+                 %M: memref<16x64xf32>, %O: memref<16x64xf32>) {
+  %zero = arith.constant 0.0 : f32
+  %lr = arith.constant 0.01 : f32
+  %step = arith.constant 0.02 : f32
+
+  // AdamW, from zero second moments.
+  %adamP = memref.alloc() : memref<16x64xf32>
+  %adamM = memref.alloc() : memref<16x64xf32>
+  %adamV = memref.alloc() : memref<16x64xf32>
+  memref.copy %P, %adamP : memref<16x64xf32> to memref<16x64xf32>
+  memref.copy %M, %adamM : memref<16x64xf32> to memref<16x64xf32>
+  linalg.fill ins(%zero : f32) outs(%adamV : memref<16x64xf32>)
+  tpp.adam_update ins(%G: memref<16x64xf32>, %lr: f32, %step: f32)
+                  out(%adamP: memref<16x64xf32>, %adamM: memref<16x64xf32>,
+                      %adamV: memref<16x64xf32>)
+                  {beta1 = 0.9 : f32, beta2 = 0.999 : f32,
+                   epsilon = 1.0e-08 : f32, weight_decay = 0.1 : f32}
+
+  // SGD on the left half of wider buffers: strided.
+  %sgdP = memref.alloc() : memref<16x128xf32>
+  %sgdV = memref.alloc() : memref<16x128xf32>
+  %subP = memref.subview %sgdP[0, 0] [16, 64] [1, 1]
+    : memref<16x128xf32> to memref<16x64xf32, strided<[128, 1]>>
+  %subV = memref.subview %sgdV[0, 0] [16, 64] [1, 1]
+    : memref<16x128xf32> to memref<16x64xf32, strided<[128, 1]>>
+  memref.copy %P, %subP
+    : memref<16x64xf32> to memref<16x64xf32, strided<[128, 1]>>
+  memref.copy %M, %subV
+    : memref<16x64xf32> to memref<16x64xf32, strided<[128, 1]>>
+  tpp.sgd_update ins(%G: memref<16x64xf32>, %lr: f32)
+                 out(%subP: memref<16x64xf32, strided<[128, 1]>>,
+                     %subV: memref<16x64xf32, strided<[128, 1]>>)
+                 {momentum = 0.9 : f32, weight_decay = 0.1 : f32}
+
+  linalg.generic {indexing_maps = [#map, #map, #map, #map], iterator_types = ["parallel", "parallel"]}
+    ins(%adamP, %adamV, %subP : memref<16x64xf32>, memref<16x64xf32>,
+                                memref<16x64xf32, strided<[128, 1]>>)
+    outs(%O : memref<16x64xf32>) {
+  ^bb0(%p: f32, %v: f32, %s: f32, %out: f32):
+    %0 = arith.addf %p, %v : f32
+    %1 = arith.addf %0, %s : f32
+    linalg.yield %1 : f32
+  }
+
+  memref.dealloc %adamP : memref<16x64xf32>
+  memref.dealloc %adamM : memref<16x64xf32>
+  memref.dealloc %adamV : memref<16x64xf32>
+  memref.dealloc %sgdP : memref<16x128xf32>
+  memref.dealloc %sgdV : memref<16x128xf32>
+  return
+}
+
+// CHECK: Verification: PASS
@@ -0,0 +1,135 @@
+// RUN: tpp-run %s -tpp-pipeline=default -verify-against=loops \
+// RUN:  -print=none -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// The int8 GEMM and BRGEMM run through LIBXSMM (VNNI_A and B_UNSIGNED, with
+// ldb counted in VNNI columns), requantize through the vector lowering, and
+// are compared against the loops. The int8 operands are built in the kernel,
+// since tpp-run only initializes f32 arguments: A spans [128, 191], which is
+// negative if read as signed, and B varies along n and k, which a wrong ldb
+// would mix up.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#map3 = affine_map<(d0, d1, d2) -> (d0, d1, d2)>
+#map4 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+
+func.func @entry(%O: memref<32x32xf32>) {
+  %c3 = arith.constant 3 : index
+  %c5 = arith.constant 5 : index
+  %c7 = arith.constant 7 : index
+  %c64 = arith.constant 64 : index
+  %c128 = arith.constant 128 : index
+  %c2_i8 = arith.constant 2 : i8
+
+  // GEMM operands: A[m][k] and B[k/4][n][4].
+  %A = memref.alloc() : memref<32x64xi8>
+  linalg.generic {indexing_maps = [#map], iterator_types = ["parallel", "parallel"]}
+    outs(%A : memref<32x64xi8>) {
+  ^bb0(%out: i8):
+    %m = linalg.index 0 : index
+    %k = linalg.index 1 : index
+    %0 = arith.addi %m, %k : index
+    %1 = arith.remui %0, %c64 : index
+    %2 = arith.addi %1, %c128 : index
+    %3 = arith.index_cast %2 : index to i8
+    linalg.yield %3 : i8
+  }
+  %B = memref.alloc() : memref<16x32x4xi8>
+  linalg.generic {indexing_maps = [#map3], iterator_types = ["parallel", "parallel", "parallel"]}
+    outs(%B : memref<16x32x4xi8>) {
+  ^bb0(%out: i8):
+    %k0 = linalg.index 0 : index
+    %n = linalg.index 1 : index
+    %k1 = linalg.index 2 : index
+    %0 = arith.addi %k0, %n : index
+    %1 = arith.addi %0, %k1 : index
+    %2 = arith.remui %1, %c5 : index
+    %3 = arith.index_cast %2 : index to i8
+    %4 = arith.subi %3, %c2_i8 : i8
+    linalg.yield %4 : i8
+  }
+
+  // BRGEMM operands, batch of two.
+  %BA = memref.alloc() : memref<2x32x64xi8>
+  linalg.generic {indexing_maps = [#map3], iterator_types = ["parallel", "parallel", "parallel"]}
+    outs(%BA : memref<2x32x64xi8>) {
+  ^bb0(%out: i8):
+    %b = linalg.index 0 : index
+    %m = linalg.index 1 : index
+    %k = linalg.index 2 : index
+    %0 = arith.muli %b, %c7 : index
+    %1 = arith.addi %0, %m : index
+    %2 = arith.addi %1, %k : index
+    %3 = arith.remui %2, %c64 : index
+    %4 = arith.addi %3, %c128 : index
+    %5 = arith.index_cast %4 : index to i8
+    linalg.yield %5 : i8
+  }
+  %BB = memref.alloc() : memref<2x16x32x4xi8>
+  linalg.generic {indexing_maps = [#map4], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+    outs(%BB : memref<2x16x32x4xi8>) {
+  ^bb0(%out: i8):
+    %b = linalg.index 0 : index
+    %k0 = linalg.index 1 : index
+    %n = linalg.index 2 : index
+    %k1 = linalg.index 3 : index
+    %0 = arith.muli %k0, %c3 : index
+    %1 = arith.addi %b, %0 : index
+    %2 = arith.addi %1, %n : index
+    %3 = arith.addi %2, %k1 : index
+    %4 = arith.remui %3, %c5 : index
+    %5 = arith.index_cast %4 : index to i8
+    %6 = arith.subi %5, %c2_i8 : i8
+    linalg.yield %6 : i8
+  }
+
+  // Non-zero accumulators, the kernels add to C.
+  %C = memref.alloc() : memref<32x32xi32>
+  %BC = memref.alloc() : memref<32x32xi32>
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+    outs(%C, %BC : memref<32x32xi32>, memref<32x32xi32>) {
+  ^bb0(%out: i32, %out1: i32):
+    %m = linalg.index 0 : index
+    %n = linalg.index 1 : index
+    %0 = arith.muli %m, %n : index
+    %1 = arith.remui %0, %c7 : index
+    %2 = arith.index_cast %1 : index to i32
+    linalg.yield %2, %2 : i32, i32
+  }
+
+  tpp.quantized_matmul ins(%A: memref<32x64xi8>, %B: memref<16x32x4xi8>)
+                       out(%C: memref<32x32xi32>)
+  tpp.quantized_brgemm ins(%BA: memref<2x32x64xi8>, %BB: memref<2x16x32x4xi8>)
+                       out(%BC: memref<32x32xi32>)
+
+  // Some values saturate on either side of [0, 255].
+  %Q = memref.alloc() : memref<32x32xi8>
+  tpp.requantize ins(%C: memref<32x32xi32>) out(%Q: memref<32x32xi8>)
+                 {scale = 0.5 : f32, zero_point = 128 : i32,
+                  min = 0 : i32, max = 255 : i32}
+
+  linalg.generic {indexing_maps = [#map, #map, #map, #map], iterator_types = ["parallel", "parallel"]}
+    ins(%C, %BC, %Q : memref<32x32xi32>, memref<32x32xi32>, memref<32x32xi8>)
+    outs(%O : memref<32x32xf32>) {
+  ^bb0(%c: i32, %bc: i32, %q: i8, %out: f32):
+    %0 = arith.sitofp %c : i32 to f32
+    %1 = arith.sitofp %bc : i32 to f32
+    %2 = arith.uitofp %q : i8 to f32
+    %3 = arith.addf %0, %1 : f32
+    %4 = arith.addf %3, %2 : f32
+    linalg.yield %4 : f32
+  }
+
+  memref.dealloc %A : memref<32x64xi8>
+  memref.dealloc %B : memref<16x32x4xi8>
+  memref.dealloc %BA : memref<2x32x64xi8>
+  memref.dealloc %BB : memref<2x16x32x4xi8>
+  memref.dealloc %C : memref<32x32xi32>
+  memref.dealloc %BC : memref<32x32xi32>
+  memref.dealloc %Q : memref<32x32xi8>
+  return
+}
+
+// CHECK: Verification: PASS
@@ -0,0 +1,97 @@
+// RUN: tpp-run %s -tpp-pipeline=default -verify-against=loops -seed=123 \
+// RUN:  -print=none -e data_gradient -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+// RUN: tpp-run %s -tpp-pipeline=aggressive -verify-against=loops -seed=123 \
+// RUN:  -print=none -e data_gradient -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+// RUN: tpp-run %s -tpp-pipeline=aggressive -verify-against=loops -seed=123 \
+// RUN:  -print=none -e weight_gradient -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+// RUN: tpp-opt %s -default-tpp-passes="aggressive" | \
+// RUN: FileCheck %s -check-prefix=XSMM
+//
+
+// Backward pass of a relu layer followed by the two transposed matmuls of an
+// MLP layer, against the loops. The inputs are in [0, 1), the forward
+// activation is shifted by 0.5 so that the relu mask drops about half of the
+// gradient.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#mapA = affine_map<(i, j, k) -> (i, k)>
+#mapBT = affine_map<(i, j, k) -> (j, k)>
+#mapAT = affine_map<(i, j, k) -> (k, i)>
+#mapB = affine_map<(i, j, k) -> (k, j)>
+#mapC = affine_map<(i, j, k) -> (i, j)>
+
+// dX = dZ * W^T
+func.func @data_gradient(%Z: tensor<64x128xf32>, %dY: tensor<64x128xf32>,
+                         %W: tensor<256x128xf32>,
+                         %dX: tensor<64x256xf32>) -> tensor<64x256xf32> {
+  %c0 = arith.constant 0.0 : f32
+  %half = arith.constant 0.5 : f32
+  %empty = tensor.empty() : tensor<64x128xf32>
+  %fwd = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]} ins(%Z : tensor<64x128xf32>) outs(%empty : tensor<64x128xf32>) {
+  ^bb0(%z: f32, %out: f32):
+    %0 = arith.subf %z, %half : f32
+    linalg.yield %0 : f32
+  } -> tensor<64x128xf32>
+  %empty1 = tensor.empty() : tensor<64x128xf32>
+  %dZ = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]} ins(%dY, %fwd : tensor<64x128xf32>, tensor<64x128xf32>) outs(%empty1 : tensor<64x128xf32>) {
+  ^bb0(%g: f32, %x: f32, %out: f32):
+    %0 = arith.cmpf ogt, %x, %c0 : f32
+    %1 = arith.select %0, %g, %c0 : f32
+    linalg.yield %1 : f32
+  } -> tensor<64x128xf32>
+  %0 = linalg.generic {indexing_maps = [#mapA, #mapBT, #mapC], iterator_types = ["parallel", "parallel", "reduction"]} ins(%dZ, %W : tensor<64x128xf32>, tensor<256x128xf32>) outs(%dX : tensor<64x256xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %1 = arith.mulf %a, %b : f32
+    %2 = arith.addf %c, %1 : f32
+    linalg.yield %2 : f32
+  } -> tensor<64x256xf32>
+  return %0 : tensor<64x256xf32>
+}
+
+// dW = X^T * dZ
+func.func @weight_gradient(%Z: tensor<64x128xf32>, %dY: tensor<64x128xf32>,
+                           %X: tensor<64x256xf32>,
+                           %dW: tensor<256x128xf32>) -> tensor<256x128xf32> {
+  %c0 = arith.constant 0.0 : f32
+  %half = arith.constant 0.5 : f32
+  %empty = tensor.empty() : tensor<64x128xf32>
+  %fwd = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]} ins(%Z : tensor<64x128xf32>) outs(%empty : tensor<64x128xf32>) {
+  ^bb0(%z: f32, %out: f32):
+    %0 = arith.subf %z, %half : f32
+    linalg.yield %0 : f32
+  } -> tensor<64x128xf32>
+  %empty1 = tensor.empty() : tensor<64x128xf32>
+  %dZ = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]} ins(%dY, %fwd : tensor<64x128xf32>, tensor<64x128xf32>) outs(%empty1 : tensor<64x128xf32>) {
+  ^bb0(%g: f32, %x: f32, %out: f32):
+    %0 = arith.cmpf ogt, %x, %c0 : f32
+    %1 = arith.select %0, %g, %c0 : f32
+    linalg.yield %1 : f32
+  } -> tensor<64x128xf32>
+  %0 = linalg.generic {indexing_maps = [#mapAT, #mapB, #mapC], iterator_types = ["parallel", "parallel", "reduction"]} ins(%X, %dZ : tensor<64x256xf32>, tensor<64x128xf32>) outs(%dW : tensor<256x128xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %1 = arith.mulf %a, %b : f32
+    %2 = arith.addf %c, %1 : f32
+    linalg.yield %2 : f32
+  } -> tensor<256x128xf32>
+  return %0 : tensor<256x128xf32>
+}
+
+// CHECK: Verification: PASS
+
+// The relu backward reads the forward activation as its mask input, and both
+// transposed matmuls are packed to BRGEMM.
+// XSMM-LABEL: func.func @data_gradient(
+// XSMM-DAG: call @xsmm_unary_secondary_invoke
+// XSMM-DAG: call @xsmm_brgemm_invoke
+// XSMM-LABEL: func.func @weight_gradient(
+// XSMM-DAG: call @xsmm_unary_secondary_invoke
+// XSMM-DAG: call @xsmm_brgemm_invoke
@@ -0,0 +1,19 @@
+// RUN: tpp-specialize-run %s -entry=entry \
+// RUN:  -call=4x16,16x8,4x8 -call=2x16,16x8,2x8 -call=4x16,16x8,4x8 \
+// RUN: -shared-libs=%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// The cache reads the shapes from the descriptors: the third call has the
+// first one's shapes, and reuses its executable.
+
+func.func @entry(%A: memref<?x16xf32>, %B: memref<16x?xf32>,
+                 %C: memref<?x?xf32>) {
+  linalg.matmul ins(%A, %B : memref<?x16xf32>, memref<16x?xf32>)
+                outs(%C : memref<?x?xf32>)
+  return
+}
+
+// CHECK: call 0: sum 1.120000e+02, 1 specializations
+// CHECK-NEXT: call 1: sum 5.600000e+01, 2 specializations
+// CHECK-NEXT: call 2: sum 1.120000e+02, 2 specializations
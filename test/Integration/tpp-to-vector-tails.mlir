@@ -0,0 +1,175 @@
+// RUN: tpp-opt %s -convert-tpp-to-vector | \
+// RUN: tpp-run -print=none -e entry -entry-point-result=void \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+// RUN: tpp-opt %s -convert-tpp-to-vector="register-tile=4,8,2" | \
+// RUN: tpp-run -print=none -e entry -entry-point-result=void \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// Shapes that are not multiples of the register tile, through the vector
+// lowering, against linalg references lowered to loops:
+//  * matmul 11x5 * 5x37: 3 rows and 5 (or 5 and 1 with TN=8) columns of tail,
+//    K is odd so TK=2 is not unrolled;
+//  * brgemm 3 x (7x6 * 6x19): row and column tails, TK=2 unrolled;
+//  * add and relu on 7x19: tails along the rows.
+// The inputs are small integers, the results are exact: every difference
+// printed is 0.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#reduce = affine_map<(d0, d1) -> ()>
+#mmA = affine_map<(i, j, k) -> (i, k)>
+#mmB = affine_map<(i, j, k) -> (k, j)>
+#mmC = affine_map<(i, j, k) -> (i, j)>
+#brA = affine_map<(b, i, j, k) -> (b, i, k)>
+#brB = affine_map<(b, i, j, k) -> (b, k, j)>
+#brC = affine_map<(b, i, j, k) -> (i, j)>
+
+// ((7 i + 3 j + salt) mod 5) - 2, in [-2, 2]
+func.func @init(%M: memref<?x?xf32>, %salt: index) {
+  %c2 = arith.constant 2.0 : f32
+  %c3 = arith.constant 3 : index
+  %c5 = arith.constant 5 : index
+  %c7 = arith.constant 7 : index
+  linalg.generic {indexing_maps = [#map], iterator_types = ["parallel", "parallel"]}
+    outs(%M : memref<?x?xf32>) {
+  ^bb0(%out: f32):
+    %i = linalg.index 0 : index
+    %j = linalg.index 1 : index
+    %0 = arith.muli %i, %c7 : index
+    %1 = arith.muli %j, %c3 : index
+    %2 = arith.addi %0, %1 : index
+    %3 = arith.addi %2, %salt : index
+    %4 = arith.remui %3, %c5 : index
+    %5 = arith.index_cast %4 : index to i64
+    %6 = arith.sitofp %5 : i64 to f32
+    %7 = arith.subf %6, %c2 : f32
+    linalg.yield %7 : f32
+  }
+  return
+}
+
+// Largest absolute difference
+func.func @maxdiff(%A: memref<?x?xf32>, %B: memref<?x?xf32>) -> f32 {
+  %zero = arith.constant 0.0 : f32
+  %max = memref.alloc() : memref<f32>
+  memref.store %zero, %max[] : memref<f32>
+  linalg.generic {indexing_maps = [#map, #map, #reduce], iterator_types = ["reduction", "reduction"]}
+    ins(%A, %B : memref<?x?xf32>, memref<?x?xf32>) outs(%max : memref<f32>) {
+  ^bb0(%a: f32, %b: f32, %acc: f32):
+    %0 = arith.subf %a, %b : f32
+    %1 = math.absf %0 : f32
+    %2 = arith.maxf %acc, %1 : f32
+    linalg.yield %2 : f32
+  }
+  %result = memref.load %max[] : memref<f32>
+  memref.dealloc %max : memref<f32>
+  return %result : f32
+}
+
+func.func @entry(%O: memref<4xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %c3 = arith.constant 3 : index
+  %zero = arith.constant 0.0 : f32
+
+  // Matmul
+  %A = memref.alloc() : memref<11x5xf32>
+  %B = memref.alloc() : memref<5x37xf32>
+  %C = memref.alloc() : memref<11x37xf32>
+  %Cref = memref.alloc() : memref<11x37xf32>
+  %dA = memref.cast %A : memref<11x5xf32> to memref<?x?xf32>
+  %dB = memref.cast %B : memref<5x37xf32> to memref<?x?xf32>
+  %dC = memref.cast %C : memref<11x37xf32> to memref<?x?xf32>
+  %dCref = memref.cast %Cref : memref<11x37xf32> to memref<?x?xf32>
+  call @init(%dA, %c0) : (memref<?x?xf32>, index) -> ()
+  call @init(%dB, %c1) : (memref<?x?xf32>, index) -> ()
+  call @init(%dC, %c2) : (memref<?x?xf32>, index) -> ()
+  call @init(%dCref, %c2) : (memref<?x?xf32>, index) -> ()
+  tpp.matmul ins(%A: memref<11x5xf32>, %B: memref<5x37xf32>) out(%C: memref<11x37xf32>)
+  linalg.generic {indexing_maps = [#mmA, #mmB, #mmC], iterator_types = ["parallel", "parallel", "reduction"]}
+    ins(%A, %B : memref<11x5xf32>, memref<5x37xf32>) outs(%Cref : memref<11x37xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %0 = arith.mulf %a, %b : f32
+    %1 = arith.addf %c, %0 : f32
+    linalg.yield %1 : f32
+  }
+  // CHECK: 0
+  %d0 = call @maxdiff(%dC, %dCref) : (memref<?x?xf32>, memref<?x?xf32>) -> f32
+  vector.print %d0 : f32
+
+  // BRGEMM, the batch is the outer dimension of the operands
+  %BA = memref.alloc() : memref<3x7x6xf32>
+  %BB = memref.alloc() : memref<3x6x19xf32>
+  %BC = memref.alloc() : memref<7x19xf32>
+  %BCref = memref.alloc() : memref<7x19xf32>
+  %fA = memref.collapse_shape %BA [[0, 1], [2]] : memref<3x7x6xf32> into memref<21x6xf32>
+  %fB = memref.collapse_shape %BB [[0, 1], [2]] : memref<3x6x19xf32> into memref<18x19xf32>
+  %dfA = memref.cast %fA : memref<21x6xf32> to memref<?x?xf32>
+  %dfB = memref.cast %fB : memref<18x19xf32> to memref<?x?xf32>
+  %dBC = memref.cast %BC : memref<7x19xf32> to memref<?x?xf32>
+  %dBCref = memref.cast %BCref : memref<7x19xf32> to memref<?x?xf32>
+  call @init(%dfA, %c3) : (memref<?x?xf32>, index) -> ()
+  call @init(%dfB, %c0) : (memref<?x?xf32>, index) -> ()
+  call @init(%dBC, %c1) : (memref<?x?xf32>, index) -> ()
+  call @init(%dBCref, %c1) : (memref<?x?xf32>, index) -> ()
+  tpp.brgemm ins(%BA: memref<3x7x6xf32>, %BB: memref<3x6x19xf32>) out(%BC: memref<7x19xf32>)
+  linalg.generic {indexing_maps = [#brA, #brB, #brC], iterator_types = ["reduction", "parallel", "parallel", "reduction"]}
+    ins(%BA, %BB : memref<3x7x6xf32>, memref<3x6x19xf32>) outs(%BCref : memref<7x19xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %0 = arith.mulf %a, %b : f32
+    %1 = arith.addf %c, %0 : f32
+    linalg.yield %1 : f32
+  }
+  // CHECK-NEXT: 0
+  %d1 = call @maxdiff(%dBC, %dBCref) : (memref<?x?xf32>, memref<?x?xf32>) -> f32
+  vector.print %d1 : f32
+
+  // Add, then relu in place: about half of the sums are negative
+  %X = memref.alloc() : memref<7x19xf32>
+  %Y = memref.alloc() : memref<7x19xf32>
+  %Yref = memref.alloc() : memref<7x19xf32>
+  %dX = memref.cast %X : memref<7x19xf32> to memref<?x?xf32>
+  %dY = memref.cast %Y : memref<7x19xf32> to memref<?x?xf32>
+  %dYref = memref.cast %Yref : memref<7x19xf32> to memref<?x?xf32>
+  call @init(%dX, %c2) : (memref<?x?xf32>, index) -> ()
+  call @init(%dY, %c3) : (memref<?x?xf32>, index) -> ()
+  call @init(%dYref, %c3) : (memref<?x?xf32>, index) -> ()
+  tpp.add ins(%X: memref<7x19xf32>) out(%Y: memref<7x19xf32>)
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+    ins(%X : memref<7x19xf32>) outs(%Yref : memref<7x19xf32>) {
+  ^bb0(%x: f32, %y: f32):
+    %0 = arith.addf %x, %y : f32
+    linalg.yield %0 : f32
+  }
+  // CHECK-NEXT: 0
+  %d2 = call @maxdiff(%dY, %dYref) : (memref<?x?xf32>, memref<?x?xf32>) -> f32
+  vector.print %d2 : f32
+
+  tpp.relu out(%Y: memref<7x19xf32>)
+  linalg.generic {indexing_maps = [#map], iterator_types = ["parallel", "parallel"]}
+    outs(%Yref : memref<7x19xf32>) {
+  ^bb0(%y: f32):
+    %0 = arith.maxf %y, %zero : f32
+    linalg.yield %0 : f32
+  }
+  // CHECK-NEXT: 0
+  %d3 = call @maxdiff(%dY, %dYref) : (memref<?x?xf32>, memref<?x?xf32>) -> f32
+  vector.print %d3 : f32
+
+  memref.dealloc %A : memref<11x5xf32>
+  memref.dealloc %B : memref<5x37xf32>
+  memref.dealloc %C : memref<11x37xf32>
+  memref.dealloc %Cref : memref<11x37xf32>
+  memref.dealloc %BA : memref<3x7x6xf32>
+  memref.dealloc %BB : memref<3x6x19xf32>
+  memref.dealloc %BC : memref<7x19xf32>
+  memref.dealloc %BCref : memref<7x19xf32>
+  memref.dealloc %X : memref<7x19xf32>
+  memref.dealloc %Y : memref<7x19xf32>
+  memref.dealloc %Yref : memref<7x19xf32>
+  return
+}
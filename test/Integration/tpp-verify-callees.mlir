@@ -0,0 +1,39 @@
+// RUN: tpp-run %s -tpp-pipeline=default -verify-against=loops -seed=123 \
+// RUN:  -verify-rel-threshold=1e-5 -print=none -e entry -entry-point-result=void \
+// RUN:  -mlir-print-ir-before=convert-func-to-llvm \
+// RUN: -shared-libs=%llvmlibdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext 2>&1 | \
+// RUN: FileCheck %s
+//
+
+// The kernel calls a helper, which the TPP pipeline turns into XSMM calls.
+// The reference must call its own copy of the helper, lowered to loops, not
+// the optimized one, or it would be compared against itself.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @helper(%A: memref<8x16xf32>, %B: memref<16x8xf32>,
+                  %C: memref<8x8xf32>) {
+  linalg.matmul ins(%A, %B : memref<8x16xf32>, memref<16x8xf32>)
+                outs(%C : memref<8x8xf32>)
+  return
+}
+
+func.func @entry(%A: memref<8x16xf32>, %B: memref<16x8xf32>,
+                 %O: memref<8x8xf32>) {
+  %zero = arith.constant 0.0 : f32
+  call @helper(%A, %B, %O)
+    : (memref<8x16xf32>, memref<16x8xf32>, memref<8x8xf32>) -> ()
+  linalg.generic {indexing_maps = [#map], iterator_types = ["parallel", "parallel"]}
+    outs(%O : memref<8x8xf32>) {
+  ^bb0(%out: f32):
+    %0 = arith.maxf %out, %zero : f32
+    linalg.yield %0 : f32
+  }
+  return
+}
+
+// CHECK: func.func @helper_reference(
+// CHECK-NOT: xsmm
+// CHECK: func.func @_entry_reference(
+// CHECK: call @helper_reference(
+// CHECK: Verification: PASS
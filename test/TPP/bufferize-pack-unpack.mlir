@@ -11,3 +11,17 @@ func.func @myfunc(%arg0: tensor<4x4xi32>) -> tensor<4x4xi32> {
 // CHECK-NEXT: linalgx.pack
 // CHECK-NEXT: linalgx.unpack
 // CHECK-NEXT: memref.dealloc
+
+// The output is updated in place.
+func.func @sparse_brgemm(%arg0: tensor<2x4x4xf32>, %arg1: tensor<?x4x4xf32>,
+                         %arg2: tensor<?xi64>, %arg3: tensor<4x4xf32>) -> tensor<4x4xf32> {
+  %0 = linalgx.sparse_brgemm ins(%arg0, %arg1, %arg2 : tensor<2x4x4xf32>, tensor<?x4x4xf32>, tensor<?xi64>)
+                             outs(%arg3 : tensor<4x4xf32>) -> tensor<4x4xf32>
+  return %0 : tensor<4x4xf32>
+}
+
+// CHECK-LABEL: func.func @sparse_brgemm(
+// CHECK-SAME: %[[A:.+]]: memref<2x4x4xf32>, %[[B:.+]]: memref<?x4x4xf32>, %[[IDX:.+]]: memref<?xi64>, %[[C:.+]]: memref<4x4xf32>)
+// CHECK-NOT: memref.alloc
+// CHECK: linalgx.sparse_brgemm ins(%[[A]], %[[B]], %[[IDX]] : memref<2x4x4xf32>, memref<?x4x4xf32>, memref<?xi64>) outs(%[[C]] : memref<4x4xf32>)
+// CHECK-NEXT: return
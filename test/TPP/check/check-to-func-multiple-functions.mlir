@@ -0,0 +1,35 @@
+// RUN: tpp-opt %s -split-input-file -convert-check-to-func | FileCheck %s
+
+// Functions sharing a runtime function get a single declaration.
+
+// CHECK-COUNT-1: func.func private @expect_true(i1) attributes {llvm.emit_c_interface}
+// CHECK-NOT: func.func private @expect_true
+// CHECK-LABEL: func.func @first
+// CHECK: call @expect_true(%{{.+}}) : (i1) -> ()
+func.func @first(%arg0: i1) {
+  check.expect_true(%arg0):i1
+  return
+}
+
+// CHECK-LABEL: func.func @second
+// CHECK: call @expect_true(%{{.+}}) : (i1) -> ()
+func.func @second(%arg0: i1) {
+  check.expect_true(%arg0):i1
+  return
+}
+
+// -----
+
+// An existing declaration is reused.
+
+// CHECK-COUNT-1: func.func private @expect_true(i1)
+// CHECK-NOT: func.func private @expect_true
+func.func private @expect_true(i1) attributes {llvm.emit_c_interface}
+
+// CHECK-LABEL: func.func @only
+// CHECK: call @expect_true(%{{.+}}) : (i1) -> ()
+// CHECK-NOT: check.expect_true
+func.func @only(%arg0: i1) {
+  check.expect_true(%arg0):i1
+  return
+}
@@ -0,0 +1,65 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: tpp-opt %s -default-tpp-passes="cache-dir=%t/cache" | FileCheck %s
+// RUN: ls %t/cache | FileCheck %s -check-prefix=FOUR
+// Changing @add only compiles @add and its caller again, the other units are
+// read from the cache.
+// RUN: sed 's/arith.addf/arith.subf/' %s > %t/sub.mlir
+// RUN: tpp-opt %t/sub.mlir -default-tpp-passes="cache-dir=%t/cache" | FileCheck %s -check-prefix=SUB
+// RUN: ls %t/cache | FileCheck %s -check-prefix=FIVE
+
+// CHECK-LABEL: func.func @matmul(
+// CHECK: call @xsmm_matmul_invoke
+// CHECK-LABEL: func.func @add(
+// CHECK-LABEL: func.func @caller(
+// CHECK: call @add(
+// Both units made a global for their constant, one of them is renamed.
+// CHECK: memref.global "private" constant @[[LOW:.+]] : memref<4xf32> = dense<[1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00]>
+// CHECK-LABEL: func.func @low(
+// CHECK: memref.get_global @[[LOW]]
+// CHECK: memref.global "private" constant @[[HIGH:.+]] : memref<4xf32> = dense<[5.000000e+00, 6.000000e+00, 7.000000e+00, 8.000000e+00]>
+// CHECK-LABEL: func.func @high(
+// CHECK: memref.get_global @[[HIGH]]
+
+// SUB-LABEL: func.func @matmul(
+// SUB: call @xsmm_matmul_invoke
+// SUB-LABEL: func.func @add(
+// SUB: arith.subf
+
+// @add and its caller are one unit, @matmul, @low and @high one each.
+// FOUR-COUNT-4: .mlir
+// FOUR-NOT: .mlir
+
+// FIVE-COUNT-5: .mlir
+// FIVE-NOT: .mlir
+
+#map = affine_map<(d0) -> (d0)>
+
+func.func @matmul(%A: tensor<64x64xf32>, %B: tensor<64x64xf32>,
+                  %C: tensor<64x64xf32>) -> tensor<64x64xf32> {
+  %D = linalg.matmul ins(%A, %B: tensor<64x64xf32>, tensor<64x64xf32>) outs(%C: tensor<64x64xf32>) -> tensor<64x64xf32>
+  return %D : tensor<64x64xf32>
+}
+
+func.func @add(%A: tensor<5xf32>, %B: tensor<5xf32>) -> tensor<5xf32> {
+  %C = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]} ins(%A : tensor<5xf32>) outs(%B : tensor<5xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %0 = arith.addf %a, %b : f32
+    linalg.yield %0 : f32
+  } -> tensor<5xf32>
+  return %C : tensor<5xf32>
+}
+
+func.func @caller(%A: tensor<5xf32>, %B: tensor<5xf32>) -> tensor<5xf32> {
+  %C = call @add(%A, %B) : (tensor<5xf32>, tensor<5xf32>) -> tensor<5xf32>
+  return %C : tensor<5xf32>
+}
+
+func.func @low() -> tensor<4xf32> {
+  %C = arith.constant dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>
+  return %C : tensor<4xf32>
+}
+
+func.func @high() -> tensor<4xf32> {
+  %C = arith.constant dense<[5.0, 6.0, 7.0, 8.0]> : tensor<4xf32>
+  return %C : tensor<4xf32>
+}
@@ -0,0 +1,36 @@
+// RUN: rm -rf %t
+// RUN: tpp-opt %s -default-tpp-passes="cache-dir=%t" | FileCheck %s
+// RUN: ls %t | FileCheck %s -check-prefix=ENTRY
+// Same output, read from the cache.
+// RUN: tpp-opt %s -default-tpp-passes="cache-dir=%t" | FileCheck %s
+// RUN: ls %t | FileCheck %s -check-prefix=ENTRY
+// A hit reads the entry: rename the function in it and look for the new name.
+// RUN: sed -i 's/"matmul"/"matmul_cached"/g' %t/*.mlir
+// RUN: tpp-opt %s -default-tpp-passes="cache-dir=%t" | FileCheck %s -check-prefix=HIT
+// The key does not depend on the printing options of the command line.
+// RUN: tpp-opt %s -default-tpp-passes="cache-dir=%t" --mlir-elide-elementsattrs-if-larger=1 | FileCheck %s -check-prefix=HIT
+// RUN: ls %t | FileCheck %s -check-prefix=ENTRY
+// Other options, other entry.
+// RUN: tpp-opt %s -default-tpp-passes="aggressive cache-dir=%t" | FileCheck %s -check-prefix=AGGR
+// RUN: ls %t | FileCheck %s -check-prefix=ENTRIES
+
+// ENTRY-COUNT-1: .mlir
+// ENTRY-NOT: .mlir
+
+// ENTRIES-COUNT-2: .mlir
+// ENTRIES-NOT: .mlir
+
+// CHECK-LABEL: func.func @matmul(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<64x64xf32>, %[[ARG1:.+]]: memref<64x64xf32>, %[[ARG2:.+]]: memref<64x64xf32>)
+// CHECK: call @xsmm_matmul_dispatch
+// CHECK: call @xsmm_matmul_invoke
+// HIT-LABEL: func.func @matmul_cached(
+// HIT: call @xsmm_matmul_invoke
+// AGGR-LABEL: func.func @matmul(
+// AGGR: call @xsmm_brgemm_dispatch
+// AGGR: call @xsmm_brgemm_invoke
+func.func @matmul(%A: tensor<64x64xf32>, %B: tensor<64x64xf32>,
+                  %C: tensor<64x64xf32>) -> tensor<64x64xf32> {
+  %D = linalg.matmul ins(%A, %B: tensor<64x64xf32>, tensor<64x64xf32>) outs(%C: tensor<64x64xf32>) -> tensor<64x64xf32>
+  return %D : tensor<64x64xf32>
+}
@@ -0,0 +1,30 @@
+// RUN: tpp-opt %s -default-tpp-passes -split-input-file | FileCheck %s
+// RUN: tpp-opt %s -default-tpp-passes="aggressive" -split-input-file | FileCheck %s -check-prefix=AGGR
+
+// CHECK-LABEL: func.func @matmul(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<64x64xf32>, %[[ARG1:.+]]: memref<64x64xf32>, %[[ARG2:.+]]: memref<64x64xf32>)
+// AGGR-LABEL: func.func @matmul(
+func.func @matmul(%A: tensor<64x64xf32>, %B: tensor<64x64xf32>,
+                  %C: tensor<64x64xf32>) -> tensor<64x64xf32> {
+  // CHECK: call @xsmm_matmul_dispatch
+  // CHECK: call @xsmm_matmul_invoke
+  // AGGR: call @xsmm_brgemm_dispatch
+  // AGGR: scf.for
+  // AGGR: call @xsmm_brgemm_invoke
+  // AGGR-NOT: call @xsmm_brgemm_dispatch
+  %D = linalg.matmul ins(%A, %B: tensor<64x64xf32>, tensor<64x64xf32>) outs(%C: tensor<64x64xf32>) -> tensor<64x64xf32>
+  return %D : tensor<64x64xf32>
+}
+
+// -----
+
+// Leftovers are vectorized instead of going to scalar loops.
+
+// CHECK-LABEL: func.func @fill(
+func.func @fill(%A: tensor<8x16xf32>) -> tensor<8x16xf32> {
+  // CHECK-NOT: linalg.fill
+  // CHECK: vector.transfer_write
+  %c0 = arith.constant 0.0 : f32
+  %0 = linalg.fill ins(%c0 : f32) outs(%A : tensor<8x16xf32>) -> tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
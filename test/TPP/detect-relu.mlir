@@ -146,3 +146,22 @@ module {
     return %7 : memref<1x512xf32>
   }
 }
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// Relu backward: propagate the gradient where the forward input was positive.
+// CHECK-LABEL: func.func @reluBackward
+func.func @reluBackward(%grad: tensor<32x64xf32>, %fwd: tensor<32x64xf32>) -> tensor<32x64xf32> {
+  %0 = tensor.empty() : tensor<32x64xf32>
+  // CHECK: library_call = "tpp.relu_backward"
+  %c0 = arith.constant 0.0 : f32
+  %1 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]} ins(%grad, %fwd : tensor<32x64xf32>, tensor<32x64xf32>) outs(%0 : tensor<32x64xf32>) {
+    ^bb0(%g: f32, %x: f32, %out: f32):
+      %2 = arith.cmpf ogt, %x, %c0 : f32
+      %3 = arith.select %2, %g, %c0 : f32
+      linalg.yield %3 : f32
+  } -> tensor<32x64xf32>
+  return %1 : tensor<32x64xf32>
+}
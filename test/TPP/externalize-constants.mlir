@@ -0,0 +1,40 @@
+// RUN: tpp-opt %s -externalize-constants="file=%t.bin threshold=64" | FileCheck %s
+
+// Nothing to move, the file isn't even opened
+// RUN: echo "untouched" > %t.keep
+// RUN: tpp-opt %s -externalize-constants="file=%t.keep threshold=1000000" > %t.out
+// RUN: FileCheck %s --input-file=%t.keep -check-prefix=KEEP
+
+// RUN: not tpp-opt %s -externalize-constants="file=%t.missing/side.bin threshold=64" 2>&1 | \
+// RUN: FileCheck %s -check-prefix=OPEN
+
+// KEEP: untouched
+// OPEN: error: cannot open '{{.*}}side.bin'
+
+// CHECK: module attributes {tpp.external_resources = {file = "/{{.*}}.bin", offsets = {tpp_external = 0 : i64, tpp_external_1 = 128 : i64}}}
+
+// CHECK: memref.global "private" constant @big_global : memref<4x8xf32> = dense_resource<tpp_external>
+memref.global "private" constant @big_global : memref<4x8xf32> = dense<[
+    [ 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 ],
+    [ 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 ],
+    [ 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 ],
+    [ 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 ]
+  ]>
+
+// CHECK-LABEL: func.func @constants
+func.func @constants() -> (tensor<4x8xf32>, tensor<2x2xf32>, tensor<4x8xf32>) {
+  // CHECK: arith.constant dense_resource<tpp_external_1> : tensor<4x8xf32>
+  %0 = arith.constant dense<[
+    [ 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 ],
+    [ 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 ],
+    [ 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 ],
+    [ 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 ]
+  ]> : tensor<4x8xf32>
+  // Too small
+  // CHECK: arith.constant dense<{{\[}}[1.000000e+00, 2.000000e+00]
+  %1 = arith.constant dense<[[1.0, 2.0], [3.0, 4.0]]> : tensor<2x2xf32>
+  // Splats are cheap
+  // CHECK: arith.constant dense<1.000000e+00> : tensor<4x8xf32>
+  %2 = arith.constant dense<1.0> : tensor<4x8xf32>
+  return %0, %1, %2 : tensor<4x8xf32>, tensor<2x2xf32>, tensor<4x8xf32>
+}
@@ -0,0 +1,57 @@
+// RUN: tpp-opt %s -hoist-xsmm-dispatch -split-input-file | FileCheck %s
+
+// CHECK-LABEL: func.func @matmul_relu(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<4x4xf32>, %[[ARG1:.+]]: memref<4x4xf32>, %[[ARG2:.+]]: memref<4x4xf32>)
+func.func @matmul_relu(%arg0: memref<4x4xf32>, %arg1: memref<4x4xf32>,
+                       %arg2: memref<4x4xf32>) {
+  // CHECK-NOT: xsmm.ternary.dispatch
+  // CHECK: %[[G0:.+]] = memref.get_global @__xsmm_dispatch_0 : memref<i64>
+  // CHECK: %[[MM:.+]] = memref.load %[[G0]][] : memref<i64>
+  // CHECK: xsmm.ternary matmul(dataType f32, %[[MM]], %[[ARG0]], %[[ARG1]], %[[ARG2]])
+  %0 = xsmm.ternary.dispatch matmul [4, 4, 4, 4, 4, 4](dataType f32)
+  xsmm.ternary matmul(dataType f32, %0, %arg0, %arg1, %arg2)
+    : (i64, memref<4x4xf32>, memref<4x4xf32>, memref<4x4xf32>) -> ()
+  // CHECK: %[[G1:.+]] = memref.get_global @__xsmm_dispatch_1 : memref<i64>
+  // CHECK: %[[RELU:.+]] = memref.load %[[G1]][] : memref<i64>
+  // CHECK: xsmm.unary relu(dataType f32, %[[RELU]], %[[ARG2]], %[[ARG2]])
+  %1 = xsmm.unary.dispatch relu [4, 4, 4, 4](broadcast none dataType f32)
+  xsmm.unary relu(dataType f32, %1, %arg2, %arg2)
+    : (i64, memref<4x4xf32>, memref<4x4xf32>) -> ()
+  return
+}
+
+// The same kernel in another function shares the global.
+// CHECK-LABEL: func.func @matmul(
+func.func @matmul(%arg0: memref<4x4xf32>, %arg1: memref<4x4xf32>,
+                  %arg2: memref<4x4xf32>) {
+  // CHECK: %[[G0:.+]] = memref.get_global @__xsmm_dispatch_0 : memref<i64>
+  // CHECK: %[[MM:.+]] = memref.load %[[G0]][] : memref<i64>
+  // CHECK: xsmm.ternary matmul(dataType f32, %[[MM]]
+  %0 = xsmm.ternary.dispatch matmul [4, 4, 4, 4, 4, 4](dataType f32)
+  xsmm.ternary matmul(dataType f32, %0, %arg0, %arg1, %arg2)
+    : (i64, memref<4x4xf32>, memref<4x4xf32>, memref<4x4xf32>) -> ()
+  return
+}
+
+// CHECK: memref.global "private" @__xsmm_dispatch_0 : memref<i64>
+// CHECK: memref.global "private" @__xsmm_dispatch_1 : memref<i64>
+// CHECK-NOT: memref.global
+// CHECK-LABEL: func.func @tpp_init()
+// CHECK-SAME:  attributes {llvm.emit_c_interface}
+// CHECK: %[[D0:.+]] = xsmm.ternary.dispatch matmul [4, 4, 4, 4, 4, 4](dataType f32)
+// CHECK: %[[I0:.+]] = memref.get_global @__xsmm_dispatch_0 : memref<i64>
+// CHECK: memref.store %[[D0]], %[[I0]][] : memref<i64>
+// CHECK: %[[D1:.+]] = xsmm.unary.dispatch relu [4, 4, 4, 4](broadcast none dataType f32)
+// CHECK: %[[I1:.+]] = memref.get_global @__xsmm_dispatch_1 : memref<i64>
+// CHECK: memref.store %[[D1]], %[[I1]][] : memref<i64>
+// CHECK-NOT: xsmm.ternary.dispatch
+// CHECK: return
+
+// -----
+
+// No dispatch, no initializer.
+// CHECK-LABEL: func.func @no_kernel(
+func.func @no_kernel(%arg0: memref<4x4xf32>) {
+  return
+}
+// CHECK-NOT: tpp_init
@@ -0,0 +1,94 @@
+// RUN: tpp-opt %s -huge-page-allocation="threshold=1024" -split-input-file | FileCheck %s
+
+// CHECK-LABEL: func.func @large(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<16x32xf32>, %[[ARG1:.+]]: memref<4x8xf32>)
+func.func @large(%arg0: memref<16x32xf32>, %arg1: memref<4x8xf32>) {
+  // CHECK: %[[SIZE:.+]] = arith.constant 2048 : i64
+  // CHECK: %[[BUF:.+]] = call @tpp_huge_alloc(%[[SIZE]]) : (i64) -> memref<?xi8>
+  // CHECK: %[[OFF:.+]] = arith.constant 0 : index
+  // CHECK: %[[VIEW:.+]] = memref.view %[[BUF]][%[[OFF]]][] : memref<?xi8> to memref<16x32xf32>
+  %large = memref.alloc() : memref<16x32xf32>
+  // Below the threshold
+  // CHECK: %[[SMALL:.+]] = memref.alloc() : memref<4x8xf32>
+  %small = memref.alloc() : memref<4x8xf32>
+  // CHECK: memref.copy %[[ARG0]], %[[VIEW]]
+  memref.copy %arg0, %large : memref<16x32xf32> to memref<16x32xf32>
+  // CHECK: memref.copy %[[ARG1]], %[[SMALL]]
+  memref.copy %arg1, %small : memref<4x8xf32> to memref<4x8xf32>
+  // CHECK: call @tpp_huge_free(%[[BUF]]) : (memref<?xi8>) -> ()
+  memref.dealloc %large : memref<16x32xf32>
+  // CHECK: memref.dealloc %[[SMALL]]
+  memref.dealloc %small : memref<4x8xf32>
+  return
+}
+
+// CHECK: func.func private @tpp_huge_alloc(i64) -> memref<?xi8> attributes {llvm.emit_c_interface}
+// CHECK: func.func private @tpp_huge_free(memref<?xi8>) attributes {llvm.emit_c_interface}
+
+// -----
+
+// The caller would free the returned buffer, it is not moved.
+// CHECK-LABEL: func.func @escaping(
+func.func @escaping(%arg0: memref<16x32xf32>) -> memref<16x32xf32> {
+  // CHECK-NOT: tpp_huge_alloc
+  // CHECK: %[[OUT:.+]] = memref.alloc() : memref<16x32xf32>
+  %out = memref.alloc() : memref<16x32xf32>
+  memref.copy %arg0, %out : memref<16x32xf32> to memref<16x32xf32>
+  // CHECK: return %[[OUT]]
+  return %out : memref<16x32xf32>
+}
+// CHECK-NOT: tpp_huge_alloc
+
+// -----
+
+func.func private @consume(memref<16x32xf32>)
+
+// The callee may keep the buffer, it is not moved.
+// CHECK-LABEL: func.func @passed_to_call(
+func.func @passed_to_call(%arg0: memref<16x32xf32>) {
+  // CHECK-NOT: tpp_huge_alloc
+  // CHECK: %[[BUF:.+]] = memref.alloc() : memref<16x32xf32>
+  %buf = memref.alloc() : memref<16x32xf32>
+  memref.copy %arg0, %buf : memref<16x32xf32> to memref<16x32xf32>
+  // CHECK: call @consume(%[[BUF]])
+  call @consume(%buf) : (memref<16x32xf32>) -> ()
+  // CHECK: memref.dealloc %[[BUF]]
+  memref.dealloc %buf : memref<16x32xf32>
+  return
+}
+// CHECK-NOT: tpp_huge_alloc
+
+// -----
+
+// Stored in memory, the buffer outlives the function.
+// CHECK-LABEL: func.func @stored(
+func.func @stored(%arg0: memref<memref<16x32xf32>>) {
+  // CHECK-NOT: tpp_huge_alloc
+  // CHECK: %[[BUF:.+]] = memref.alloc() : memref<16x32xf32>
+  %buf = memref.alloc() : memref<16x32xf32>
+  // CHECK: memref.store %[[BUF]]
+  memref.store %buf, %arg0[] : memref<memref<16x32xf32>>
+  return
+}
+// CHECK-NOT: tpp_huge_alloc
+
+// -----
+
+// A mapping per iteration would cost more than the TLB misses.
+// CHECK-LABEL: func.func @in_loop(
+func.func @in_loop(%arg0: memref<16x32xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  // CHECK: scf.for
+  scf.for %i = %c0 to %c4 step %c1 {
+    // CHECK-NOT: tpp_huge_alloc
+    // CHECK: %[[BUF:.+]] = memref.alloc() : memref<16x32xf32>
+    %buf = memref.alloc() : memref<16x32xf32>
+    memref.copy %arg0, %buf : memref<16x32xf32> to memref<16x32xf32>
+    // CHECK: memref.dealloc %[[BUF]]
+    memref.dealloc %buf : memref<16x32xf32>
+  }
+  return
+}
+// CHECK-NOT: tpp_huge_alloc
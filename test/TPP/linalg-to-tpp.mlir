@@ -14,6 +14,21 @@ func.func @brgemm_lowering(%arg0: memref<3x5x4xf32>, %arg1: memref<3x4x5xf32>,
 
 // -----
 
+// CHECK-LABEL: func.func @sparse_brgemm_lowering(
+// CHECK-SAME: %[[arg0:.*]]: memref<3x5x4xf32>,
+// CHECK-SAME: %[[arg1:.*]]: memref<?x4x5xf32>,
+// CHECK-SAME: %[[arg2:.*]]: memref<?xi64>,
+// CHECK-SAME: %[[arg3:.*]]: memref<5x5xf32>) {
+func.func @sparse_brgemm_lowering(%arg0: memref<3x5x4xf32>, %arg1: memref<?x4x5xf32>,
+                                  %arg2: memref<?xi64>, %arg3: memref<5x5xf32>) {
+  // CHECK: tpp.sparse_brgemm ins(%[[arg0]] : memref<3x5x4xf32>, %[[arg1]] : memref<?x4x5xf32>, %[[arg2]] : memref<?xi64>) out(%[[arg3]] : memref<5x5xf32>)
+  linalgx.sparse_brgemm ins(%arg0, %arg1, %arg2 : memref<3x5x4xf32>, memref<?x4x5xf32>, memref<?xi64>)
+                        outs(%arg3 : memref<5x5xf32>)
+  return
+}
+
+// -----
+
 #map5 = affine_map<(d0, d1, d2) -> (d0, d1, d2)>
 
 // CHECK-LABEL: func.func @relu(
@@ -0,0 +1,60 @@
+// RUN: tpp-opt %s -pack-matmul="block-factors=32,32,32" -split-input-file | FileCheck %s
+
+// Data gradient, dX = dY * W^T: B is read transposed.
+#map0 = affine_map<(i, j, k) -> (i, k)>
+#map1 = affine_map<(i, j, k) -> (j, k)>
+#map2 = affine_map<(i, j, k) -> (i, j)>
+
+func.func @matmul_transpose_b(%dy: tensor<64x128xf32>, %w: tensor<256x128xf32>,
+                              %dx: tensor<64x256xf32>) -> tensor<64x256xf32> {
+  %0 = linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction"]} ins(%dy, %w : tensor<64x128xf32>, tensor<256x128xf32>) outs(%dx : tensor<64x256xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %1 = arith.mulf %a, %b : f32
+      %2 = arith.addf %c, %1 : f32
+      linalg.yield %2 : f32
+  } -> tensor<64x256xf32>
+  return %0 : tensor<64x256xf32>
+}
+
+// CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d2, d3, d5)>
+// CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+// CHECK-DAG: #[[MAP2:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d3, d4)>
+// CHECK-LABEL: func.func @matmul_transpose_b(
+// CHECK-SAME: %[[DY:.+]]: tensor<64x128xf32>, %[[W:.+]]: tensor<256x128xf32>, %[[DX:.+]]: tensor<64x256xf32>)
+// CHECK: %[[PACK0:.+]] = linalgx.pack %[[DY]] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<64x128xf32> tensor<2x4x32x32xf32>) -> tensor<2x4x32x32xf32>
+// CHECK: %[[PACK1:.+]] = linalgx.pack %[[W]] inner_dims_pos = [1, 0] inner_tiles = [32, 32] into %{{.+}} : (tensor<256x128xf32> tensor<8x4x32x32xf32>) -> tensor<8x4x32x32xf32>
+// CHECK: %[[PACK2:.+]] = linalgx.pack %[[DX]] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<64x256xf32> tensor<2x8x32x32xf32>) -> tensor<2x8x32x32xf32>
+// CHECK: %[[GEN:.+]] = linalg.generic {indexing_maps = [#[[MAP0]], #[[MAP1]], #[[MAP2]]], iterator_types = ["parallel", "parallel", "reduction", "parallel", "parallel", "reduction"]} ins(%[[PACK0]], %[[PACK1]] : tensor<2x4x32x32xf32>, tensor<8x4x32x32xf32>) outs(%[[PACK2]] : tensor<2x8x32x32xf32>)
+// CHECK: %[[OUT:.+]] = linalgx.unpack %[[GEN]] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %[[DX]] : (tensor<2x8x32x32xf32> tensor<64x256xf32>) -> tensor<64x256xf32>
+// CHECK: return %[[OUT]]
+
+// -----
+
+// Weight gradient, dW = X^T * dY, reduced over the batch: A is read
+// transposed and dW is blocked like the weights.
+#map0 = affine_map<(i, j, k) -> (k, i)>
+#map1 = affine_map<(i, j, k) -> (k, j)>
+#map2 = affine_map<(i, j, k) -> (i, j)>
+
+func.func @matmul_transpose_a(%x: tensor<64x256xf32>, %dy: tensor<64x128xf32>,
+                              %dw: tensor<256x128xf32>) -> tensor<256x128xf32> {
+  %0 = linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction"]} ins(%x, %dy : tensor<64x256xf32>, tensor<64x128xf32>) outs(%dw : tensor<256x128xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %1 = arith.mulf %a, %b : f32
+      %2 = arith.addf %c, %1 : f32
+      linalg.yield %2 : f32
+  } -> tensor<256x128xf32>
+  return %0 : tensor<256x128xf32>
+}
+
+// CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d2, d3, d5)>
+// CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+// CHECK-DAG: #[[MAP2:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d0, d3, d4)>
+// CHECK-LABEL: func.func @matmul_transpose_a(
+// CHECK-SAME: %[[X:.+]]: tensor<64x256xf32>, %[[DY:.+]]: tensor<64x128xf32>, %[[DW:.+]]: tensor<256x128xf32>)
+// CHECK: %[[PACK0:.+]] = linalgx.pack %[[X]] outer_dims_perm = [1, 0] inner_dims_pos = [1, 0] inner_tiles = [32, 32] into %{{.+}} : (tensor<64x256xf32> tensor<8x2x32x32xf32>) -> tensor<8x2x32x32xf32>
+// CHECK: %[[PACK1:.+]] = linalgx.pack %[[DY]] outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<64x128xf32> tensor<4x2x32x32xf32>) -> tensor<4x2x32x32xf32>
+// CHECK: %[[PACK2:.+]] = linalgx.pack %[[DW]] outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<256x128xf32> tensor<4x8x32x32xf32>) -> tensor<4x8x32x32xf32>
+// CHECK: %[[GEN:.+]] = linalg.generic {indexing_maps = [#[[MAP0]], #[[MAP1]], #[[MAP2]]], iterator_types = ["parallel", "parallel", "reduction", "parallel", "parallel", "reduction"]} ins(%[[PACK0]], %[[PACK1]] : tensor<8x2x32x32xf32>, tensor<4x2x32x32xf32>) outs(%[[PACK2]] : tensor<4x8x32x32xf32>)
+// CHECK: %[[OUT:.+]] = linalgx.unpack %[[GEN]] outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %[[DW]] : (tensor<4x8x32x32xf32> tensor<256x128xf32>) -> tensor<256x128xf32>
+// CHECK: return %[[OUT]]
@@ -0,0 +1,164 @@
+// RUN: tpp-opt %s -partition-block-loops -split-input-file | FileCheck %s
+// RUN: tpp-opt %s -partition-block-loops="min-fill-bytes=128" -split-input-file | FileCheck %s -check-prefix=SMALL
+
+// Each iteration writes its own block of %out.
+// CHECK-LABEL: func.func @owned_blocks(
+func.func @owned_blocks(%in: memref<4x8x32xf32>, %out: memref<4x8x32xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  // CHECK: scf.parallel (%[[I:.+]]) = (%{{.+}}) to (%{{.+}}) step (%{{.+}}) {
+  // CHECK:   %[[SRC:.+]] = memref.subview %{{.+}}[%[[I]], 0, 0] [1, 8, 32] [1, 1, 1]
+  // CHECK:   %[[DST:.+]] = memref.subview %{{.+}}[%[[I]], 0, 0] [1, 8, 32] [1, 1, 1]
+  // CHECK:   memref.copy %[[SRC]], %[[DST]]
+  // CHECK-NOT: scf.for
+  scf.for %i = %c0 to %c4 step %c1 {
+    %src = memref.subview %in[%i, 0, 0] [1, 8, 32] [1, 1, 1] : memref<4x8x32xf32> to memref<8x32xf32, strided<[32, 1], offset: ?>>
+    %dst = memref.subview %out[%i, 0, 0] [1, 8, 32] [1, 1, 1] : memref<4x8x32xf32> to memref<8x32xf32, strided<[32, 1], offset: ?>>
+    memref.copy %src, %dst : memref<8x32xf32, strided<[32, 1], offset: ?>> to memref<8x32xf32, strided<[32, 1], offset: ?>>
+  }
+  return
+}
+
+// -----
+
+// Iteration %i reads the block that iteration %i + 1 writes.
+// CHECK-LABEL: func.func @shifted_blocks(
+func.func @shifted_blocks(%buf: memref<5x8x32xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  // CHECK-NOT: scf.parallel
+  // CHECK: scf.for
+  scf.for %i = %c0 to %c4 step %c1 {
+    %next = arith.addi %i, %c1 : index
+    %src = memref.subview %buf[%next, 0, 0] [1, 8, 32] [1, 1, 1] : memref<5x8x32xf32> to memref<8x32xf32, strided<[32, 1], offset: ?>>
+    %dst = memref.subview %buf[%i, 0, 0] [1, 8, 32] [1, 1, 1] : memref<5x8x32xf32> to memref<8x32xf32, strided<[32, 1], offset: ?>>
+    memref.copy %src, %dst : memref<8x32xf32, strided<[32, 1], offset: ?>> to memref<8x32xf32, strided<[32, 1], offset: ?>>
+  }
+  return
+}
+
+// -----
+
+// Scalar packing loops store into the slice of the outermost index.
+// CHECK-LABEL: func.func @scalar_stores(
+func.func @scalar_stores(%in: memref<4x32xf32>, %out: memref<4x32xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c32 = arith.constant 32 : index
+  // CHECK: scf.parallel (%[[I:.+]]) =
+  // CHECK:   scf.for %[[J:.+]] =
+  // CHECK:     memref.store %{{.+}}, %{{.+}}[%[[I]], %[[J]]]
+  scf.for %i = %c0 to %c4 step %c1 {
+    scf.for %j = %c0 to %c32 step %c1 {
+      %v = memref.load %in[%j, %i] : memref<4x32xf32>
+      memref.store %v, %out[%i, %j] : memref<4x32xf32>
+    }
+  }
+  return
+}
+
+// -----
+
+// Only the outermost dimension stays parallel.
+// CHECK-LABEL: func.func @parallel_2d(
+func.func @parallel_2d(%buf: memref<4x8x32xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c8 = arith.constant 8 : index
+  %zero = arith.constant 0.0 : f32
+  // CHECK: scf.parallel (%[[I:.+]]) = (%{{.+}}) to (%{{.+}}) step (%{{.+}}) {
+  // CHECK:   scf.for %[[J:.+]] =
+  // CHECK:     memref.subview %{{.+}}[%[[I]], %[[J]], 0]
+  scf.parallel (%i, %j) = (%c0, %c0) to (%c4, %c8) step (%c1, %c1) {
+    %row = memref.subview %buf[%i, %j, 0] [1, 1, 32] [1, 1, 1] : memref<4x8x32xf32> to memref<32xf32, strided<[1], offset: ?>>
+    linalg.fill ins(%zero : f32) outs(%row : memref<32xf32, strided<[1], offset: ?>>)
+    scf.yield
+  }
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @fill(
+func.func @fill(%buf: memref<4x8x32x32xf32>) {
+  %zero = arith.constant 0.0 : f32
+  // CHECK: scf.parallel (%[[I:.+]]) =
+  // CHECK:   %[[SLICE:.+]] = memref.subview %{{.+}}[%[[I]], 0, 0, 0] [1, 8, 32, 32] [1, 1, 1, 1]
+  // CHECK:   linalg.fill ins(%{{.+}} : f32) outs(%[[SLICE]]
+  linalg.fill ins(%zero : f32) outs(%buf : memref<4x8x32x32xf32>)
+  return
+}
+
+// -----
+
+// Below the default size, a fill is not worth the threads.
+// CHECK-LABEL: func.func @small_fill(
+// SMALL-LABEL: func.func @small_fill(
+func.func @small_fill(%buf: memref<4x8xf32>) {
+  %zero = arith.constant 0.0 : f32
+  // CHECK-NOT: scf.parallel
+  // CHECK: linalg.fill ins(%{{.+}} : f32) outs(%{{.+}} : memref<4x8xf32>)
+  // SMALL: scf.parallel
+  linalg.fill ins(%zero : f32) outs(%buf : memref<4x8xf32>)
+  return
+}
+
+// -----
+
+// Each iteration reads and writes a vector in its own row.
+// CHECK-LABEL: func.func @owned_transfers(
+func.func @owned_transfers(%in: memref<4x8xf32>, %out: memref<4x8xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %pad = arith.constant 0.0 : f32
+  // CHECK: scf.parallel
+  scf.for %i = %c0 to %c4 step %c1 {
+    %v = vector.transfer_read %in[%i, %c0], %pad : memref<4x8xf32>, vector<8xf32>
+    vector.transfer_write %v, %out[%i, %c0] : vector<8xf32>, memref<4x8xf32>
+  }
+  return
+}
+
+// -----
+
+#col = affine_map<(d0, d1) -> (d0)>
+
+// The vectors span the outermost dimension: iteration %i writes rows %i to
+// %i + 3.
+// CHECK-LABEL: func.func @transfers_across_rows(
+func.func @transfers_across_rows(%in: memref<8x8xf32>, %out: memref<8x8xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %pad = arith.constant 0.0 : f32
+  // CHECK-NOT: scf.parallel
+  // CHECK: scf.for
+  scf.for %i = %c0 to %c4 step %c1 {
+    %v = vector.transfer_read %in[%i, %c0], %pad {permutation_map = #col} : memref<8x8xf32>, vector<4xf32>
+    vector.transfer_write %v, %out[%i, %c0] {permutation_map = #col} : vector<4xf32>, memref<8x8xf32>
+  }
+  return
+}
+
+// -----
+
+// A rank-0 buffer is shared by all the iterations.
+// CHECK-LABEL: func.func @rank0_transfer(
+func.func @rank0_transfer(%in: memref<4xf32>, %acc: memref<f32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %pad = arith.constant 0.0 : f32
+  // CHECK-NOT: scf.parallel
+  // CHECK: scf.for
+  scf.for %i = %c0 to %c4 step %c1 {
+    %v = vector.transfer_read %in[%i], %pad : memref<4xf32>, vector<f32>
+    vector.transfer_write %v, %acc[] : vector<f32>, memref<f32>
+  }
+  return
+}
@@ -0,0 +1,123 @@
+// RUN: tpp-opt %s -rewrite-to-brgemm -split-input-file | FileCheck %s
+
+#map0 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d2, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d3, d4)>
+
+// Half of the weight blocks are zero: only the others are multiplied.
+// CHECK-LABEL: func.func @sparse_blocked_matmul(
+// CHECK-SAME: %[[ARG0:.+]]: tensor<2x2x2x2xf32>, %[[ARG1:.+]]: tensor<2x2x2x2xf32>)
+func.func @sparse_blocked_matmul(%arg0: tensor<2x2x2x2xf32>, %arg1: tensor<2x2x2x2xf32>) -> tensor<2x2x2x2xf32> {
+  // CHECK-DAG: %[[PTR:.+]] = arith.constant dense<[0, 1, 2]> : tensor<3xi64>
+  // CHECK-DAG: %[[IDX:.+]] = arith.constant dense<[0, 1]> : tensor<2xi64>
+  // CHECK-DAG: %[[BLOCKS:.+]] = arith.constant dense<{{\[\[\[}}1.000000e+00, 2.000000e+00], [3.000000e+00, 4.000000e+00]], {{\[\[}}5.000000e+00, 6.000000e+00], [7.000000e+00, 8.000000e+00]]]> : tensor<2x2x2xf32>
+  // CHECK: %[[OUTER:.+]] = scf.for %[[I:.+]] = %{{.+}} to %{{.+}} step %{{.+}} iter_args(%[[INIT:.+]] = %[[ARG1]]) -> (tensor<2x2x2x2xf32>) {
+  // CHECK: %[[INNER:.+]] = scf.for %[[J:.+]] = %{{.+}} to %{{.+}} step %{{.+}} iter_args(%[[INIT2:.+]] = %[[INIT]]) -> (tensor<2x2x2x2xf32>) {
+  // CHECK: %[[SLICEA:.+]] = tensor.extract_slice %[[ARG0]][%[[I]], 0, 0, 0] [1, 2, 2, 2] [1, 1, 1, 1] : tensor<2x2x2x2xf32> to tensor<2x2x2xf32>
+  // CHECK: %[[SLICEC:.+]] = tensor.extract_slice %[[INIT2]][%[[I]], %[[J]], 0, 0] [1, 1, 2, 2] [1, 1, 1, 1] : tensor<2x2x2x2xf32> to tensor<2x2xf32>
+  // CHECK: %[[NEXT:.+]] = arith.addi %[[J]], %{{.+}} : index
+  // CHECK: %[[PTR0:.+]] = tensor.extract %[[PTR]][%[[J]]] : tensor<3xi64>
+  // CHECK: %[[START:.+]] = arith.index_cast %[[PTR0]] : i64 to index
+  // CHECK: %[[PTR1:.+]] = tensor.extract %[[PTR]][%[[NEXT]]] : tensor<3xi64>
+  // CHECK: %[[END:.+]] = arith.index_cast %[[PTR1]] : i64 to index
+  // CHECK: %[[COUNT:.+]] = arith.subi %[[END]], %[[START]] : index
+  // CHECK: %[[SLICEB:.+]] = tensor.extract_slice %[[BLOCKS]][%[[START]], 0, 0] [%[[COUNT]], 2, 2] [1, 1, 1] : tensor<2x2x2xf32> to tensor<?x2x2xf32>
+  // CHECK: %[[SLICEIDX:.+]] = tensor.extract_slice %[[IDX]][%[[START]]] [%[[COUNT]]] [1] : tensor<2xi64> to tensor<?xi64>
+  // CHECK: %[[MUL:.+]] = linalgx.sparse_brgemm ins(%[[SLICEA]], %[[SLICEB]], %[[SLICEIDX]] : tensor<2x2x2xf32>, tensor<?x2x2xf32>, tensor<?xi64>) outs(%[[SLICEC]] : tensor<2x2xf32>) -> tensor<2x2xf32>
+  // CHECK: %[[YIELD:.+]] = tensor.insert_slice %[[MUL]] into %[[INIT2]][%[[I]], %[[J]], 0, 0] [1, 1, 2, 2] [1, 1, 1, 1] : tensor<2x2xf32> into tensor<2x2x2x2xf32>
+  // CHECK: scf.yield %[[YIELD]] : tensor<2x2x2x2xf32>
+  // CHECK: scf.yield %[[INNER]] : tensor<2x2x2x2xf32>
+  // CHECK: return %[[OUTER]] : tensor<2x2x2x2xf32>
+  %cst = arith.constant dense<[[[[1.0, 2.0], [3.0, 4.0]], [[0.0, 0.0], [0.0, 0.0]]],
+                               [[[0.0, 0.0], [0.0, 0.0]], [[5.0, 6.0], [7.0, 8.0]]]]> : tensor<2x2x2x2xf32>
+  %0 = linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction", "parallel", "parallel", "reduction"]} ins(%arg0, %cst : tensor<2x2x2x2xf32>, tensor<2x2x2x2xf32>) outs(%arg1 : tensor<2x2x2x2xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %1 = arith.mulf %a, %b : f32
+      %2 = arith.addf %c, %1 : f32
+      linalg.yield %2 : f32
+  } -> tensor<2x2x2x2xf32>
+  return %0 : tensor<2x2x2x2xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d2, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d3, d4)>
+
+// The weights are packed from a KC constant, only block (k = 0, n = 1) is
+// non-zero.
+// CHECK-LABEL: func.func @sparse_packed_weights(
+func.func @sparse_packed_weights(%arg0: tensor<2x2x2x2xf32>, %arg1: tensor<2x2x2x2xf32>) -> tensor<2x2x2x2xf32> {
+  // CHECK-DAG: %[[PTR:.+]] = arith.constant dense<[0, 0, 1]> : tensor<3xi64>
+  // CHECK-DAG: %[[IDX:.+]] = arith.constant dense<0> : tensor<1xi64>
+  // CHECK-DAG: %[[BLOCKS:.+]] = arith.constant dense<{{\[\[\[}}1.000000e+00, 2.000000e+00], [3.000000e+00, 4.000000e+00]]]> : tensor<1x2x2xf32>
+  // CHECK-NOT: linalgx.pack
+  // CHECK: linalgx.sparse_brgemm
+  %cst = arith.constant dense<[[0.0, 0.0, 1.0, 2.0],
+                               [0.0, 0.0, 3.0, 4.0],
+                               [0.0, 0.0, 0.0, 0.0],
+                               [0.0, 0.0, 0.0, 0.0]]> : tensor<4x4xf32>
+  %empty = tensor.empty() : tensor<2x2x2x2xf32>
+  %packed = linalgx.pack %cst outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [2, 2] into %empty : (tensor<4x4xf32> tensor<2x2x2x2xf32>) -> tensor<2x2x2x2xf32>
+  %0 = linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction", "parallel", "parallel", "reduction"]} ins(%arg0, %packed : tensor<2x2x2x2xf32>, tensor<2x2x2x2xf32>) outs(%arg1 : tensor<2x2x2x2xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %1 = arith.mulf %a, %b : f32
+      %2 = arith.addf %c, %1 : f32
+      linalg.yield %2 : f32
+  } -> tensor<2x2x2x2xf32>
+  return %0 : tensor<2x2x2x2xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d2, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d3, d4)>
+
+// A single zero block is not worth the indirection: dense BRGEMM.
+// CHECK-LABEL: func.func @dense_blocked_matmul(
+func.func @dense_blocked_matmul(%arg0: tensor<2x2x2x2xf32>, %arg1: tensor<2x2x2x2xf32>) -> tensor<2x2x2x2xf32> {
+  // CHECK-NOT: linalgx.sparse_brgemm
+  // CHECK: linalg.batch_reduce_matmul
+  %cst = arith.constant dense<[[[[1.0, 2.0], [3.0, 4.0]], [[0.0, 0.0], [0.0, 0.0]]],
+                               [[[1.0, 0.0], [0.0, 0.0]], [[5.0, 6.0], [7.0, 8.0]]]]> : tensor<2x2x2x2xf32>
+  %0 = linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction", "parallel", "parallel", "reduction"]} ins(%arg0, %cst : tensor<2x2x2x2xf32>, tensor<2x2x2x2xf32>) outs(%arg1 : tensor<2x2x2x2xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %1 = arith.mulf %a, %b : f32
+      %2 = arith.addf %c, %1 : f32
+      linalg.yield %2 : f32
+  } -> tensor<2x2x2x2xf32>
+  return %0 : tensor<2x2x2x2xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d2, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d3, d4)>
+
+// The weights of @sparse_blocked_matmul, in a dense resource.
+// CHECK-LABEL: func.func @sparse_resource_weights(
+func.func @sparse_resource_weights(%arg0: tensor<2x2x2x2xf32>, %arg1: tensor<2x2x2x2xf32>) -> tensor<2x2x2x2xf32> {
+  // CHECK-DAG: %[[PTR:.+]] = arith.constant dense<[0, 1, 2]> : tensor<3xi64>
+  // CHECK-DAG: %[[IDX:.+]] = arith.constant dense<[0, 1]> : tensor<2xi64>
+  // CHECK-DAG: %[[BLOCKS:.+]] = arith.constant dense<{{\[\[\[}}1.000000e+00, 2.000000e+00], [3.000000e+00, 4.000000e+00]], {{\[\[}}5.000000e+00, 6.000000e+00], [7.000000e+00, 8.000000e+00]]]> : tensor<2x2x2xf32>
+  // CHECK: linalgx.sparse_brgemm
+  %cst = arith.constant dense_resource<sparse_weights> : tensor<2x2x2x2xf32>
+  %0 = linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction", "parallel", "parallel", "reduction"]} ins(%arg0, %cst : tensor<2x2x2x2xf32>, tensor<2x2x2x2xf32>) outs(%arg1 : tensor<2x2x2x2xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %1 = arith.mulf %a, %b : f32
+      %2 = arith.addf %c, %1 : f32
+      linalg.yield %2 : f32
+  } -> tensor<2x2x2x2xf32>
+  return %0 : tensor<2x2x2x2xf32>
+}
+
+{-#
+  dialect_resources: {
+    builtin: {
+      sparse_weights: "0x040000000000803F00000040000040400000804000000000000000000000000000000000000000000000000000000000000000000000A0400000C0400000E04000000041"
+    }
+  }
+#-}
@@ -0,0 +1,17 @@
+// RUN: tpp-opt %s -specialize-shapes="entry=entry shapes=arg0:4x8,arg1:8x16,arg2:4x16" | FileCheck %s
+
+// CHECK-LABEL: func.func @entry(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<4x8xf32>, %[[ARG1:.+]]: tensor<8x16xf32>, %[[ARG2:.+]]: tensor<4x16xf32>) -> tensor<4x16xf32>
+func.func @entry(%A: tensor<?x8xf32>, %B: tensor<8x?xf32>, %C: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  // CHECK: %[[D:.+]] = linalg.matmul ins(%[[ARG0]], %[[ARG1]] : tensor<4x8xf32>, tensor<8x16xf32>) outs(%[[ARG2]] : tensor<4x16xf32>) -> tensor<4x16xf32>
+  %D = linalg.matmul ins(%A, %B : tensor<?x8xf32>, tensor<8x?xf32>) outs(%C : tensor<?x?xf32>) -> tensor<?x?xf32>
+  // CHECK: return %[[D]] : tensor<4x16xf32>
+  return %D : tensor<?x?xf32>
+}
+
+// Only the entry is specialized
+// CHECK-LABEL: func.func @other(
+// CHECK-SAME:  %{{.+}}: memref<?x?xf32>)
+func.func @other(%A: memref<?x?xf32>) {
+  return
+}
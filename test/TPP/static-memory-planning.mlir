@@ -0,0 +1,138 @@
+// RUN: tpp-opt %s -static-memory-planning -split-input-file | FileCheck %s
+
+// %a and %c are never live at the same time, they share the same offset.
+// The arena is keyed by the address of a private global.
+// CHECK: memref.global "private" @__tpp_arena_overlapping : memref<i64> = dense<0>
+// CHECK-LABEL: func.func @overlapping(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<4x8xf32>, %[[ARG1:.+]]: memref<4x8xf32>)
+func.func @overlapping(%arg0: memref<4x8xf32>, %arg1: memref<4x8xf32>) {
+  // CHECK: %[[KEY:.+]] = memref.get_global @__tpp_arena_overlapping : memref<i64>
+  // CHECK: %[[SIZE:.+]] = arith.constant 256 : i64
+  // CHECK: %[[ARENA:.+]] = call @tpp_arena_get(%[[KEY]], %[[SIZE]]) : (memref<i64>, i64) -> memref<?xi8>
+  // CHECK: %[[OFF_A:.+]] = arith.constant 0 : index
+  // CHECK: %[[A:.+]] = memref.view %[[ARENA]][%[[OFF_A]]][] : memref<?xi8> to memref<4x8xf32>
+  %a = memref.alloc() : memref<4x8xf32>
+  // CHECK: %[[OFF_B:.+]] = arith.constant 128 : index
+  // CHECK: %[[B:.+]] = memref.view %[[ARENA]][%[[OFF_B]]][] : memref<?xi8> to memref<4x8xf32>
+  %b = memref.alloc() : memref<4x8xf32>
+  // CHECK: memref.copy %[[ARG0]], %[[A]]
+  memref.copy %arg0, %a : memref<4x8xf32> to memref<4x8xf32>
+  // CHECK: memref.copy %[[A]], %[[B]]
+  memref.copy %a, %b : memref<4x8xf32> to memref<4x8xf32>
+  memref.dealloc %a : memref<4x8xf32>
+  // CHECK: %[[OFF_C:.+]] = arith.constant 0 : index
+  // CHECK: %[[C:.+]] = memref.view %[[ARENA]][%[[OFF_C]]][] : memref<?xi8> to memref<4x8xf32>
+  %c = memref.alloc() : memref<4x8xf32>
+  // CHECK: memref.copy %[[B]], %[[C]]
+  memref.copy %b, %c : memref<4x8xf32> to memref<4x8xf32>
+  memref.dealloc %b : memref<4x8xf32>
+  // CHECK: memref.copy %[[C]], %[[ARG1]]
+  memref.copy %c, %arg1 : memref<4x8xf32> to memref<4x8xf32>
+  memref.dealloc %c : memref<4x8xf32>
+  // CHECK-NOT: memref.alloc
+  // CHECK-NOT: memref.dealloc
+  // CHECK: return
+  return
+}
+
+// CHECK: func.func private @tpp_arena_get(memref<i64>, i64) -> memref<?xi8> attributes {llvm.emit_c_interface}
+
+// -----
+
+// The returned buffer escapes, it is not planned.
+// CHECK-LABEL: func.func @escaping(
+func.func @escaping(%arg0: memref<4x8xf32>) -> memref<4x8xf32> {
+  // CHECK: %[[SIZE:.+]] = arith.constant 128 : i64
+  // CHECK: %[[ARENA:.+]] = call @tpp_arena_get(%{{.+}}, %[[SIZE]])
+  // CHECK: memref.view %[[ARENA]]
+  %tmp = memref.alloc() : memref<4x8xf32>
+  // CHECK: %[[OUT:.+]] = memref.alloc() : memref<4x8xf32>
+  %out = memref.alloc() : memref<4x8xf32>
+  memref.copy %arg0, %tmp : memref<4x8xf32> to memref<4x8xf32>
+  memref.copy %tmp, %out : memref<4x8xf32> to memref<4x8xf32>
+  memref.dealloc %tmp : memref<4x8xf32>
+  // CHECK: return %[[OUT]]
+  return %out : memref<4x8xf32>
+}
+
+// -----
+
+// Dynamically shaped buffers are not planned.
+// CHECK-LABEL: func.func @dynamic(
+func.func @dynamic(%arg0: memref<?x8xf32>, %dim: index) {
+  // CHECK-NOT: tpp_arena_get
+  // CHECK: memref.alloc(%{{.+}}) : memref<?x8xf32>
+  %tmp = memref.alloc(%dim) : memref<?x8xf32>
+  memref.copy %arg0, %tmp : memref<?x8xf32> to memref<?x8xf32>
+  memref.dealloc %tmp : memref<?x8xf32>
+  return
+}
+// CHECK-NOT: tpp_arena_get
+
+// -----
+
+// Buffers passed to a call or stored escape as well, the callee or whoever
+// loads them could keep them.
+// CHECK-LABEL: func.func @escaping_call_store(
+func.func @escaping_call_store(%arg0: memref<4x8xf32>,
+                               %slot: memref<memref<4x8xf32>>) {
+  // CHECK-NOT: tpp_arena_get
+  // CHECK: %[[PASSED:.+]] = memref.alloc() : memref<4x8xf32>
+  // CHECK: %[[STORED:.+]] = memref.alloc() : memref<4x8xf32>
+  %passed = memref.alloc() : memref<4x8xf32>
+  %stored = memref.alloc() : memref<4x8xf32>
+  // CHECK: call @consume(%[[PASSED]])
+  call @consume(%passed) : (memref<4x8xf32>) -> ()
+  // CHECK: memref.store %[[STORED]]
+  memref.store %stored, %slot[] : memref<memref<4x8xf32>>
+  memref.dealloc %passed : memref<4x8xf32>
+  return
+}
+func.func private @consume(memref<4x8xf32>)
+
+// -----
+
+// Functions of the same name in different modules have their own arenas, so
+// the key is the global, not the name: two functions get two globals.
+// CHECK-DAG: memref.global "private" @__tpp_arena_first : memref<i64>
+// CHECK-DAG: memref.global "private" @__tpp_arena_second : memref<i64>
+// CHECK-LABEL: func.func @first(
+func.func @first(%arg0: memref<4x8xf32>) {
+  // CHECK: memref.get_global @__tpp_arena_first
+  %tmp = memref.alloc() : memref<4x8xf32>
+  memref.copy %arg0, %tmp : memref<4x8xf32> to memref<4x8xf32>
+  memref.dealloc %tmp : memref<4x8xf32>
+  return
+}
+// CHECK-LABEL: func.func @second(
+func.func @second(%arg0: memref<4x8xf32>) {
+  // CHECK: memref.get_global @__tpp_arena_second
+  %tmp = memref.alloc() : memref<4x8xf32>
+  memref.copy %arg0, %tmp : memref<4x8xf32> to memref<4x8xf32>
+  memref.dealloc %tmp : memref<4x8xf32>
+  return
+}
+
+// -----
+
+// A recursive call would reuse the arena of the call still running, the
+// buffers of recursive functions are not planned.
+// CHECK-LABEL: func.func @recursive(
+func.func @recursive(%arg0: memref<4x8xf32>, %n: index) {
+  // CHECK-NOT: tpp_arena_get
+  // CHECK: memref.alloc() : memref<4x8xf32>
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %tmp = memref.alloc() : memref<4x8xf32>
+  memref.copy %arg0, %tmp : memref<4x8xf32> to memref<4x8xf32>
+  %done = arith.cmpi eq, %n, %c0 : index
+  scf.if %done {
+  } else {
+    %m = arith.subi %n, %c1 : index
+    func.call @recursive(%arg0, %m) : (memref<4x8xf32>, index) -> ()
+  }
+  memref.copy %tmp, %arg0 : memref<4x8xf32> to memref<4x8xf32>
+  memref.dealloc %tmp : memref<4x8xf32>
+  return
+}
+// CHECK-NOT: tpp_arena_get
@@ -90,3 +90,96 @@ func.func @tpp_matmul_invalid(%arg0: memref<3x2xf32>, %arg1: memref<2x3xf32>,
   tpp.matmul ins(%arg0: memref<3x2xf32>, %arg1: memref<2x3xf32>) out(%arg2: memref<3x3xbf16>)
   return %arg2: memref<3x3xbf16>
 }
+
+// -----
+
+func.func @tpp_sgd_update_invalid(%grad: memref<4x32xf32>, %lr: f32,
+                                  %param: memref<4x32xf32>,
+                                  %velocity: memref<8x32xf32>) {
+  // expected-error @below {{'tpp.sgd_update' op fails to verify operands dimensions mismatch}}
+  tpp.sgd_update ins(%grad: memref<4x32xf32>, %lr: f32)
+                 out(%param: memref<4x32xf32>, %velocity: memref<8x32xf32>)
+                 {momentum = 0.9 : f32, weight_decay = 0.0 : f32}
+  return
+}
+
+// -----
+
+func.func @tpp_dropout_invalid(%input: memref<4x30xf32>, %seed: i64,
+                               %output: memref<4x30xf32>,
+                               %mask: memref<16xi8>) {
+  // expected-error @below {{'tpp.dropout' op expects a mask of 15 bytes}}
+  tpp.dropout ins(%input: memref<4x30xf32>, %seed: i64)
+              out(%output: memref<4x30xf32>, %mask: memref<16xi8>)
+              {probability = 0.1 : f32}
+  return
+}
+
+// -----
+
+func.func @tpp_dropout_invalid(%input: memref<4x32xf32>, %seed: i64,
+                               %output: memref<4x32xf32>,
+                               %mask: memref<16xi8>) {
+  // expected-error @below {{'tpp.dropout' op expects a probability in [0, 1)}}
+  tpp.dropout ins(%input: memref<4x32xf32>, %seed: i64)
+              out(%output: memref<4x32xf32>, %mask: memref<16xi8>)
+              {probability = 1.0 : f32}
+  return
+}
+
+// -----
+
+func.func @tpp_quantized_matmul_invalid(%a: memref<4x16xi8>,
+                                        %b: memref<8x8x2xi8>,
+                                        %c: memref<4x8xi32>) {
+  // expected-error @below {{'tpp.quantized_matmul' op expects matrix B in VNNI4 format}}
+  tpp.quantized_matmul ins(%a: memref<4x16xi8>, %b: memref<8x8x2xi8>)
+                       out(%c: memref<4x8xi32>)
+  return
+}
+
+// -----
+
+func.func @tpp_quantized_brgemm_invalid(%a: memref<2x4x16xi8>,
+                                        %b: memref<2x2x8x4xi8>,
+                                        %c: memref<4x8xi32>) {
+  // expected-error @below {{'tpp.quantized_brgemm' op fails to verify operands dimensions mismatch}}
+  tpp.quantized_brgemm ins(%a: memref<2x4x16xi8>, %b: memref<2x2x8x4xi8>)
+                       out(%c: memref<4x8xi32>)
+  return
+}
+
+// -----
+
+func.func @tpp_requantize_invalid(%acc: memref<4x8xi32>,
+                                  %out: memref<4x8xi8>) {
+  // expected-error @below {{'tpp.requantize' op expects min <= max within [-128, 127] or [0, 255]}}
+  tpp.requantize ins(%acc: memref<4x8xi32>) out(%out: memref<4x8xi8>)
+                 {scale = 0.5 : f32, zero_point = 0 : i32,
+                  min = -128 : i32, max = 256 : i32}
+  return
+}
+
+// -----
+
+func.func @tpp_requantize_mixed_range(%acc: memref<4x8xi32>,
+                                      %out: memref<4x8xi8>) {
+  // expected-error @below {{'tpp.requantize' op expects min <= max within [-128, 127] or [0, 255]}}
+  tpp.requantize ins(%acc: memref<4x8xi32>) out(%out: memref<4x8xi8>)
+                 {scale = 0.5 : f32, zero_point = 0 : i32,
+                  min = -128 : i32, max = 255 : i32}
+  return
+}
+
+// -----
+
+func.func @tpp_sparse_brgemm_invalid(%a: memref<4x8x16xf32>,
+                                     %b: memref<2x16x32xf32>,
+                                     %idx: memref<3xi64>,
+                                     %c: memref<8x32xf32>) {
+  // expected-error @below {{'tpp.sparse_brgemm' op expects one index per block of matrix B}}
+  tpp.sparse_brgemm ins(%a: memref<4x8x16xf32>, %b: memref<2x16x32xf32>,
+                        %idx: memref<3xi64>)
+                    out(%c: memref<8x32xf32>)
+  return
+}
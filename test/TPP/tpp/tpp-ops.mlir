@@ -19,6 +19,10 @@ func.func @myfunc(%arg0: memref<2x2xf32>,
   // CHECK: tpp.relu
   tpp.relu out(%arg3: f32)
 
+  // CHECK: tpp.relu_backward
+  tpp.relu_backward ins(%arg0: memref<2x2xf32>, %arg1: memref<2x2xf32>)
+                    out(%arg2: memref<2x2xf32>)
+
   // CHECK: tpp.matmul
   tpp.matmul ins(%arg0: memref<2x2xf32>, %arg1: memref<2x2xf32>)
              out(%arg2: memref<2x2xf32>) 
@@ -64,3 +68,70 @@ func.func @testBrgemmWithBf16(%arg0: memref<32x4x4x2xbf16>, %arg1: memref<64x4x4
   tpp.vnni_brgemm ins(%arg0: memref<32x4x4x2xbf16>, %arg1: memref<64x4x4xbf16>) out(%arg2: memref<4x4xbf16>)
   return %arg2: memref<4x4xbf16>
 }
+
+// CHECK-LABEL: func.func @optimizerUpdates
+func.func @optimizerUpdates(%grad: memref<4x8x32x32xf32>, %lr: f32, %step: f32,
+                            %param: memref<4x8x32x32xf32>,
+                            %m: memref<4x8x32x32xf32>,
+                            %v: memref<4x8x32x32xf32>) {
+  // CHECK: tpp.sgd_update
+  tpp.sgd_update ins(%grad: memref<4x8x32x32xf32>, %lr: f32)
+                 out(%param: memref<4x8x32x32xf32>, %m: memref<4x8x32x32xf32>)
+                 {momentum = 0.9 : f32, weight_decay = 0.0 : f32}
+
+  // CHECK: tpp.adam_update
+  tpp.adam_update ins(%grad: memref<4x8x32x32xf32>, %lr: f32, %step: f32)
+                  out(%param: memref<4x8x32x32xf32>, %m: memref<4x8x32x32xf32>,
+                      %v: memref<4x8x32x32xf32>)
+                  {beta1 = 0.9 : f32, beta2 = 0.999 : f32,
+                   epsilon = 1.0e-08 : f32, weight_decay = 0.01 : f32}
+  return
+}
+
+// CHECK-LABEL: func.func @dropout
+func.func @dropout(%input: memref<4x32xf32>, %seed: i64,
+                   %output: memref<4x32xf32>, %mask: memref<16xi8>) {
+  // CHECK: tpp.dropout
+  tpp.dropout ins(%input: memref<4x32xf32>, %seed: i64)
+              out(%output: memref<4x32xf32>, %mask: memref<16xi8>)
+              {probability = 0.1 : f32}
+
+  // CHECK: tpp.dropout_backward
+  tpp.dropout_backward ins(%output: memref<4x32xf32>, %mask: memref<16xi8>)
+                       out(%input: memref<4x32xf32>)
+                       {probability = 0.1 : f32}
+  return
+}
+
+// CHECK-LABEL: func.func @quantized_matmul
+func.func @quantized_matmul(%a: memref<4x16xi8>, %b: memref<4x8x4xi8>,
+                            %c: memref<4x8xi32>, %out: memref<4x8xi8>) {
+  // CHECK: tpp.quantized_matmul
+  tpp.quantized_matmul ins(%a: memref<4x16xi8>, %b: memref<4x8x4xi8>)
+                       out(%c: memref<4x8xi32>)
+
+  // CHECK: tpp.requantize
+  tpp.requantize ins(%c: memref<4x8xi32>) out(%out: memref<4x8xi8>)
+                 {scale = 0.5 : f32, zero_point = 0 : i32,
+                  min = 0 : i32, max = 255 : i32}
+  return
+}
+
+// CHECK-LABEL: func.func @quantized_brgemm
+func.func @quantized_brgemm(%a: memref<2x4x16xi8>, %b: memref<2x4x8x4xi8>,
+                            %c: memref<4x8xi32>) {
+  // CHECK: tpp.quantized_brgemm
+  tpp.quantized_brgemm ins(%a: memref<2x4x16xi8>, %b: memref<2x4x8x4xi8>)
+                       out(%c: memref<4x8xi32>)
+  return
+}
+
+// CHECK-LABEL: func.func @sparse_brgemm
+func.func @sparse_brgemm(%a: memref<4x8x16xf32>, %b: memref<?x16x32xf32>,
+                         %idx: memref<?xi64>, %c: memref<8x32xf32>) {
+  // CHECK: tpp.sparse_brgemm
+  tpp.sparse_brgemm ins(%a: memref<4x8x16xf32>, %b: memref<?x16x32xf32>,
+                        %idx: memref<?xi64>)
+                    out(%c: memref<8x32xf32>)
+  return
+}
@@ -35,6 +35,25 @@ func.func @relu_to_loops(%arg0: memref<3x3xf32>) {
 
 // -----
 
+func.func @relu_backward_to_loops(%arg0: memref<3x3xf32>, %arg1: memref<3x3xf32>,
+                                  %arg2: memref<3x3xf32>) {
+  // CHECK-DAG: %[[zero:.*]] = arith.constant 0.000000e+00 : f32
+  // CHECK: scf.for %[[i:.*]] =
+  // CHECK:   scf.for %[[j:.*]] =
+  // CHECK:     %[[grad:.*]] = memref.load %arg0[%[[i]], %[[j]]] : memref<3x3xf32>
+  // CHECK:     %[[input:.*]] = memref.load %arg1[%[[i]], %[[j]]] : memref<3x3xf32>
+  // CHECK:     %[[mask:.*]] = arith.cmpf ogt, %[[input]], %[[zero]] : f32
+  // CHECK:     %[[sel:.*]] = arith.select %[[mask]], %[[grad]], %[[zero]] : f32
+  // CHECK:     memref.store %[[sel]], %arg2[%[[i]], %[[j]]] : memref<3x3xf32>
+  // CHECK:   }
+  // CHECK: }
+  tpp.relu_backward ins(%arg0: memref<3x3xf32>, %arg1: memref<3x3xf32>)
+                    out(%arg2: memref<3x3xf32>)
+  return
+}
+
+// -----
+
 func.func @add_to_loops(%arg0: memref<3x3xf32>, %arg1: memref<3x3xf32>) {
   // CHECK-DAG: %[[ub:.*]] = arith.constant 3 : index
   // CHECK-DAG: %[[lb:.*]] = arith.constant 0 : index
@@ -147,3 +166,197 @@ func.func @brgemm_to_loops(%arg0: memref<2x3x4xf32>, %arg1: memref<2x4x3xf32>, %
   tpp.brgemm ins(%arg0: memref<2x3x4xf32>, %arg1: memref<2x4x3xf32>) out(%arg2: memref<3x3xf32>)
   return 
 }
+
+// -----
+
+// CHECK-LABEL: func.func @sgd_update_to_loops(
+// CHECK-SAME: %[[GRAD:.+]]: memref<2x4x8xf32>, %[[LR:.+]]: f32, %[[PARAM:.+]]: memref<2x4x8xf32>, %[[VEL:.+]]: memref<2x4x8xf32>)
+func.func @sgd_update_to_loops(%grad: memref<2x4x8xf32>, %lr: f32,
+                               %param: memref<2x4x8xf32>,
+                               %velocity: memref<2x4x8xf32>) {
+  // CHECK-DAG: %[[MOMENTUM:.+]] = arith.constant 0.899999976 : f32
+  // CHECK-DAG: %[[DECAY:.+]] = arith.constant 0.000000e+00 : f32
+  // CHECK: scf.for %[[I:.+]] =
+  // CHECK:   scf.for %[[J:.+]] =
+  // CHECK:     scf.for %[[K:.+]] =
+  // CHECK:       %[[G:.+]] = memref.load %[[GRAD]][%[[I]], %[[J]], %[[K]]]
+  // CHECK:       %[[P:.+]] = memref.load %[[PARAM]][%[[I]], %[[J]], %[[K]]]
+  // CHECK:       %[[V:.+]] = memref.load %[[VEL]][%[[I]], %[[J]], %[[K]]]
+  // CHECK:       %[[WD:.+]] = arith.mulf %[[DECAY]], %[[P]] : f32
+  // CHECK:       %[[G1:.+]] = arith.addf %[[G]], %[[WD]] : f32
+  // CHECK:       %[[V1:.+]] = arith.mulf %[[MOMENTUM]], %[[V]] : f32
+  // CHECK:       %[[V2:.+]] = arith.addf %[[V1]], %[[G1]] : f32
+  // CHECK:       %[[STEP:.+]] = arith.mulf %[[LR]], %[[V2]] : f32
+  // CHECK:       %[[P1:.+]] = arith.subf %[[P]], %[[STEP]] : f32
+  // CHECK:       memref.store %[[V2]], %[[VEL]][%[[I]], %[[J]], %[[K]]]
+  // CHECK:       memref.store %[[P1]], %[[PARAM]][%[[I]], %[[J]], %[[K]]]
+  tpp.sgd_update ins(%grad: memref<2x4x8xf32>, %lr: f32)
+                 out(%param: memref<2x4x8xf32>, %velocity: memref<2x4x8xf32>)
+                 {momentum = 0.9 : f32, weight_decay = 0.0 : f32}
+  return
+}
+
+// -----
+
+// A is unsigned, B is signed and in VNNI4 format.
+// CHECK-LABEL: func.func @quantized_matmul_to_loops(
+// CHECK-SAME: %[[A:.+]]: memref<4x16xi8>, %[[B:.+]]: memref<4x8x4xi8>, %[[C:.+]]: memref<4x8xi32>)
+func.func @quantized_matmul_to_loops(%a: memref<4x16xi8>, %b: memref<4x8x4xi8>,
+                                     %c: memref<4x8xi32>) {
+  // CHECK-DAG: %[[FOUR:.+]] = arith.constant 4 : index
+  // CHECK: scf.for %[[I:.+]] =
+  // CHECK:   scf.for %[[J:.+]] =
+  // CHECK:     scf.for %[[K0:.+]] =
+  // CHECK:       scf.for %[[K1:.+]] =
+  // CHECK:         %[[MUL:.+]] = arith.muli %[[K0]], %[[FOUR]] : index
+  // CHECK:         %[[K:.+]] = arith.addi %[[MUL]], %[[K1]] : index
+  // CHECK:         %[[MA:.+]] = memref.load %[[A]][%[[I]], %[[K]]] : memref<4x16xi8>
+  // CHECK:         %[[MB:.+]] = memref.load %[[B]][%[[K0]], %[[J]], %[[K1]]] : memref<4x8x4xi8>
+  // CHECK:         %[[MC:.+]] = memref.load %[[C]][%[[I]], %[[J]]] : memref<4x8xi32>
+  // CHECK:         %[[EA:.+]] = arith.extui %[[MA]] : i8 to i32
+  // CHECK:         %[[EB:.+]] = arith.extsi %[[MB]] : i8 to i32
+  // CHECK:         %[[PROD:.+]] = arith.muli %[[EA]], %[[EB]] : i32
+  // CHECK:         %[[SUM:.+]] = arith.addi %[[MC]], %[[PROD]] : i32
+  // CHECK:         memref.store %[[SUM]], %[[C]][%[[I]], %[[J]]] : memref<4x8xi32>
+  tpp.quantized_matmul ins(%a: memref<4x16xi8>, %b: memref<4x8x4xi8>)
+                       out(%c: memref<4x8xi32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @requantize_to_loops(
+// CHECK-SAME: %[[ACC:.+]]: memref<4x8xi32>, %[[OUT:.+]]: memref<4x8xi8>)
+func.func @requantize_to_loops(%acc: memref<4x8xi32>, %out: memref<4x8xi8>) {
+  // CHECK-DAG: %[[SCALE:.+]] = arith.constant 5.000000e-01 : f32
+  // CHECK-DAG: %[[ZP:.+]] = arith.constant 3.000000e+00 : f32
+  // CHECK-DAG: %[[MIN:.+]] = arith.constant -1.280000e+02 : f32
+  // CHECK-DAG: %[[MAX:.+]] = arith.constant 1.270000e+02 : f32
+  // CHECK: scf.for %[[I:.+]] =
+  // CHECK:   scf.for %[[J:.+]] =
+  // CHECK:     %[[V:.+]] = memref.load %[[ACC]][%[[I]], %[[J]]] : memref<4x8xi32>
+  // CHECK:     %[[F:.+]] = arith.sitofp %[[V]] : i32 to f32
+  // CHECK:     %[[S:.+]] = arith.mulf %[[F]], %[[SCALE]] : f32
+  // CHECK:     %[[R:.+]] = math.round %[[S]] : f32
+  // CHECK:     %[[Z:.+]] = arith.addf %[[R]], %[[ZP]] : f32
+  // CHECK:     %[[LO:.+]] = arith.maxf %[[Z]], %[[MIN]] : f32
+  // CHECK:     %[[HI:.+]] = arith.minf %[[LO]], %[[MAX]] : f32
+  // CHECK:     %[[I32:.+]] = arith.fptosi %[[HI]] : f32 to i32
+  // CHECK:     %[[I8:.+]] = arith.trunci %[[I32]] : i32 to i8
+  // CHECK:     memref.store %[[I8]], %[[OUT]][%[[I]], %[[J]]] : memref<4x8xi8>
+  tpp.requantize ins(%acc: memref<4x8xi32>) out(%out: memref<4x8xi8>)
+                 {scale = 0.5 : f32, zero_point = 3 : i32,
+                  min = -128 : i32, max = 127 : i32}
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @sparse_brgemm_to_loops(
+// CHECK-SAME: %[[A:.+]]: memref<4x3x4xf32>, %[[B:.+]]: memref<?x4x3xf32>, %[[IDX:.+]]: memref<?xi64>, %[[C:.+]]: memref<3x3xf32>)
+func.func @sparse_brgemm_to_loops(%a: memref<4x3x4xf32>, %b: memref<?x4x3xf32>,
+                                  %idx: memref<?xi64>, %c: memref<3x3xf32>) {
+  // CHECK-DAG: %[[zero:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[one:.+]] = arith.constant 1 : index
+  // CHECK: %[[nnz:.+]] = memref.dim %[[B]], %[[zero]] : memref<?x4x3xf32>
+  // CHECK: scf.for %[[b:.+]] = %[[zero]] to %[[nnz]] step %[[one]] {
+  // CHECK: scf.for %[[i:.+]] =
+  // CHECK: scf.for %[[j:.+]] =
+  // CHECK: scf.for %[[k:.+]] =
+  // CHECK: %[[block:.+]] = memref.load %[[IDX]][%[[b]]] : memref<?xi64>
+  // CHECK: %[[blockIdx:.+]] = arith.index_cast %[[block]] : i64 to index
+  // CHECK: %[[ma:.+]] = memref.load %[[A]][%[[blockIdx]], %[[i]], %[[k]]] : memref<4x3x4xf32>
+  // CHECK: %[[mb:.+]] = memref.load %[[B]][%[[b]], %[[k]], %[[j]]] : memref<?x4x3xf32>
+  // CHECK: %[[mc:.+]] = memref.load %[[C]][%[[i]], %[[j]]] : memref<3x3xf32>
+  // CHECK: %[[mul:.+]] = arith.mulf %[[ma]], %[[mb]] : f32
+  // CHECK: %[[add:.+]] = arith.addf %[[mc]], %[[mul]] : f32
+  // CHECK: memref.store %[[add]], %[[C]][%[[i]], %[[j]]] : memref<3x3xf32>
+  tpp.sparse_brgemm ins(%a: memref<4x3x4xf32>, %b: memref<?x4x3xf32>,
+                        %idx: memref<?xi64>)
+                    out(%c: memref<3x3xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @dynamic_add_to_loops(
+// CHECK-SAME: %[[ARG0:.+]]: memref<?x8xf32>, %[[ARG1:.+]]: memref<?x8xf32>)
+func.func @dynamic_add_to_loops(%arg0: memref<?x8xf32>, %arg1: memref<?x8xf32>) {
+  // CHECK-DAG: %[[zero:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[one:.+]] = arith.constant 1 : index
+  // CHECK-DAG: %[[eight:.+]] = arith.constant 8 : index
+  // CHECK: %[[dim:.+]] = memref.dim %[[ARG1]], %[[zero]] : memref<?x8xf32>
+  // CHECK: scf.for %[[i:.+]] = %[[zero]] to %[[dim]] step %[[one]] {
+  // CHECK:   scf.for %[[j:.+]] = %[[zero]] to %[[eight]] step %[[one]] {
+  // CHECK:     memref.load %[[ARG0]][%[[i]], %[[j]]] : memref<?x8xf32>
+  tpp.add ins(%arg0: memref<?x8xf32>) out(%arg1: memref<?x8xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @dynamic_relu_to_loops(
+// CHECK-SAME: %[[ARG0:.+]]: memref<?x8xf32>)
+func.func @dynamic_relu_to_loops(%arg0: memref<?x8xf32>) {
+  // CHECK-DAG: %[[zero:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[one:.+]] = arith.constant 1 : index
+  // CHECK-DAG: %[[eight:.+]] = arith.constant 8 : index
+  // CHECK: %[[dim:.+]] = memref.dim %[[ARG0]], %[[zero]] : memref<?x8xf32>
+  // CHECK: scf.for %[[i:.+]] = %[[zero]] to %[[dim]] step %[[one]] {
+  // CHECK:   scf.for %[[j:.+]] = %[[zero]] to %[[eight]] step %[[one]] {
+  tpp.relu out(%arg0: memref<?x8xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @dynamic_identity_to_loops(
+// CHECK-SAME: %[[ARG0:.+]]: memref<8xf32>, %[[ARG1:.+]]: memref<?x8xf32>)
+func.func @dynamic_identity_to_loops(%arg0: memref<8xf32>, %arg1: memref<?x8xf32>) {
+  // CHECK-DAG: %[[zero:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[one:.+]] = arith.constant 1 : index
+  // CHECK-DAG: %[[eight:.+]] = arith.constant 8 : index
+  // CHECK: %[[dim:.+]] = memref.dim %[[ARG1]], %[[zero]] : memref<?x8xf32>
+  // CHECK: scf.for %[[i:.+]] = %[[zero]] to %[[dim]] step %[[one]] {
+  // CHECK:   scf.for %[[j:.+]] = %[[zero]] to %[[eight]] step %[[one]] {
+  // CHECK:     %[[load:.+]] = memref.load %[[ARG0]][%[[j]]] : memref<8xf32>
+  // CHECK:     memref.store %[[load]], %[[ARG1]][%[[i]], %[[j]]] : memref<?x8xf32>
+  tpp.identity ins(%arg0: memref<8xf32>) out(%arg1: memref<?x8xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @dynamic_matmul_to_loops(
+// CHECK-SAME: %[[ARG0:.+]]: memref<?x16xf32>, %[[ARG1:.+]]: memref<16x32xf32>, %[[ARG2:.+]]: memref<?x32xf32>)
+func.func @dynamic_matmul_to_loops(%arg0: memref<?x16xf32>, %arg1: memref<16x32xf32>, %arg2: memref<?x32xf32>) {
+  // CHECK-DAG: %[[zero:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[one:.+]] = arith.constant 1 : index
+  // CHECK-DAG: %[[sixteen:.+]] = arith.constant 16 : index
+  // CHECK-DAG: %[[thirtytwo:.+]] = arith.constant 32 : index
+  // CHECK: %[[dim:.+]] = memref.dim %[[ARG2]], %[[zero]] : memref<?x32xf32>
+  // CHECK: scf.for %[[i:.+]] = %[[zero]] to %[[dim]] step %[[one]] {
+  // CHECK:   scf.for %[[j:.+]] = %[[zero]] to %[[thirtytwo]] step %[[one]] {
+  // CHECK:     scf.for %[[k:.+]] = %[[zero]] to %[[sixteen]] step %[[one]] {
+  tpp.matmul ins(%arg0 : memref<?x16xf32>, %arg1 : memref<16x32xf32>) out(%arg2 : memref<?x32xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @dynamic_brgemm_to_loops(
+// CHECK-SAME: %[[ARG0:.+]]: memref<?x?x16xf32>, %[[ARG1:.+]]: memref<?x16x32xf32>, %[[ARG2:.+]]: memref<?x32xf32>)
+func.func @dynamic_brgemm_to_loops(%arg0: memref<?x?x16xf32>, %arg1: memref<?x16x32xf32>, %arg2: memref<?x32xf32>) {
+  // CHECK-DAG: %[[zero:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[one:.+]] = arith.constant 1 : index
+  // CHECK-DAG: %[[sixteen:.+]] = arith.constant 16 : index
+  // CHECK-DAG: %[[thirtytwo:.+]] = arith.constant 32 : index
+  // CHECK-DAG: %[[dimI:.+]] = memref.dim %[[ARG2]], %[[zero]] : memref<?x32xf32>
+  // CHECK-DAG: %[[batch:.+]] = memref.dim %[[ARG0]], %[[zero]] : memref<?x?x16xf32>
+  // CHECK: scf.for %[[b:.+]] = %[[zero]] to %[[batch]] step %[[one]] {
+  // CHECK:   scf.for %[[i:.+]] = %[[zero]] to %[[dimI]] step %[[one]] {
+  // CHECK:     scf.for %[[j:.+]] = %[[zero]] to %[[thirtytwo]] step %[[one]] {
+  // CHECK:       scf.for %[[k:.+]] = %[[zero]] to %[[sixteen]] step %[[one]] {
+  tpp.brgemm ins(%arg0 : memref<?x?x16xf32>, %arg1 : memref<?x16x32xf32>) out(%arg2 : memref<?x32xf32>)
+  return
+}
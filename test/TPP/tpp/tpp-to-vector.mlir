@@ -0,0 +1,140 @@
+// RUN: tpp-opt %s -convert-tpp-to-vector -split-input-file | FileCheck %s
+// RUN: tpp-opt %s -convert-tpp-to-vector="register-tile=2,8,2" -split-input-file | FileCheck %s -check-prefix=TILE
+
+// CHECK-LABEL: func.func @matmul_to_vector(
+// CHECK-SAME:  %[[A:.+]]: memref<8x12xf32>, %[[B:.+]]: memref<12x32xf32>, %[[C:.+]]: memref<8x32xf32>)
+// CHECK-DAG: %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG: %[[C1:.+]] = arith.constant 1 : index
+// CHECK-DAG: %[[C4:.+]] = arith.constant 4 : index
+// CHECK-DAG: %[[C16:.+]] = arith.constant 16 : index
+// CHECK: scf.for %[[I:.+]] = %[[C0]] to %{{.+}} step %[[C4]] {
+// CHECK:   scf.for %[[J:.+]] = %[[C0]] to %{{.+}} step %[[C16]] {
+// CHECK:     %[[ACC:.+]] = vector.transfer_read %[[C]][%[[I]], %[[J]]]{{.*}}{in_bounds = [true, true]} : memref<8x32xf32>, vector<4x16xf32>
+// CHECK:     %[[RES:.+]] = scf.for %[[K:.+]] = %[[C0]] to %{{.+}} step %[[C1]] iter_args(%[[TILE:.+]] = %[[ACC]]) -> (vector<4x16xf32>) {
+// CHECK:       %[[COL:.+]] = vector.transfer_read %[[A]][%[[I]], %[[K]]]{{.*}} : memref<8x12xf32>, vector<4xf32>
+// CHECK:       %[[ROW:.+]] = vector.transfer_read %[[B]][%[[K]], %[[J]]]{{.*}} : memref<12x32xf32>, vector<16xf32>
+// CHECK:       %[[OP:.+]] = vector.outerproduct %[[COL]], %[[ROW]], %[[TILE]]
+// CHECK:       scf.yield %[[OP]] : vector<4x16xf32>
+// CHECK:     vector.transfer_write %[[RES]], %[[C]][%[[I]], %[[J]]]{{.*}} : vector<4x16xf32>, memref<8x32xf32>
+// CHECK-NOT: tpp.matmul
+// TILE-LABEL: func.func @matmul_to_vector(
+// TILE: vector.transfer_read {{.+}} : memref<8x32xf32>, vector<2x8xf32>
+// TILE: scf.for
+// TILE-COUNT-2: vector.outerproduct
+// TILE: scf.yield
+func.func @matmul_to_vector(%A: memref<8x12xf32>, %B: memref<12x32xf32>, %C: memref<8x32xf32>) {
+  tpp.matmul ins(%A: memref<8x12xf32>, %B: memref<12x32xf32>) out(%C: memref<8x32xf32>)
+  return
+}
+
+// -----
+
+// bf16 accumulates in f32, C is truncated once per tile.
+// CHECK-LABEL: func.func @matmul_bf16(
+// CHECK: %[[ACC:.+]] = vector.transfer_read {{.+}} : memref<8x32xbf16>, vector<4x16xbf16>
+// CHECK: %[[ACC32:.+]] = arith.extf %[[ACC]] : vector<4x16xbf16> to vector<4x16xf32>
+// CHECK: %[[RES:.+]] = scf.for {{.+}} iter_args(%[[TILE:.+]] = %[[ACC32]]) -> (vector<4x16xf32>) {
+// CHECK:   %[[COL:.+]] = vector.transfer_read {{.+}} : memref<8x12xbf16>, vector<4xbf16>
+// CHECK:   %[[ROW:.+]] = vector.transfer_read {{.+}} : memref<12x32xbf16>, vector<16xbf16>
+// CHECK:   %[[COL32:.+]] = arith.extf %[[COL]] : vector<4xbf16> to vector<4xf32>
+// CHECK:   %[[ROW32:.+]] = arith.extf %[[ROW]] : vector<16xbf16> to vector<16xf32>
+// CHECK:   vector.outerproduct %[[COL32]], %[[ROW32]], %[[TILE]]
+// CHECK: %[[OUT:.+]] = arith.truncf %[[RES]] : vector<4x16xf32> to vector<4x16xbf16>
+// CHECK: vector.transfer_write %[[OUT]], {{.+}} : vector<4x16xbf16>, memref<8x32xbf16>
+func.func @matmul_bf16(%A: memref<8x12xbf16>, %B: memref<12x32xbf16>, %C: memref<8x32xbf16>) {
+  tpp.matmul ins(%A: memref<8x12xbf16>, %B: memref<12x32xbf16>) out(%C: memref<8x32xbf16>)
+  return
+}
+
+// -----
+
+// Tails are read padded and written masked.
+// CHECK-LABEL: func.func @matmul_tails(
+// CHECK: vector.transfer_read {{.+}} : memref<6x20xf32>, vector<4x16xf32>
+// CHECK: vector.outerproduct
+// CHECK: vector.transfer_write {{.+}} : vector<4x16xf32>, memref<6x20xf32>
+func.func @matmul_tails(%A: memref<6x5xf32>, %B: memref<5x20xf32>, %C: memref<6x20xf32>) {
+  tpp.matmul ins(%A: memref<6x5xf32>, %B: memref<5x20xf32>) out(%C: memref<6x20xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @brgemm_to_vector(
+// CHECK-SAME:  %[[A:.+]]: memref<2x4x8xf32>, %[[B:.+]]: memref<2x8x16xf32>, %[[C:.+]]: memref<4x16xf32>)
+// CHECK:     vector.transfer_read %[[C]]
+// CHECK:     scf.for %[[BATCH:.+]] = {{.+}} iter_args(
+// CHECK:       scf.for %[[K:.+]] = {{.+}} iter_args(
+// CHECK:         vector.transfer_read %[[A]][%[[BATCH]], %{{.+}}, %[[K]]]{{.*}} : memref<2x4x8xf32>, vector<4xf32>
+// CHECK:         vector.transfer_read %[[B]][%[[BATCH]], %[[K]], %{{.+}}]{{.*}} : memref<2x8x16xf32>, vector<16xf32>
+// CHECK:         vector.outerproduct
+// CHECK:     vector.transfer_write {{.+}}, %[[C]]
+// CHECK-NOT: tpp.brgemm
+func.func @brgemm_to_vector(%A: memref<2x4x8xf32>, %B: memref<2x8x16xf32>, %C: memref<4x16xf32>) {
+  tpp.brgemm ins(%A: memref<2x4x8xf32>, %B: memref<2x8x16xf32>) out(%C: memref<4x16xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @add_to_vector(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<3x32xf32>, %[[ARG1:.+]]: memref<3x32xf32>)
+// CHECK: scf.for %[[I:.+]] =
+// CHECK:   scf.for %[[J:.+]] = {{.+}} step %{{.+}} {
+// CHECK:     %[[LHS:.+]] = vector.transfer_read %[[ARG0]][%[[I]], %[[J]]]{{.*}} : memref<3x32xf32>, vector<16xf32>
+// CHECK:     %[[RHS:.+]] = vector.transfer_read %[[ARG1]][%[[I]], %[[J]]]{{.*}} : memref<3x32xf32>, vector<16xf32>
+// CHECK:     %[[ADD:.+]] = arith.addf %[[LHS]], %[[RHS]] : vector<16xf32>
+// CHECK:     vector.transfer_write %[[ADD]], %[[ARG1]][%[[I]], %[[J]]]
+func.func @add_to_vector(%arg0: memref<3x32xf32>, %arg1: memref<3x32xf32>) {
+  tpp.add ins(%arg0: memref<3x32xf32>) out(%arg1: memref<3x32xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @relu_to_vector(
+// CHECK: %[[IN:.+]] = vector.transfer_read {{.+}} : memref<3x32xf32>, vector<16xf32>
+// CHECK: %[[MAX:.+]] = arith.maxf %[[IN]], %{{.+}} : vector<16xf32>
+// CHECK: vector.transfer_write %[[MAX]]
+func.func @relu_to_vector(%arg0: memref<3x32xf32>) {
+  tpp.relu out(%arg0: memref<3x32xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @identity_broadcast(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<3x32xf32>, %[[ARG1:.+]]: memref<32xf32>, %[[ARG2:.+]]: memref<3x1xf32>)
+// CHECK: %[[ROW:.+]] = vector.transfer_read %[[ARG1]][%{{.+}}]{{.*}} : memref<32xf32>, vector<16xf32>
+// CHECK: vector.transfer_write %[[ROW]], %[[ARG0]]
+// CHECK: %[[SCALAR:.+]] = memref.load %[[ARG2]]
+// CHECK: %[[BCAST:.+]] = vector.broadcast %[[SCALAR]] : f32 to vector<16xf32>
+// CHECK: vector.transfer_write %[[BCAST]], %[[ARG0]]
+func.func @identity_broadcast(%arg0: memref<3x32xf32>, %arg1: memref<32xf32>, %arg2: memref<3x1xf32>) {
+  tpp.identity ins(%arg1: memref<32xf32>) out(%arg0: memref<3x32xf32>)
+  tpp.identity ins(%arg2: memref<3x1xf32>) out(%arg0: memref<3x32xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @requantize_to_vector(
+// CHECK-SAME:  %[[ACC:.+]]: memref<4x32xi32>, %[[OUT:.+]]: memref<4x32xi8>)
+// CHECK:   scf.for %[[I:.+]] =
+// CHECK:     scf.for %[[J:.+]] =
+// CHECK:       %[[V:.+]] = vector.transfer_read %[[ACC]][%[[I]], %[[J]]]{{.*}} : memref<4x32xi32>, vector<16xi32>
+// CHECK:       %[[F:.+]] = arith.sitofp %[[V]] : vector<16xi32> to vector<16xf32>
+// CHECK:       %[[S:.+]] = arith.mulf %[[F]], %{{.+}} : vector<16xf32>
+// CHECK:       %[[R:.+]] = math.round %[[S]] : vector<16xf32>
+// CHECK:       %[[Z:.+]] = arith.addf %[[R]], %{{.+}} : vector<16xf32>
+// CHECK:       %[[LO:.+]] = arith.maxf %[[Z]], %{{.+}} : vector<16xf32>
+// CHECK:       %[[HI:.+]] = arith.minf %[[LO]], %{{.+}} : vector<16xf32>
+// CHECK:       %[[I32:.+]] = arith.fptosi %[[HI]] : vector<16xf32> to vector<16xi32>
+// CHECK:       %[[I8:.+]] = arith.trunci %[[I32]] : vector<16xi32> to vector<16xi8>
+// CHECK:       vector.transfer_write %[[I8]], %[[OUT]][%[[I]], %[[J]]]{{.*}} : vector<16xi8>, memref<4x32xi8>
+func.func @requantize_to_vector(%acc: memref<4x32xi32>, %out: memref<4x32xi8>) {
+  tpp.requantize ins(%acc: memref<4x32xi32>) out(%out: memref<4x32xi8>)
+                 {scale = 0.5 : f32, zero_point = 0 : i32,
+                  min = 0 : i32, max = 255 : i32}
+  return
+}
@@ -0,0 +1,59 @@
+// RUN: tpp-opt %s -convert-tpp-to-xsmm="inline-flops-threshold=2000" -split-input-file | FileCheck %s
+
+// 2 * 12 * 6 * 9 = 1296 FLOPs: inline, one outer product per k. At most 8
+// rows of C are held in registers, the last 4 are a masked tail.
+// CHECK-LABEL: func.func @tiny_matmul(
+// CHECK-SAME:  %[[A:.+]]: memref<12x9xf32>, %[[B:.+]]: memref<9x6xf32>, %[[C:.+]]: memref<12x6xf32>)
+// CHECK-DAG: %[[C8:.+]] = arith.constant 8 : index
+// CHECK-DAG: %[[C12:.+]] = arith.constant 12 : index
+// CHECK: scf.for %[[I:.+]] = %{{.+}} to %[[C12]] step %[[C8]]
+// CHECK-NOT: scf.for
+// CHECK: %[[ACC:.+]] = vector.transfer_read %[[C]][%[[I]], %{{.+}}]{{.*}} {in_bounds = [false, true]} : memref<12x6xf32>, vector<8x6xf32>
+// CHECK-COUNT-9: vector.outerproduct
+// CHECK: vector.transfer_write %{{.+}}, %[[C]][%[[I]], %{{.+}}]{{.*}} : vector<8x6xf32>, memref<12x6xf32>
+// CHECK-NOT: xsmm
+func.func @tiny_matmul(%A: memref<12x9xf32>, %B: memref<9x6xf32>, %C: memref<12x6xf32>) {
+  tpp.matmul ins(%A: memref<12x9xf32>, %B: memref<9x6xf32>) out(%C: memref<12x6xf32>)
+  return
+}
+
+// -----
+
+// 2 * 2 * 4 * 4 * 8 = 512 FLOPs: inline, the batch stays a loop.
+// CHECK-LABEL: func.func @tiny_brgemm(
+// CHECK: scf.for
+// CHECK-COUNT-8: vector.outerproduct
+// CHECK: scf.yield
+// CHECK-NOT: xsmm
+func.func @tiny_brgemm(%A: memref<2x4x8xf32>, %B: memref<2x8x4xf32>, %C: memref<4x4xf32>) {
+  tpp.brgemm ins(%A: memref<2x4x8xf32>, %B: memref<2x8x4xf32>) out(%C: memref<4x4xf32>)
+  return
+}
+
+// -----
+
+// 2 * 2 * 128 * 2 = 1024 FLOPs: inline, C is 128 wide, 32 columns at a time.
+// CHECK-LABEL: func.func @wide_matmul(
+// CHECK-DAG: %[[C32:.+]] = arith.constant 32 : index
+// CHECK-DAG: %[[C128:.+]] = arith.constant 128 : index
+// CHECK: scf.for %{{.+}} = %{{.+}} to %[[C128]] step %[[C32]]
+// CHECK: vector.transfer_read {{.+}} : memref<2x128xf32>, vector<2x32xf32>
+// CHECK-COUNT-2: vector.outerproduct
+// CHECK: vector.transfer_write {{.+}} : vector<2x32xf32>, memref<2x128xf32>
+// CHECK-NOT: xsmm
+func.func @wide_matmul(%A: memref<2x2xf32>, %B: memref<2x128xf32>, %C: memref<2x128xf32>) {
+  tpp.matmul ins(%A: memref<2x2xf32>, %B: memref<2x128xf32>) out(%C: memref<2x128xf32>)
+  return
+}
+
+// -----
+
+// 2 * 32 * 32 * 32 FLOPs: a LIBXSMM call.
+// CHECK-LABEL: func.func @matmul(
+// CHECK: xsmm.ternary.dispatch matmul
+// CHECK: xsmm.ternary matmul
+// CHECK-NOT: vector.outerproduct
+func.func @matmul(%A: memref<32x32xf32>, %B: memref<32x32xf32>, %C: memref<32x32xf32>) {
+  tpp.matmul ins(%A: memref<32x32xf32>, %B: memref<32x32xf32>) out(%C: memref<32x32xf32>)
+  return
+}
@@ -140,6 +140,23 @@ func.func @brgemm_to_xsmm(%arg0: memref<3x5x4xf32>, %arg1: memref<3x4x5xf32>,
 
 // -----
 
+// LIBXSMM takes bf16 in the VNNI layout only, flat bf16 GEMMs stay in tpp.
+// CHECK-LABEL: @bf16_gemms_not_to_xsmm(
+func.func @bf16_gemms_not_to_xsmm(%arg0: memref<3x5x4xbf16>, %arg1: memref<3x4x5xbf16>,
+                                  %arg2: memref<5x5xbf16>, %arg3: memref<5x4xbf16>,
+                                  %arg4: memref<4x5xbf16>) {
+  // CHECK-NOT: xsmm.ternary
+  // CHECK: tpp.brgemm
+  // CHECK: tpp.matmul
+  tpp.brgemm ins(%arg0: memref<3x5x4xbf16>, %arg1: memref<3x4x5xbf16>)
+             out(%arg2: memref<5x5xbf16>)
+  tpp.matmul ins(%arg3: memref<5x4xbf16>, %arg4: memref<4x5xbf16>)
+             out(%arg2: memref<5x5xbf16>)
+  return
+}
+
+// -----
+
 // Strides are non-constant expect to fail.
 func.func @tpp_matmul(%arg0: memref<12x9xf32, strided<[?, ?], offset: ?>>,  
                       %arg1: memref<9x6xf32, strided<[?, ?], offset: ?>>, 
@@ -150,3 +167,105 @@ func.func @tpp_matmul(%arg0: memref<12x9xf32, strided<[?, ?], offset: ?>>,
              out(%arg2 : memref<12x6xf32, strided<[?, ?], offset: ?>>)
   return 
 }
+
+// -----
+
+// m is dynamic (-9223372036854775808) and read from C at runtime.
+// CHECK-LABEL: @dynamic_matmul_to_xsmm(
+// CHECK-SAME: %[[ARG0:.+]]: memref<?x16xf32>, %[[ARG1:.+]]: memref<16x32xf32>, %[[ARG2:.+]]: memref<?x32xf32>)
+func.func @dynamic_matmul_to_xsmm(%arg0: memref<?x16xf32>, %arg1: memref<16x32xf32>, %arg2: memref<?x32xf32>) {
+  // CHECK: %[[C0:.+]] = arith.constant 0 : index
+  // CHECK: %[[DIM:.+]] = memref.dim %[[ARG2]], %[[C0]] : memref<?x32xf32>
+  // CHECK: %[[M:.+]] = arith.index_cast %[[DIM]] : index to i64
+  // CHECK: %[[DISPATCH:.+]] = xsmm.ternary.dispatch matmul [-9223372036854775808, 32, 16, 16, 32, 32] dims(%[[M]])(dataType f32)
+  // CHECK: xsmm.ternary matmul(dataType f32, %[[DISPATCH]], %[[ARG0]], %[[ARG1]], %[[ARG2]])
+  tpp.matmul ins(%arg0 : memref<?x16xf32>, %arg1 : memref<16x32xf32>) out(%arg2 : memref<?x32xf32>)
+  return
+}
+
+// -----
+
+// The batch size is dynamic too, it is an operand of the invoke.
+// CHECK-LABEL: @dynamic_brgemm_to_xsmm(
+// CHECK-SAME: %[[ARG0:.+]]: memref<?x?x16xf32>, %[[ARG1:.+]]: memref<?x16x32xf32>, %[[ARG2:.+]]: memref<?x32xf32>)
+func.func @dynamic_brgemm_to_xsmm(%arg0: memref<?x?x16xf32>, %arg1: memref<?x16x32xf32>, %arg2: memref<?x32xf32>) {
+  // CHECK: %[[DIM:.+]] = memref.dim %[[ARG2]], %{{.+}} : memref<?x32xf32>
+  // CHECK: %[[M:.+]] = arith.index_cast %[[DIM]] : index to i64
+  // CHECK: %[[DISPATCH:.+]] = xsmm.ternary.dispatch brgemm [-9223372036854775808, 32, 16, 16, 32, 32] dims(%[[M]])(dataType f32)
+  // CHECK: %[[BATCH_DIM:.+]] = memref.dim %[[ARG1]], %{{.+}} : memref<?x16x32xf32>
+  // CHECK: %[[BATCH:.+]] = arith.index_cast %[[BATCH_DIM]] : index to i64
+  // CHECK: xsmm.ternary brgemm(dataType f32, %[[DISPATCH]], %[[ARG0]], %[[ARG1]], %[[ARG2]], %[[BATCH]])
+  tpp.brgemm ins(%arg0 : memref<?x?x16xf32>, %arg1 : memref<?x16x32xf32>) out(%arg2 : memref<?x32xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: @dynamic_relu_to_xsmm(
+// CHECK-SAME: %[[ARG0:.+]]: memref<?x32xf32>)
+func.func @dynamic_relu_to_xsmm(%arg0: memref<?x32xf32>) {
+  // CHECK: %[[DIM:.+]] = memref.dim %[[ARG0]], %{{.+}} : memref<?x32xf32>
+  // CHECK: %[[M:.+]] = arith.index_cast %[[DIM]] : index to i64
+  // CHECK: %[[DISPATCH:.+]] = xsmm.unary.dispatch relu [-9223372036854775808, 32, 32, 32] dims(%[[M]])(broadcast none dataType f32)
+  // CHECK: xsmm.unary relu(dataType f32, %[[DISPATCH]], %[[ARG0]])
+  tpp.relu out(%arg0 : memref<?x32xf32>)
+  return
+}
+
+// -----
+
+// The forward activation is the secondary input of relu_inv.
+// CHECK-LABEL: @relu_backward_to_xsmm(
+// CHECK-SAME: %[[GRAD:.+]]: memref<5x6xf32>, %[[INPUT:.+]]: memref<5x6xf32>, %[[OUT:.+]]: memref<5x6xf32>)
+func.func @relu_backward_to_xsmm(%arg0: memref<5x6xf32>, %arg1: memref<5x6xf32>,
+                                 %arg2: memref<5x6xf32>) {
+  // CHECK: %[[DISPATCH:.+]] = xsmm.unary.dispatch relu_inv [5, 6, 6, 6](broadcast none dataType f32)
+  // CHECK: xsmm.unary relu_inv(dataType f32, %[[DISPATCH]], %[[GRAD]], %[[INPUT]], %[[OUT]])
+  tpp.relu_backward ins(%arg0: memref<5x6xf32>, %arg1: memref<5x6xf32>)
+                    out(%arg2: memref<5x6xf32>)
+  return
+}
+
+// -----
+
+// ldb counts the columns of B in VNNI4 format: 32, not 128.
+// CHECK-LABEL: @quantized_matmul_to_xsmm(
+// CHECK-SAME: %[[A:.+]]: memref<16x64xi8>, %[[B:.+]]: memref<16x32x4xi8>, %[[C:.+]]: memref<16x32xi32>)
+func.func @quantized_matmul_to_xsmm(%arg0: memref<16x64xi8>, %arg1: memref<16x32x4xi8>,
+                                    %arg2: memref<16x32xi32>) {
+  // CHECK: %[[DISPATCH:.+]] = xsmm.ternary.dispatch matmul [16, 32, 64, 64, 32, 32](dataType i8)
+  // CHECK: xsmm.ternary matmul(dataType i8, %[[DISPATCH]], %[[A]], %[[B]], %[[C]])
+  tpp.quantized_matmul ins(%arg0: memref<16x64xi8>, %arg1: memref<16x32x4xi8>)
+                       out(%arg2: memref<16x32xi32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: @quantized_brgemm_to_xsmm(
+// CHECK-SAME: %[[A:.+]]: memref<4x16x64xi8>, %[[B:.+]]: memref<4x16x32x4xi8>, %[[C:.+]]: memref<16x32xi32>)
+func.func @quantized_brgemm_to_xsmm(%arg0: memref<4x16x64xi8>, %arg1: memref<4x16x32x4xi8>,
+                                    %arg2: memref<16x32xi32>) {
+  // CHECK: %[[DISPATCH:.+]] = xsmm.ternary.dispatch brgemm [16, 32, 64, 64, 32, 32](dataType i8)
+  // CHECK: xsmm.ternary brgemm(dataType i8, %[[DISPATCH]], %[[A]], %[[B]], %[[C]], %{{.+}})
+  tpp.quantized_brgemm ins(%arg0: memref<4x16x64xi8>, %arg1: memref<4x16x32x4xi8>)
+                       out(%arg2: memref<16x32xi32>)
+  return
+}
+
+// -----
+
+// The number of non-zero blocks is an operand of the invoke.
+// CHECK-LABEL: @sparse_brgemm_to_xsmm(
+// CHECK-SAME: %[[A:.+]]: memref<4x16x64xf32>, %[[B:.+]]: memref<?x64x32xf32>, %[[IDX:.+]]: memref<?xi64>, %[[C:.+]]: memref<16x32xf32>)
+func.func @sparse_brgemm_to_xsmm(%arg0: memref<4x16x64xf32>, %arg1: memref<?x64x32xf32>,
+                                 %arg2: memref<?xi64>, %arg3: memref<16x32xf32>) {
+  // CHECK: %[[DISPATCH:.+]] = xsmm.ternary.dispatch sparse_brgemm [16, 32, 64, 64, 32, 32](dataType f32)
+  // CHECK: %[[BATCH_DIM:.+]] = memref.dim %[[B]], %{{.+}} : memref<?x64x32xf32>
+  // CHECK: %[[BATCH:.+]] = arith.index_cast %[[BATCH_DIM]] : index to i64
+  // CHECK: xsmm.ternary sparse_brgemm(dataType f32, %[[DISPATCH]], %[[A]], %[[B]], %[[IDX]], %[[C]], %[[BATCH]])
+  tpp.sparse_brgemm ins(%arg0: memref<4x16x64xf32>, %arg1: memref<?x64x32xf32>,
+                        %arg2: memref<?xi64>)
+                    out(%arg3: memref<16x32xf32>)
+  return
+}
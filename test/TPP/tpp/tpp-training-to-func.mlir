@@ -0,0 +1,87 @@
+// RUN: tpp-opt %s -convert-tpp-training-to-func -split-input-file | FileCheck %s
+
+// CHECK: func.func private @tpp_sgd_update(memref<*xf32>, f32, memref<*xf32>, memref<*xf32>, f32, f32) attributes {llvm.emit_c_interface}
+
+// The blocked weights are updated in place, whatever their rank.
+// CHECK-LABEL: func.func @sgd_update(
+// CHECK-SAME: %[[GRAD:.+]]: memref<4x8x32x32xf32>, %[[LR:.+]]: f32, %[[PARAM:.+]]: memref<4x8x32x32xf32>, %[[VEL:.+]]: memref<4x8x32x32xf32>)
+func.func @sgd_update(%grad: memref<4x8x32x32xf32>, %lr: f32,
+                      %param: memref<4x8x32x32xf32>,
+                      %velocity: memref<4x8x32x32xf32>) {
+  // CHECK: %[[G:.+]] = memref.cast %[[GRAD]] : memref<4x8x32x32xf32> to memref<*xf32>
+  // CHECK: %[[P:.+]] = memref.cast %[[PARAM]] : memref<4x8x32x32xf32> to memref<*xf32>
+  // CHECK: %[[V:.+]] = memref.cast %[[VEL]] : memref<4x8x32x32xf32> to memref<*xf32>
+  // CHECK-DAG: %[[MOMENTUM:.+]] = arith.constant 0.899999976 : f32
+  // CHECK-DAG: %[[DECAY:.+]] = arith.constant 5.000000e-01 : f32
+  // CHECK: call @tpp_sgd_update(%[[G]], %[[LR]], %[[P]], %[[V]], %[[MOMENTUM]], %[[DECAY]])
+  tpp.sgd_update ins(%grad: memref<4x8x32x32xf32>, %lr: f32)
+                 out(%param: memref<4x8x32x32xf32>,
+                     %velocity: memref<4x8x32x32xf32>)
+                 {momentum = 0.9 : f32, weight_decay = 0.5 : f32}
+  return
+}
+
+// -----
+
+// CHECK: func.func private @tpp_adam_update(memref<*xf32>, f32, f32, memref<*xf32>, memref<*xf32>, memref<*xf32>, f32, f32, f32, f32) attributes {llvm.emit_c_interface}
+
+// CHECK-LABEL: func.func @adam_update(
+func.func @adam_update(%grad: memref<256x128xf32>, %lr: f32, %step: f32,
+                       %param: memref<256x128xf32>, %m: memref<256x128xf32>,
+                       %v: memref<256x128xf32>) {
+  // CHECK-COUNT-4: memref.cast
+  // CHECK: call @tpp_adam_update
+  tpp.adam_update ins(%grad: memref<256x128xf32>, %lr: f32, %step: f32)
+                  out(%param: memref<256x128xf32>, %m: memref<256x128xf32>,
+                      %v: memref<256x128xf32>)
+                  {beta1 = 0.9 : f32, beta2 = 0.999 : f32,
+                   epsilon = 1.0e-08 : f32, weight_decay = 0.01 : f32}
+  return
+}
+
+// -----
+
+// A strided parameter is not swept as a flat array, but with loops.
+// CHECK-NOT: func.func private @tpp_sgd_update
+// CHECK-LABEL: func.func @sgd_update_strided(
+func.func @sgd_update_strided(%grad: memref<32x32xf32, strided<[64, 1]>>,
+                              %lr: f32,
+                              %param: memref<32x32xf32, strided<[64, 1]>>,
+                              %velocity: memref<32x32xf32, strided<[64, 1]>>) {
+  // CHECK-NOT: tpp.sgd_update
+  // CHECK: scf.for
+  // CHECK:   scf.for
+  // CHECK:     memref.store {{.+}} : memref<32x32xf32, strided<[64, 1]>>
+  // CHECK:     memref.store {{.+}} : memref<32x32xf32, strided<[64, 1]>>
+  tpp.sgd_update ins(%grad: memref<32x32xf32, strided<[64, 1]>>, %lr: f32)
+                 out(%param: memref<32x32xf32, strided<[64, 1]>>,
+                     %velocity: memref<32x32xf32, strided<[64, 1]>>)
+                 {momentum = 0.9 : f32, weight_decay = 0.0 : f32}
+  return
+}
+
+// -----
+
+// CHECK-DAG: func.func private @tpp_dropout(memref<*xf32>, i64, memref<*xf32>, memref<*xi8>, f32) attributes {llvm.emit_c_interface}
+// CHECK-DAG: func.func private @tpp_dropout_backward(memref<*xf32>, memref<*xi8>, memref<*xf32>, f32) attributes {llvm.emit_c_interface}
+
+// The mask holds one bit per element: 64 * 128 / 8 bytes.
+// CHECK-LABEL: func.func @dropout(
+// CHECK-SAME: %[[INPUT:.+]]: memref<64x128xf32>, %[[SEED:.+]]: i64, %[[OUTPUT:.+]]: memref<64x128xf32>, %[[MASK:.+]]: memref<1024xi8>, %[[GRAD:.+]]: memref<64x128xf32>, %[[DX:.+]]: memref<64x128xf32>)
+func.func @dropout(%input: memref<64x128xf32>, %seed: i64,
+                   %output: memref<64x128xf32>, %mask: memref<1024xi8>,
+                   %grad: memref<64x128xf32>, %dx: memref<64x128xf32>) {
+  // CHECK: %[[I:.+]] = memref.cast %[[INPUT]] : memref<64x128xf32> to memref<*xf32>
+  // CHECK: %[[O:.+]] = memref.cast %[[OUTPUT]] : memref<64x128xf32> to memref<*xf32>
+  // CHECK: %[[M:.+]] = memref.cast %[[MASK]] : memref<1024xi8> to memref<*xi8>
+  // CHECK: %[[P:.+]] = arith.constant 5.000000e-01 : f32
+  // CHECK: call @tpp_dropout(%[[I]], %[[SEED]], %[[O]], %[[M]], %[[P]])
+  tpp.dropout ins(%input: memref<64x128xf32>, %seed: i64)
+              out(%output: memref<64x128xf32>, %mask: memref<1024xi8>)
+              {probability = 0.5 : f32}
+  // CHECK: call @tpp_dropout_backward
+  tpp.dropout_backward ins(%grad: memref<64x128xf32>, %mask: memref<1024xi8>)
+                       out(%dx: memref<64x128xf32>)
+                       {probability = 0.5 : f32}
+  return
+}
@@ -0,0 +1,40 @@
+// RUN: tpp-opt %s -transform-dialect-interpreter="per-function=true" -transform-drop-schedule | FileCheck %s
+// RUN: tpp-opt %s -transform-dialect-interpreter -transform-drop-schedule | FileCheck %s
+
+// Applied to each function as its own payload, the schedule gives the same
+// result as applied once to the whole module. Declarations are skipped.
+
+transform.sequence failures(propagate) {
+  ^bb0(%arg1: !pdl.operation):
+    %0 = transform.structured.match ops{["linalg.matmul"]} in %arg1
+    %1, %loops:3 = transform.structured.tile %0 [4, 4, 4]
+}
+
+// CHECK: func.func private @external(tensor<8x8xf32>)
+func.func private @external(tensor<8x8xf32>)
+
+// CHECK-LABEL: func.func @first(
+func.func @first(%arg0: tensor<8x8xf32>, %arg1: tensor<8x8xf32>,
+                 %arg2: tensor<8x8xf32>) -> tensor<8x8xf32> {
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: linalg.matmul {{.*}} -> tensor<4x4xf32>
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<8x8xf32>, tensor<8x8xf32>)
+                     outs(%arg2: tensor<8x8xf32>) -> tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func.func @second(
+func.func @second(%arg0: tensor<16x8xf32>, %arg1: tensor<8x16xf32>,
+                  %arg2: tensor<16x16xf32>) -> tensor<16x16xf32> {
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: linalg.matmul {{.*}} -> tensor<4x4xf32>
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<16x8xf32>, tensor<8x16xf32>)
+                     outs(%arg2: tensor<16x16xf32>) -> tensor<16x16xf32>
+  return %0 : tensor<16x16xf32>
+}
+
+// CHECK-NOT: transform.sequence
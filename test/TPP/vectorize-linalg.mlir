@@ -0,0 +1,80 @@
+// RUN: tpp-opt %s -vectorize-linalg -split-input-file | FileCheck %s
+// RUN: tpp-opt %s -vectorize-linalg="max-elements=64" -split-input-file | FileCheck %s -check-prefix=TILE
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// Small enough, vectorized as a whole either way.
+// CHECK-LABEL: func.func @add(
+// TILE-LABEL: func.func @add(
+func.func @add(%A: memref<4x16xf32>, %B: memref<4x16xf32>) {
+  // CHECK-NOT: scf.for
+  // CHECK: vector.transfer_read {{.+}} : memref<4x16xf32>, vector<4x16xf32>
+  // CHECK: vector.transfer_read {{.+}} : memref<4x16xf32>, vector<4x16xf32>
+  // CHECK: arith.addf {{.+}} : vector<4x16xf32>
+  // CHECK: vector.transfer_write {{.+}} : vector<4x16xf32>, memref<4x16xf32>
+  // TILE-NOT: scf.for
+  // TILE: arith.addf {{.+}} : vector<4x16xf32>
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+    ins(%A : memref<4x16xf32>) outs(%B : memref<4x16xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %0 = arith.addf %a, %b : f32
+    linalg.yield %0 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// Above 'max-elements', the innermost loop is kept whole, the outer one is
+// tiled to fit and each tile is vectorized.
+// CHECK-LABEL: func.func @large_add(
+// TILE-LABEL: func.func @large_add(
+func.func @large_add(%A: memref<32x48xf32>, %B: memref<32x48xf32>) {
+  // CHECK-NOT: scf.for
+  // CHECK: arith.addf {{.+}} : vector<32x48xf32>
+  // TILE-DAG: %[[C0:.+]] = arith.constant 0 : index
+  // TILE-DAG: %[[C32:.+]] = arith.constant 32 : index
+  // TILE: scf.for %{{.+}} = %[[C0]] to %[[C32]] step %{{.+}} {
+  // TILE: memref.subview {{.+}} [1, 48] [1, 1]
+  // TILE: arith.addf {{.+}} : vector<1x48xf32>
+  // TILE-NOT: linalg.generic
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+    ins(%A : memref<32x48xf32>) outs(%B : memref<32x48xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %0 = arith.addf %a, %b : f32
+    linalg.yield %0 : f32
+  }
+  return
+}
+
+// -----
+
+// An innermost loop that doesn't fit on its own is tiled to its largest
+// divisor that fits, the outer ones to 1.
+// TILE-LABEL: func.func @large_fill(
+func.func @large_fill(%A: tensor<2x96xf32>) -> tensor<2x96xf32> {
+  // TILE: scf.for
+  // TILE: scf.for
+  // TILE: tensor.extract_slice {{.+}} [1, 48] [1, 1]
+  // TILE: vector.transfer_write {{.+}} : vector<1x48xf32>, tensor<1x48xf32>
+  // TILE-NOT: linalg.fill
+  %c0 = arith.constant 0.0 : f32
+  %0 = linalg.fill ins(%c0 : f32) outs(%A : tensor<2x96xf32>) -> tensor<2x96xf32>
+  return %0 : tensor<2x96xf32>
+}
+
+// -----
+
+// Dynamic shapes are left alone.
+// CHECK-LABEL: func.func @dynamic(
+// TILE-LABEL: func.func @dynamic(
+func.func @dynamic(%A: memref<?x4096xf32>) {
+  // CHECK: linalg.fill
+  // TILE-NOT: scf.for
+  // TILE: linalg.fill
+  %c0 = arith.constant 0.0 : f32
+  linalg.fill ins(%c0 : f32) outs(%A : memref<?x4096xf32>)
+  return
+}
@@ -4,3 +4,11 @@
 func.func @myfunc(%arg0: memref<2x2xf32>, %arg1: memref<2x2xf32>) -> memref<2x2xf32> {
   return %arg0: memref<2x2xf32>
 }
+
+// -----
+
+func.func @dispatch_missing_dynamic_input() -> i64 {
+  // expected-error @below {{expected 1 dynamic inputs, but got 0}}
+  %0 = xsmm.ternary.dispatch matmul [-9223372036854775808, 32, 16, 16, 32, 32] (dataType f32)
+  return %0 : i64
+}
@@ -0,0 +1,35 @@
+// RUN: tpp-opt %s -convert-xsmm-ops-to-func | FileCheck %s
+
+// The function-level conversion calls the runtime functions already declared
+// in the module, and declares none of its own: each function is rewritten on
+// its own, in parallel.
+
+func.func private @xsmm_matmul_dispatch(i64, i64, i64, i64, i64, i64, i64) -> i64 attributes {llvm.emit_c_interface}
+func.func private @xsmm_matmul_invoke(i64, i64, memref<*xf32>, memref<*xf32>, memref<*xf32>) attributes {llvm.emit_c_interface}
+
+// CHECK-COUNT-1: func.func private @xsmm_matmul_dispatch(
+// CHECK-COUNT-1: func.func private @xsmm_matmul_invoke(
+
+// CHECK-LABEL: func.func @first(
+func.func @first(%arg0: memref<3x6xf32>, %arg1: memref<6x3xf32>,
+                 %arg2: memref<3x3xf32>) {
+  // CHECK: %[[DISPATCH:.+]] = call @xsmm_matmul_dispatch(
+  // CHECK: call @xsmm_matmul_invoke(%{{.+}}, %[[DISPATCH]], %{{.+}}, %{{.+}}, %{{.+}})
+  // CHECK-NOT: xsmm.
+  %0 = xsmm.ternary.dispatch matmul [3, 3, 6, 6, 3, 3] (dataType f32)
+  xsmm.ternary matmul(dataType f32, %0, %arg0, %arg1, %arg2) : (i64, memref<3x6xf32>, memref<6x3xf32>, memref<3x3xf32>) -> ()
+  return
+}
+
+// CHECK-LABEL: func.func @second(
+func.func @second(%arg0: memref<4x8xf32>, %arg1: memref<8x4xf32>,
+                  %arg2: memref<4x4xf32>) {
+  // CHECK: %[[DISPATCH:.+]] = call @xsmm_matmul_dispatch(
+  // CHECK: call @xsmm_matmul_invoke(%{{.+}}, %[[DISPATCH]], %{{.+}}, %{{.+}}, %{{.+}})
+  // CHECK-NOT: xsmm.
+  %0 = xsmm.ternary.dispatch matmul [4, 4, 8, 8, 4, 4] (dataType f32)
+  xsmm.ternary matmul(dataType f32, %0, %arg0, %arg1, %arg2) : (i64, memref<4x8xf32>, memref<8x4xf32>, memref<4x4xf32>) -> ()
+  return
+}
+
+// CHECK-NOT: func.func private @xsmm_
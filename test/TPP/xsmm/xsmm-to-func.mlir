@@ -19,3 +19,45 @@ func.func @dispatch_brgemm(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
   xsmm.ternary brgemm(dataType f32, %0, %arg0, %arg1, %arg2, %c2_i64) : (i64, memref<2x5x4xf32>, memref<2x4x5xf32>, memref<4x4xf32>, i64) -> ()
   return %arg2 : memref<4x4xf32>
 }
+
+// -----
+
+// The dynamic m (-9223372036854775808) is passed at runtime.
+// CHECK-LABEL: func.func @dispatch_dynamic_matmul(
+// CHECK-SAME: %[[M:.+]]: i64)
+func.func @dispatch_dynamic_matmul(%m: i64) -> i64 {
+  // CHECK: %[[DTYPE:.+]] = arith.constant 1 : i64
+  // CHECK: call @xsmm_matmul_dispatch(%[[DTYPE]], %[[M]], %{{.+}}, %{{.+}}, %{{.+}}, %{{.+}}, %{{.+}})
+  %0 = xsmm.ternary.dispatch matmul [-9223372036854775808, 32, 16, 16, 32, 32] dims(%m) (dataType f32)
+  return %0 : i64
+}
+
+// -----
+
+// The int8 invokes have their own runtime functions, the operands are i8 and
+// i32 memrefs.
+// CHECK: func.func private @xsmm_matmul_invoke_i8(i64, i64, memref<*xi8>, memref<*xi8>, memref<*xi32>) attributes {llvm.emit_c_interface}
+// CHECK-LABEL: func.func @invoke_quantized_matmul(
+func.func @invoke_quantized_matmul(%arg0: i64, %arg1: memref<16x64xi8>,
+                                   %arg2: memref<16x32x4xi8>,
+                                   %arg3: memref<16x32xi32>) {
+  // CHECK: %[[DTYPE:.+]] = arith.constant 9 : i64
+  // CHECK: call @xsmm_matmul_invoke_i8(%[[DTYPE]], %{{.+}}, %{{.+}}, %{{.+}}, %{{.+}})
+  xsmm.ternary matmul(dataType i8, %arg0, %arg1, %arg2, %arg3) : (i64, memref<16x64xi8>, memref<16x32x4xi8>, memref<16x32xi32>) -> ()
+  return
+}
+
+// -----
+
+// CHECK-DAG: func.func private @xsmm_sparse_brgemm_dispatch(i64, i64, i64, i64, i64, i64, i64) -> i64 attributes {llvm.emit_c_interface}
+// CHECK-DAG: func.func private @xsmm_sparse_brgemm_invoke(i64, i64, memref<*xf32>, memref<*xf32>, memref<*xi64>, memref<*xf32>, i64) attributes {llvm.emit_c_interface}
+// CHECK-LABEL: func.func @sparse_brgemm(
+func.func @sparse_brgemm(%arg0: memref<4x5x4xf32>, %arg1: memref<?x4x5xf32>,
+                         %arg2: memref<?xi64>, %arg3: memref<5x5xf32>,
+                         %arg4: i64) {
+  // CHECK: call @xsmm_sparse_brgemm_dispatch(
+  // CHECK: call @xsmm_sparse_brgemm_invoke(
+  %0 = xsmm.ternary.dispatch sparse_brgemm [5, 5, 4, 4, 5, 5] (dataType f32)
+  xsmm.ternary sparse_brgemm(dataType f32, %0, %arg0, %arg1, %arg2, %arg3, %arg4) : (i64, memref<4x5x4xf32>, memref<?x4x5xf32>, memref<?xi64>, memref<5x5xf32>, i64) -> ()
+  return
+}
@@ -34,6 +34,30 @@ config.substitutions.append(('%shlibext', config.llvm_shlib_ext))
 config.substitutions.append(('%llvmlibdir', config.llvm_lib_dir))
 config.substitutions.append(('%tpplibdir', config.tpp_obj_root + "/lib/"))
 
+# The OpenMP runtime, for tpp-run -parallel, if LLVM was built with it.
+omp_runtime = os.path.join(config.llvm_lib_dir, 'libomp' + config.llvm_shlib_ext)
+if os.path.exists(omp_runtime):
+    config.available_features.add('openmp')
+    config.substitutions.append(('%ompruntime', omp_runtime))
+
+# Huge pages for the runtime's large buffers: transparent ones on request, or
+# reserved hugetlbfs ones.
+def has_huge_pages():
+    try:
+        with open('/sys/kernel/mm/transparent_hugepage/enabled') as f:
+            if re.search(r'\[(always|madvise)\]', f.read()):
+                return True
+    except OSError:
+        pass
+    try:
+        with open('/proc/sys/vm/nr_hugepages') as f:
+            return int(f.read()) > 0
+    except (OSError, ValueError):
+        return False
+
+if has_huge_pages():
+    config.available_features.add('huge-pages')
+
 llvm_config.with_system_environment(
     ['HOME', 'INCLUDE', 'LIB', 'TMP', 'TEMP'])
 
@@ -54,7 +78,11 @@ llvm_config.with_environment('PATH', config.llvm_tools_dir, append_path=True)
 tool_dirs = [config.tpp_tools_dir, config.llvm_tools_dir]
 tools = [
     'tpp-opt',
-    'tpp-run'
+    'tpp-run',
+    'mlir-gen',
+    'tpp-engine-run',
+    'tpp-serve-bench',
+    'tpp-specialize-run'
 ]
 
 llvm_config.add_tool_substitutions(tools, tool_dirs)
@@ -0,0 +1,328 @@
+//===- TPPEngine.cpp - Execution engine for compiled TPP modules ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Embeds TPP compiled modules in a host application. A module is either JIT
+// compiled from MLIR or loaded from a shared library built ahead of time, its
+// public functions become entry points called on caller-owned buffers.
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPPEngine.h"
+
+#include "TPP/Dialect/Check/BufferizableOpInterfaceImpl.h"
+#include "TPP/Dialect/Check/CheckDialect.h"
+#include "TPP/Dialect/LinalgX/BufferizableOpInterfaceImpl.h"
+#include "TPP/Dialect/LinalgX/LinalgXDialect.h"
+#include "TPP/Dialect/Tpp/TppDialect.h"
+#include "TPP/Dialect/VNNI/VNNIDialect.h"
+#include "TPP/Dialect/Xsmm/XsmmDialect.h"
+#include "TPP/Passes.h"
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/InitAllDialects.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Target/LLVMIR/Dialect/All.h"
+
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/TargetSelect.h"
+
+#include <array>
+#include <utility>
+
+#define DEBUG_TYPE "tpp-engine"
+
+using namespace mlir;
+
+static_assert(sizeof(void *) == sizeof(int64_t),
+              "memref descriptors are built from 64-bit words");
+
+namespace {
+
+/// Module initializer created by -hoist-xsmm-dispatch
+constexpr llvm::StringLiteral kInitFnName = "tpp_init";
+
+/// Descriptor words inlined on the stack by EntryPoint::run, enough for 16
+/// arguments of rank 6
+constexpr unsigned kInlineWords = 256;
+
+llvm::Error makeError(const llvm::Twine &msg) {
+  return llvm::make_error<llvm::StringError>(msg,
+                                             llvm::inconvertibleErrorCode());
+}
+
+/// C interface functions take one pointer per memref descriptor
+template <size_t> using DescriptorPtr = void *;
+
+template <size_t... I>
+void callWithDescriptors(void *fn, void *const *descriptors,
+                         std::index_sequence<I...>) {
+  using Fn = void (*)(DescriptorPtr<I>...);
+  reinterpret_cast<Fn>(fn)(descriptors[I]...);
+}
+
+template <size_t N> void call(void *fn, void *const *descriptors) {
+  callWithDescriptors(fn, descriptors, std::make_index_sequence<N>());
+}
+
+template <size_t... N>
+constexpr std::array<void (*)(void *, void *const *), sizeof...(N)>
+makeCallers(std::index_sequence<N...>) {
+  return {{&call<N>...}};
+}
+
+/// Same registry as tpp-run
+void registerDialects(DialectRegistry &registry) {
+  registry.insert<mlir::tpp::TppDialect>();
+  registry.insert<mlir::xsmm::XsmmDialect>();
+  registry.insert<mlir::linalgx::LinalgXDialect>();
+  registry.insert<mlir::check::CheckDialect>();
+  registry.insert<mlir::vnni::VNNIDialect>();
+  mlir::linalgx::registerBufferizableOpInterfaceExternalModels(registry);
+  mlir::check::registerBufferizableOpInterfaceExternalModels(registry);
+  registerAllDialects(registry);
+  registerAllToLLVMIRTranslations(registry);
+}
+
+/// Argument of an entry point: statically shaped and dense, of integers or
+/// floats. Tensors bufferize to identity layout memrefs at the boundaries.
+Optional<TPPArgument> getArgument(Type type) {
+  auto shaped = type.dyn_cast<ShapedType>();
+  if (!shaped || !shaped.hasStaticShape() ||
+      !shaped.getElementType().isIntOrFloat())
+    return llvm::None;
+  if (auto memref = type.dyn_cast<MemRefType>())
+    if (!memref.getLayout().isIdentity())
+      return llvm::None;
+  TPPArgument argument;
+  argument.elementType = shaped.getElementType();
+  argument.shape.assign(shaped.getShape().begin(), shaped.getShape().end());
+  return argument;
+}
+
+/// Signatures of the public functions the engine can call. When 'annotate',
+/// marks them to be compiled with the C interface.
+void collectEntryPoints(ModuleOp module, llvm::StringMap<EntryPoint> &entries,
+                        bool annotate) {
+  for (auto func : module.getOps<func::FuncOp>()) {
+    if (func.isExternal() || func.isPrivate() || func.getName() == kInitFnName)
+      continue;
+    SmallVector<TPPArgument> arguments;
+    for (Type type : func.getArgumentTypes()) {
+      Optional<TPPArgument> argument = getArgument(type);
+      if (!argument)
+        break;
+      arguments.push_back(std::move(*argument));
+    }
+    if (arguments.size() != func.getNumArguments()) {
+      LLVM_DEBUG(llvm::dbgs() << "Not an entry point: " << func.getName()
+                              << "\n");
+      continue;
+    }
+    entries.try_emplace(func.getName(), EntryPoint(func.getName(), arguments));
+    if (annotate)
+      func->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                    UnitAttr::get(module.getContext()));
+  }
+}
+
+} // namespace
+
+//----------------------- TPPArgument
+
+int64_t TPPArgument::getSizeInBytes() const {
+  int64_t elements = 1;
+  for (int64_t dim : shape)
+    elements *= dim;
+  return elements * llvm::divideCeil(elementType.getIntOrFloatBitWidth(), 8);
+}
+
+//----------------------- EntryPoint
+
+EntryPoint::EntryPoint(llvm::StringRef name,
+                       llvm::ArrayRef<TPPArgument> arguments)
+    : name(name.str()), arguments(arguments.begin(), arguments.end()) {
+  // base, data, offset, sizes, strides; row major
+  for (const TPPArgument &argument : arguments) {
+    descriptorOffsets.push_back(descriptors.size());
+    descriptors.append({0, 0, 0});
+    descriptors.append(argument.shape.begin(), argument.shape.end());
+    SmallVector<int64_t> strides(argument.shape.size(), 1);
+    for (int64_t i = static_cast<int64_t>(strides.size()) - 2; i >= 0; i--)
+      strides[i] = strides[i + 1] * argument.shape[i + 1];
+    descriptors.append(strides.begin(), strides.end());
+  }
+}
+
+llvm::Error EntryPoint::run(llvm::ArrayRef<void *> buffers) const {
+  if (buffers.size() != arguments.size())
+    return makeError("'" + name + "' expects " +
+                     llvm::Twine(arguments.size()) + " buffers, got " +
+                     llvm::Twine(buffers.size()));
+
+  // Copy of the prepared descriptors, with the addresses of the buffers
+  SmallVector<int64_t, kInlineWords> words(descriptors.begin(),
+                                           descriptors.end());
+  void *args[kMaxArgs];
+  for (auto en : llvm::enumerate(buffers)) {
+    int64_t *descriptor = &words[descriptorOffsets[en.index()]];
+    descriptor[0] = descriptor[1] = reinterpret_cast<int64_t>(en.value());
+    args[en.index()] = descriptor;
+  }
+  caller(fn, args);
+  return llvm::Error::success();
+}
+
+//----------------------- TPPEngine
+
+TPPEngine::TPPEngine(const TPPEngineOptions &options)
+    : options(options),
+      pool(std::make_unique<llvm::ThreadPool>(
+          llvm::hardware_concurrency(options.numThreads))) {
+  DialectRegistry registry;
+  registerDialects(registry);
+  context = std::make_unique<MLIRContext>(registry);
+}
+
+TPPEngine::~TPPEngine() { pool->wait(); }
+
+llvm::Expected<std::unique_ptr<TPPEngine>>
+TPPEngine::compile(llvm::StringRef mlirFile, const TPPEngineOptions &options) {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  llvm::InitializeNativeTargetAsmParser();
+
+  std::unique_ptr<TPPEngine> engine(new TPPEngine(options));
+  OwningOpRef<ModuleOp> module =
+      parseSourceFile<ModuleOp>(mlirFile, engine->context.get());
+  if (!module)
+    return makeError("Cannot parse '" + mlirFile + "'");
+  collectEntryPoints(*module, engine->entryPoints, /*annotate=*/true);
+
+  // Kernels dispatched at load time. With pre-dispatch the pipeline also
+  // plans the buffers in arenas, before the huge page allocation, so that the
+  // calls are allocation free.
+  PassManager passManager(engine->context.get());
+  passManager.addPass(
+      tpp::createDefaultTppPass(options.aggressive, /*preDispatch=*/true,
+                                options.cacheDir));
+  tpp::addLLVMLoweringPasses(passManager, options.parallel);
+  if (failed(passManager.run(*module)))
+    return makeError("Cannot compile '" + mlirFile + "'");
+
+  // Results would be returned in new allocations, which we'd leak
+  for (const auto &entry : engine->entryPoints) {
+    auto llvmFunc = module->lookupSymbol<LLVM::LLVMFuncOp>(entry.getKey());
+    if (!llvmFunc || !llvmFunc.getFunctionType()
+                          .getReturnType()
+                          .isa<LLVM::LLVMVoidType>())
+      return makeError("Entry point '" + entry.getKey() +
+                       "' must write its results to its arguments");
+  }
+
+  llvm::SmallVector<llvm::StringRef> libs(options.sharedLibPaths.begin(),
+                                          options.sharedLibPaths.end());
+  ExecutionEngineOptions engineOptions;
+  engineOptions.transformer = makeOptimizingTransformer(
+      /*optLevel=*/3, /*sizeLevel=*/0, /*targetMachine=*/nullptr);
+  engineOptions.sharedLibPaths = libs;
+  auto jit = ExecutionEngine::create(*module, engineOptions);
+  if (!jit)
+    return jit.takeError();
+  engine->jit = std::move(*jit);
+
+  if (auto error = engine->initialize())
+    return std::move(error);
+  return std::move(engine);
+}
+
+llvm::Expected<std::unique_ptr<TPPEngine>>
+TPPEngine::load(llvm::StringRef sharedLib, llvm::StringRef mlirFile,
+                const TPPEngineOptions &options) {
+  std::unique_ptr<TPPEngine> engine(new TPPEngine(options));
+  OwningOpRef<ModuleOp> module =
+      parseSourceFile<ModuleOp>(mlirFile, engine->context.get());
+  if (!module)
+    return makeError("Cannot parse '" + mlirFile + "'");
+  collectEntryPoints(*module, engine->entryPoints, /*annotate=*/false);
+
+  // The runtime first, the module's symbols resolve against it
+  std::string message;
+  for (const std::string &lib : options.sharedLibPaths)
+    if (llvm::sys::DynamicLibrary::LoadLibraryPermanently(lib.c_str(),
+                                                          &message))
+      return makeError("Cannot load '" + lib + "': " + message);
+  engine->library = llvm::sys::DynamicLibrary::getPermanentLibrary(
+      sharedLib.str().c_str(), &message);
+  if (!engine->library.isValid())
+    return makeError("Cannot load '" + sharedLib + "': " + message);
+
+  if (auto error = engine->initialize())
+    return std::move(error);
+  return std::move(engine);
+}
+
+llvm::Expected<void *> TPPEngine::lookupSymbol(llvm::StringRef name) const {
+  if (jit)
+    return jit->lookup(name);
+  if (void *address = library.getAddressOfSymbol(name.str().c_str()))
+    return address;
+  return makeError("Symbol '" + name + "' not found");
+}
+
+llvm::Error TPPEngine::initialize() {
+  static constexpr auto kCallers =
+      makeCallers(std::make_index_sequence<EntryPoint::kMaxArgs + 1>());
+
+  for (auto &entry : entryPoints) {
+    EntryPoint &entryPoint = entry.getValue();
+    if (entryPoint.arguments.size() > EntryPoint::kMaxArgs)
+      return makeError("Entry point '" + entryPoint.name + "' has more than " +
+                       llvm::Twine(EntryPoint::kMaxArgs) + " arguments");
+    auto fn = lookupSymbol("_mlir_ciface_" + entryPoint.name);
+    if (!fn)
+      return fn.takeError();
+    entryPoint.fn = *fn;
+    entryPoint.caller = kCallers[entryPoint.arguments.size()];
+  }
+
+  // Modules without XSMM kernels have no initializer
+  auto init = lookupSymbol(("_mlir_ciface_" + kInitFnName).str());
+  if (!init) {
+    llvm::consumeError(init.takeError());
+    return llvm::Error::success();
+  }
+  reinterpret_cast<void (*)()>(*init)();
+  return llvm::Error::success();
+}
+
+const EntryPoint *TPPEngine::lookup(llvm::StringRef name) const {
+  auto it = entryPoints.find(name);
+  return it == entryPoints.end() ? nullptr : &it->getValue();
+}
+
+llvm::Error TPPEngine::run(llvm::StringRef name,
+                           llvm::ArrayRef<void *> buffers) const {
+  const EntryPoint *entryPoint = lookup(name);
+  if (!entryPoint)
+    return makeError("Entry point '" + name + "' not found");
+  return entryPoint->run(buffers);
+}
+
+void TPPEngine::runAsync(const EntryPoint &entryPoint,
+                         llvm::ArrayRef<void *> buffers,
+                         std::function<void(llvm::Error)> done) {
+  SmallVector<void *, 16> args(buffers.begin(), buffers.end());
+  pool->async([&entryPoint, args, done]() { done(entryPoint.run(args)); });
+}
+
+void TPPEngine::wait() { pool->wait(); }
@@ -0,0 +1,181 @@
+//===- TPPEngine.h - Execution engine for compiled TPP modules --*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Embeds TPP compiled modules in a host application. A module is either JIT
+// compiled from MLIR or loaded from a shared library built ahead of time, its
+// public functions become entry points called on caller-owned buffers. All
+// the XSMM kernels are dispatched when the module is loaded, the intermediate
+// buffers live in per-thread arenas, so that calls from any number of threads
+// only pay for the kernels themselves.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_ENGINE_TPPENGINE_H
+#define TPP_ENGINE_TPPENGINE_H
+
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Types.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace mlir {
+
+/// Options of the compilation and of the engine
+struct TPPEngineOptions {
+  /// Run the aggressive TPP pipeline (packing, BRGEMM)
+  bool aggressive = false;
+
+  /// Lower the parallel loops to OpenMP, kernels use all the cores
+  bool parallel = false;
+
+  /// Threads serving runAsync, 0 for one per hardware thread
+  unsigned numThreads = 0;
+
+  /// Libraries the kernels call into (tpp-rt, for the XSMM calls)
+  llvm::SmallVector<std::string> sharedLibPaths;
+
+  /// Directory caching the TPP pipeline's outputs, none if empty
+  std::string cacheDir;
+};
+
+/// Statically shaped argument of an entry point, a dense row-major buffer
+struct TPPArgument {
+  Type elementType;
+  llvm::SmallVector<int64_t> shape;
+
+  /// Size of the buffer the caller binds to it, in bytes
+  int64_t getSizeInBytes() const;
+};
+
+/// EntryPoint - A public function of a loaded module.
+///
+/// The function writes its results into its arguments, each of them bound to
+/// a caller-owned buffer without copy. The memref descriptors are prepared
+/// at load time, a call only patches in the buffer addresses, on the stack.
+class EntryPoint {
+  /// Maximum number of arguments of an entry point
+  static constexpr unsigned kMaxArgs = 16;
+
+  /// Calls a C interface function with N descriptors
+  using Caller = void (*)(void *fn, void *const *descriptors);
+
+  std::string name;
+
+  /// _mlir_ciface_<name>
+  void *fn = nullptr;
+
+  Caller caller = nullptr;
+
+  llvm::SmallVector<TPPArgument> arguments;
+
+  /// Memref descriptors of all the arguments, back to back, in 64-bit words:
+  /// base, data, offset, sizes, strides. The addresses are left null.
+  llvm::SmallVector<int64_t> descriptors;
+
+  /// Position of each argument's descriptor in 'descriptors'
+  llvm::SmallVector<unsigned> descriptorOffsets;
+
+  friend class TPPEngine;
+
+public:
+  EntryPoint(llvm::StringRef name, llvm::ArrayRef<TPPArgument> arguments);
+
+  llvm::StringRef getName() const { return name; }
+  llvm::ArrayRef<TPPArgument> getArguments() const { return arguments; }
+
+  /// Calls the function with one buffer per argument, in order. Thread safe,
+  /// does not allocate.
+  llvm::Error run(llvm::ArrayRef<void *> buffers) const;
+
+  /// Same as run, checking the element size of each buffer
+  template <typename... Ts> llvm::Error operator()(Ts *...buffers) const {
+    const unsigned bitWidths[] = {sizeof(Ts) * 8 ...};
+    void *const ptrs[] = {static_cast<void *>(buffers)...};
+    for (unsigned i = 0, e = std::min<unsigned>(sizeof...(Ts),
+                                                 arguments.size());
+         i < e; i++)
+      if (arguments[i].elementType.getIntOrFloatBitWidth() != bitWidths[i])
+        return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                       "Element size mismatch on argument %u",
+                                       i);
+    return run(ptrs);
+  }
+};
+
+/// TPPEngine - Owns a loaded module and the threads serving it.
+///
+/// Loading compiles (or maps) the module, calls its initializer, which
+/// dispatches every XSMM kernel, and resolves the entry points. After that
+/// the engine is immutable: entry points can be called concurrently from any
+/// thread. Each thread gets its own arena for the intermediate buffers, the
+/// first call on a thread allocates it, later calls don't allocate.
+class TPPEngine {
+  TPPEngineOptions options;
+
+  /// Signatures and, for the JIT, the IR of the module
+  std::unique_ptr<MLIRContext> context;
+
+  /// JIT compiled module, if not loaded from a shared library
+  std::unique_ptr<ExecutionEngine> jit;
+
+  /// Module compiled ahead of time, if not JIT compiled
+  llvm::sys::DynamicLibrary library;
+
+  llvm::StringMap<EntryPoint> entryPoints;
+
+  /// Serves runAsync
+  std::unique_ptr<llvm::ThreadPool> pool;
+
+  explicit TPPEngine(const TPPEngineOptions &options);
+
+  /// Address of a symbol of the loaded module
+  llvm::Expected<void *> lookupSymbol(llvm::StringRef name) const;
+
+  /// Resolves the entry points and runs the module initializer
+  llvm::Error initialize();
+
+public:
+  /// JIT compiles an MLIR file through the TPP pipeline
+  static llvm::Expected<std::unique_ptr<TPPEngine>>
+  compile(llvm::StringRef mlirFile, const TPPEngineOptions &options = {});
+
+  /// Loads a module compiled ahead of time to a shared library, with the
+  /// MLIR it was compiled from for the signatures of the entry points
+  static llvm::Expected<std::unique_ptr<TPPEngine>>
+  load(llvm::StringRef sharedLib, llvm::StringRef mlirFile,
+       const TPPEngineOptions &options = {});
+
+  ~TPPEngine();
+
+  /// Entry point by name, null if the module has none
+  const EntryPoint *lookup(llvm::StringRef name) const;
+
+  /// Calls an entry point on the calling thread
+  llvm::Error run(llvm::StringRef name, llvm::ArrayRef<void *> buffers) const;
+
+  /// Queues a call on the engine's threads, 'done' gets its result there
+  void runAsync(const EntryPoint &entryPoint, llvm::ArrayRef<void *> buffers,
+                std::function<void(llvm::Error)> done);
+
+  /// Waits for all the queued calls
+  void wait();
+};
+
+} // namespace mlir
+
+#endif // TPP_ENGINE_TPPENGINE_H
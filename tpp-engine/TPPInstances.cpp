@@ -0,0 +1,177 @@
+//===- TPPInstances.cpp - Independent instances of an entry point ---------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Serves an entry point with K independent instances on disjoint cores, each
+// with its own thread, arena and copy of the weights.
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPPInstances.h"
+
+#include "NumaRunnerUtils.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MemAlloc.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace mlir;
+
+/// Alignment of the weight copies, in bytes
+static constexpr size_t kAlignment = 64;
+
+static llvm::Error makeError(const llvm::Twine &msg) {
+  return llvm::make_error<llvm::StringError>(msg,
+                                             llvm::inconvertibleErrorCode());
+}
+
+TPPInstances::TPPInstances(const EntryPoint &entryPoint,
+                           const TPPInstancesOptions &options)
+    : entryPoint(entryPoint), options(options) {}
+
+llvm::Expected<std::unique_ptr<TPPInstances>>
+TPPInstances::create(const EntryPoint &entryPoint,
+                     llvm::ArrayRef<const void *> weights,
+                     const TPPInstancesOptions &options) {
+  llvm::ArrayRef<TPPArgument> arguments = entryPoint.getArguments();
+  if (options.numInstances == 0)
+    return makeError("Expected at least one instance");
+  if (weights.size() != options.weightArgs.size())
+    return makeError("Expected " + llvm::Twine(options.weightArgs.size()) +
+                     " weights, got " + llvm::Twine(weights.size()));
+
+  std::unique_ptr<TPPInstances> pool(new TPPInstances(entryPoint, options));
+  for (unsigned arg : options.weightArgs) {
+    if (arg >= arguments.size())
+      return makeError("'" + entryPoint.getName() + "' has no argument " +
+                       llvm::Twine(arg));
+    pool->weightSizes.push_back(arguments[arg].getSizeInBytes());
+  }
+
+  // Contiguous blocks of CPUs, the first ones get the remainder
+  int64_t numCpus = _mlir_ciface_tpp_num_cpus();
+  int64_t numInstances = options.numInstances;
+  int64_t firstCpu = 0;
+  for (int64_t i = 0; i < numInstances; i++) {
+    auto instance = std::make_unique<Instance>();
+    instance->firstCpu = firstCpu;
+    instance->numCpus =
+        std::max<int64_t>(1, numCpus / numInstances +
+                                 (i < numCpus % numInstances ? 1 : 0));
+    firstCpu = (firstCpu + instance->numCpus) % numCpus;
+    pool->instances.push_back(std::move(instance));
+  }
+
+  TPPInstances *self = pool.get();
+  for (auto &instance : pool->instances) {
+    Instance *ptr = instance.get();
+    ptr->thread = std::thread([self, ptr]() { self->serve(*ptr); });
+  }
+
+  // Copies made by the instances' threads, which first touch them
+  for (unsigned i = 0; i < pool->size(); i++) {
+    Instance *instance = pool->instances[i].get();
+    pool->post(i, [self, instance, weights]() {
+      for (auto en : llvm::enumerate(weights)) {
+        int64_t size = self->weightSizes[en.index()];
+        void *copy = llvm::allocate_buffer(size, kAlignment);
+        std::memcpy(copy, en.value(), size);
+        instance->weights.push_back(copy);
+      }
+    });
+  }
+  pool->wait();
+  return std::move(pool);
+}
+
+TPPInstances::~TPPInstances() {
+  for (auto &instance : instances) {
+    {
+      std::lock_guard<std::mutex> lock(instance->mutex);
+      instance->stop = true;
+    }
+    instance->wakeUp.notify_one();
+  }
+  for (auto &instance : instances) {
+    instance->thread.join();
+    for (auto en : llvm::enumerate(instance->weights))
+      llvm::deallocate_buffer(en.value(), weightSizes[en.index()],
+                              kAlignment);
+  }
+}
+
+void TPPInstances::serve(Instance &instance) {
+  if (options.pin)
+    (void)_mlir_ciface_tpp_cpu_bind(instance.firstCpu, instance.numCpus);
+
+  std::unique_lock<std::mutex> lock(instance.mutex);
+  while (true) {
+    instance.wakeUp.wait(
+        lock, [&]() { return instance.stop || !instance.tasks.empty(); });
+    if (instance.tasks.empty())
+      return;
+    std::function<void()> task = std::move(instance.tasks.front());
+    instance.tasks.pop_front();
+    instance.busy = true;
+    lock.unlock();
+    task();
+    lock.lock();
+    instance.busy = false;
+    if (instance.tasks.empty())
+      instance.idle.notify_all();
+  }
+}
+
+llvm::Error TPPInstances::run(unsigned instance,
+                              llvm::ArrayRef<void *> activations) const {
+  unsigned numArgs = entryPoint.getArguments().size();
+  if (activations.size() + options.weightArgs.size() != numArgs)
+    return makeError("'" + entryPoint.getName() + "' expects " +
+                     llvm::Twine(numArgs - options.weightArgs.size()) +
+                     " activations, got " + llvm::Twine(activations.size()));
+
+  // Weights in their positions, activations in the others
+  llvm::SmallVector<void *, 16> buffers;
+  const Instance &self = *instances[instance];
+  auto activation = activations.begin();
+  for (unsigned arg = 0; arg < numArgs; arg++) {
+    auto *weight = llvm::find(options.weightArgs, arg);
+    if (weight != options.weightArgs.end())
+      buffers.push_back(self.weights[weight - options.weightArgs.begin()]);
+    else
+      buffers.push_back(*activation++);
+  }
+  return entryPoint.run(buffers);
+}
+
+void TPPInstances::post(unsigned instance, std::function<void()> task) {
+  Instance &self = *instances[instance];
+  {
+    std::lock_guard<std::mutex> lock(self.mutex);
+    self.tasks.push_back(std::move(task));
+  }
+  self.wakeUp.notify_one();
+}
+
+void TPPInstances::submit(unsigned instance,
+                          llvm::ArrayRef<void *> activations,
+                          std::function<void(llvm::Error)> done) {
+  llvm::SmallVector<void *, 16> args(activations.begin(), activations.end());
+  post(instance, [this, instance, args, done]() {
+    done(run(instance, args));
+  });
+}
+
+void TPPInstances::wait() {
+  for (auto &instance : instances) {
+    std::unique_lock<std::mutex> lock(instance->mutex);
+    instance->idle.wait(
+        lock, [&]() { return instance->tasks.empty() && !instance->busy; });
+  }
+}
@@ -0,0 +1,125 @@
+//===- TPPInstances.h - Independent instances of an entry point -*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Serves an entry point with K independent instances on disjoint cores. For
+// small batches, several instances each using a few cores get more
+// throughput than one instance using all of them: the kernels are too small
+// to scale across the whole machine, and the instances don't share caches,
+// memory bandwidth or weights across sockets.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_ENGINE_TPPINSTANCES_H
+#define TPP_ENGINE_TPPINSTANCES_H
+
+#include "TPPEngine.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Error.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace mlir {
+
+/// Options of the instances
+struct TPPInstancesOptions {
+  /// Number of instances
+  unsigned numInstances = 1;
+
+  /// Positions of the arguments holding the weights: read only, and copied
+  /// once per instance. The other arguments are the activations, given on
+  /// each call.
+  llvm::SmallVector<unsigned> weightArgs;
+
+  /// Bind each instance to its share of the CPUs
+  bool pin = true;
+};
+
+/// TPPInstances - K instances of an entry point, each on its own thread.
+///
+/// Instance i runs on a thread bound to the i-th of K contiguous blocks of
+/// the process' CPUs (with OpenMP, set OMP_NUM_THREADS to the block size so
+/// that its parallel regions stay on them). The thread owns the instance's
+/// arena and, since it copies them, first touches its weights: both are in
+/// the memory of the node the instance runs on.
+class TPPInstances {
+  struct Instance {
+    /// CPUs of the instance, in the process' CPU order
+    int64_t firstCpu = 0;
+    int64_t numCpus = 0;
+
+    /// Copy of each weight, in the order of TPPInstancesOptions::weightArgs
+    llvm::SmallVector<void *> weights;
+
+    /// Tasks to run on the instance's thread
+    std::deque<std::function<void()>> tasks;
+    bool busy = false;
+    bool stop = false;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable idle;
+
+    std::thread thread;
+  };
+
+  const EntryPoint &entryPoint;
+
+  TPPInstancesOptions options;
+
+  /// Size in bytes of each weight
+  llvm::SmallVector<int64_t> weightSizes;
+
+  llvm::SmallVector<std::unique_ptr<Instance>> instances;
+
+  TPPInstances(const EntryPoint &entryPoint,
+               const TPPInstancesOptions &options);
+
+  /// Body of an instance's thread
+  void serve(Instance &instance);
+
+public:
+  /// Starts the instances and gives each of them a copy of the weights, one
+  /// buffer per weight argument
+  static llvm::Expected<std::unique_ptr<TPPInstances>>
+  create(const EntryPoint &entryPoint, llvm::ArrayRef<const void *> weights,
+         const TPPInstancesOptions &options);
+
+  /// Stops the threads once their tasks are done and frees the weights
+  ~TPPInstances();
+
+  unsigned size() const { return instances.size(); }
+
+  /// Number of CPUs of an instance
+  int64_t getNumCpus(unsigned instance) const {
+    return instances[instance]->numCpus;
+  }
+
+  /// Calls the entry point with the weights of 'instance' and the given
+  /// activations, in argument order, on the calling thread
+  llvm::Error run(unsigned instance, llvm::ArrayRef<void *> activations) const;
+
+  /// Queues 'task' on the thread of 'instance'
+  void post(unsigned instance, std::function<void()> task);
+
+  /// Queues a call on the thread of 'instance', 'done' gets its result there
+  void submit(unsigned instance, llvm::ArrayRef<void *> activations,
+              std::function<void(llvm::Error)> done);
+
+  /// Waits for the tasks of all the instances
+  void wait();
+};
+
+} // namespace mlir
+
+#endif // TPP_ENGINE_TPPINSTANCES_H
@@ -0,0 +1,246 @@
+//===- tpp-engine-run.cpp - Compile and run a module with TPPEngine -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Compiles a module with TPPEngine, possibly several times, and calls one of
+// its entry points several times on each engine. The f32 arguments are reset
+// to the same values before each call, and the checksum of the last argument
+// is printed after it: all the lines must agree. Used by the tests, to check
+// that the engine's arenas and pre-dispatched kernels are reusable.
+//
+// With -instances=K, the calls go through TPPInstances instead: each of the K
+// instances gets its copy of the -weights arguments and runs on its own
+// thread, with its own activations.
+//
+// Usage: tpp-engine-run kernel.mlir -entry=name -compiles=2 -runs=2
+//                       [-instances=2 -weights=1]
+//                       -shared-libs=libtpp_c_runner_utils.so
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPPEngine.h"
+#include "TPPInstances.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemAlloc.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <atomic>
+
+using namespace mlir;
+
+static llvm::cl::opt<std::string> inputFile(llvm::cl::Positional,
+                                            llvm::cl::desc("<input file>"),
+                                            llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    entryName("entry", llvm::cl::desc("The kernel to run"),
+              llvm::cl::init("entry"));
+
+static llvm::cl::opt<unsigned>
+    compiles("compiles", llvm::cl::desc("Engines compiled from the module"),
+             llvm::cl::init(2));
+
+static llvm::cl::opt<unsigned> runs("runs",
+                                    llvm::cl::desc("Calls on each engine"),
+                                    llvm::cl::init(2));
+
+static llvm::cl::opt<unsigned>
+    numInstances("instances",
+                 llvm::cl::desc("Run through TPPInstances, with this many "
+                                "instances (0: call the engine directly)"),
+                 llvm::cl::init(0));
+
+static llvm::cl::list<unsigned>
+    weightArgs("weights",
+               llvm::cl::desc("Arguments holding the weights, copied to each "
+                              "instance"),
+               llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<bool>
+    aggressive("aggressive", llvm::cl::desc("Pack matmuls to BRGEMM"),
+               llvm::cl::init(false));
+
+static llvm::cl::opt<std::string>
+    cacheDir("cache-dir",
+             llvm::cl::desc("Directory caching the TPP pipeline's outputs"),
+             llvm::cl::init(""));
+
+static llvm::cl::list<std::string>
+    sharedLibs("shared-libs",
+               llvm::cl::desc("Libraries to link the kernel against"),
+               llvm::cl::CommaSeparated);
+
+/// Alignment of the buffers, in bytes
+static constexpr size_t kAlignment = 64;
+
+/// Deterministic inputs, small multiples of 1/8 that are exact in f32
+static void fill(float *buffer, int64_t elements, unsigned arg) {
+  for (int64_t i = 0; i < elements; i++)
+    buffer[i] = static_cast<float>((i + arg) % 8) / 8.0f;
+}
+
+/// Checksum of a buffer
+static double sum(const void *buffer, int64_t bytes) {
+  const float *data = static_cast<const float *>(buffer);
+  double result = 0;
+  for (int64_t i = 0, e = bytes / sizeof(float); i < e; i++)
+    result += data[i];
+  return result;
+}
+
+/// Runs the entry point on each of the instances, with the same inputs as the
+/// direct calls, and prints the checksums in order
+static int runInstances(const EntryPoint &entryPoint, unsigned compile) {
+  llvm::ArrayRef<TPPArgument> arguments = entryPoint.getArguments();
+  if (llvm::is_contained(weightArgs, arguments.size() - 1)) {
+    llvm::errs() << "ERROR: The last argument is the output, not a weight\n";
+    return 1;
+  }
+
+  // The instances copy the weights when they start
+  llvm::SmallVector<void *> weights;
+  for (unsigned arg : weightArgs) {
+    if (arg >= arguments.size()) {
+      llvm::errs() << "ERROR: No argument " << arg << "\n";
+      return 1;
+    }
+    int64_t size = arguments[arg].getSizeInBytes();
+    weights.push_back(llvm::allocate_buffer(size, kAlignment));
+    fill(static_cast<float *>(weights.back()), size / sizeof(float), arg);
+  }
+  TPPInstancesOptions options;
+  options.numInstances = numInstances;
+  options.weightArgs.assign(weightArgs.begin(), weightArgs.end());
+  llvm::SmallVector<const void *> weightPtrs(weights.begin(), weights.end());
+  auto instances = TPPInstances::create(entryPoint, weightPtrs, options);
+  for (auto en : llvm::enumerate(weights))
+    llvm::deallocate_buffer(
+        en.value(), arguments[weightArgs[en.index()]].getSizeInBytes(),
+        kAlignment);
+  if (!instances) {
+    llvm::errs() << "ERROR: " << llvm::toString(instances.takeError())
+                 << "\n";
+    return 1;
+  }
+
+  // All the instances at once, each on its thread with its activations
+  llvm::SmallVector<double> sums(numInstances * runs);
+  std::atomic<bool> failed(false);
+  for (unsigned i = 0; i < numInstances; i++) {
+    (*instances)->post(i, [&, i]() {
+      llvm::SmallVector<unsigned> activationArgs;
+      llvm::SmallVector<void *> activations;
+      for (unsigned arg = 0; arg < arguments.size(); arg++) {
+        if (llvm::is_contained(weightArgs, arg))
+          continue;
+        activationArgs.push_back(arg);
+        activations.push_back(llvm::allocate_buffer(
+            arguments[arg].getSizeInBytes(), kAlignment));
+      }
+      for (unsigned r = 0; r < runs && !failed; r++) {
+        for (auto en : llvm::enumerate(activations)) {
+          unsigned arg = activationArgs[en.index()];
+          fill(static_cast<float *>(en.value()),
+               arguments[arg].getSizeInBytes() / sizeof(float), arg);
+        }
+        if (auto error = (*instances)->run(i, activations)) {
+          llvm::errs() << "ERROR: " << llvm::toString(std::move(error))
+                       << "\n";
+          failed = true;
+          break;
+        }
+        sums[i * runs + r] =
+            sum(activations.back(), arguments.back().getSizeInBytes());
+      }
+      for (auto en : llvm::enumerate(activations))
+        llvm::deallocate_buffer(
+            en.value(),
+            arguments[activationArgs[en.index()]].getSizeInBytes(),
+            kAlignment);
+    });
+  }
+  (*instances)->wait();
+  if (failed)
+    return 1;
+
+  for (unsigned i = 0; i < numInstances; i++)
+    for (unsigned r = 0; r < runs; r++)
+      llvm::outs() << llvm::format("compile %u instance %u run %u: sum %e\n",
+                                   compile, i, r, sums[i * runs + r]);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv, "TPP engine runner\n");
+
+  TPPEngineOptions engineOptions;
+  engineOptions.aggressive = aggressive;
+  engineOptions.cacheDir = cacheDir;
+  engineOptions.sharedLibPaths.assign(sharedLibs.begin(), sharedLibs.end());
+
+  for (unsigned c = 0; c < compiles; c++) {
+    auto engine = TPPEngine::compile(inputFile, engineOptions);
+    if (!engine) {
+      llvm::errs() << "ERROR: " << llvm::toString(engine.takeError()) << "\n";
+      return 1;
+    }
+    const EntryPoint *entryPoint = (*engine)->lookup(entryName);
+    if (!entryPoint) {
+      llvm::errs() << "ERROR: Entry point '" << entryName << "' not found\n";
+      return 1;
+    }
+
+    llvm::ArrayRef<TPPArgument> arguments = entryPoint->getArguments();
+    if (arguments.empty()) {
+      llvm::errs() << "ERROR: Entry point '" << entryName
+                   << "' has no arguments\n";
+      return 1;
+    }
+    for (const TPPArgument &argument : arguments) {
+      if (!argument.elementType.isF32()) {
+        llvm::errs() << "ERROR: Only f32 arguments are supported\n";
+        return 1;
+      }
+    }
+    if (numInstances) {
+      if (int status = runInstances(*entryPoint, c))
+        return status;
+      continue;
+    }
+
+    llvm::SmallVector<void *> buffers;
+    for (const TPPArgument &argument : arguments)
+      buffers.push_back(
+          llvm::allocate_buffer(argument.getSizeInBytes(), kAlignment));
+
+    int status = 0;
+    for (unsigned r = 0; r < runs && !status; r++) {
+      for (auto en : llvm::enumerate(arguments))
+        fill(static_cast<float *>(buffers[en.index()]),
+             en.value().getSizeInBytes() / sizeof(float), en.index());
+      if (auto error = entryPoint->run(buffers)) {
+        llvm::errs() << "ERROR: " << llvm::toString(std::move(error)) << "\n";
+        status = 1;
+        break;
+      }
+      llvm::outs() << llvm::format(
+          "compile %u run %u: sum %e\n", c, r,
+          sum(buffers.back(), arguments.back().getSizeInBytes()));
+    }
+
+    for (auto en : llvm::enumerate(arguments))
+      llvm::deallocate_buffer(buffers[en.index()],
+                              en.value().getSizeInBytes(), kAlignment);
+    if (status)
+      return status;
+  }
+  return 0;
+}
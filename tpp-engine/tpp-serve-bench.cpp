@@ -0,0 +1,209 @@
+//===- tpp-serve-bench.cpp - Throughput of independent instances ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Finds the best partitioning of the machine to serve a kernel. For each
+// number of instances K, runs K independent instances of the kernel on
+// disjoint blocks of CPUs, all at once, and reports:
+//  * latency: average time of a call on an instance;
+//  * throughput: calls per second, over all the instances;
+//  * speedup: throughput over the throughput of the first K.
+//
+// Usage: tpp-serve-bench kernel.mlir -entry=name -instances=1,2,4,8
+//                        -weights=1,2 -shared-libs=libtpp_c_runner_utils.so
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPPEngine.h"
+#include "TPPInstances.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemAlloc.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace mlir;
+
+static llvm::cl::opt<std::string> inputFile(llvm::cl::Positional,
+                                            llvm::cl::desc("<input file>"),
+                                            llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    entryName("entry", llvm::cl::desc("The kernel to serve"),
+              llvm::cl::init("entry"));
+
+static llvm::cl::list<unsigned>
+    numInstances("instances",
+                 llvm::cl::desc("Numbers of instances to measure"),
+                 llvm::cl::CommaSeparated);
+
+static llvm::cl::list<unsigned>
+    weightArgs("weights",
+               llvm::cl::desc("Arguments holding the weights, copied to each "
+                              "instance"),
+               llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<unsigned>
+    iterations("iterations", llvm::cl::desc("Calls per instance"),
+               llvm::cl::init(100));
+
+static llvm::cl::opt<unsigned>
+    warmup("warmup", llvm::cl::desc("Calls per instance before timing"),
+           llvm::cl::init(10));
+
+static llvm::cl::opt<bool>
+    aggressive("aggressive", llvm::cl::desc("Pack matmuls to BRGEMM"),
+               llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+    parallel("parallel",
+             llvm::cl::desc("Lower the parallel loops to OpenMP (set "
+                            "OMP_NUM_THREADS to the CPUs per instance)"),
+             llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+    pin("pin", llvm::cl::desc("Bind each instance to its share of the CPUs"),
+        llvm::cl::init(true));
+
+static llvm::cl::list<std::string>
+    sharedLibs("shared-libs",
+               llvm::cl::desc("Libraries to link the kernel against"),
+               llvm::cl::CommaSeparated);
+
+/// Alignment of the benchmark's buffers, in bytes
+static constexpr size_t kAlignment = 64;
+
+/// A zero-initialized buffer per argument, which the constructing thread
+/// first touches
+struct Buffers {
+  llvm::SmallVector<void *> data;
+  llvm::SmallVector<int64_t> sizes;
+
+  explicit Buffers(llvm::ArrayRef<int64_t> sizes)
+      : sizes(sizes.begin(), sizes.end()) {
+    for (int64_t size : sizes) {
+      void *buffer = llvm::allocate_buffer(size, kAlignment);
+      std::memset(buffer, 0, size);
+      data.push_back(buffer);
+    }
+  }
+
+  ~Buffers() {
+    for (auto en : llvm::enumerate(data))
+      llvm::deallocate_buffer(en.value(), sizes[en.index()], kAlignment);
+  }
+};
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "TPP multi-instance serving benchmark\n");
+
+  TPPEngineOptions engineOptions;
+  engineOptions.aggressive = aggressive;
+  engineOptions.parallel = parallel;
+  engineOptions.sharedLibPaths.assign(sharedLibs.begin(), sharedLibs.end());
+  auto engine = TPPEngine::compile(inputFile, engineOptions);
+  if (!engine) {
+    llvm::errs() << "ERROR: " << llvm::toString(engine.takeError()) << "\n";
+    return 1;
+  }
+  const EntryPoint *entryPoint = (*engine)->lookup(entryName);
+  if (!entryPoint) {
+    llvm::errs() << "ERROR: Entry point '" << entryName << "' not found\n";
+    return 1;
+  }
+
+  // Weights and activations, by argument order
+  llvm::SmallVector<int64_t> weightSizes, activationSizes;
+  for (auto en : llvm::enumerate(entryPoint->getArguments())) {
+    bool isWeight = llvm::is_contained(weightArgs, en.index());
+    (isWeight ? weightSizes : activationSizes)
+        .push_back(en.value().getSizeInBytes());
+  }
+  Buffers weights(weightSizes);
+  llvm::SmallVector<const void *> weightPtrs(weights.data.begin(),
+                                             weights.data.end());
+
+  llvm::SmallVector<unsigned> counts(numInstances.begin(), numInstances.end());
+  if (counts.empty())
+    counts = {1};
+
+  llvm::outs() << llvm::format("%9s %6s %14s %14s %8s\n", "instances",
+                               "cpus", "latency (ms)", "calls/s",
+                               "speedup");
+  double baseline = 0;
+  for (unsigned count : counts) {
+    TPPInstancesOptions options;
+    options.numInstances = count;
+    options.weightArgs.assign(weightArgs.begin(), weightArgs.end());
+    options.pin = pin;
+    auto instances = TPPInstances::create(*entryPoint, weightPtrs, options);
+    if (!instances) {
+      llvm::errs() << "ERROR: " << llvm::toString(instances.takeError())
+                   << "\n";
+      return 1;
+    }
+
+    // Each instance allocates its activations, warms up, then waits for the
+    // others so that the timed calls run concurrently
+    std::atomic<unsigned> ready(0);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> totalNs(0);
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<int64_t> startNs(0);
+    for (unsigned i = 0; i < count; i++) {
+      (*instances)->post(i, [&, i]() {
+        Buffers activations(activationSizes);
+        auto run = [&]() {
+          if (auto error = (*instances)->run(i, activations.data)) {
+            llvm::errs() << "ERROR: " << llvm::toString(std::move(error))
+                         << "\n";
+            failed = true;
+          }
+        };
+        for (unsigned it = 0; it < warmup; it++)
+          run();
+        if (++ready == count)
+          startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        while (ready != count)
+          std::this_thread::yield();
+
+        auto begin = std::chrono::steady_clock::now();
+        for (unsigned it = 0; it < iterations; it++)
+          run();
+        totalNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+      });
+    }
+    (*instances)->wait();
+    auto wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count() -
+                  startNs;
+    if (failed)
+      return 1;
+
+    double latencyMs = 1e-6 * totalNs / (double(count) * iterations);
+    double throughput = 1e9 * double(count) * iterations / wallNs;
+    if (baseline == 0)
+      baseline = throughput;
+    llvm::outs() << llvm::format("%9u %6ld %14.3f %14.1f %8.2f\n", count,
+                                 (long)(*instances)->getNumCpus(0), latencyMs,
+                                 throughput, throughput / baseline);
+  }
+  return 0;
+}
@@ -13,7 +13,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "CheckRunnerUtils.h"
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <vector>
 
 extern "C" void _mlir_ciface_expect_almost_equals(UnrankedMemRefType<float> *A,
                                                   UnrankedMemRefType<float> *B,
@@ -47,3 +50,125 @@ extern "C" void _mlir_ciface_expect_almost_equals(UnrankedMemRefType<float> *A,
 extern "C" void _mlir_ciface_expect_true(int A) {
   assert(A == 1 && "Result mismatch");
 }
+
+extern "C" bool _mlir_ciface_print_error_stats(UnrankedMemRefType<float> *A,
+                                               UnrankedMemRefType<float> *B,
+                                               float threshold,
+                                               float relThreshold) {
+  DynamicMemRefType<float> result = DynamicMemRefType<float>(*A);
+  DynamicMemRefType<float> reference = DynamicMemRefType<float>(*B);
+  assert(result.rank == reference.rank && "Rank mismatch");
+
+  int64_t numElements = 1;
+  for (int64_t i = 0; i < result.rank; i++) {
+    assert(result.sizes[i] == reference.sizes[i] && "Shape mismatch");
+    numElements *= result.sizes[i];
+  }
+
+  // Walk both memrefs in logical order, as their strides may differ.
+  std::vector<int64_t> indices(result.rank, 0);
+  float maxAbsError = 0.0f;
+  float maxRelError = 0.0f;
+  bool pass = true;
+  for (int64_t n = 0; n < numElements; n++) {
+    int64_t offsetA = result.offset;
+    int64_t offsetB = reference.offset;
+    for (int64_t i = 0; i < result.rank; i++) {
+      offsetA += indices[i] * result.strides[i];
+      offsetB += indices[i] * reference.strides[i];
+    }
+    float expected = reference.data[offsetB];
+    float absError = std::fabs(result.data[offsetA] - expected);
+    // NaNs always count as errors.
+    if (absError != absError)
+      absError = INFINITY;
+    float relError = expected != 0.0f ? absError / std::fabs(expected)
+                                      : absError;
+    if (absError > maxAbsError)
+      maxAbsError = absError;
+    if (relError > maxRelError)
+      maxRelError = relError;
+    // Large values are allowed a proportionally larger error.
+    if (!(absError <= threshold + relThreshold * std::fabs(expected)))
+      pass = false;
+
+    // Next index, innermost dimension first.
+    for (int64_t i = result.rank - 1; i >= 0; i--) {
+      if (++indices[i] < result.sizes[i])
+        break;
+      indices[i] = 0;
+    }
+  }
+
+  printf("Verification: %s (max abs error: %e, max rel error: %e)\n",
+         pass ? "PASS" : "FAIL", maxAbsError, maxRelError);
+  fflush(stdout);
+  return pass;
+}
+
+extern "C" void _mlir_ciface_print_checksum(UnrankedMemRefType<float> *A) {
+  DynamicMemRefType<float> memref = DynamicMemRefType<float>(*A);
+
+  // Rank-0 memrefs are a single element.
+  int64_t numElements = 1;
+  for (int64_t i = 0; i < memref.rank; i++)
+    numElements *= memref.sizes[i];
+  int64_t innerSize = memref.rank ? memref.sizes[memref.rank - 1] : 1;
+  int64_t innerStride = memref.rank ? memref.strides[memref.rank - 1] : 1;
+  int64_t numRows = innerSize ? numElements / innerSize : 0;
+
+  // Each lane accumulates the elements at the same position modulo kLanes
+  // along the innermost dimension, which the compiler can vectorize. Lanes are
+  // combined in a fixed order at the end, to keep the result order-stable.
+  const int kLanes = 8;
+  double sum[kLanes], sumSq[kLanes];
+  float max[kLanes];
+  for (int l = 0; l < kLanes; l++) {
+    sum[l] = 0.0;
+    sumSq[l] = 0.0;
+    max[l] = -INFINITY;
+  }
+
+  std::vector<int64_t> indices(memref.rank ? memref.rank - 1 : 0, 0);
+  for (int64_t r = 0; r < numRows; r++) {
+    int64_t offset = memref.offset;
+    for (size_t i = 0; i < indices.size(); i++)
+      offset += indices[i] * memref.strides[i];
+    const float *row = memref.data + offset;
+
+    int64_t j = 0;
+    for (; j + kLanes <= innerSize; j += kLanes) {
+      for (int l = 0; l < kLanes; l++) {
+        float value = row[(j + l) * innerStride];
+        sum[l] += value;
+        sumSq[l] += (double)value * value;
+        max[l] = value > max[l] ? value : max[l];
+      }
+    }
+    for (int l = 0; j < innerSize; j++, l++) {
+      float value = row[j * innerStride];
+      sum[l] += value;
+      sumSq[l] += (double)value * value;
+      max[l] = value > max[l] ? value : max[l];
+    }
+
+    // Next row, innermost outer dimension first.
+    for (int64_t i = (int64_t)indices.size() - 1; i >= 0; i--) {
+      if (++indices[i] < memref.sizes[i])
+        break;
+      indices[i] = 0;
+    }
+  }
+
+  double totalSum = 0.0, totalSumSq = 0.0;
+  float totalMax = -INFINITY;
+  for (int l = 0; l < kLanes; l++) {
+    totalSum += sum[l];
+    totalSumSq += sumSq[l];
+    totalMax = max[l] > totalMax ? max[l] : totalMax;
+  }
+
+  printf("Checksum: %ld elements, sum: %e, sum sq: %e, max: %e\n",
+         (long)numElements, totalSum, totalSumSq, totalMax);
+  fflush(stdout);
+}
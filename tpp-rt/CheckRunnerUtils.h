@@ -23,4 +23,18 @@ _mlir_ciface_expect_almost_equals(UnrankedMemRefType<float> *,
 
 extern "C" MLIR_RUNNERUTILS_EXPORT void _mlir_ciface_expect_true(int A);
 
+// Prints the maximum absolute and relative errors between two memrefs of the
+// same shape and whether every element is within the absolute threshold plus
+// the relative threshold times the reference value, which is also returned.
+// Works on any rank and any strides.
+extern "C" MLIR_RUNNERUTILS_EXPORT bool
+_mlir_ciface_print_error_stats(UnrankedMemRefType<float> *,
+                               UnrankedMemRefType<float> *, float, float);
+
+// Prints a one-line fingerprint of a memref of any rank: sum, sum of squares
+// and maximum. The reduction order only depends on the shape, so the same
+// values always produce the same fingerprint.
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_print_checksum(UnrankedMemRefType<float> *);
+
 #endif // TPP_EXECUTIONENGINE_CRUNNERUTILS_H
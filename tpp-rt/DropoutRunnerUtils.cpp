@@ -0,0 +1,152 @@
+//===- DropoutRunnerUtils.cpp - Dropout with a counter-based RNG ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The random number of element i is word i % 4 of the Philox block i / 4.
+// The body computes 8 blocks side by side, 32 elements and 4 mask bytes per
+// step, in fixed-size loops the compiler turns into SIMD; a scalar tail
+// covers the rest a mask byte at a time. The steps are independent: they can
+// be split across threads without changing the result.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DropoutRunnerUtils.h"
+#include <cassert>
+#include <cstdint>
+
+namespace {
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+// 3"): 4 random 32-bit numbers v[0..3][l] for the counter 'counter + l' and
+// the key 'seed', for each of the 'Lanes' lanes.
+template <int Lanes>
+void philox4x32(uint64_t counter, uint64_t seed, uint32_t v[4][Lanes]) {
+  const uint32_t kMul0 = 0xD2511F53, kMul1 = 0xCD9E8D57;
+  const uint32_t kWeyl0 = 0x9E3779B9, kWeyl1 = 0xBB67AE85;
+  uint32_t c0[Lanes], c1[Lanes], c2[Lanes], c3[Lanes];
+  for (int l = 0; l < Lanes; l++) {
+    c0[l] = static_cast<uint32_t>(counter + l);
+    c1[l] = static_cast<uint32_t>((counter + l) >> 32);
+    c2[l] = 0;
+    c3[l] = 0;
+  }
+  uint32_t k0 = static_cast<uint32_t>(seed);
+  uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+  for (int round = 0; round < 10; round++) {
+    for (int l = 0; l < Lanes; l++) {
+      uint64_t p0 = static_cast<uint64_t>(kMul0) * c0[l];
+      uint64_t p1 = static_cast<uint64_t>(kMul1) * c2[l];
+      c0[l] = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+      c2[l] = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+      c1[l] = static_cast<uint32_t>(p1);
+      c3[l] = static_cast<uint32_t>(p0);
+    }
+    k0 += kWeyl0;
+    k1 += kWeyl1;
+  }
+  for (int l = 0; l < Lanes; l++) {
+    v[0][l] = c0[l];
+    v[1][l] = c1[l];
+    v[2][l] = c2[l];
+    v[3][l] = c3[l];
+  }
+}
+
+// Philox blocks per step of the vector body, and the elements they cover.
+constexpr int kLanes = 8;
+constexpr int kStep = 4 * kLanes;
+
+int64_t getNumElements(const DynamicMemRefType<float> &memref) {
+  int64_t numElements = 1;
+  for (int64_t i = 0; i < memref.rank; i++)
+    numElements *= memref.sizes[i];
+  return numElements;
+}
+
+// Elements whose random number is below the threshold are dropped.
+uint32_t getDropThreshold(float probability) {
+  assert(probability >= 0.0f && probability < 1.0f && "Bad probability");
+  return static_cast<uint32_t>(static_cast<double>(probability) * 4294967296.0);
+}
+
+} // namespace
+
+extern "C" void _mlir_ciface_tpp_dropout(UnrankedMemRefType<float> *I,
+                                         int64_t seed,
+                                         UnrankedMemRefType<float> *O,
+                                         UnrankedMemRefType<int8_t> *M,
+                                         float probability) {
+  DynamicMemRefType<float> input = DynamicMemRefType<float>(*I);
+  DynamicMemRefType<float> output = DynamicMemRefType<float>(*O);
+  DynamicMemRefType<int8_t> mask = DynamicMemRefType<int8_t>(*M);
+  int64_t numElements = getNumElements(output);
+  assert(getNumElements(input) == numElements && "Size mismatch");
+  assert(mask.sizes[0] * 8 >= numElements && "Mask too small");
+
+  const float *__restrict__ in = input.data + input.offset;
+  float *__restrict__ out = output.data + output.offset;
+  uint8_t *__restrict__ bits =
+      reinterpret_cast<uint8_t *>(mask.data + mask.offset);
+  const uint32_t threshold = getDropThreshold(probability);
+  const float scale = 1.0f / (1.0f - probability);
+  const uint64_t key = static_cast<uint64_t>(seed);
+
+  int64_t numSteps = numElements / kStep;
+  for (int64_t step = 0; step < numSteps; step++) {
+    uint32_t random[4][kLanes];
+    philox4x32<kLanes>(step * kLanes, key, random);
+    int64_t first = step * kStep;
+    uint8_t keep[kStep];
+    for (int e = 0; e < kStep; e++) {
+      keep[e] = random[e % 4][e / 4] >= threshold;
+      out[first + e] = keep[e] ? in[first + e] * scale : 0.0f;
+    }
+    for (int byte = 0; byte < kStep / 8; byte++) {
+      uint8_t kept = 0;
+      for (int bit = 0; bit < 8; bit++)
+        kept |= keep[byte * 8 + bit] << bit;
+      bits[first / 8 + byte] = kept;
+    }
+  }
+
+  // Scalar tail: two Philox blocks per mask byte.
+  for (int64_t byte = numSteps * kStep / 8, numBytes = (numElements + 7) / 8;
+       byte < numBytes; byte++) {
+    uint32_t random[4][2];
+    philox4x32<2>(2 * byte, key, random);
+    uint8_t kept = 0;
+    int64_t first = byte * 8;
+    int64_t count = numElements - first < 8 ? numElements - first : 8;
+    for (int64_t bit = 0; bit < count; bit++) {
+      bool keep = random[bit % 4][bit / 4] >= threshold;
+      kept |= static_cast<uint8_t>(keep) << bit;
+      out[first + bit] = keep ? in[first + bit] * scale : 0.0f;
+    }
+    bits[byte] = kept;
+  }
+}
+
+extern "C" void _mlir_ciface_tpp_dropout_backward(
+    UnrankedMemRefType<float> *G, UnrankedMemRefType<int8_t> *M,
+    UnrankedMemRefType<float> *O, float probability) {
+  DynamicMemRefType<float> grad = DynamicMemRefType<float>(*G);
+  DynamicMemRefType<int8_t> mask = DynamicMemRefType<int8_t>(*M);
+  DynamicMemRefType<float> output = DynamicMemRefType<float>(*O);
+  int64_t numElements = getNumElements(output);
+  assert(getNumElements(grad) == numElements && "Size mismatch");
+  assert(mask.sizes[0] * 8 >= numElements && "Mask too small");
+
+  const float *__restrict__ in = grad.data + grad.offset;
+  float *__restrict__ out = output.data + output.offset;
+  const uint8_t *__restrict__ bits =
+      reinterpret_cast<const uint8_t *>(mask.data + mask.offset);
+  const float scale = 1.0f / (1.0f - probability);
+  for (int64_t i = 0; i < numElements; i++) {
+    bool keep = (bits[i >> 3] >> (i & 7)) & 1;
+    out[i] = keep ? in[i] * scale : 0.0f;
+  }
+}
@@ -0,0 +1,32 @@
+//===- DropoutRunnerUtils.h - Dropout with a counter-based RNG ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Dropout kernels tpp.dropout and tpp.dropout_backward lower to. The random
+// number of element i is a pure function of the seed and of i (Philox4x32-10),
+// so the result does not depend on the number of threads.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_EXECUTIONENGINE_DROPOUTRUNNERUTILS_H
+#define TPP_EXECUTIONENGINE_DROPOUTRUNNERUTILS_H
+
+#include "mlir/ExecutionEngine/RunnerUtils.h"
+
+// input, seed, output, mask (one bit per element), probability.
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_tpp_dropout(UnrankedMemRefType<float> *, int64_t,
+                         UnrankedMemRefType<float> *,
+                         UnrankedMemRefType<int8_t> *, float);
+
+// grad, mask, output, probability.
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_tpp_dropout_backward(UnrankedMemRefType<float> *,
+                                  UnrankedMemRefType<int8_t> *,
+                                  UnrankedMemRefType<float> *, float);
+
+#endif // TPP_EXECUTIONENGINE_DROPOUTRUNNERUTILS_H
@@ -0,0 +1,198 @@
+//===- MemoryRunnerUtils.cpp - Utils to manage kernel memory --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Memory the generated kernels get from the runtime.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MemoryRunnerUtils.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sys/mman.h>
+#include <unordered_map>
+
+namespace {
+/// Alignment of the arenas, the planning pass places buffers at multiples of it
+constexpr size_t kArenaAlignment = 64;
+
+/// Size of a huge page on x86 and of the default ones on AArch64
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+/// Bytes mapped for each huge page buffer, by address, to unmap them
+std::mutex hugeMutex;
+std::unordered_map<void *, size_t> hugeMappings;
+
+/// Maps 'size' bytes, rounded up to a number of huge pages, at a huge page
+/// boundary. Reserved hugetlbfs pages are used first: they never fall back to
+/// small pages, but there may be none. Otherwise, ask for transparent huge
+/// pages, which the kernel may or may not give.
+void *hugeAlloc(int64_t size) {
+  size_t length = (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  void *data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  data = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+  if (data == MAP_FAILED) {
+    // Map an extra page to align the start, then give back both ends
+    size_t padded = length + kHugePageSize;
+    void *mapping = mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+      fprintf(stderr, "Failed to map %ld bytes\n", (long)length);
+      abort();
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+    uintptr_t aligned =
+        (start + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    if (aligned != start)
+      munmap(mapping, aligned - start);
+    size_t tail = start + padded - (aligned + length);
+    if (tail)
+      munmap(reinterpret_cast<void *>(aligned + length), tail);
+    data = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+    // Only a hint, fails when transparent huge pages are disabled
+    madvise(data, length, MADV_HUGEPAGE);
+#endif
+  }
+
+  std::lock_guard<std::mutex> lock(hugeMutex);
+  hugeMappings[data] = length;
+  return data;
+}
+
+/// With TPP_HUGE_PAGE_STATS set, prints how many bytes of the mapping holding
+/// 'data' are backed by huge pages, transparent or hugetlbfs, from
+/// /proc/self/smaps. Tells whether the system actually gave us huge pages.
+void printHugePageStats(void *data, size_t length) {
+  static const bool enabled = getenv("TPP_HUGE_PAGE_STATS") != nullptr;
+  if (!enabled)
+    return;
+  FILE *smaps = fopen("/proc/self/smaps", "r");
+  if (!smaps)
+    return;
+  uintptr_t address = reinterpret_cast<uintptr_t>(data);
+  bool inMapping = false;
+  long hugeKB = 0;
+  char line[512];
+  while (fgets(line, sizeof(line), smaps)) {
+    // Each mapping starts with its address range, followed by its fields
+    unsigned long start, end;
+    if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+      if (inMapping)
+        break;
+      inMapping = start <= address && address < end;
+      continue;
+    }
+    long kb;
+    if (inMapping && (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1 ||
+                      sscanf(line, "Private_Hugetlb: %ld kB", &kb) == 1))
+      hugeKB += kb;
+  }
+  fclose(smaps);
+  fprintf(stderr, "tpp_huge_free: %ld bytes, %ld in huge pages\n",
+          (long)length, hugeKB * 1024);
+}
+
+void hugeFree(void *data) {
+  if (!data)
+    return;
+  size_t length;
+  {
+    std::lock_guard<std::mutex> lock(hugeMutex);
+    auto mapping = hugeMappings.find(data);
+    if (mapping == hugeMappings.end()) {
+      fprintf(stderr, "Freeing %p, not a huge page buffer\n", data);
+      abort();
+    }
+    length = mapping->second;
+    hugeMappings.erase(mapping);
+  }
+  printHugePageStats(data, length);
+  munmap(data, length);
+}
+
+/// One arena per function, grown to the largest size requested
+struct Arena {
+  void *data = nullptr;
+  int64_t size = 0;
+  bool huge = false;
+};
+
+/// The arenas of a thread, freed when it exits
+class ArenaMap {
+  /// By the address of the function's key global
+  std::unordered_map<const void *, Arena> arenas;
+
+  static void release(Arena &arena) {
+    if (arena.huge)
+      hugeFree(arena.data);
+    else
+      free(arena.data);
+    arena.data = nullptr;
+    arena.size = 0;
+  }
+
+public:
+  ~ArenaMap() {
+    for (auto &entry : arenas)
+      release(entry.second);
+  }
+
+  Arena &get(const void *key, int64_t size) {
+    Arena &arena = arenas[key];
+    if (arena.size >= size)
+      return arena;
+    // The buffers are dead between calls, no need to copy them over
+    release(arena);
+    // Packed weights and activations walk many pages per tile, keep the large
+    // arenas in huge pages
+    arena.huge = static_cast<size_t>(size) >= kHugePageSize;
+    if (arena.huge) {
+      arena.data = hugeAlloc(size);
+    } else if (posix_memalign(&arena.data, kArenaAlignment, size) != 0) {
+      fprintf(stderr, "Failed to allocate a %ld bytes arena\n", (long)size);
+      abort();
+    }
+    arena.size = size;
+    return arena;
+  }
+};
+
+/// Calls on different threads have their own arenas
+thread_local ArenaMap threadArenas;
+
+/// Describes a flat buffer of bytes to MLIR
+void setDescriptor(StridedMemRefType<char, 1> *result, void *data,
+                   int64_t size) {
+  result->basePtr = static_cast<char *>(data);
+  result->data = static_cast<char *>(data);
+  result->offset = 0;
+  result->sizes[0] = size;
+  result->strides[0] = 1;
+}
+} // namespace
+
+extern "C" void
+_mlir_ciface_tpp_arena_get(StridedMemRefType<char, 1> *result,
+                           StridedMemRefType<int64_t, 0> *key, int64_t size) {
+  Arena &arena = threadArenas.get(key->data, size);
+  setDescriptor(result, arena.data, arena.size);
+}
+
+extern "C" void _mlir_ciface_tpp_huge_alloc(StridedMemRefType<char, 1> *result,
+                                            int64_t size) {
+  setDescriptor(result, hugeAlloc(size), size);
+}
+
+extern "C" void _mlir_ciface_tpp_huge_free(StridedMemRefType<char, 1> *buffer) {
+  hugeFree(buffer->basePtr);
+}
@@ -0,0 +1,38 @@
+//===- MemoryRunnerUtils.h - Utils to manage kernel memory ----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Memory the generated kernels get from the runtime instead of allocating it
+// on every call, or instead of malloc for large buffers.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_EXECUTIONENGINE_MEMORYRUNNERUTILS_H
+#define TPP_EXECUTIONENGINE_MEMORYRUNNERUTILS_H
+
+#include "mlir/ExecutionEngine/RunnerUtils.h"
+
+// Returns the arena of the function whose key is the given global, for the
+// calling thread, at least 'size' bytes and 64-byte aligned (see
+// -static-memory-planning). The arena is kept across calls and only grows,
+// its contents are not preserved when it does. Large arenas are backed by
+// huge pages.
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_tpp_arena_get(StridedMemRefType<char, 1> *,
+                           StridedMemRefType<int64_t, 0> *, int64_t);
+
+// Returns 'size' bytes aligned to 2MB and backed by huge pages when the system
+// has them: hugetlbfs pages if any are reserved, transparent huge pages
+// otherwise (see -huge-page-allocation). Release with tpp_huge_free.
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_tpp_huge_alloc(StridedMemRefType<char, 1> *, int64_t);
+
+// Releases a buffer returned by tpp_huge_alloc.
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_tpp_huge_free(StridedMemRefType<char, 1> *);
+
+#endif // TPP_EXECUTIONENGINE_MEMORYRUNNERUTILS_H
@@ -0,0 +1,134 @@
+//===- NumaRunnerUtils.cpp - Utils to place threads on NUMA nodes ---------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Binding of the worker threads to a NUMA node. Reads the topology from sysfs,
+// to avoid a dependency on libnuma.
+//
+//===----------------------------------------------------------------------===//
+
+#include "NumaRunnerUtils.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef __linux__
+/// Path of a NUMA node's directory in sysfs
+std::string nodePath(int64_t node) {
+  return "/sys/devices/system/node/node" + std::to_string(node);
+}
+
+/// Parses a sysfs CPU list ("0-15,32-47") into a CPU set
+bool parseCpuList(const std::string &list, cpu_set_t &cpus) {
+  CPU_ZERO(&cpus);
+  std::stringstream ranges(list);
+  std::string range;
+  bool any = false;
+  while (std::getline(ranges, range, ',')) {
+    int first, last;
+    int fields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+    if (fields < 1)
+      continue;
+    if (fields == 1)
+      last = first;
+    for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+      CPU_SET(cpu, &cpus);
+      any = true;
+    }
+  }
+  return any;
+}
+
+/// CPUs of the process, those of its main thread
+bool getProcessCpus(cpu_set_t &cpus) {
+  return sched_getaffinity(getpid(), sizeof(cpus), &cpus) == 0;
+}
+#endif
+} // namespace
+
+extern "C" int64_t _mlir_ciface_tpp_numa_num_nodes() {
+#ifdef __linux__
+  int64_t nodes = 0;
+  while (std::ifstream(nodePath(nodes) + "/cpulist").good())
+    nodes++;
+  return nodes ? nodes : 1;
+#else
+  return 1;
+#endif
+}
+
+extern "C" int64_t _mlir_ciface_tpp_numa_bind(int64_t node) {
+#ifdef __linux__
+  std::ifstream file(nodePath(node) + "/cpulist");
+  std::string list;
+  cpu_set_t cpus;
+  if (node < 0 || !std::getline(file, list) || !parseCpuList(list, cpus)) {
+    fprintf(stderr, "NUMA node %ld not found, threads are not bound\n",
+            (long)node);
+    return -1;
+  }
+  if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+    perror("sched_setaffinity");
+    return -1;
+  }
+  return 0;
+#else
+  fprintf(stderr, "NUMA binding is not supported on this system\n");
+  return -1;
+#endif
+}
+
+extern "C" int64_t _mlir_ciface_tpp_num_cpus() {
+#ifdef __linux__
+  cpu_set_t cpus;
+  if (!getProcessCpus(cpus))
+    return 1;
+  int64_t count = CPU_COUNT(&cpus);
+  return count ? count : 1;
+#else
+  return 1;
+#endif
+}
+
+extern "C" int64_t _mlir_ciface_tpp_cpu_bind(int64_t first, int64_t count) {
+#ifdef __linux__
+  cpu_set_t cpus, range;
+  if (!getProcessCpus(cpus)) {
+    perror("sched_getaffinity");
+    return -1;
+  }
+  CPU_ZERO(&range);
+  int64_t index = 0;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &cpus))
+      continue;
+    if (index >= first && index < first + count)
+      CPU_SET(cpu, &range);
+    index++;
+  }
+  if (CPU_COUNT(&range) == 0) {
+    fprintf(stderr, "No CPU in range [%ld, %ld), thread is not bound\n",
+            (long)first, (long)(first + count));
+    return -1;
+  }
+  if (sched_setaffinity(0, sizeof(range), &range) != 0) {
+    perror("sched_setaffinity");
+    return -1;
+  }
+  return 0;
+#else
+  fprintf(stderr, "CPU binding is not supported on this system\n");
+  return -1;
+#endif
+}
@@ -0,0 +1,40 @@
+//===- NumaRunnerUtils.h - Utils to place threads on NUMA nodes -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Binding of the worker threads to a NUMA node, so that the blocks they first
+// touch, and then compute on, are in local memory.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_EXECUTIONENGINE_NUMARUNNERUTILS_H
+#define TPP_EXECUTIONENGINE_NUMARUNNERUTILS_H
+
+#include "mlir/ExecutionEngine/RunnerUtils.h"
+
+// Returns the number of NUMA nodes of the system, 1 if it can't tell.
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t _mlir_ciface_tpp_numa_num_nodes();
+
+// Restricts the calling thread to the CPUs of NUMA node 'node', so that the
+// pages it first touches are on that node. Threads created afterwards inherit
+// the binding: call it before the first parallel region to keep the whole
+// OpenMP pool on the node. Returns 0 on success, -1 if the node doesn't exist
+// or binding isn't supported.
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_tpp_numa_bind(int64_t node);
+
+// Returns the number of CPUs the process may run on, 1 if it can't tell.
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t _mlir_ciface_tpp_num_cpus();
+
+// Restricts the calling thread to 'count' CPUs of the process, starting at the
+// 'first' one in CPU order, to run independent instances of a kernel on
+// disjoint cores. Returns 0 on success, -1 if the range is empty or binding
+// isn't supported.
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_tpp_cpu_bind(int64_t first, int64_t count);
+
+#endif // TPP_EXECUTIONENGINE_NUMARUNNERUTILS_H
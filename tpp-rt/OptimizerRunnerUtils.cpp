@@ -0,0 +1,81 @@
+//===- OptimizerRunnerUtils.cpp - Fused optimizer updates -----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The updates are bandwidth bound: every element of the parameter and its
+// state is read and written once, in a single loop the compiler vectorizes
+// (the pointers do not alias and sqrt does not set errno, see CMakeLists).
+//
+//===----------------------------------------------------------------------===//
+
+#include "OptimizerRunnerUtils.h"
+#include <cassert>
+#include <cmath>
+
+// Number of elements and base address of a contiguous memref.
+static int64_t getNumElements(const DynamicMemRefType<float> &memref) {
+  int64_t numElements = 1;
+  for (int64_t i = 0; i < memref.rank; i++)
+    numElements *= memref.sizes[i];
+  return numElements;
+}
+
+static float *getBase(const DynamicMemRefType<float> &memref) {
+  return memref.data + memref.offset;
+}
+
+extern "C" void _mlir_ciface_tpp_sgd_update(UnrankedMemRefType<float> *G,
+                                            float learningRate,
+                                            UnrankedMemRefType<float> *P,
+                                            UnrankedMemRefType<float> *V,
+                                            float momentum, float weightDecay) {
+  DynamicMemRefType<float> grad = DynamicMemRefType<float>(*G);
+  DynamicMemRefType<float> param = DynamicMemRefType<float>(*P);
+  DynamicMemRefType<float> velocity = DynamicMemRefType<float>(*V);
+  int64_t numElements = getNumElements(param);
+  assert(getNumElements(grad) == numElements &&
+         getNumElements(velocity) == numElements && "Size mismatch");
+
+  const float *__restrict__ g = getBase(grad);
+  float *__restrict__ p = getBase(param);
+  float *__restrict__ v = getBase(velocity);
+  for (int64_t i = 0; i < numElements; i++) {
+    float update = g[i] + weightDecay * p[i];
+    v[i] = momentum * v[i] + update;
+    p[i] -= learningRate * v[i];
+  }
+}
+
+extern "C" void _mlir_ciface_tpp_adam_update(
+    UnrankedMemRefType<float> *G, float learningRate, float stepSize,
+    UnrankedMemRefType<float> *P, UnrankedMemRefType<float> *M,
+    UnrankedMemRefType<float> *V, float beta1, float beta2, float epsilon,
+    float weightDecay) {
+  DynamicMemRefType<float> grad = DynamicMemRefType<float>(*G);
+  DynamicMemRefType<float> param = DynamicMemRefType<float>(*P);
+  DynamicMemRefType<float> firstMoment = DynamicMemRefType<float>(*M);
+  DynamicMemRefType<float> secondMoment = DynamicMemRefType<float>(*V);
+  int64_t numElements = getNumElements(param);
+  assert(getNumElements(grad) == numElements &&
+         getNumElements(firstMoment) == numElements &&
+         getNumElements(secondMoment) == numElements && "Size mismatch");
+
+  const float *__restrict__ g = getBase(grad);
+  float *__restrict__ p = getBase(param);
+  float *__restrict__ m = getBase(firstMoment);
+  float *__restrict__ v = getBase(secondMoment);
+  const float oneMinusBeta1 = 1.0f - beta1;
+  const float oneMinusBeta2 = 1.0f - beta2;
+  for (int64_t i = 0; i < numElements; i++) {
+    float gi = g[i];
+    m[i] = beta1 * m[i] + oneMinusBeta1 * gi;
+    v[i] = beta2 * v[i] + oneMinusBeta2 * gi * gi;
+    // The weight decay is not bias corrected: plain learning rate.
+    float decay = learningRate * weightDecay * p[i];
+    p[i] -= decay + stepSize * m[i] / (std::sqrt(v[i]) + epsilon);
+  }
+}
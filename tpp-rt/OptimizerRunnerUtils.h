@@ -0,0 +1,35 @@
+//===- OptimizerRunnerUtils.h - Fused optimizer updates -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Optimizer steps tpp.sgd_update and tpp.adam_update lower to: one sweep over
+// the parameter and its state. The memrefs are contiguous and have the same
+// shape, any layout of the parameter (e.g., blocked weights) works.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_EXECUTIONENGINE_OPTIMIZERRUNNERUTILS_H
+#define TPP_EXECUTIONENGINE_OPTIMIZERRUNNERUTILS_H
+
+#include "mlir/ExecutionEngine/RunnerUtils.h"
+
+// SGD with momentum and weight decay, see tpp.sgd_update:
+// grad, learning rate, param, velocity, momentum, weight decay.
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_tpp_sgd_update(UnrankedMemRefType<float> *, float,
+                            UnrankedMemRefType<float> *,
+                            UnrankedMemRefType<float> *, float, float);
+
+// Adam with decoupled weight decay, see tpp.adam_update:
+// grad, learning rate, bias-corrected step size, param, m, v, beta1, beta2,
+// epsilon, weight decay.
+extern "C" MLIR_RUNNERUTILS_EXPORT void _mlir_ciface_tpp_adam_update(
+    UnrankedMemRefType<float> *, float, float, UnrankedMemRefType<float> *,
+    UnrankedMemRefType<float> *, UnrankedMemRefType<float> *, float, float,
+    float, float);
+
+#endif // TPP_EXECUTIONENGINE_OPTIMIZERRUNNERUTILS_H
@@ -14,6 +14,8 @@
 
 #include "XsmmRunnerUtils.h"
 #include "libxsmm.h" // NOLINT [build/include_subdir]
+#include <cassert>
+#include <vector>
 
 extern "C" void _mlir_ciface_xsmm_matmul_invoke(const libxsmm_datatype dtype,
                                                 int64_t funcAddr,
@@ -70,11 +72,36 @@ extern "C" void _mlir_ciface_xsmm_matmul_invoke(const libxsmm_datatype dtype,
     gemm_param.a.primary = (void *)addr_b;
     gemm_param.b.primary = (void *)addr_a;
     gemm_param.c.primary = (void *)addr_c;
+  } else if (dtype == LIBXSMM_DATATYPE_I8) {
+    // Int8 inputs, i32 accumulator.
+    int8_t *addr_a = (int8_t *)matrixA.data + matrixA.offset;
+    int8_t *addr_b = (int8_t *)matrixB.data + matrixB.offset;
+    int32_t *addr_c = (int32_t *)matrixC.data + matrixC.offset;
+    //  LIBXSMM col-major change A with B.
+    gemm_param.a.primary = (void *)addr_b;
+    gemm_param.b.primary = (void *)addr_a;
+    gemm_param.c.primary = (void *)addr_c;
   }
   sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(funcAddr);
   sgemm.gemm(&gemm_param);
 }
 
+// Int8 GEMMs multiply unsigned A by signed B and accumulate in i32. B, the
+// LIBXSMM A, is in VNNI4 format.
+static void setGemmTypes(const libxsmm_datatype dtype,
+                         libxsmm_gemm_shape &l_shape,
+                         libxsmm_bitfield &l_flags) {
+  l_shape.a_in_type = dtype;
+  l_shape.b_in_type = dtype;
+  l_shape.out_type = dtype;
+  l_shape.comp_type = dtype;
+  if (dtype == LIBXSMM_DATATYPE_I8) {
+    l_shape.out_type = LIBXSMM_DATATYPE_I32;
+    l_shape.comp_type = LIBXSMM_DATATYPE_I32;
+    l_flags |= LIBXSMM_GEMM_FLAG_VNNI_A | LIBXSMM_GEMM_FLAG_B_UNSIGNED;
+  }
+}
+
 extern "C" int64_t
 _mlir_ciface_xsmm_matmul_dispatch(const libxsmm_datatype dtype, int64_t m,
                                   int64_t n, int64_t k, int64_t lda,
@@ -104,10 +131,7 @@ _mlir_ciface_xsmm_matmul_dispatch(const libxsmm_datatype dtype, int64_t m,
   l_shape.lda = ldb;
   l_shape.ldb = lda;
   l_shape.ldc = ldc;
-  l_shape.a_in_type = dtype;
-  l_shape.b_in_type = dtype;
-  l_shape.out_type = dtype;
-  l_shape.comp_type = dtype;
+  setGemmTypes(dtype, l_shape, l_flags);
 
   auto sgemm = libxsmm_dispatch_gemm_v2(l_shape, l_flags, l_prefetch_flags);
   return reinterpret_cast<int64_t>(sgemm);
@@ -211,6 +235,30 @@ _mlir_ciface_xsmm_unary_invoke_inline(const libxsmm_datatype dType,
   _mlir_ciface_xsmm_unary_invoke(dType, addr, input, input);
 }
 
+// Unary kernels reading a second input, e.g. the forward activation of a
+// relu backward (LIBXSMM's RELU_INV without bitmask).
+extern "C" void _mlir_ciface_xsmm_unary_secondary_invoke(
+    const libxsmm_datatype dType, int64_t addr, UnrankedMemRefType<char> *input,
+    UnrankedMemRefType<char> *secondary, UnrankedMemRefType<char> *output) {
+  DynamicMemRefType<char> tensorA = DynamicMemRefType<char>(*input);
+  DynamicMemRefType<char> tensorS = DynamicMemRefType<char>(*secondary);
+  DynamicMemRefType<char> tensorB = DynamicMemRefType<char>(*output);
+
+  libxsmm_meltwfunction_unary kernel =
+      reinterpret_cast<libxsmm_meltwfunction_unary>(addr);
+  libxsmm_meltw_unary_param param;
+  if (dType == LIBXSMM_DATATYPE_F32) {
+    param.in.primary = (void *)((float *)tensorA.data + tensorA.offset);
+    param.in.secondary = (void *)((float *)tensorS.data + tensorS.offset);
+    param.out.primary = (void *)((float *)tensorB.data + tensorB.offset);
+  } else if (dType == LIBXSMM_DATATYPE_BF16) {
+    param.in.primary = (void *)((bf16 *)tensorA.data + tensorA.offset);
+    param.in.secondary = (void *)((bf16 *)tensorS.data + tensorS.offset);
+    param.out.primary = (void *)((bf16 *)tensorB.data + tensorB.offset);
+  }
+  kernel(&param);
+}
+
 extern "C" void _mlir_ciface_xsmm_binary_invoke(const libxsmm_datatype dType,
                                                 int64_t addr,
                                                 UnrankedMemRefType<char> *lhs,
@@ -331,11 +379,37 @@ extern "C" void _mlir_ciface_xsmm_brgemm_invoke(const libxsmm_datatype dType,
     gemm_param.a.primary = (void *)addr_tensorB;
     gemm_param.b.primary = (void *)addr_tensorA;
     gemm_param.c.primary = (void *)addr_tensorC;
+  } else if (dType == LIBXSMM_DATATYPE_I8) {
+    int8_t *addr_tensorA = (int8_t *)tensorA.data + tensorA.offset;
+    int8_t *addr_tensorB = (int8_t *)tensorB.data + tensorB.offset;
+    int32_t *addr_tensorC = (int32_t *)tensorC.data + tensorC.offset;
+    gemm_param.a.primary = (void *)addr_tensorB;
+    gemm_param.b.primary = (void *)addr_tensorA;
+    gemm_param.c.primary = (void *)addr_tensorC;
   }
   gemm_param.op.tertiary = (void *)&numBatchesVar;
   sgemm.gemm(&gemm_param);
 }
 
+// The int8 invokes have their own declaration on the MLIR side (the operands
+// are i8 and i32 memrefs), they share the implementation.
+static_assert(LIBXSMM_DATATYPE_I8 == 9,
+              "xsmm::DataType::I8 must match libxsmm_datatype");
+
+extern "C" void _mlir_ciface_xsmm_matmul_invoke_i8(
+    const libxsmm_datatype dtype, int64_t funcAddr,
+    UnrankedMemRefType<char> *A, UnrankedMemRefType<char> *B,
+    UnrankedMemRefType<char> *C) {
+  _mlir_ciface_xsmm_matmul_invoke(dtype, funcAddr, A, B, C);
+}
+
+extern "C" void _mlir_ciface_xsmm_brgemm_invoke_i8(
+    const libxsmm_datatype dType, int64_t addr, UnrankedMemRefType<char> *A,
+    UnrankedMemRefType<char> *B, UnrankedMemRefType<char> *C,
+    int64_t numBatches) {
+  _mlir_ciface_xsmm_brgemm_invoke(dType, addr, A, B, C, numBatches);
+}
+
 extern "C" int64_t
 _mlir_ciface_xsmm_brgemm_dispatch(const libxsmm_datatype dtype, int64_t m,
                                   int64_t n, int64_t k, int64_t lda,
@@ -355,7 +429,9 @@ _mlir_ciface_xsmm_brgemm_dispatch(const libxsmm_datatype dtype, int64_t m,
   libxsmm_blasint k_int = k;
   // TODO: move stride computation to dispatch
   // operation as in: https://github.com/plaidml/plaidml/pull/1983
-  auto typeSize = dtype == LIBXSMM_DATATYPE_F32 ? sizeof(float) : sizeof(bf16);
+  auto typeSize = dtype == LIBXSMM_DATATYPE_F32    ? sizeof(float)
+                  : dtype == LIBXSMM_DATATYPE_BF16 ? sizeof(bf16)
+                                                   : sizeof(int8_t);
   libxsmm_blasint stride_a = lda * m * typeSize;
   libxsmm_blasint stride_b = ldb * k * typeSize;
 
@@ -370,10 +446,7 @@ _mlir_ciface_xsmm_brgemm_dispatch(const libxsmm_datatype dtype, int64_t m,
   l_shape.lda = ldb_int;
   l_shape.ldb = lda_int;
   l_shape.ldc = ldc_int;
-  l_shape.a_in_type = dtype;
-  l_shape.b_in_type = dtype;
-  l_shape.out_type = dtype;
-  l_shape.comp_type = dtype;
+  setGemmTypes(dtype, l_shape, l_flags);
   l_brconfig.br_type = LIBXSMM_GEMM_BATCH_REDUCE_STRIDE;
   l_brconfig.br_stride_a_hint = stride_b;
   l_brconfig.br_stride_b_hint = stride_a;
@@ -385,6 +458,79 @@ _mlir_ciface_xsmm_brgemm_dispatch(const libxsmm_datatype dtype, int64_t m,
   return reinterpret_cast<int64_t>(sgemm);
 }
 
+// The batch of a sparse brgemm is given by offsets rather than by a stride:
+// the kernel only depends on the shape of the blocks.
+extern "C" int64_t _mlir_ciface_xsmm_sparse_brgemm_dispatch(
+    const libxsmm_datatype dtype, int64_t m, int64_t n, int64_t k, int64_t lda,
+    int64_t ldb, int64_t ldc) {
+  libxsmm_gemm_shape l_shape;
+  libxsmm_bitfield l_flags = LIBXSMM_GEMM_FLAGS('N', 'N');
+  libxsmm_bitfield l_prefetch_flags = 0;
+  libxsmm_gemm_batch_reduce_config l_brconfig;
+
+  l_shape.m = n;
+  l_shape.n = m;
+  l_shape.k = k;
+  l_shape.lda = ldb;
+  l_shape.ldb = lda;
+  l_shape.ldc = ldc;
+  setGemmTypes(dtype, l_shape, l_flags);
+  l_brconfig.br_type = LIBXSMM_GEMM_BATCH_REDUCE_OFFSET;
+  l_brconfig.br_stride_a_hint = 0;
+  l_brconfig.br_stride_b_hint = 0;
+  l_brconfig.br_unroll_hint = 0;
+
+  auto sgemm = libxsmm_dispatch_brgemm_v2(l_shape, l_flags, l_prefetch_flags,
+                                          l_brconfig);
+
+  return reinterpret_cast<int64_t>(sgemm);
+}
+
+// B holds the non-zero blocks of the weights, block `i` multiplies block
+// `indices[i]` of A. The offsets are in bytes from the base pointers.
+extern "C" void _mlir_ciface_xsmm_sparse_brgemm_invoke(
+    const libxsmm_datatype dType, int64_t addr, UnrankedMemRefType<char> *A,
+    UnrankedMemRefType<char> *B, UnrankedMemRefType<int64_t> *indices,
+    UnrankedMemRefType<char> *C, int64_t numBatches) {
+  assert(dType == LIBXSMM_DATATYPE_F32 && "expect f32 sparse brgemm");
+  if (numBatches == 0)
+    return;
+
+  DynamicMemRefType<char> tensorA = DynamicMemRefType<char>(*A);
+  DynamicMemRefType<char> tensorB = DynamicMemRefType<char>(*B);
+  DynamicMemRefType<int64_t> blocks = DynamicMemRefType<int64_t>(*indices);
+  DynamicMemRefType<char> tensorC = DynamicMemRefType<char>(*C);
+
+  // The offsets buffer is reused across calls, each thread grows its own:
+  // no allocation on the hot path once the largest batch has been seen.
+  static thread_local std::vector<unsigned long long> offsets;
+  if (offsets.size() < static_cast<size_t>(2 * numBatches))
+    offsets.resize(2 * numBatches);
+  unsigned long long *offsetsA = offsets.data();
+  unsigned long long *offsetsB = offsetsA + numBatches;
+  int64_t *addr_blocks = blocks.data + blocks.offset;
+  for (int64_t i = 0; i < numBatches; i++) {
+    offsetsA[i] =
+        addr_blocks[i * blocks.strides[0]] * tensorA.strides[0] * sizeof(float);
+    offsetsB[i] = i * tensorB.strides[0] * sizeof(float);
+  }
+
+  libxsmm_xmmfunction sgemm;
+  libxsmm_gemm_param gemm_param;
+  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(addr);
+  unsigned long long numBatchesVar = numBatches;
+  float *addr_tensorA = (float *)tensorA.data + tensorA.offset;
+  float *addr_tensorB = (float *)tensorB.data + tensorB.offset;
+  float *addr_tensorC = (float *)tensorC.data + tensorC.offset;
+  gemm_param.a.primary = (void *)addr_tensorB;
+  gemm_param.a.secondary = (void *)offsetsB;
+  gemm_param.b.primary = (void *)addr_tensorA;
+  gemm_param.b.secondary = (void *)offsetsA;
+  gemm_param.c.primary = (void *)addr_tensorC;
+  gemm_param.op.tertiary = (void *)&numBatchesVar;
+  sgemm.gemm(&gemm_param);
+}
+
 //----------------------------------------------------------------------------//
 // BRGEMM connection on the IREE side.
 //----------------------------------------------------------------------------//
@@ -56,6 +56,12 @@ extern "C" MLIR_RUNNERUTILS_EXPORT void
 _mlir_ciface_xsmm_unary_invoke_inline(const libxsmm_datatype, int64_t,
                                       UnrankedMemRefType<char> *);
 
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_unary_secondary_invoke(const libxsmm_datatype, int64_t,
+                                         UnrankedMemRefType<char> *,
+                                         UnrankedMemRefType<char> *,
+                                         UnrankedMemRefType<char> *);
+
 extern "C" MLIR_RUNNERUTILS_EXPORT void
 _mlir_ciface_xsmm_unary_scalar_invoke(const libxsmm_datatype, int64_t, float,
                                       UnrankedMemRefType<char> *);
@@ -69,6 +75,24 @@ extern "C" MLIR_RUNNERUTILS_EXPORT void _mlir_ciface_xsmm_brgemm_invoke(
     const libxsmm_datatype, int64_t, UnrankedMemRefType<char> *,
     UnrankedMemRefType<char> *, UnrankedMemRefType<char> *, int64_t);
 
+extern "C" MLIR_RUNNERUTILS_EXPORT void _mlir_ciface_xsmm_matmul_invoke_i8(
+    const libxsmm_datatype, int64_t, UnrankedMemRefType<char> *,
+    UnrankedMemRefType<char> *, UnrankedMemRefType<char> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void _mlir_ciface_xsmm_brgemm_invoke_i8(
+    const libxsmm_datatype, int64_t, UnrankedMemRefType<char> *,
+    UnrankedMemRefType<char> *, UnrankedMemRefType<char> *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_sparse_brgemm_dispatch(const libxsmm_datatype, int64_t,
+                                         int64_t, int64_t, int64_t, int64_t,
+                                         int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void _mlir_ciface_xsmm_sparse_brgemm_invoke(
+    const libxsmm_datatype, int64_t, UnrankedMemRefType<char> *,
+    UnrankedMemRefType<char> *, UnrankedMemRefType<int64_t> *,
+    UnrankedMemRefType<char> *, int64_t);
+
 //----------------------------------------------------------------------------//
 // BRGEMM connection on the IREE side.
 //----------------------------------------------------------------------------//
@@ -0,0 +1,226 @@
+//===- tpp-rt-bench.cpp - TPP runtime entry point overhead ----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Micro-benchmark of the runtime entry points the XSMM lowering calls, on
+// tiny shapes where their overhead is comparable to the kernels. For each
+// kernel, data type and shape, it reports in nanoseconds per call:
+//  * cold dispatch: first dispatch of a kernel (code generation included),
+//    averaged over distinct leading dimensions so that each one is new;
+//  * hot dispatch: dispatch of a kernel already in LIBXSMM's registry;
+//  * invoke: call through the unranked memref ABI, as the generated code does;
+//  * direct: call to the LIBXSMM kernel with prepared parameters.
+// The difference between invoke and direct is the cost of the trampoline.
+// BRGEMMs reduce over a batch of 4, relu is in place.
+//
+// Usage: tpp-rt-bench [iterations]
+//
+//===----------------------------------------------------------------------===//
+
+#include "XsmmRunnerUtils.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+/// Cold dispatches per shape, each with a new leading dimension
+constexpr int kColdSamples = 8;
+
+/// Nanoseconds per call of 'fn', over 'iterations' calls
+template <typename Fn> double timeCalls(int iterations, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    fn(i);
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+         iterations;
+}
+
+/// A row major 2D buffer and the descriptors MLIR would pass for it
+struct Buffer {
+  std::vector<char> storage;
+  StridedMemRefType<char, 2> descriptor;
+  UnrankedMemRefType<char> unranked;
+
+  Buffer(int64_t rows, int64_t cols, size_t typeSize)
+      : storage(rows * cols * typeSize, 0) {
+    descriptor.basePtr = storage.data();
+    descriptor.data = storage.data();
+    descriptor.offset = 0;
+    descriptor.sizes[0] = rows;
+    descriptor.sizes[1] = cols;
+    descriptor.strides[0] = cols;
+    descriptor.strides[1] = 1;
+    unranked.rank = 2;
+    unranked.descriptor = &descriptor;
+  }
+
+  void *data() { return storage.data(); }
+};
+
+struct Result {
+  double coldDispatch;
+  double hotDispatch;
+  double invoke;
+  double direct;
+};
+
+/// LIBXSMM has no kernel for this type and shape
+Result unsupported(Result result) {
+  result.invoke = NAN;
+  result.direct = NAN;
+  return result;
+}
+
+Result benchMatmul(libxsmm_datatype dtype, size_t typeSize, int64_t m,
+                   int64_t n, int64_t k, int iterations) {
+  Result result;
+  Buffer a(m, k, typeSize), b(k, n, typeSize), c(m, n, typeSize);
+
+  result.coldDispatch = timeCalls(kColdSamples, [&](int i) {
+    _mlir_ciface_xsmm_matmul_dispatch(dtype, m, n, k, k, n, n + i + 1);
+  });
+  int64_t addr = 0;
+  result.hotDispatch = timeCalls(iterations, [&](int) {
+    addr = _mlir_ciface_xsmm_matmul_dispatch(dtype, m, n, k, k, n, n);
+  });
+  if (!addr)
+    return unsupported(result);
+
+  result.invoke = timeCalls(iterations, [&](int) {
+    _mlir_ciface_xsmm_matmul_invoke(dtype, addr, &a.unranked, &b.unranked,
+                                    &c.unranked);
+  });
+
+  libxsmm_gemmfunction kernel = reinterpret_cast<libxsmm_gemmfunction>(addr);
+  libxsmm_gemm_param param;
+  // LIBXSMM col-major change A with B.
+  param.a.primary = b.data();
+  param.b.primary = a.data();
+  param.c.primary = c.data();
+  result.direct = timeCalls(iterations, [&](int) { kernel(&param); });
+  return result;
+}
+
+Result benchBrgemm(libxsmm_datatype dtype, size_t typeSize, int64_t m,
+                   int64_t n, int64_t k, int64_t batch, int iterations) {
+  Result result;
+  Buffer a(batch * m, k, typeSize), b(batch * k, n, typeSize),
+      c(m, n, typeSize);
+
+  result.coldDispatch = timeCalls(kColdSamples, [&](int i) {
+    _mlir_ciface_xsmm_brgemm_dispatch(dtype, m, n, k, k, n, n + i + 1);
+  });
+  int64_t addr = 0;
+  result.hotDispatch = timeCalls(iterations, [&](int) {
+    addr = _mlir_ciface_xsmm_brgemm_dispatch(dtype, m, n, k, k, n, n);
+  });
+  if (!addr)
+    return unsupported(result);
+
+  result.invoke = timeCalls(iterations, [&](int) {
+    _mlir_ciface_xsmm_brgemm_invoke(dtype, addr, &a.unranked, &b.unranked,
+                                    &c.unranked, batch);
+  });
+
+  libxsmm_gemmfunction kernel = reinterpret_cast<libxsmm_gemmfunction>(addr);
+  libxsmm_gemm_param param;
+  unsigned long long numBatches = batch;
+  param.a.primary = b.data();
+  param.b.primary = a.data();
+  param.c.primary = c.data();
+  param.op.tertiary = &numBatches;
+  result.direct = timeCalls(iterations, [&](int) { kernel(&param); });
+  return result;
+}
+
+Result benchRelu(libxsmm_datatype dtype, size_t typeSize, int64_t m,
+                 int64_t n, int iterations) {
+  Result result;
+  Buffer in(m, n, typeSize);
+  const int64_t relu = LIBXSMM_MELTW_TYPE_UNARY_RELU;
+  const int64_t noBcast = LIBXSMM_MELTW_FLAG_UNARY_NONE;
+
+  result.coldDispatch = timeCalls(kColdSamples, [&](int i) {
+    _mlir_ciface_xsmm_unary_dispatch(dtype, m, n, n, n + i + 1, relu,
+                                     noBcast);
+  });
+  int64_t addr = 0;
+  result.hotDispatch = timeCalls(iterations, [&](int) {
+    addr = _mlir_ciface_xsmm_unary_dispatch(dtype, m, n, n, n, relu, noBcast);
+  });
+  if (!addr)
+    return unsupported(result);
+
+  result.invoke = timeCalls(iterations, [&](int) {
+    _mlir_ciface_xsmm_unary_invoke(dtype, addr, &in.unranked, &in.unranked);
+  });
+
+  libxsmm_meltwfunction_unary kernel =
+      reinterpret_cast<libxsmm_meltwfunction_unary>(addr);
+  libxsmm_meltw_unary_param param;
+  param.in.primary = in.data();
+  param.out.primary = in.data();
+  result.direct = timeCalls(iterations, [&](int) { kernel(&param); });
+  return result;
+}
+
+void printResult(const char *kernel, const char *dtype, int64_t m, int64_t n,
+                 int64_t k, const Result &result) {
+  char shape[32];
+  if (k)
+    std::snprintf(shape, sizeof(shape), "%ldx%ldx%ld", (long)m, (long)n,
+                  (long)k);
+  else
+    std::snprintf(shape, sizeof(shape), "%ldx%ld", (long)m, (long)n);
+  std::printf("%-8s %-5s %-10s %12.1f %12.1f %10.1f %10.1f %10.1f\n", kernel,
+              dtype, shape, result.coldDispatch, result.hotDispatch,
+              result.invoke, result.direct, result.invoke - result.direct);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+  if (iterations <= 0) {
+    std::fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  struct DataType {
+    const char *name;
+    libxsmm_datatype type;
+    size_t size;
+  };
+  const DataType dataTypes[] = {{"f32", LIBXSMM_DATATYPE_F32, sizeof(float)},
+                                {"bf16", LIBXSMM_DATATYPE_BF16, sizeof(bf16)}};
+  const int64_t sizes[] = {4, 8, 16, 32};
+  const int64_t batch = 4;
+
+  libxsmm_init();
+  std::printf("%-8s %-5s %-10s %12s %12s %10s %10s %10s\n", "kernel", "type",
+              "MxNxK", "cold (ns)", "hot (ns)", "invoke", "direct",
+              "overhead");
+  for (const DataType &dt : dataTypes) {
+    for (int64_t size : sizes) {
+      printResult("matmul", dt.name, size, size, size,
+                  benchMatmul(dt.type, dt.size, size, size, size, iterations));
+      printResult("brgemm", dt.name, size, size, size,
+                  benchBrgemm(dt.type, dt.size, size, size, size, batch,
+                              iterations));
+      printResult("relu", dt.name, size, size, 0,
+                  benchRelu(dt.type, dt.size, size, size, iterations));
+    }
+  }
+  libxsmm_finalize();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+//===- CachedJit.cpp - JIT with an object file cache ----------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// JIT-compiles a module lowered to the LLVM dialect through an object file
+// cache.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CachedJit.h"
+
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/Target/LLVMIR/Export.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/SmallVectorMemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+
+using namespace mlir;
+
+#define DEBUG_TYPE "cached-jit"
+
+static llvm::Error makeError(const llvm::Twine &msg) {
+  return llvm::make_error<llvm::StringError>(msg,
+                                             llvm::inconvertibleErrorCode());
+}
+
+/// Hash of the LLVM IR, the target and the optimization level
+static std::string getObjectKey(llvm::Module &module,
+                                llvm::TargetMachine &targetMachine,
+                                llvm::Optional<unsigned> optLevel) {
+  llvm::SHA1 hasher;
+  hasher.update(LLVM_VERSION_STRING);
+  hasher.update(targetMachine.getTargetTriple().str());
+  hasher.update(targetMachine.getTargetCPU());
+  hasher.update(targetMachine.getTargetFeatureString());
+  hasher.update(optLevel ? std::to_string(*optLevel) : "default");
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  module.print(os, /*AAW=*/nullptr);
+  hasher.update(os.str());
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/// Optimizes the module and emits its object file
+static llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+compileToObject(llvm::Module &module, llvm::TargetMachine &targetMachine,
+                llvm::Optional<unsigned> optLevel) {
+  if (optLevel) {
+    auto transformer = makeOptimizingTransformer(*optLevel, /*sizeLevel=*/0,
+                                                 &targetMachine);
+    if (auto err = transformer(&module))
+      return std::move(err);
+  }
+
+  llvm::SmallVector<char, 0> buffer;
+  llvm::raw_svector_ostream os(buffer);
+  llvm::legacy::PassManager codegen;
+  if (targetMachine.addPassesToEmitFile(codegen, os, /*DwoOut=*/nullptr,
+                                        llvm::CGFT_ObjectFile))
+    return makeError("The target cannot emit object files");
+  codegen.run(module);
+  return std::make_unique<llvm::SmallVectorMemoryBuffer>(
+      std::move(buffer), module.getModuleIdentifier(),
+      /*RequiresNullTerminator=*/false);
+}
+
+/// Best effort: a cache we cannot write to only costs the next compilation.
+/// Objects are written under a unique name and renamed, so that concurrent
+/// runs never read a partial object.
+static void storeObject(llvm::StringRef cacheDir, llvm::StringRef path,
+                        llvm::MemoryBufferRef object) {
+  llvm::SmallString<128> tmpPath;
+  int fd;
+  if (llvm::sys::fs::create_directories(cacheDir) ||
+      llvm::sys::fs::createUniqueFile(path + "-%%%%%%.tmp", fd, tmpPath))
+    return;
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << object.getBuffer();
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::sys::fs::remove(tmpPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(tmpPath, path))
+    llvm::sys::fs::remove(tmpPath);
+  LLVM_DEBUG(llvm::dbgs() << "Cached " << path << "\n");
+}
+
+llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>>
+mlir::createCachedJit(ModuleOp module, const CachedJitOptions &options) {
+  auto targetMachineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!targetMachineBuilder)
+    return targetMachineBuilder.takeError();
+  if (options.optLevel)
+    targetMachineBuilder->setCodeGenOptLevel(
+        static_cast<llvm::CodeGenOpt::Level>(*options.optLevel));
+  auto targetMachine = targetMachineBuilder->createTargetMachine();
+  if (!targetMachine)
+    return targetMachine.takeError();
+
+  // The key is the IR before the LLVM optimizations, which a hit skips
+  llvm::LLVMContext llvmContext;
+  std::unique_ptr<llvm::Module> llvmModule =
+      translateModuleToLLVMIR(module, llvmContext);
+  if (!llvmModule)
+    return makeError("Cannot translate the module to LLVM IR");
+  llvmModule->setDataLayout((*targetMachine)->createDataLayout());
+  llvmModule->setTargetTriple((*targetMachine)->getTargetTriple().getTriple());
+
+  llvm::SmallString<128> path;
+  std::unique_ptr<llvm::MemoryBuffer> object;
+  if (!options.cacheDir.empty()) {
+    path = options.cacheDir;
+    llvm::sys::path::append(
+        path, getObjectKey(*llvmModule, **targetMachine, options.optLevel) +
+                  ".o");
+    auto cached = llvm::MemoryBuffer::getFile(path, /*IsText=*/false,
+                                              /*RequiresNullTerminator=*/false);
+    if (cached) {
+      LLVM_DEBUG(llvm::dbgs() << "Cache hit " << path << "\n");
+      object = std::move(*cached);
+    }
+  }
+  if (!object) {
+    auto compiled =
+        compileToObject(*llvmModule, **targetMachine, options.optLevel);
+    if (!compiled)
+      return compiled.takeError();
+    object = std::move(*compiled);
+    if (!path.empty())
+      storeObject(options.cacheDir, path, object->getMemBufferRef());
+  }
+
+  auto jit = llvm::orc::LLJITBuilder()
+                 .setJITTargetMachineBuilder(std::move(*targetMachineBuilder))
+                 .create();
+  if (!jit)
+    return jit.takeError();
+
+  // Same resolution as the ExecutionEngine: the process, then the libraries
+  llvm::orc::JITDylib &mainJD = (*jit)->getMainJITDylib();
+  char prefix = (*jit)->getDataLayout().getGlobalPrefix();
+  auto process =
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix);
+  if (!process)
+    return process.takeError();
+  mainJD.addGenerator(std::move(*process));
+  for (const std::string &lib : options.sharedLibs) {
+    auto generator =
+        llvm::orc::DynamicLibrarySearchGenerator::Load(lib.c_str(), prefix);
+    if (!generator)
+      return generator.takeError();
+    mainJD.addGenerator(std::move(*generator));
+  }
+  if (options.symbolMap) {
+    llvm::orc::MangleAndInterner interner((*jit)->getExecutionSession(),
+                                          (*jit)->getDataLayout());
+    auto symbols = llvm::orc::absoluteSymbols(options.symbolMap(interner));
+    if (auto err = mainJD.define(std::move(symbols)))
+      return std::move(err);
+  }
+
+  if (auto err = (*jit)->addObjectFile(std::move(object)))
+    return std::move(err);
+  return std::move(*jit);
+}
@@ -0,0 +1,60 @@
+//===- CachedJit.h - JIT with an object file cache --------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// JIT-compiles a module lowered to the LLVM dialect through an object file
+// cache. The object file compiled from a given LLVM IR, for a given target
+// and optimization level, is stored in the cache directory and loaded
+// directly the next time, which skips the LLVM optimizations and the code
+// generation, most of the compile time of a large kernel.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_RUN_CACHEDJIT_H
+#define TPP_RUN_CACHEDJIT_H
+
+#include "mlir/IR/BuiltinOps.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/Mangling.h"
+#include "llvm/Support/Error.h"
+
+#include <memory>
+#include <string>
+
+namespace mlir {
+
+/// Options of createCachedJit
+struct CachedJitOptions {
+  /// Level of the LLVM optimizations and of the code generation. Without
+  /// one, the IR is not optimized and the code generation uses its default
+  llvm::Optional<unsigned> optLevel;
+
+  /// Libraries the module's external symbols are resolved from, after the
+  /// symbols of the process
+  llvm::ArrayRef<std::string> sharedLibs;
+
+  /// Directory of the object files, no caching if empty
+  llvm::StringRef cacheDir;
+
+  /// Symbols to define in the JIT, e.g. the data of the external inputs
+  llvm::function_ref<llvm::orc::SymbolMap(llvm::orc::MangleAndInterner)>
+      symbolMap = nullptr;
+};
+
+/// Translates the module to LLVM IR and compiles it to an object file, or
+/// reads the object file compiled for the same LLVM IR from the cache, and
+/// returns a JIT with the object file loaded
+llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>>
+createCachedJit(ModuleOp module, const CachedJitOptions &options);
+
+} // namespace mlir
+
+#endif // TPP_RUN_CACHEDJIT_H
@@ -0,0 +1,178 @@
+//===- ExternalInputs.cpp - Files bound to JIT globals --------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Binds globals of a JIT-ed module to data in memory-mapped files.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ExternalInputs.h"
+
+#include "mlir/IR/BuiltinTypes.h"
+
+#include "llvm/ExecutionEngine/JITSymbol.h"
+
+#include <cstdlib>
+#include <string>
+#include <system_error>
+
+using namespace mlir;
+
+static llvm::Error makeError(llvm::StringRef path, const llvm::Twine &reason) {
+  return llvm::make_error<llvm::StringError>(
+      "Cannot load input '" + path + "': " + reason,
+      llvm::inconvertibleErrorCode());
+}
+
+/// Returns the value of 'key' in the .npy header dictionary
+static std::string getNpyField(const std::string &header, const char *key) {
+  size_t pos = header.find(key);
+  if (pos == std::string::npos)
+    return "";
+  pos = header.find(':', pos);
+  if (pos == std::string::npos)
+    return "";
+  pos = header.find_first_not_of(' ', pos + 1);
+  if (pos == std::string::npos)
+    return "";
+  // Tuples end with ')', everything else with ','
+  char end = header[pos] == '(' ? ')' : ',';
+  size_t last = header.find(end, pos);
+  if (last == std::string::npos)
+    return "";
+  return header.substr(pos, last - pos + (end == ')'));
+}
+
+/// Parses a .npy header, returns the offset of the data. See:
+/// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+static llvm::Expected<size_t> parseNpyHeader(llvm::StringRef path,
+                                             llvm::StringRef file,
+                                             int64_t elementSize,
+                                             int64_t numElements) {
+  size_t headerLen, headerStart;
+  // Version 1 has a 2-byte header length, versions 2 and 3 a 4-byte one
+  if (file.size() < 10)
+    return makeError(path, "truncated .npy header");
+  if (file[6] < 1 || file[6] > 3)
+    return makeError(path, "unsupported .npy version");
+  if (file[6] != 1 && file.size() < 12)
+    return makeError(path, "truncated .npy header");
+  if (file[6] == 1) {
+    headerLen = (unsigned char)file[8] | ((unsigned char)file[9] << 8);
+    headerStart = 10;
+  } else {
+    headerLen = 0;
+    for (int i = 3; i >= 0; i--)
+      headerLen = (headerLen << 8) | (unsigned char)file[8 + i];
+    headerStart = 12;
+  }
+  if (headerStart + headerLen > file.size())
+    return makeError(path, "truncated .npy header");
+  std::string header = file.substr(headerStart, headerLen).str();
+
+  // Little endian float for f32, any 2-byte type for bf16 (numpy has no bf16)
+  std::string descr = getNpyField(header, "'descr'");
+  bool typeMatches = elementSize == 4
+                         ? descr == "'<f4'"
+                         : descr == "'<u2'" || descr == "'<i2'" ||
+                               descr == "'<V2'" || descr == "'|V2'";
+  if (!typeMatches)
+    return makeError(path, "element type doesn't match the argument");
+  if (getNpyField(header, "'fortran_order'") != "False")
+    return makeError(path, "only C order is supported");
+
+  // Product of the shape tuple
+  std::string shape = getNpyField(header, "'shape'");
+  if (shape.empty() || shape[0] != '(')
+    return makeError(path, "malformed .npy shape");
+  int64_t count = 1;
+  const char *ptr = shape.c_str();
+  while (*ptr) {
+    if (*ptr >= '0' && *ptr <= '9')
+      count *= strtoll(ptr, const_cast<char **>(&ptr), 10);
+    else
+      ptr++;
+  }
+  if (count != numElements)
+    return makeError(path, "number of elements doesn't match the argument");
+
+  return headerStart + headerLen;
+}
+
+/// Maps the whole file
+static llvm::Error mapFile(llvm::StringRef path,
+                           llvm::sys::fs::mapped_file_region::mapmode mode,
+                           std::unique_ptr<llvm::sys::fs::mapped_file_region>
+                               &mapping) {
+  auto fd = llvm::sys::fs::openNativeFileForRead(path);
+  if (!fd)
+    return makeError(path, llvm::toString(fd.takeError()));
+  llvm::sys::fs::file_status status;
+  std::error_code ec = llvm::sys::fs::status(*fd, status);
+  if (!ec && status.getSize() == 0)
+    ec = std::make_error_code(std::errc::invalid_argument);
+  if (!ec)
+    mapping = std::make_unique<llvm::sys::fs::mapped_file_region>(
+        *fd, mode, status.getSize(), /*offset=*/0, ec);
+  llvm::sys::fs::closeFile(*fd);
+  if (ec)
+    return makeError(path, "cannot map file: " + ec.message());
+  return llvm::Error::success();
+}
+
+llvm::Error ExternalInputs::bind(llvm::StringRef global, llvm::StringRef path,
+                                 int64_t offset, MemRefType type,
+                                 bool writable) {
+  auto elementType = type.getElementType();
+  if (!elementType.isF32() && !elementType.isBF16())
+    return makeError(path, "unsupported element type");
+  int64_t elementSize = elementType.getIntOrFloatBitWidth() / 8;
+  int64_t numElements = type.getNumElements();
+  size_t numBytes = numElements * elementSize;
+
+  // The globals reading the same file share its pages until they write
+  std::unique_ptr<Mapping> *mapping;
+  if (writable) {
+    privateMappings.emplace_back();
+    mapping = &privateMappings.back();
+    if (auto err = mapFile(path, Mapping::priv, *mapping))
+      return err;
+  } else {
+    mapping = &sharedMappings[path];
+    if (!*mapping)
+      if (auto err = mapFile(path, Mapping::readonly, *mapping))
+        return err;
+  }
+  llvm::StringRef file((*mapping)->const_data(), (*mapping)->size());
+
+  size_t dataStart = offset >= 0 ? offset : 0;
+  if (offset < 0 && file.startswith("\x93NUMPY")) {
+    auto npyStart = parseNpyHeader(path, file, elementSize, numElements);
+    if (!npyStart)
+      return npyStart.takeError();
+    dataStart = *npyStart;
+  }
+  if (dataStart + numBytes > file.size())
+    return makeError(path, "file is smaller than the argument");
+  // The mapping is page aligned, .npy data and side file constants are
+  // aligned further than their elements
+  if (dataStart % elementSize)
+    return makeError(path, "data is not aligned to its element type");
+
+  symbols[global] = file.data() + dataStart;
+  return llvm::Error::success();
+}
+
+llvm::orc::SymbolMap
+ExternalInputs::getSymbols(llvm::orc::MangleAndInterner interner) const {
+  llvm::orc::SymbolMap symbolMap;
+  for (auto &symbol : symbols)
+    symbolMap[interner(symbol.getKey())] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(symbol.getValue()),
+        llvm::JITSymbolFlags::Exported);
+  return symbolMap;
+}
@@ -0,0 +1,65 @@
+//===- ExternalInputs.h - Files bound to JIT globals ------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Binds globals of a JIT-ed module to data in files: kernel arguments loaded
+// with -input and constants moved to a side file by -externalize-constants.
+// The globals are only declared in the module and the JIT resolves their
+// symbols to the data in a memory mapping of the file, so nothing is copied
+// and the pages are shared, through the page cache, by every process that
+// maps the same file.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_RUN_EXTERNALINPUTS_H
+#define TPP_RUN_EXTERNALINPUTS_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ExecutionEngine/Orc/Core.h"
+#include "llvm/ExecutionEngine/Orc/Mangling.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+
+#include <memory>
+
+namespace mlir {
+class MemRefType;
+
+/// ExternalInputs - Memory mappings backing the globals filled from files.
+///
+/// The mappings are released with this object, which must outlive the
+/// execution engine running the module.
+class ExternalInputs {
+  using Mapping = llvm::sys::fs::mapped_file_region;
+
+  /// Read-only mappings, by path, shared by the globals reading that file
+  llvm::StringMap<std::unique_ptr<Mapping>> sharedMappings;
+
+  /// Copy-on-write mappings, one per writable global
+  llvm::SmallVector<std::unique_ptr<Mapping>> privateMappings;
+
+  /// Address of the data of each global, by symbol name
+  llvm::StringMap<const char *> symbols;
+
+public:
+  /// Binds the global to the data of the given type in the file. With a
+  /// negative offset, the file is parsed as .npy if it has the .npy magic and
+  /// read as raw data otherwise. With a positive offset, the raw data is read
+  /// from that offset. Read-only globals share a read-only mapping of the
+  /// file, writable ones (e.g. the kernel's output) get a private mapping, so
+  /// that they only copy the pages they write to.
+  llvm::Error bind(llvm::StringRef global, llvm::StringRef path,
+                   int64_t offset, MemRefType type, bool writable);
+
+  /// Symbols of the bound globals, to register with the execution engine
+  llvm::orc::SymbolMap getSymbols(llvm::orc::MangleAndInterner) const;
+};
+
+} // namespace mlir
+
+#endif // TPP_RUN_EXTERNALINPUTS_H
@@ -7,11 +7,20 @@
 //===----------------------------------------------------------------------===//
 
 #include "MLIRBench.h"
+#include "ExternalInputs.h"
+
+#include "TPP/Dialect/Check/CheckDialect.h"
+#include "TPP/Dialect/Check/CheckOps.h"
+#include "TPP/Passes.h"
+#include "TPP/Transforms.h"
 
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Arith/Transforms/Passes.h"
+#include "mlir/Dialect/Bufferization/IR/BufferizableOpInterface.h"
+#include "mlir/Dialect/Bufferization/Transforms/Passes.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Passes.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
@@ -26,17 +35,21 @@
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <random>
 
 using namespace mlir;
 
-MLIRBench::MLIRBench(mlir::Operation *op)
-    : builder(op->getContext()), unkLoc(builder.getUnknownLoc()) {
+MLIRBench::MLIRBench(mlir::Operation *op, unsigned seed)
+    : builder(op->getContext()), unkLoc(builder.getUnknownLoc()), seed(seed) {
   module = dyn_cast<ModuleOp>(op);
   assert(module && "expected a 'builtin.Module' op");
   auto *ctx = module->getContext();
   ctx->getOrLoadDialect<tensor::TensorDialect>();
   ctx->getOrLoadDialect<vector::VectorDialect>();
   ctx->getOrLoadDialect<scf::SCFDialect>();
+  ctx->getOrLoadDialect<check::CheckDialect>();
 
   // TODO: Remove this once we use the perf dialect
   declareGlobalFunctions();
@@ -86,6 +99,92 @@ LogicalResult MLIRBench::checkKernelSignature() {
   return success();
 }
 
+LogicalResult MLIRBench::bindShape(unsigned argNum,
+                                   llvm::ArrayRef<int64_t> shape) {
+  auto funcType = kernel.getFunctionType();
+  if (argNum >= funcType.getNumInputs())
+    return emitError("Shape bound to arg" + Twine(argNum) +
+                     ", but kernel only has " +
+                     Twine(funcType.getNumInputs()) + " arguments");
+  argShapes[argNum] = SmallVector<int64_t>(shape.begin(), shape.end());
+  return success();
+}
+
+LogicalResult MLIRBench::specializeKernel() {
+  if (argShapes.empty())
+    return success();
+  return tpp::specializeShapes(kernel, argShapes);
+}
+
+LogicalResult MLIRBench::createReferenceKernel() {
+  // Clone the whole module, so that anything the kernel calls is still there
+  referenceModule = module.clone();
+  auto refKernel =
+      referenceModule->lookupSymbol<func::FuncOp>(kernel.getName());
+  assert(refKernel && "Kernel not found in the cloned module");
+
+  // Lower the copy without any TPP optimization, using the same
+  // bufferization options as the TPP pipeline, so the signatures match
+  PassManager passManager(module->getContext());
+  applyPassManagerCLOptions(passManager);
+
+  bufferization::OneShotBufferizationOptions buffOpts;
+  buffOpts.bufferizeFunctionBoundaries = true;
+  buffOpts.allowReturnAllocs = true;
+  buffOpts.functionBoundaryTypeConversion =
+      bufferization::BufferizationOptions::LayoutMapOption::IdentityLayoutMap;
+  passManager.addNestedPass<func::FuncOp>(
+      bufferization::createEmptyTensorToAllocTensorPass());
+  passManager.addPass(bufferization::createOneShotBufferizePass(buffOpts));
+  passManager.addNestedPass<func::FuncOp>(createCanonicalizerPass());
+  passManager.addPass(bufferization::createDropEquivalentBufferResultsPass());
+  passManager.addNestedPass<func::FuncOp>(
+      bufferization::createFinalizingBufferizePass());
+
+  // Reference lowering
+  passManager.addNestedPass<func::FuncOp>(tpp::createConvertTppToLoopsPass());
+  passManager.addNestedPass<func::FuncOp>(tpp::createLinalgXToLoopsPass());
+  passManager.addNestedPass<func::FuncOp>(createConvertLinalgToLoopsPass());
+
+  auto result = passManager.run(*referenceModule);
+  if (failed(result)) {
+    llvm::errs() << "ERROR: Failed to lower the reference kernel\n";
+    referenceModule->dump();
+    return result;
+  }
+
+  // Keep the reference module around, the kernel is moved into the main one
+  // by createMainWrapper, after the main module is optimized
+  reference = refKernel;
+  reference.setName(
+      builder.getStringAttr("_" + kernel.getName() + "_reference"));
+
+  return success();
+}
+
+LogicalResult MLIRBench::runTppPipeline(bool aggressive, StringRef cacheDir) {
+  PassManager passManager(module->getContext());
+  applyPassManagerCLOptions(passManager);
+  passManager.addPass(
+      tpp::createDefaultTppPass(aggressive, /*preDispatch=*/false, cacheDir));
+
+  // A cached output replaces the module's operations, kernel included
+  std::string kernelName = kernel.getName().str();
+  auto result = passManager.run(module);
+  if (failed(result)) {
+    llvm::errs() << "ERROR: Failed to run the TPP pipeline\n";
+    module->dump();
+    return result;
+  }
+
+  kernel = dyn_cast_or_null<func::FuncOp>(
+      SymbolTable::lookupSymbolIn(module, kernelName));
+  if (!kernel)
+    return module.emitError("Kernel " + kernelName +
+                             " not found after the TPP pipeline");
+  return result;
+}
+
 LogicalResult MLIRBench::renameKernel() {
   // Rename the entry point to something else and make the main the entry point
   // This is required because we can't change the original Name
@@ -101,15 +200,134 @@ MLIRBench::createGlobals(llvm::SmallVector<llvm::StringRef> &list) {
   // Create global dense memrefs (Module insertion point)
   builder.setInsertionPointToStart(&getModuleBlock());
   auto funcType = kernel.getFunctionType();
-  for (auto &ty : funcType.getInputs()) {
-    auto memRefTy = dyn_cast_or_null<MemRefType>(ty);
-    list.push_back(createGlobal(memRefTy));
+  for (auto &en : llvm::enumerate(funcType.getInputs())) {
+    auto memRefTy = dyn_cast_or_null<MemRefType>(en.value());
+    if (!memRefTy || !memRefTy.hasStaticShape())
+      return emitError("Argument " + Twine(en.index()) +
+                       " has a dynamic shape, bind it with -shape=arg" +
+                       Twine(en.index()) + ":DxD..");
+    auto input = inputFiles.find(en.index());
+    if (input == inputFiles.end()) {
+      list.push_back(createGlobal(memRefTy));
+      continue;
+    }
+    // Bound to a file, loaded at runtime instead of initialised in the IR
+    auto name = createGlobal(memRefTy, /*initialize=*/false);
+    externalInputs.push_back({name.str(), input->second, /*offset=*/-1});
+    list.push_back(name);
+  }
+
+  return success();
+}
+
+void MLIRBench::moveReferenceKernel() {
+  // Bring the globals the reference uses along (constants created by its
+  // bufferization), and the functions it calls, transitively. Those were
+  // lowered with it and must not resolve to the optimized copies, so they are
+  // renamed if they clash with the main module's. Declarations are shared.
+  llvm::DenseMap<StringAttr, StringAttr> renames;
+  auto moveSymbol = [&](StringAttr name, Operation *op) {
+    op->remove();
+    if (module.lookupSymbol(name))
+      SymbolTable::setSymbolName(op, (name.getValue() + "_reference").str());
+    module.push_back(op);
+    renames[name] = SymbolTable::getSymbolName(op);
+  };
+
+  llvm::SmallVector<func::FuncOp> worklist{reference};
+  while (!worklist.empty()) {
+    func::FuncOp func = worklist.pop_back_val();
+    func.walk([&](memref::GetGlobalOp getGlobal) {
+      auto name = getGlobal.getNameAttr().getAttr();
+      if (!renames.count(name)) {
+        auto global = referenceModule->lookupSymbol<memref::GlobalOp>(name);
+        if (!global)
+          return;
+        moveSymbol(name, global);
+      }
+      getGlobal.setNameAttr(FlatSymbolRefAttr::get(renames[name]));
+    });
+    func.walk([&](func::CallOp call) {
+      auto name = call.getCalleeAttr().getAttr();
+      if (!renames.count(name)) {
+        auto callee = referenceModule->lookupSymbol<func::FuncOp>(name);
+        if (!callee)
+          return;
+        if (callee.isDeclaration() && module.lookupSymbol(name)) {
+          renames[name] = name;
+          return;
+        }
+        moveSymbol(name, callee);
+        if (!callee.isDeclaration())
+          worklist.push_back(callee);
+      }
+      call.setCalleeAttr(FlatSymbolRefAttr::get(renames[name]));
+    });
+  }
+
+  reference->remove();
+  module.push_back(reference);
+  referenceModule = nullptr;
+}
+
+LogicalResult MLIRBench::bindInput(unsigned argNum, llvm::StringRef file) {
+  auto funcType = kernel.getFunctionType();
+  if (argNum >= funcType.getNumInputs())
+    return emitError("Input bound to arg" + Twine(argNum) +
+                     ", but kernel only has " +
+                     Twine(funcType.getNumInputs()) + " arguments");
+  inputFiles[argNum] = file.str();
+  return success();
+}
+
+LogicalResult MLIRBench::loadExternalInputs(ExternalInputs &inputs) {
+  // Constants moved to a side file by -externalize-constants. By now they
+  // are bufferized into globals
+  auto resources =
+      module->getAttrOfType<DictionaryAttr>("tpp.external_resources");
+  if (resources) {
+    auto file = resources.getAs<StringAttr>("file");
+    auto offsets = resources.getAs<DictionaryAttr>("offsets");
+    if (!file || !offsets)
+      return emitError("Malformed tpp.external_resources attribute");
+    for (auto global : module.getOps<memref::GlobalOp>()) {
+      auto init = global.getInitialValue();
+      if (!init)
+        continue;
+      auto resource = init->dyn_cast<DenseResourceElementsAttr>();
+      if (!resource)
+        continue;
+      auto offset =
+          offsets.getAs<IntegerAttr>(resource.getRawHandle().getKey());
+      if (!offset)
+        return emitError("No offset for resource " +
+                         resource.getRawHandle().getKey());
+      externalInputs.push_back(
+          {global.getSymName().str(), file.str(), offset.getInt()});
+    }
+  }
+
+  // Turn the globals into declarations, which the JIT resolves to the data in
+  // the files' mappings. Only the pages the kernel reads are ever loaded, and
+  // they are shared with any other process mapping the same file
+  for (auto &input : externalInputs) {
+    auto global = module.lookupSymbol<memref::GlobalOp>(input.global);
+    if (auto err = inputs.bind(input.global, input.path, input.offset,
+                               global.getType(), !global.getConstant()))
+      return emitError(llvm::toString(std::move(err)));
+    global.removeInitialValueAttr();
+    global.removeAlignmentAttr();
+    global.setPublic();
   }
 
   return success();
 }
 
 LogicalResult MLIRBench::createMainWrapper() {
+  // The module is optimized by now, we can bring the reference in
+  if (referenceModule)
+    moveReferenceKernel();
+
   // Add a `main` function (with no args/rets) to handle init/tear down
   auto funcType = builder.getFunctionType({}, {});
   main = func::FuncOp::create(unkLoc, mainName, funcType);
@@ -122,36 +340,89 @@ LogicalResult MLIRBench::createMainWrapper() {
 }
 
 Value MLIRBench::callKernel(llvm::SmallVector<llvm::StringRef> &list) {
-  // Get those globals as arguments (function insertion point)
-  // Cache locally, so we can avoid doing it again inside the loop
-  if (kernelArgs.empty()) {
-    for (auto &name : list) {
-      // GetGlobal op properties
-      auto nameAttr = builder.getStringAttr(name);
-      auto type = getGlobalType(name);
-      auto getGlobal =
-          builder.create<memref::GetGlobalOp>(unkLoc, type, nameAttr);
-
-      // Add argument to list
-      kernelArgs.push_back(getGlobal);
-    }
-  }
+  auto &args = getKernelArgs(list);
 
   // Call the Kernel, making sure to set the result to either the return value
   // or the last argument, if the return is void.
   Value result;
-  auto funcType = main.getFunctionType();
+  auto funcType = kernel.getFunctionType();
   if (funcType.getNumResults() == 0) {
-    builder.create<func::CallOp>(unkLoc, kernel, kernelArgs);
-    result = kernelArgs.back();
+    builder.create<func::CallOp>(unkLoc, kernel, args);
+    result = args.back();
   } else {
-    auto call = builder.create<func::CallOp>(unkLoc, kernel, kernelArgs);
+    auto call = builder.create<func::CallOp>(unkLoc, kernel, args);
     result = call->getOpResult(0);
   }
 
   return result;
 }
 
+Value MLIRBench::callReference(llvm::SmallVector<llvm::StringRef> &list) {
+  assert(reference && "Reference kernel not created");
+  if (reference.getFunctionType() != kernel.getFunctionType()) {
+    emitError("Reference kernel signature doesn't match the kernel's");
+    return nullptr;
+  }
+
+  // Inputs are shared, but the output is copied, so that the reference
+  // doesn't accumulate on top of the kernel's result (or vice-versa)
+  SmallVector<Value> args(getKernelArgs(list));
+  auto funcType = reference.getFunctionType();
+  if (funcType.getNumResults() != 0) {
+    auto call = builder.create<func::CallOp>(unkLoc, reference, args);
+    return call->getOpResult(0);
+  }
+
+  auto outType = args.back().getType().cast<MemRefType>();
+  Value copy = builder.create<memref::AllocOp>(unkLoc, outType);
+  builder.create<memref::CopyOp>(unkLoc, args.back(), copy);
+  args.back() = copy;
+  builder.create<func::CallOp>(unkLoc, reference, args);
+
+  return copy;
+}
+
+LogicalResult MLIRBench::verifyResult(Value result, Value refResult,
+                                      float threshold, float relThreshold) {
+  // bf16 results are compared in f32, bf16 itself has no precision to spare
+  auto resultType = result.getType().dyn_cast<MemRefType>();
+  auto kernelResult = result;
+  auto kernelRefResult = refResult;
+  auto f32Result = getF32MemRef(result);
+  auto f32RefResult = getF32MemRef(refResult);
+  if (!resultType || failed(f32Result) || failed(f32RefResult))
+    return emitError("Verification only supports f32 and bf16 memrefs");
+  result = *f32Result;
+  refResult = *f32RefResult;
+
+  // Report the errors first, so we know by how much it failed
+  auto f32 = builder.getF32Type();
+  auto unrankedType = UnrankedMemRefType::get(f32, resultType.getMemorySpace());
+  auto thresholdVal = builder.create<arith::ConstantFloatOp>(
+      unkLoc, APFloat(threshold), f32);
+  auto relThresholdVal = builder.create<arith::ConstantFloatOp>(
+      unkLoc, APFloat(relThreshold), f32);
+  auto unrankedResult =
+      builder.create<memref::CastOp>(unkLoc, unrankedType, result);
+  auto unrankedRef =
+      builder.create<memref::CastOp>(unkLoc, unrankedType, refResult);
+  auto pass = builder.create<func::CallOp>(
+      unkLoc, errorStats,
+      ValueRange{unrankedResult, unrankedRef, thresholdVal, relThresholdVal});
+
+  // Then fail hard if the results don't match
+  builder.create<check::ExpectTrueOp>(unkLoc, pass->getResult(0));
+
+  if (result != kernelResult)
+    builder.create<memref::DeallocOp>(unkLoc, result);
+  if (refResult != kernelRefResult)
+    builder.create<memref::DeallocOp>(unkLoc, refResult);
+  if (kernelRefResult.getDefiningOp<memref::AllocOp>())
+    builder.create<memref::DeallocOp>(unkLoc, kernelRefResult);
+
+  return success();
+}
+
 Value MLIRBench::createTimerLoop(llvm::SmallVector<llvm::StringRef> &list,
                                  unsigned n) {
   // Allocates the vector for results
@@ -265,38 +536,41 @@ LogicalResult MLIRBench::printMemRef(mlir::Value memRef) {
   return success();
 }
 
+LogicalResult MLIRBench::printChecksum(Value memRef) {
+  // The reduction happens in the runtime, which takes unranked memrefs
+  auto memRefType = memRef.getType().dyn_cast<MemRefType>();
+  auto f32MemRef = getF32MemRef(memRef);
+  if (!memRefType || failed(f32MemRef))
+    return emitError("Checksum only supports f32 and bf16 memrefs");
+
+  auto unrankedType = UnrankedMemRefType::get(builder.getF32Type(),
+                                              memRefType.getMemorySpace());
+  auto unranked =
+      builder.create<memref::CastOp>(unkLoc, unrankedType, *f32MemRef);
+  builder.create<func::CallOp>(unkLoc, checksum, ValueRange{unranked});
+  if (*f32MemRef != memRef)
+    builder.create<memref::DeallocOp>(unkLoc, *f32MemRef);
+
+  return success();
+}
+
 LogicalResult MLIRBench::finalize() {
   // If we created a main at all...
   // return void and add func to Module
   if (main) {
+    for (auto buffer : hugeBuffers)
+      builder.create<func::CallOp>(unkLoc, getHugeFreeFunc(),
+                                   ValueRange{buffer});
     builder.create<func::ReturnOp>(unkLoc);
   }
 
   // Minimal passes to make it work
-  // We don't want TPP passes here, as that's the job of tpp-opt
+  // We don't want TPP passes here, as that's the job of tpp-opt or of the
+  // -tpp-pipeline option, which runs before we get here
   // The IR here should be free of TPP/XSMM or any TPP extensions
   PassManager passManager(module->getContext());
   applyPassManagerCLOptions(passManager);
-
-  // Bufferization, if needed
-  passManager.addNestedPass<func::FuncOp>(createTensorBufferizePass());
-  passManager.addNestedPass<func::FuncOp>(vector::createVectorBufferizePass());
-  passManager.addNestedPass<func::FuncOp>(createLinalgBufferizePass());
-
-  // Partial Lowering
-  passManager.addPass(createConvertTensorToLinalgPass());
-  passManager.addNestedPass<func::FuncOp>(createConvertLinalgToLoopsPass());
-  passManager.addPass(arith::createArithExpandOpsPass());
-  passManager.addPass(createConvertVectorToSCFPass());
-  passManager.addPass(createConvertSCFToCFPass());
-
-  // Lower to LLVM
-  passManager.addPass(createConvertVectorToLLVMPass());
-  passManager.addPass(createConvertFuncToLLVMPass());
-  passManager.addPass(createMemRefToLLVMConversionPass());
-  passManager.addNestedPass<func::FuncOp>(createArithToLLVMConversionPass());
-  passManager.addNestedPass<func::FuncOp>(createCanonicalizerPass());
-  passManager.addPass(createReconcileUnrealizedCastsPass());
+  tpp::addLLVMLoweringPasses(passManager, parallel);
 
   auto result = passManager.run(module);
   if (failed(result)) {
@@ -309,13 +583,37 @@ LogicalResult MLIRBench::finalize() {
 
 //----------------------- Helpers & private methods
 
-llvm::StringRef MLIRBench::createGlobal(MemRefType type) {
+FailureOr<Value> MLIRBench::getF32MemRef(Value memRef) {
+  auto type = memRef.getType().dyn_cast<MemRefType>();
+  if (!type)
+    return failure();
+  if (type.getElementType().isF32())
+    return memRef;
+  if (!type.getElementType().isBF16() || !type.hasStaticShape())
+    return failure();
+
+  // Element-wise extension, lowered to loops with the rest of the wrapper
+  auto f32 = builder.getF32Type();
+  auto copyType =
+      MemRefType::get(type.getShape(), f32, {}, type.getMemorySpace());
+  Value copy = builder.create<memref::AllocOp>(unkLoc, copyType);
+  auto map = builder.getMultiDimIdentityMap(type.getRank());
+  SmallVector<utils::IteratorType> iterators(type.getRank(),
+                                             utils::IteratorType::parallel);
+  builder.create<linalg::GenericOp>(
+      unkLoc, ValueRange{memRef}, ValueRange{copy},
+      ArrayRef<AffineMap>{map, map}, iterators,
+      [&](OpBuilder &b, Location loc, ValueRange args) {
+        Value extended = b.create<arith::ExtFOp>(loc, f32, args[0]);
+        b.create<linalg::YieldOp>(loc, extended);
+      });
+  return copy;
+}
+
+llvm::StringRef MLIRBench::createGlobal(MemRefType type, bool initialize) {
   // Simple auto increment
   static unsigned order = 0;
 
-  // TODO: Use some random initialiser
-  APFloat floatValue = APFloat(1.0F);
-
   // Create global dense memrefs (Module insertion point)
   auto privAttr = builder.getStringAttr("private");
 
@@ -330,7 +628,34 @@ llvm::StringRef MLIRBench::createGlobal(MemRefType type) {
   // See: lib/Dialect/MemRef/IR/MemRefOps.cpp :: GlobalOp::verify
   auto tensorType =
       RankedTensorType::get(memrefTy.getShape(), memrefTy.getElementType());
-  auto floatInit = mlir::DenseElementsAttr::get(tensorType, floatValue);
+  auto elementType = memrefTy.getElementType().cast<FloatType>();
+  Attribute floatInit;
+  if (!initialize) {
+    // Backed by a file, see loadExternalInputs
+    floatInit = builder.getUnitAttr();
+  } else if (seed) {
+    // Random values in [0, 1), different for each global but reproducible
+    std::mt19937 generator(seed + order);
+    std::uniform_real_distribution<float> distribution(0.0F, 1.0F);
+    SmallVector<APFloat> values;
+    values.reserve(tensorType.getNumElements());
+    for (int64_t i = 0, e = tensorType.getNumElements(); i < e; i++) {
+      APFloat value(distribution(generator));
+      bool losesInfo;
+      value.convert(elementType.getFloatSemantics(),
+                    APFloat::rmNearestTiesToEven, &losesInfo);
+      values.push_back(value);
+    }
+    floatInit = DenseElementsAttr::get(tensorType, values);
+  } else {
+    // All ones. The splat must carry the element type's semantics: a bf16
+    // tensor built from an f32 APFloat asserts
+    APFloat one(1.0F);
+    bool losesInfo;
+    one.convert(elementType.getFloatSemantics(), APFloat::rmNearestTiesToEven,
+                &losesInfo);
+    floatInit = DenseElementsAttr::get(tensorType, one);
+  }
   auto alignment = builder.getIntegerAttr(builder.getI64Type(), 128);
 
   // Create the global object in the Module's region
@@ -341,6 +666,76 @@ llvm::StringRef MLIRBench::createGlobal(MemRefType type) {
   return global.getName();
 }
 
+LogicalResult MLIRBench::bindNumaNode(int64_t node) {
+  auto i64 = builder.getI64Type();
+  auto bind = module.lookupSymbol<func::FuncOp>("tpp_numa_bind");
+  if (!bind) {
+    bind = func::FuncOp::create(unkLoc, "tpp_numa_bind",
+                                builder.getFunctionType({i64}, {i64}));
+    bind->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                  UnitAttr::get(module->getContext()));
+    bind.setPrivate();
+    module.push_back(bind);
+  }
+
+  // Failing to bind only costs performance, the runtime reports it
+  auto nodeVal = builder.create<arith::ConstantOp>(
+      unkLoc, i64, builder.getIntegerAttr(i64, node));
+  builder.create<func::CallOp>(unkLoc, bind, ValueRange{nodeVal});
+  return success();
+}
+
+func::FuncOp MLIRBench::getHugeAllocFunc() {
+  // Same declaration as -huge-page-allocation, which may have added it
+  if (auto func = module.lookupSymbol<func::FuncOp>("tpp_huge_alloc"))
+    return func;
+
+  auto bufferType =
+      MemRefType::get({ShapedType::kDynamic}, builder.getIntegerType(8));
+  auto func = func::FuncOp::create(
+      unkLoc, "tpp_huge_alloc",
+      builder.getFunctionType({builder.getI64Type()}, {bufferType}));
+  func->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                UnitAttr::get(module->getContext()));
+  func.setPrivate();
+  module.push_back(func);
+  return func;
+}
+
+func::FuncOp MLIRBench::getHugeFreeFunc() {
+  if (auto func = module.lookupSymbol<func::FuncOp>("tpp_huge_free"))
+    return func;
+
+  auto bufferType =
+      MemRefType::get({ShapedType::kDynamic}, builder.getIntegerType(8));
+  auto func = func::FuncOp::create(unkLoc, "tpp_huge_free",
+                                   builder.getFunctionType({bufferType}, {}));
+  func->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                UnitAttr::get(module->getContext()));
+  func.setPrivate();
+  module.push_back(func);
+  return func;
+}
+
+Value MLIRBench::copyToHugePages(Value global) {
+  auto type = global.getType().cast<MemRefType>();
+  auto bytes = llvm::divideCeil(
+      type.getNumElements() * type.getElementTypeBitWidth(), 8);
+  auto i64 = builder.getI64Type();
+  auto size = builder.create<arith::ConstantOp>(
+      unkLoc, i64, builder.getIntegerAttr(i64, bytes));
+  auto buffer = builder.create<func::CallOp>(unkLoc, getHugeAllocFunc(),
+                                             ValueRange{size})
+                    .getResult(0);
+  hugeBuffers.push_back(buffer);
+
+  auto zero = builder.create<arith::ConstantIndexOp>(unkLoc, 0);
+  Value view = builder.create<memref::ViewOp>(unkLoc, type, buffer, zero,
+                                              ValueRange{});
+  builder.create<memref::CopyOp>(unkLoc, global, view);
+  return view;
+}
+
 void MLIRBench::declareGlobalFunctions() {
   // Common function attributes
   auto cifaceAttr = LLVM::LLVMDialect::getEmitCWrapperAttrName();
@@ -385,6 +780,44 @@ void MLIRBench::declareGlobalFunctions() {
   timer.deviation->setAttr(cifaceAttr, unitAttr);
   timer.deviation->setAttr(visAttr, privAttr);
   module.push_back(timer.deviation);
+
+  // Verification report
+  auto f32 = builder.getF32Type();
+  auto unrankedF32 = UnrankedMemRefType::get(f32, 0);
+  errorStats = func::FuncOp::create(
+      unkLoc, "print_error_stats",
+      builder.getFunctionType({unrankedF32, unrankedF32, f32, f32},
+                              {builder.getI1Type()}));
+  errorStats->setAttr(cifaceAttr, unitAttr);
+  errorStats->setAttr(visAttr, privAttr);
+  module.push_back(errorStats);
+
+  // Checksum
+  checksum = func::FuncOp::create(unkLoc, "print_checksum",
+                                  builder.getFunctionType({unrankedF32}, {}));
+  checksum->setAttr(cifaceAttr, unitAttr);
+  checksum->setAttr(visAttr, privAttr);
+  module.push_back(checksum);
+}
+
+llvm::SmallVector<Value> &
+MLIRBench::getKernelArgs(llvm::SmallVector<llvm::StringRef> &list) {
+  // Get those globals as arguments (function insertion point)
+  // Cache locally, so we can avoid doing it again inside the loop
+  if (kernelArgs.empty()) {
+    for (auto &name : list) {
+      // GetGlobal op properties
+      auto nameAttr = builder.getStringAttr(name);
+      auto type = getGlobalType(name);
+      Value arg = builder.create<memref::GetGlobalOp>(unkLoc, type, nameAttr);
+      if (hugePageGlobals)
+        arg = copyToHugePages(arg);
+
+      // Add argument to list
+      kernelArgs.push_back(arg);
+    }
+  }
+  return kernelArgs;
 }
 
 MemRefType MLIRBench::getGlobalType(llvm::StringRef name) {
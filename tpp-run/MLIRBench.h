@@ -13,14 +13,18 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Location.h"
+#include "mlir/IR/OwningOpRef.h"
 #include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 
 namespace mlir {
+class ExternalInputs;
 class ModuleOp;
 class MemRefType;
 class Operation;
+class OpPassManager;
 class Value;
 namespace func {
 class FuncOp;
@@ -45,6 +49,15 @@ class MLIRBench {
   /// Kernel function, if found
   func::FuncOp kernel;
 
+  /// Reference kernel, lowered to loops, if requested
+  func::FuncOp reference;
+
+  /// Module holding the reference kernel until it's moved into the main one
+  OwningOpRef<ModuleOp> referenceModule;
+
+  /// Seed for the random initialisation of the globals (0 means all ones)
+  unsigned seed;
+
   /// Values of the kernel arguments (no need to declare every time)
   llvm::SmallVector<Value> kernelArgs;
 
@@ -57,8 +70,44 @@ class MLIRBench {
   /// Global variables for all arguments (in order)
   llvm::SmallVector<llvm::StringRef> globals;
 
-  /// Create a random global based on the memref type
-  llvm::StringRef createGlobal(MemRefType);
+  /// Static shapes bound to kernel arguments, by argument number
+  llvm::DenseMap<unsigned, llvm::SmallVector<int64_t>> argShapes;
+
+  /// Files bound to kernel arguments, by argument number
+  llvm::DenseMap<unsigned, std::string> inputFiles;
+
+  /// Globals backed by files (-1 offset means auto-detect)
+  struct ExternalInput {
+    std::string global;
+    std::string path;
+    int64_t offset;
+  };
+  llvm::SmallVector<ExternalInput> externalInputs;
+
+  /// Copy the kernel arguments to huge page buffers before calling it
+  bool hugePageGlobals = false;
+
+  /// Huge page buffers holding the kernel arguments, released in finalize
+  llvm::SmallVector<Value> hugeBuffers;
+
+  /// Lower the parallel loops to OpenMP instead of sequential loops
+  bool parallel = false;
+
+  /// Create a random global based on the memref type, or an uninitialized one
+  /// if the data comes from elsewhere
+  llvm::StringRef createGlobal(MemRefType, bool initialize = true);
+
+  /// Get (or declare) the runtime functions managing huge page buffers
+  func::FuncOp getHugeAllocFunc();
+  func::FuncOp getHugeFreeFunc();
+
+  /// Copies a global to a huge page buffer, returns a view of the buffer
+  Value copyToHugePages(Value);
+
+  /// Returns an f32 copy of a bf16 memref, for the runtime helpers that only
+  /// take f32, or the memref itself if it is f32 already. Copies are
+  /// allocated, the caller deallocates them
+  FailureOr<Value> getF32MemRef(Value);
 
   /// Declare some required global functions
   /// TODO: This won't be needed after the perf dialect is used
@@ -70,16 +119,25 @@ class MLIRBench {
     func::FuncOp average;
     func::FuncOp deviation;
   } timer;
+  func::FuncOp errorStats;
+  func::FuncOp checksum;
 
   /// Get a global memref by name
   MemRefType getGlobalType(llvm::StringRef);
 
+  /// Moves the reference kernel, and the globals and functions it uses, into
+  /// the module
+  void moveReferenceKernel();
+
+  /// Get the kernel arguments from the globals, cached in kernelArgs
+  llvm::SmallVector<Value> &getKernelArgs(llvm::SmallVector<llvm::StringRef> &);
+
   /// Gets module's main block
   Block &getModuleBlock();
 
 public:
   /// Creates context, builder
-  MLIRBench(Operation *op);
+  MLIRBench(Operation *op, unsigned seed = 0);
 
   /// Finds the kernel method, checks correct name and shape
   LogicalResult findKernel(llvm::StringRef);
@@ -88,6 +146,24 @@ public:
   /// Find the kernel first with findKernel.
   LogicalResult checkKernelSignature();
 
+  /// Binds a static shape to a dynamically shaped kernel argument
+  LogicalResult bindShape(unsigned, llvm::ArrayRef<int64_t>);
+
+  /// Specializes the kernel to the shapes bound with bindShape, so that the
+  /// TPP pipeline only sees static shapes. Call right after findKernel
+  LogicalResult specializeKernel();
+
+  /// Clones the module and lowers the kernel's copy to plain loops, to be
+  /// used as the reference implementation. Must be called after findKernel
+  /// and before any optimizing pipeline runs on the module.
+  LogicalResult createReferenceKernel();
+
+  /// Runs the TPP compilation pipeline on the whole module, taking linalg on
+  /// tensors down to XSMM calls and vectors. Bufferization changes the
+  /// kernel's signature in place, so call it before createGlobals. With a
+  /// cache directory, the output is reused if the input was compiled before.
+  LogicalResult runTppPipeline(bool aggressive, StringRef cacheDir = "");
+
   /// Renames the kernel to _name, so that we can create the wrapper
   LogicalResult renameKernel();
 
@@ -95,6 +171,29 @@ public:
   /// Populates the list with the names, in order
   LogicalResult createGlobals(llvm::SmallVector<llvm::StringRef> &);
 
+  /// Binds a kernel argument to a file (.npy or raw), whose memory mapping
+  /// backs the argument's global. Call before createGlobals
+  LogicalResult bindInput(unsigned, llvm::StringRef);
+
+  /// Passes copies of the globals, in huge page buffers, to the kernel
+  /// instead of the globals themselves. Call before the first kernel call
+  void setHugePageGlobals(bool enable) { hugePageGlobals = enable; }
+
+  /// Runs the parallel loops on OpenMP threads, which needs the OpenMP
+  /// runtime in the shared libraries
+  void setParallel(bool enable) { parallel = enable; }
+
+  /// Binds the threads to a NUMA node, before anything touches memory. Call
+  /// right after createMainWrapper
+  LogicalResult bindNumaNode(int64_t);
+
+  /// Binds the globals of all external inputs to their files' mappings:
+  /// arguments bound with bindInput and constants moved to a side file by
+  /// -externalize-constants. The globals become declarations, resolved by
+  /// the JIT with the symbols of the ExternalInputs, which must outlive the
+  /// execution engine. Call after createMainWrapper
+  LogicalResult loadExternalInputs(ExternalInputs &);
+
   /// Create main wrapper function, sets insertion point
   LogicalResult createMainWrapper();
 
@@ -102,6 +201,16 @@ public:
   /// the return value (if any) or the last argument (outs).
   Value callKernel(llvm::SmallVector<llvm::StringRef> &);
 
+  /// Calls the reference kernel on the same inputs, returns its result. The
+  /// output argument is copied, so that the kernel's own isn't modified.
+  Value callReference(llvm::SmallVector<llvm::StringRef> &);
+
+  /// Compares the kernel's result against the reference: prints the maximum
+  /// errors and asserts each element is within the absolute threshold plus
+  /// the relative threshold times the reference value. f32 or bf16, which is
+  /// compared in f32.
+  LogicalResult verifyResult(Value, Value, float, float);
+
   /// Create a loop with a timer around the kernel call
   /// Returns the memref containing the timings
   /// TODO: Move this to create a perf.timer op
@@ -116,6 +225,9 @@ public:
   /// Prints the memref as a vector read + print
   LogicalResult printMemRef(Value);
 
+  /// Prints a one-line checksum of an f32 or bf16 memref of any rank
+  LogicalResult printChecksum(Value);
+
   /// Terminates the function, issuing a return, lower to LLVM
   LogicalResult finalize();
 
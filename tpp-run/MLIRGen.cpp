@@ -0,0 +1,278 @@
+//===- MLIRGen.cpp - MLIR Kernel Generator --------------------------------===//
+//
+// Generates linalg on tensors kernels (matmul, BRGEMM, MLP and convolution)
+// from a set of parameters, so that shape sweeps don't need hand-written
+// files. The kernels take every buffer as an argument, including the outputs,
+// so that tpp-run can allocate and initialise them all.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MLIRGen.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/AffineMap.h"
+#include "mlir/IR/BuiltinTypes.h"
+
+using namespace mlir;
+
+MLIRGen::MLIRGen(MLIRContext *ctx, const Parameters &params)
+    : builder(ctx), unkLoc(builder.getUnknownLoc()),
+      module(ModuleOp::create(unkLoc)), params(params) {
+  ctx->getOrLoadDialect<arith::ArithDialect>();
+  ctx->getOrLoadDialect<func::FuncDialect>();
+  ctx->getOrLoadDialect<linalg::LinalgDialect>();
+  ctx->getOrLoadDialect<tensor::TensorDialect>();
+  dataType = params.bf16 ? builder.getBF16Type() : builder.getF32Type();
+}
+
+FailureOr<ModuleOp> MLIRGen::generate() {
+  if (params.m <= 0 || params.n <= 0 || params.k <= 0 || params.batch <= 0 ||
+      params.layers <= 0)
+    return emitError("Sizes must be positive");
+  if (!params.blocking.empty()) {
+    if (params.blocking.size() != 3)
+      return emitError("Blocking needs three factors: bm, bn, bk");
+    int64_t bm = params.blocking[0], bn = params.blocking[1],
+            bk = params.blocking[2];
+    if (params.m % bm || params.n % bn || params.k % bk)
+      return emitError("Blocking factors must divide M, N and K");
+    if (params.kernel == KernelType::MLP && params.layers > 1 && bn != bk)
+      return emitError("Multi-layer blocked MLP needs bn == bk, the output "
+                       "of a layer is the input of the next");
+  }
+
+  LogicalResult result = failure();
+  switch (params.kernel) {
+  case KernelType::Matmul:
+    result = generateMatmul();
+    break;
+  case KernelType::BRGEMM:
+    result = generateBRGEMM();
+    break;
+  case KernelType::MLP:
+    result = generateMLP();
+    break;
+  case KernelType::Conv:
+    result = generateConv();
+    break;
+  }
+  if (failed(result))
+    return failure();
+
+  (*module)->setAttr("tpp.flops", builder.getI64IntegerAttr(flops));
+  return *module;
+}
+
+LogicalResult MLIRGen::generateMatmul() {
+  auto typeA = getTensorType(getShapeA(params.m, params.k));
+  auto typeB = getTensorType(getShapeB(params.k, params.n));
+  auto typeC = getTensorType(getShapeC(params.m, params.n));
+  createKernelFunction({typeA, typeB, typeC});
+
+  auto args = builder.getInsertionBlock()->getArguments();
+  Value result = createMatmul(args[0], args[1], args[2]);
+  builder.create<func::ReturnOp>(unkLoc, result);
+
+  flops = 2 * params.m * params.n * params.k;
+  return success();
+}
+
+LogicalResult MLIRGen::generateBRGEMM() {
+  if (!params.blocking.empty())
+    return emitError("BRGEMM is already blocked, on the batch dimension");
+
+  auto typeA = getTensorType({params.batch, params.m, params.k});
+  auto typeB = getTensorType({params.batch, params.k, params.n});
+  auto typeC = getTensorType({params.m, params.n});
+  createKernelFunction({typeA, typeB, typeC});
+
+  auto args = builder.getInsertionBlock()->getArguments();
+  auto brgemm = builder.create<linalg::BatchReduceMatmulOp>(
+      unkLoc, typeC, ValueRange{args[0], args[1]}, ValueRange{args[2]});
+  builder.create<func::ReturnOp>(unkLoc, brgemm.getResult(0));
+
+  flops = 2 * params.batch * params.m * params.n * params.k;
+  return success();
+}
+
+LogicalResult MLIRGen::generateMLP() {
+  // Input, then weights, bias and output of each layer
+  SmallVector<Type> argTypes;
+  argTypes.push_back(getTensorType(getShapeA(params.m, params.k)));
+  for (int64_t layer = 0; layer < params.layers; layer++) {
+    int64_t inputSize = layer ? params.n : params.k;
+    argTypes.push_back(getTensorType(getShapeB(inputSize, params.n)));
+    if (params.blocking.empty())
+      argTypes.push_back(getTensorType({1, params.n}));
+    else
+      argTypes.push_back(getTensorType(
+          {params.n / params.blocking[1], params.blocking[1]}));
+    argTypes.push_back(getTensorType(getShapeC(params.m, params.n)));
+    flops += 2 * params.m * params.n * inputSize;
+  }
+  createKernelFunction(argTypes);
+
+  auto args = builder.getInsertionBlock()->getArguments();
+  Value input = args[0];
+  for (int64_t layer = 0; layer < params.layers; layer++) {
+    Value weights = args[1 + 3 * layer];
+    Value bias = args[2 + 3 * layer];
+    Value output = args[3 + 3 * layer];
+    Value biased = createBias(bias, output);
+    Value matmul = createMatmul(input, weights, biased);
+    input = createRelu(matmul);
+  }
+  builder.create<func::ReturnOp>(unkLoc, input);
+
+  return success();
+}
+
+LogicalResult MLIRGen::generateConv() {
+  if (!params.blocking.empty())
+    return emitError("Blocking is not supported on convolutions");
+
+  // 3x3 filter, stride 1, no padding
+  const int64_t filterSize = 3;
+  if (params.m < filterSize)
+    return emitError("Image smaller than the filter");
+  int64_t outSize = params.m - filterSize + 1;
+  auto inputType =
+      getTensorType({params.batch, params.m, params.m, params.k});
+  auto filterType =
+      getTensorType({filterSize, filterSize, params.k, params.n});
+  auto outputType = getTensorType({params.batch, outSize, outSize, params.n});
+  createKernelFunction({inputType, filterType, outputType});
+
+  auto args = builder.getInsertionBlock()->getArguments();
+  auto unitStrides = builder.getI64TensorAttr({1, 1});
+  auto conv = builder.create<linalg::Conv2DNhwcHwcfOp>(
+      unkLoc, outputType, ValueRange{args[0], args[1]}, ValueRange{args[2]},
+      /*strides=*/unitStrides, /*dilations=*/unitStrides);
+  builder.create<func::ReturnOp>(unkLoc, conv.getResult(0));
+
+  flops = 2 * params.batch * outSize * outSize * params.n * params.k *
+          filterSize * filterSize;
+  return success();
+}
+
+//----------------------- Helpers & private methods
+
+void MLIRGen::createKernelFunction(llvm::ArrayRef<Type> argTypes) {
+  // Destination passing style, the result is always the last argument
+  auto funcType = builder.getFunctionType(argTypes, argTypes.back());
+  auto func = func::FuncOp::create(unkLoc, "entry", funcType);
+  func.setVisibility(SymbolTable::Visibility::Public);
+  auto *entryBlock = func.addEntryBlock();
+  builder.setInsertionPointToEnd(entryBlock);
+  module->push_back(func);
+}
+
+RankedTensorType MLIRGen::getTensorType(llvm::ArrayRef<int64_t> shape) {
+  return RankedTensorType::get(shape, dataType);
+}
+
+llvm::SmallVector<int64_t> MLIRGen::getShapeA(int64_t m, int64_t k) {
+  // Blocked: [M/bm][K/bk][bm][bk]
+  if (params.blocking.empty())
+    return {m, k};
+  int64_t bm = params.blocking[0], bk = params.blocking[2];
+  return {m / bm, k / bk, bm, bk};
+}
+
+llvm::SmallVector<int64_t> MLIRGen::getShapeB(int64_t k, int64_t n) {
+  // Blocked: [N/bn][K/bk][bk][bn]
+  if (params.blocking.empty())
+    return {k, n};
+  int64_t bn = params.blocking[1], bk = params.blocking[2];
+  return {n / bn, k / bk, bk, bn};
+}
+
+llvm::SmallVector<int64_t> MLIRGen::getShapeC(int64_t m, int64_t n) {
+  // Blocked: [M/bm][N/bn][bm][bn]
+  if (params.blocking.empty())
+    return {m, n};
+  int64_t bm = params.blocking[0], bn = params.blocking[1];
+  return {m / bm, n / bn, bm, bn};
+}
+
+Value MLIRGen::createMatmul(Value a, Value b, Value c) {
+  if (params.blocking.empty()) {
+    auto matmul = builder.create<linalg::MatmulOp>(
+        unkLoc, c.getType(), ValueRange{a, b}, ValueRange{c});
+    return matmul.getResult(0);
+  }
+
+  // Same layout and maps as the packing of linalg.matmul, which
+  // -rewrite-to-brgemm maps to BRGEMM
+  auto *ctx = builder.getContext();
+  AffineExpr p1, p2, r1, p3, p4, r2;
+  bindDims(ctx, p1, p2, r1, p3, p4, r2);
+  AffineMap mapA = AffineMap::get(6, 0, {p1, r1, p3, r2}, ctx);
+  AffineMap mapB = AffineMap::get(6, 0, {p2, r1, r2, p4}, ctx);
+  AffineMap mapC = AffineMap::get(6, 0, {p1, p2, p3, p4}, ctx);
+  auto matmul = builder.create<linalg::GenericOp>(
+      unkLoc, c.getType(), ValueRange{a, b}, ValueRange{c},
+      ArrayRef<AffineMap>{mapA, mapB, mapC},
+      ArrayRef<utils::IteratorType>{
+          utils::IteratorType::parallel, utils::IteratorType::parallel,
+          utils::IteratorType::reduction, utils::IteratorType::parallel,
+          utils::IteratorType::parallel, utils::IteratorType::reduction},
+      [](OpBuilder &nestedBuilder, Location loc, ValueRange args) {
+        Value mul = nestedBuilder.create<arith::MulFOp>(loc, args[0], args[1]);
+        Value add = nestedBuilder.create<arith::AddFOp>(loc, args[2], mul);
+        nestedBuilder.create<linalg::YieldOp>(loc, add);
+      });
+  return matmul.getResult(0);
+}
+
+Value MLIRGen::createBias(Value bias, Value out) {
+  // Plain: bias[0][n] to out[m][n]
+  // Blocked: bias[N/bn][bn] to out[M/bm][N/bn][bm][bn]
+  auto *ctx = builder.getContext();
+  auto outType = out.getType().cast<RankedTensorType>();
+  unsigned rank = outType.getRank();
+  AffineMap biasMap;
+  if (params.blocking.empty())
+    biasMap = AffineMap::get(rank, 0,
+                             {builder.getAffineConstantExpr(0),
+                              builder.getAffineDimExpr(1)},
+                             ctx);
+  else
+    biasMap = AffineMap::get(
+        rank, 0, {builder.getAffineDimExpr(1), builder.getAffineDimExpr(3)},
+        ctx);
+  SmallVector<utils::IteratorType> iterators(rank,
+                                             utils::IteratorType::parallel);
+  auto broadcast = builder.create<linalg::GenericOp>(
+      unkLoc, outType, ValueRange{bias}, ValueRange{out},
+      ArrayRef<AffineMap>{biasMap, builder.getMultiDimIdentityMap(rank)},
+      iterators, [](OpBuilder &nestedBuilder, Location loc, ValueRange args) {
+        nestedBuilder.create<linalg::YieldOp>(loc, args[0]);
+      });
+  return broadcast.getResult(0);
+}
+
+Value MLIRGen::createRelu(Value out) {
+  // The zero is outside of the body, which is what the TPP mapping expects
+  auto outType = out.getType().cast<RankedTensorType>();
+  unsigned rank = outType.getRank();
+  Value zero = builder.create<arith::ConstantOp>(
+      unkLoc, dataType, builder.getFloatAttr(dataType, 0.0));
+  SmallVector<utils::IteratorType> iterators(rank,
+                                             utils::IteratorType::parallel);
+  auto relu = builder.create<linalg::GenericOp>(
+      unkLoc, outType, ValueRange{}, ValueRange{out},
+      ArrayRef<AffineMap>{builder.getMultiDimIdentityMap(rank)}, iterators,
+      [&](OpBuilder &nestedBuilder, Location loc, ValueRange args) {
+        Value max = nestedBuilder.create<arith::MaxFOp>(loc, args[0], zero);
+        nestedBuilder.create<linalg::YieldOp>(loc, max);
+      });
+  return relu.getResult(0);
+}
+
+LogicalResult MLIRGen::emitError(llvm::Twine desc) {
+  return module->emitError(desc);
+}
@@ -0,0 +1,110 @@
+#ifndef TPP_RUN_MLIRGEN_H
+#define TPP_RUN_MLIRGEN_H
+
+//===- MLIRGen.h - MLIR Kernel Generator ----------------------------------===//
+//
+// Generates linalg on tensors kernels (matmul, BRGEMM, MLP and convolution)
+// from a set of parameters, so that shape sweeps don't need hand-written
+// files. The kernels take every buffer as an argument, including the outputs,
+// so that tpp-run can allocate and initialise them all.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace mlir {
+class MLIRContext;
+class RankedTensorType;
+class Value;
+
+/// MLIRGen - Creates a kernel module from its parameters.
+class MLIRGen {
+public:
+  /// Kinds of kernels we can generate
+  enum class KernelType { Matmul, BRGEMM, MLP, Conv };
+
+  /// Kernel parameters. Meaning of the sizes for each kernel:
+  ///  * Matmul: C[M][N] += A[M][K] * B[K][N]
+  ///  * BRGEMM: C[M][N] += sum(A[batch][M][K] * B[batch][K][N])
+  ///  * MLP: 'layers' times out[M][N] = relu(in[M][K] * W[K][N] + bias[N]),
+  ///    with K = N after the first layer
+  ///  * Conv: 'batch' NHWC images of MxM pixels and K channels, 3x3 HWCF
+  ///    filters with N output channels, stride 1 and no padding
+  /// Blocking (bm, bn, bk) packs matmul and MLP to the blocked layout.
+  struct Parameters {
+    KernelType kernel = KernelType::Matmul;
+    int64_t m = 0;
+    int64_t n = 0;
+    int64_t k = 0;
+    int64_t batch = 1;
+    int64_t layers = 1;
+    llvm::SmallVector<int64_t> blocking;
+    bool bf16 = false;
+  };
+
+private:
+  /// MLIR OpBulder
+  OpBuilder builder;
+
+  /// Unknown location, since all this code is auto-generated
+  Location unkLoc;
+
+  /// Module being generated
+  OwningOpRef<ModuleOp> module;
+
+  /// Kernel parameters
+  Parameters params;
+
+  /// Element type of all tensors
+  Type dataType;
+
+  /// Floating point operations of the kernel, counting the contractions only
+  int64_t flops = 0;
+
+  /// Create the kernel function with those argument types, sets the
+  /// insertion point in its body
+  void createKernelFunction(llvm::ArrayRef<Type>);
+
+  /// Get a tensor of the data type
+  RankedTensorType getTensorType(llvm::ArrayRef<int64_t>);
+
+  /// Shapes of the matmul operands, blocked if requested
+  llvm::SmallVector<int64_t> getShapeA(int64_t m, int64_t k);
+  llvm::SmallVector<int64_t> getShapeB(int64_t k, int64_t n);
+  llvm::SmallVector<int64_t> getShapeC(int64_t m, int64_t n);
+
+  /// C += A * B, with a linalg.matmul or a blocked linalg.generic
+  Value createMatmul(Value a, Value b, Value c);
+
+  /// Broadcasts the bias over the output's rows
+  Value createBias(Value bias, Value out);
+
+  /// Max(0, out), in place
+  Value createRelu(Value out);
+
+  /// Kernel generators, one per type
+  LogicalResult generateMatmul();
+  LogicalResult generateBRGEMM();
+  LogicalResult generateMLP();
+  LogicalResult generateConv();
+
+public:
+  /// Creates the builder and an empty module
+  MLIRGen(MLIRContext *, const Parameters &);
+
+  /// Generates the kernel, as the 'entry' function. The module has the
+  /// kernel's FLOP count as the 'tpp.flops' attribute.
+  FailureOr<ModuleOp> generate();
+
+  /// Reports error on the module's location
+  LogicalResult emitError(llvm::Twine);
+};
+
+} // namespace mlir
+
+#endif
@@ -0,0 +1,178 @@
+//===- SpecializedKernelCache.cpp - Shape-specialized JIT cache -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Runs a dynamically shaped kernel with static shape performance. The first
+// time a kernel is called with a given set of shapes, the module is
+// specialized to those shapes, compiled through the TPP pipeline and JIT-ed.
+// The executable is cached by shape, so later calls only pay a lookup.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SpecializedKernelCache.h"
+
+#include "TPP/Passes.h"
+#include "TPP/Transforms.h"
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/ExecutionEngine/CRunnerUtils.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/Pass/PassManager.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+
+static llvm::Error makeError(const llvm::Twine &msg) {
+  return llvm::make_error<llvm::StringError>(msg,
+                                             llvm::inconvertibleErrorCode());
+}
+
+SpecializedKernelCache::SpecializedKernelCache(
+    ModuleOp module, llvm::StringRef kernelName,
+    llvm::ArrayRef<std::string> sharedLibPaths, bool aggressive)
+    : source(module.clone()), kernelName(kernelName.str()),
+      aggressive(aggressive),
+      sharedLibPaths(sharedLibPaths.begin(), sharedLibPaths.end()) {
+  // Compilations run concurrently in the same context, which can't load
+  // dialects while another thread uses it
+  source->getContext()->loadAllAvailableDialects();
+  auto kernel = source->lookupSymbol<func::FuncOp>(kernelName);
+  if (!kernel)
+    return;
+  for (Type type : kernel.getArgumentTypes()) {
+    auto shapedType = type.dyn_cast<ShapedType>();
+    argRanks.push_back(shapedType && shapedType.hasRank()
+                           ? shapedType.getRank()
+                           : -1);
+  }
+}
+
+std::string SpecializedKernelCache::getKey(
+    llvm::ArrayRef<llvm::SmallVector<int64_t>> shapes) {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  llvm::interleave(
+      shapes, os,
+      [&](const llvm::SmallVector<int64_t> &shape) {
+        llvm::interleave(shape, os, "x");
+      },
+      ",");
+  return os.str();
+}
+
+llvm::Expected<std::unique_ptr<ExecutionEngine>>
+SpecializedKernelCache::compile(
+    llvm::ArrayRef<llvm::SmallVector<int64_t>> shapes) {
+  OwningOpRef<ModuleOp> module;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    module = source->clone();
+  }
+  auto kernel = module->lookupSymbol<func::FuncOp>(kernelName);
+  if (!kernel)
+    return makeError("Kernel '" + kernelName + "' not found");
+  if (shapes.size() != kernel.getNumArguments())
+    return makeError("Expected " + llvm::Twine(kernel.getNumArguments()) +
+                     " shapes, got " + llvm::Twine(shapes.size()));
+
+  // Static shapes everywhere, then the same compilation as tpp-run's
+  llvm::DenseMap<unsigned, llvm::SmallVector<int64_t>> bindings;
+  for (auto en : llvm::enumerate(shapes))
+    bindings[en.index()] = en.value();
+  if (failed(tpp::specializeShapes(kernel, bindings)))
+    return makeError("Cannot specialize '" + kernelName + "' to " +
+                     getKey(shapes));
+  kernel->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                  UnitAttr::get(kernel.getContext()));
+
+  PassManager passManager(module->getContext());
+  passManager.addPass(tpp::createDefaultTppPass(aggressive));
+  tpp::addLLVMLoweringPasses(passManager);
+  if (failed(passManager.run(*module)))
+    return makeError("Cannot compile '" + kernelName + "' for " +
+                     getKey(shapes));
+
+  // Results would be returned in new allocations, which we'd leak
+  auto llvmKernel = module->lookupSymbol<LLVM::LLVMFuncOp>(kernelName);
+  if (!llvmKernel || !llvmKernel.getFunctionType()
+                          .getReturnType()
+                          .isa<LLVM::LLVMVoidType>())
+    return makeError("Kernel '" + kernelName +
+                     "' must write its results to its arguments");
+
+  llvm::SmallVector<llvm::StringRef> libs(sharedLibPaths.begin(),
+                                          sharedLibPaths.end());
+  ExecutionEngineOptions options;
+  options.transformer = makeOptimizingTransformer(
+      /*optLevel=*/3, /*sizeLevel=*/0, /*targetMachine=*/nullptr);
+  options.sharedLibPaths = libs;
+  return ExecutionEngine::create(*module, options);
+}
+
+llvm::Expected<ExecutionEngine *> SpecializedKernelCache::lookup(
+    llvm::ArrayRef<llvm::SmallVector<int64_t>> shapes) {
+  std::string key = getKey(shapes);
+  Specialization *specialization;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &entry = specializations[key];
+    if (!entry)
+      entry = std::make_unique<Specialization>();
+    specialization = entry.get();
+  }
+
+  // The first caller with these shapes compiles, the others with the same
+  // shapes wait for it. A failure is kept, the same shapes would fail again
+  std::call_once(specialization->compiled, [&]() {
+    auto engine = compile(shapes);
+    if (!engine) {
+      specialization->error = llvm::toString(engine.takeError());
+      return;
+    }
+    specialization->engine = std::move(*engine);
+    numCompiled++;
+  });
+  if (!specialization->engine)
+    return makeError(specialization->error);
+  return specialization->engine.get();
+}
+
+llvm::Error
+SpecializedKernelCache::invoke(llvm::ArrayRef<void *> descriptors) {
+  if (descriptors.size() != argRanks.size())
+    return makeError("Expected " + llvm::Twine(argRanks.size()) +
+                     " descriptors, got " + llvm::Twine(descriptors.size()));
+
+  // Whatever its element type and rank, a descriptor starts with two
+  // pointers and the offset, followed by the sizes
+  llvm::SmallVector<llvm::SmallVector<int64_t>> shapes;
+  for (auto en : llvm::enumerate(descriptors)) {
+    int64_t rank = argRanks[en.index()];
+    if (rank < 0)
+      return makeError("Argument " + llvm::Twine(en.index()) +
+                       " of '" + kernelName + "' is not a ranked memref");
+    auto *header = static_cast<StridedMemRefType<char, 1> *>(en.value());
+    shapes.emplace_back(header->sizes, header->sizes + rank);
+  }
+
+  auto engine = lookup(shapes);
+  if (!engine)
+    return engine.takeError();
+
+  // The C interface takes pointers to the descriptors, and the packed
+  // interface takes pointers to the arguments
+  llvm::SmallVector<void *> args(descriptors.begin(), descriptors.end());
+  llvm::SmallVector<void *> packedArgs;
+  for (auto &arg : args)
+    packedArgs.push_back(&arg);
+  return (*engine)->invokePacked("_mlir_ciface_" + kernelName, packedArgs);
+}
+
+size_t SpecializedKernelCache::size() { return numCompiled; }
@@ -0,0 +1,101 @@
+//===- SpecializedKernelCache.h - Shape-specialized JIT cache ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Runs a dynamically shaped kernel with static shape performance. The first
+// time a kernel is called with a given set of shapes, the module is
+// specialized to those shapes, compiled through the TPP pipeline and JIT-ed.
+// The executable is cached by shape, so later calls only pay a lookup.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_RUN_SPECIALIZEDKERNELCACHE_H
+#define TPP_RUN_SPECIALIZEDKERNELCACHE_H
+
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace mlir {
+
+/// SpecializedKernelCache - Compiles and caches one executable per shape.
+///
+/// The kernel must write its results into its arguments (no return values
+/// after bufferization), which is what destination-passing style kernels
+/// bufferize to. Each specialization is compiled once, outside of the cache's
+/// lock: a call with new shapes only blocks the callers with the same shapes
+/// until it's compiled, the others keep running or compiling theirs.
+class SpecializedKernelCache {
+  /// One set of shapes, compiled by the first caller with those shapes
+  struct Specialization {
+    std::once_flag compiled;
+    std::unique_ptr<ExecutionEngine> engine;
+    std::string error;
+  };
+
+  /// Dynamically shaped module, cloned for every specialization
+  OwningOpRef<ModuleOp> source;
+
+  /// Name of the kernel to specialize
+  std::string kernelName;
+
+  /// Run the aggressive TPP pipeline (packing, BRGEMM)
+  bool aggressive;
+
+  /// Libraries the kernels call into (tpp-rt, for the XSMM calls)
+  llvm::SmallVector<std::string> sharedLibPaths;
+
+  /// Rank of each of the kernel's arguments, -1 if it isn't shaped
+  llvm::SmallVector<int64_t> argRanks;
+
+  /// Specializations, compiled or being compiled, by shape key
+  llvm::StringMap<std::unique_ptr<Specialization>> specializations;
+
+  /// Guards the map and the source module, not the compilations
+  std::mutex mutex;
+
+  /// Number of specializations compiled successfully
+  std::atomic<size_t> numCompiled{0};
+
+  /// Key for a list of shapes, e.g. "128x512,512x512"
+  static std::string getKey(llvm::ArrayRef<llvm::SmallVector<int64_t>>);
+
+  /// Specializes, compiles and JITs a copy of the source module
+  llvm::Expected<std::unique_ptr<ExecutionEngine>>
+  compile(llvm::ArrayRef<llvm::SmallVector<int64_t>>);
+
+public:
+  /// Clones the module, the original can be discarded
+  SpecializedKernelCache(ModuleOp module, llvm::StringRef kernelName,
+                         llvm::ArrayRef<std::string> sharedLibPaths = {},
+                         bool aggressive = false);
+
+  /// Returns the executable for the shapes of all the kernel's arguments,
+  /// in order, compiling it the first time
+  llvm::Expected<ExecutionEngine *>
+  lookup(llvm::ArrayRef<llvm::SmallVector<int64_t>>);
+
+  /// Calls the kernel with one memref descriptor (StridedMemRefType *) per
+  /// argument, compiling it for the descriptors' shapes the first time
+  llvm::Error invoke(llvm::ArrayRef<void *>);
+
+  /// Number of specializations compiled so far
+  size_t size();
+};
+
+} // namespace mlir
+
+#endif // TPP_RUN_SPECIALIZEDKERNELCACHE_H
@@ -0,0 +1,97 @@
+//===- mlir-gen.cpp - MLIR Kernel Generator -------------------------------===//
+//
+// Command line utility that generates matmul, BRGEMM, MLP and convolution
+// kernels in linalg on tensors, from their sizes, data type and blocking.
+// The output can be piped into tpp-run directly, e.g.:
+//   mlir-gen -kernel=mlp -m=128 -n=512 -k=256 -layers=3 | \
+//     tpp-run -tpp-pipeline=default -e entry -entry-point-result=void ...
+//
+//===----------------------------------------------------------------------===//
+
+#include "MLIRGen.h"
+
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/FileUtilities.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+using namespace mlir;
+
+// Kernel to generate
+llvm::cl::opt<MLIRGen::KernelType> kernelType(
+    "kernel", llvm::cl::desc("Kernel to generate"),
+    llvm::cl::values(
+        clEnumValN(MLIRGen::KernelType::Matmul, "matmul", "C += A * B"),
+        clEnumValN(MLIRGen::KernelType::BRGEMM, "brgemm",
+                   "C += sum(A[i] * B[i]), over 'batch'"),
+        clEnumValN(MLIRGen::KernelType::MLP, "mlp",
+                   "Layers of matmul + bias + relu"),
+        clEnumValN(MLIRGen::KernelType::Conv, "conv",
+                   "NHWC/HWCF 3x3 convolution")),
+    llvm::cl::init(MLIRGen::KernelType::Matmul));
+
+// Sizes
+llvm::cl::opt<unsigned> sizeM("m", llvm::cl::desc("M (rows, image size)"),
+                              llvm::cl::value_desc("int"),
+                              llvm::cl::init(64));
+llvm::cl::opt<unsigned> sizeN("n", llvm::cl::desc("N (columns, filters)"),
+                              llvm::cl::value_desc("int"),
+                              llvm::cl::init(64));
+llvm::cl::opt<unsigned> sizeK("k", llvm::cl::desc("K (reduction, channels)"),
+                              llvm::cl::value_desc("int"),
+                              llvm::cl::init(64));
+llvm::cl::opt<unsigned>
+    batch("batch", llvm::cl::desc("BRGEMM batch, convolution images"),
+          llvm::cl::value_desc("int"), llvm::cl::init(1));
+llvm::cl::opt<unsigned> layers("layers",
+                               llvm::cl::desc("Number of MLP layers"),
+                               llvm::cl::value_desc("int"), llvm::cl::init(1));
+
+// Blocked layout for matmul and MLP
+llvm::cl::list<unsigned>
+    blocking("block", llvm::cl::desc("Blocking factors, as bm,bn,bk"),
+             llvm::cl::value_desc("int,int,int"), llvm::cl::CommaSeparated);
+
+// Data type
+llvm::cl::opt<bool> bf16("bf16", llvm::cl::desc("Use bf16 instead of f32"),
+                         llvm::cl::init(false));
+
+llvm::cl::opt<std::string> outputFilename("o",
+                                          llvm::cl::desc("Output filename"),
+                                          llvm::cl::value_desc("filename"),
+                                          llvm::cl::init("-"));
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv, "MLIR kernel generator\n");
+
+  MLIRGen::Parameters params;
+  params.kernel = kernelType;
+  params.m = sizeM;
+  params.n = sizeN;
+  params.k = sizeK;
+  params.batch = batch;
+  params.layers = layers;
+  params.blocking.assign(blocking.begin(), blocking.end());
+  params.bf16 = bf16;
+
+  MLIRContext context;
+  MLIRGen generator(&context, params);
+  auto module = generator.generate();
+  if (failed(module))
+    return 1;
+
+  std::string errorMessage;
+  auto output = openOutputFile(outputFilename, &errorMessage);
+  if (!output) {
+    llvm::errs() << errorMessage << "\n";
+    return 1;
+  }
+  module->print(output->os());
+  output->os() << "\n";
+  output->keep();
+
+  return 0;
+}
@@ -7,10 +7,22 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "CachedJit.h"
+#include "ExternalInputs.h"
 #include "MLIRBench.h"
 
+#include "TPP/Dialect/Check/BufferizableOpInterfaceImpl.h"
+#include "TPP/Dialect/Check/CheckDialect.h"
+#include "TPP/Dialect/LinalgX/BufferizableOpInterfaceImpl.h"
+#include "TPP/Dialect/LinalgX/LinalgXDialect.h"
+#include "TPP/Dialect/Tpp/TppDialect.h"
+#include "TPP/Dialect/VNNI/VNNIDialect.h"
+#include "TPP/Dialect/Xsmm/XsmmDialect.h"
+#include "TPP/Transforms.h"
+
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
 
 #include "mlir/Dialect/Arith/IR/Arith.h"
@@ -21,14 +33,16 @@
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
-#include "mlir/ExecutionEngine/JitRunner.h"
+#include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Dialect.h"
 #include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/ValueRange.h"
 #include "mlir/InitAllDialects.h"
 #include "mlir/InitAllPasses.h"
+#include "mlir/Parser/Parser.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
@@ -37,30 +51,212 @@
 
 using namespace mlir;
 
+// Input and entry point, as the JitRunner takes them
+llvm::cl::opt<std::string> inputFilename(llvm::cl::Positional,
+                                         llvm::cl::desc("<input file>"),
+                                         llvm::cl::init("-"));
+
+llvm::cl::opt<std::string>
+    mainFuncName("e", llvm::cl::desc("The function to be called"),
+                 llvm::cl::value_desc("<function name>"),
+                 llvm::cl::init("main"));
+
+llvm::cl::opt<std::string> mainFuncType(
+    "entry-point-result",
+    llvm::cl::desc("Textual description of the function type to be called"),
+    llvm::cl::value_desc("void"), llvm::cl::init("void"));
+
+llvm::cl::list<std::string>
+    sharedLibs("shared-libs", llvm::cl::desc("Libraries to link dynamically"),
+               llvm::cl::CommaSeparated);
+
+// LLVM optimization and code generation level
+llvm::cl::opt<bool> optO0("O0",
+                          llvm::cl::desc("Run opt passes and codegen at O0"));
+llvm::cl::opt<bool> optO1("O1",
+                          llvm::cl::desc("Run opt passes and codegen at O1"));
+llvm::cl::opt<bool> optO2("O2",
+                          llvm::cl::desc("Run opt passes and codegen at O2"));
+llvm::cl::opt<bool> optO3("O3",
+                          llvm::cl::desc("Run opt passes and codegen at O3"));
+
 // Number of loops for benchmarks
 llvm::cl::opt<unsigned>
     benchNumLoops("n", llvm::cl::desc("Number of loops for benchmarks"),
                   llvm::cl::value_desc("int"), llvm::cl::init(1));
 
 // Print result
-llvm::cl::opt<bool>
-    printResultMemRef("print", llvm::cl::desc("Print result memref"),
-                  llvm::cl::value_desc("true/false"), llvm::cl::init(true));
+enum class PrintMode { None, MemRef, Checksum };
+llvm::cl::opt<PrintMode> printResult(
+    "print", llvm::cl::desc("Print the result"),
+    llvm::cl::values(
+        clEnumValN(PrintMode::None, "none", "Don't print the result"),
+        clEnumValN(PrintMode::None, "false", "Same as 'none'"),
+        clEnumValN(PrintMode::MemRef, "memref",
+                   "Print the whole result memref (2D only)"),
+        clEnumValN(PrintMode::MemRef, "true", "Same as 'memref'"),
+        clEnumValN(PrintMode::Checksum, "checksum",
+                   "Print a one-line checksum of the result (any rank)")),
+    llvm::cl::init(PrintMode::MemRef));
+
+// TPP compilation pipeline to run before lowering to LLVM
+enum class TppPipeline { None, Default, Aggressive };
+llvm::cl::opt<TppPipeline> tppPipeline(
+    "tpp-pipeline", llvm::cl::desc("TPP pipeline to run on the input"),
+    llvm::cl::values(
+        clEnumValN(TppPipeline::None, "none",
+                   "Input is already lowered, only lower to LLVM"),
+        clEnumValN(TppPipeline::Default, "default",
+                   "Map linalg to TPP/XSMM and vectorize the rest"),
+        clEnumValN(TppPipeline::Aggressive, "aggressive",
+                   "Default, plus packing and BRGEMM mapping")),
+    llvm::cl::init(TppPipeline::None));
+
+// Cache of the TPP pipeline's outputs and of the object files
+llvm::cl::opt<std::string>
+    cacheDir("cache-dir",
+             llvm::cl::desc("Reuse the TPP pipeline's output and the object "
+                            "file of an unchanged kernel, cached in this "
+                            "directory"),
+             llvm::cl::value_desc("dir"), llvm::cl::init(""));
+
+// Reference implementation to verify the kernel against
+enum class VerifyAgainst { None, Loops };
+llvm::cl::opt<VerifyAgainst> verifyAgainst(
+    "verify-against",
+    llvm::cl::desc("Compare the kernel's result against a reference"),
+    llvm::cl::values(clEnumValN(VerifyAgainst::None, "none", "No verification"),
+                     clEnumValN(VerifyAgainst::Loops, "loops",
+                                "Kernel lowered to plain loops")),
+    llvm::cl::init(VerifyAgainst::None));
+
+// Maximum absolute error allowed by the verification
+llvm::cl::opt<float>
+    verifyThreshold("verify-threshold",
+                    llvm::cl::desc("Maximum absolute error when verifying"),
+                    llvm::cl::value_desc("float"), llvm::cl::init(1e-3));
 
-// This function will be called by the pass manager after parsing,
-// so we can modify the IR with the needed wrappers
-static LogicalResult prepareMLIRKernel(Operation *op,
-                                       JitRunnerOptions &options) {
-  MLIRBench bench(op);
+// Error allowed on top of the absolute one, relative to the reference value
+llvm::cl::opt<float> verifyRelThreshold(
+    "verify-rel-threshold",
+    llvm::cl::desc("Maximum relative error when verifying, added to the "
+                   "absolute one"),
+    llvm::cl::value_desc("float"), llvm::cl::init(0));
+
+// Random initialisation of the inputs
+llvm::cl::opt<unsigned> initSeed(
+    "seed",
+    llvm::cl::desc("Seed for random inputs (0 means all ones, which "
+                   "-verify-against rejects; it defaults to 123 instead)"),
+    llvm::cl::value_desc("int"), llvm::cl::init(0));
+
+// All-ones inputs hide most indexing and layout bugs: a transposed or
+// misblocked operand gives the same result. Verification runs on random ones.
+constexpr unsigned kVerifySeed = 123;
+
+// Bind kernel arguments to files, instead of initialising them in the IR
+llvm::cl::list<std::string>
+    inputFiles("input",
+               llvm::cl::desc("Load a kernel argument from a .npy or raw "
+                              "file, memory-mapped at runtime"),
+               llvm::cl::value_desc("argN:file"), llvm::cl::ZeroOrMore);
+
+// Static shapes for dynamically shaped kernel arguments
+llvm::cl::list<std::string>
+    argShapes("shape",
+              llvm::cl::desc("Specialize a dynamically shaped kernel "
+                             "argument to a static shape"),
+              llvm::cl::value_desc("argN:DxD.."), llvm::cl::ZeroOrMore);
+
+// Large inputs and weights in huge pages, as -huge-page-allocation does for
+// the buffers the kernel allocates
+llvm::cl::opt<bool> hugePageGlobals(
+    "huge-page-globals",
+    llvm::cl::desc("Copy the kernel arguments to huge page buffers"),
+    llvm::cl::init(false));
+
+// Threads, for the loops -partition-block-loops makes parallel
+llvm::cl::opt<bool> parallel(
+    "parallel",
+    llvm::cl::desc("Run the parallel loops on OpenMP threads (add the OpenMP "
+                   "runtime to -shared-libs)"),
+    llvm::cl::init(false));
+
+llvm::cl::opt<int> numaNode(
+    "numa-node",
+    llvm::cl::desc("Bind the threads to a NUMA node (-1 means no binding)"),
+    llvm::cl::value_desc("int"), llvm::cl::init(-1));
+
+// Mappings of the files bound to globals, which the JIT resolves the globals'
+// symbols to. Lives as long as the process, so longer than the JIT
+static ExternalInputs externalInputs;
+
+static llvm::orc::SymbolMap
+getExternalInputSymbols(llvm::orc::MangleAndInterner interner) {
+  return externalInputs.getSymbols(interner);
+}
+
+/// Highest of the -On flags, none if not given
+static llvm::Optional<unsigned> getOptLevel() {
+  if (optO3)
+    return 3;
+  if (optO2)
+    return 2;
+  if (optO1)
+    return 1;
+  if (optO0)
+    return 0;
+  return llvm::None;
+}
+
+// This function is called after parsing, so we can modify the IR with the
+// needed wrappers before lowering it to LLVM
+static LogicalResult prepareMLIRKernel(Operation *op) {
+  bool verify = verifyAgainst != VerifyAgainst::None;
+  unsigned seed = initSeed;
+  if (verify && !seed) {
+    if (initSeed.getNumOccurrences())
+      return op->emitError("-verify-against needs random inputs, -seed=0 "
+                           "makes them all ones");
+    seed = kVerifySeed;
+  }
+
+  MLIRBench bench(op, seed);
+  bench.setHugePageGlobals(hugePageGlobals);
+  bench.setParallel(parallel);
 
   // Basic checks
-  if (options.mainFuncType != "void")
+  if (mainFuncType != "void")
     return bench.emitError(
         "Main function has to be 'void', even if the kernel return's a value, "
         "because that's the type of the wrapper we create here");
 
-  if (failed(bench.findKernel(options.mainFuncName)))
-    return bench.emitError("Cannot find kernel '" + options.mainFuncName + "'");
+  if (failed(bench.findKernel(mainFuncName)))
+    return bench.emitError("Cannot find kernel '" + mainFuncName + "'");
+
+  // Specialize dynamic shapes before anything else, the TPP pipeline and the
+  // globals need static shapes
+  for (auto &binding : argShapes) {
+    unsigned argNum;
+    SmallVector<int64_t> shape;
+    if (failed(tpp::parseShapeBinding(binding, argNum, shape)))
+      return bench.emitError("Invalid shape binding '" + binding +
+                             "', expected argN:DxD..");
+    if (failed(bench.bindShape(argNum, shape)))
+      return failure();
+  }
+  if (failed(bench.specializeKernel()))
+    return bench.emitError("Cannot specialize the kernel's shapes");
+
+  // Keep an unoptimized copy of the kernel to verify against
+  if (verify && failed(bench.createReferenceKernel()))
+    return bench.emitError("Cannot create the reference kernel");
+
+  // Compile linalg on tensors down to XSMM calls, if requested
+  if (tppPipeline != TppPipeline::None &&
+      failed(bench.runTppPipeline(tppPipeline == TppPipeline::Aggressive,
+                                  cacheDir)))
+    return bench.emitError("Cannot run the TPP pipeline");
 
   if (failed(bench.checkKernelSignature()))
     return bench.finalize();
@@ -70,6 +266,19 @@ static LogicalResult prepareMLIRKernel(Operation *op,
   if (failed(bench.renameKernel()))
     return bench.emitError("Cannot rename kernel function");
 
+  // Arguments bound to files, as argN:file
+  for (auto &input : inputFiles) {
+    StringRef arg, file;
+    std::tie(arg, file) = StringRef(input).split(':');
+    unsigned argNum;
+    if (!arg.consume_front("arg") || arg.getAsInteger(10, argNum) ||
+        file.empty())
+      return bench.emitError("Invalid input binding '" + input +
+                             "', expected argN:file");
+    if (failed(bench.bindInput(argNum, file)))
+      return failure();
+  }
+
   // Creates the inputs for the kernel as dense globals
   SmallVector<llvm::StringRef> globalList;
   if (failed(bench.createGlobals(globalList)))
@@ -79,14 +288,37 @@ static LogicalResult prepareMLIRKernel(Operation *op,
   if (failed(bench.createMainWrapper()))
     return bench.emitError("Cannot create main wrapper");
 
+  // Before the kernel touches its buffers
+  if (numaNode >= 0 && failed(bench.bindNumaNode(numaNode)))
+    return bench.emitError("Cannot bind to NUMA node " + Twine(numaNode));
+
+  // Back the globals that come from files with the files' mappings
+  if (failed(bench.loadExternalInputs(externalInputs)))
+    return bench.emitError("Cannot load external inputs");
+
+  // Call the reference before the kernel, on a copy of the output
+  Value refRet;
+  if (verify) {
+    refRet = bench.callReference(globalList);
+    if (!refRet)
+      return bench.emitError("Cannot generate a call to the reference");
+  }
+
   // Call kernel once, to bootstrap (JIT compile, warm up caches)
   auto ret = bench.callKernel(globalList);
   if (!ret)
     return bench.emitError("Cannot generate a call to the kernel");
 
+  // Compare before the timer loop accumulates more on the output
+  if (verify && failed(bench.verifyResult(ret, refRet, verifyThreshold,
+                                            verifyRelThreshold)))
+    return bench.emitError("Cannot verify the result");
+
   // Print the result of the warming up, should be the same as any other
-  if (printResultMemRef && failed(bench.printMemRef(ret)))
+  if (printResult == PrintMode::MemRef && failed(bench.printMemRef(ret)))
     return bench.emitError("Cannot print result memref");
+  if (printResult == PrintMode::Checksum && failed(bench.printChecksum(ret)))
+    return bench.emitError("Cannot print result checksum");
 
   // This is the main loop, if N > 1
   if (benchNumLoops > 1) {
@@ -109,18 +341,54 @@ int main(int argc, char **argv) {
   llvm::InitializeNativeTarget();
   llvm::InitializeNativeTargetAsmPrinter();
   llvm::InitializeNativeTargetAsmParser();
+  registerAsmPrinterCLOptions();
+  registerMLIRContextCLOptions();
+  registerPassManagerCLOptions();
+  llvm::cl::ParseCommandLineOptions(argc, argv, "TPP CPU execution driver\n");
 
   // Add the following to include *all* MLIR Core dialects, or selectively
   // include what you need like above. You only need to register dialects that
   // will be *parsed* by the tool, not the one generated
   DialectRegistry registry;
+  registry.insert<mlir::tpp::TppDialect>();
+  registry.insert<mlir::xsmm::XsmmDialect>();
+  registry.insert<mlir::linalgx::LinalgXDialect>();
+  registry.insert<mlir::check::CheckDialect>();
+  registry.insert<mlir::vnni::VNNIDialect>();
+  mlir::linalgx::registerBufferizableOpInterfaceExternalModels(registry);
+  mlir::check::registerBufferizableOpInterfaceExternalModels(registry);
   registerAllDialects(registry);
   registerAllToLLVMIRTranslations(registry);
 
-  // This is how we integrate with the pipeline
-  JitRunnerConfig config;
-  config.mlirTransformer = prepareMLIRKernel;
+  MLIRContext context(registry);
+  llvm::SourceMgr sourceMgr;
+  SourceMgrDiagnosticHandler diagHandler(sourceMgr, &context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceFile<ModuleOp>(inputFilename, sourceMgr, &context);
+  if (!module)
+    return 1;
+  if (failed(prepareMLIRKernel(*module)))
+    return 1;
+
+  // Instead of the JitRunner's execution engine, which recompiles the module
+  // on every run, reuse the object file of an unchanged module
+  llvm::SmallVector<std::string> libs(sharedLibs.begin(), sharedLibs.end());
+  CachedJitOptions jitOptions;
+  jitOptions.optLevel = getOptLevel();
+  jitOptions.sharedLibs = libs;
+  jitOptions.cacheDir = cacheDir;
+  jitOptions.symbolMap = getExternalInputSymbols;
+  auto jit = createCachedJit(*module, jitOptions);
+  if (!jit) {
+    llvm::errs() << "ERROR: " << llvm::toString(jit.takeError()) << "\n";
+    return 1;
+  }
 
-  // Call the main JIT function
-  return JitRunnerMain(argc, argv, registry, config);
+  auto entry = (*jit)->lookup(mainFuncName);
+  if (!entry) {
+    llvm::errs() << "ERROR: " << llvm::toString(entry.takeError()) << "\n";
+    return 1;
+  }
+  entry->toPtr<void (*)()>()();
+  return 0;
 }
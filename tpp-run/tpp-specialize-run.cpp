@@ -0,0 +1,192 @@
+//===- tpp-specialize-run.cpp - Run with SpecializedKernelCache -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Calls a dynamically shaped kernel once per -call option, with f32 buffers
+// of the given shapes, through a single SpecializedKernelCache. After each
+// call, the checksum of the last argument and the number of specializations
+// compiled so far are printed. Used by the tests, to check that calls with
+// shapes already seen reuse their executable.
+//
+// Usage: tpp-specialize-run kernel.mlir -entry=name
+//                           -call=4x16,16x8,4x8 -call=2x16,16x8,2x8
+//                           -shared-libs=libtpp_c_runner_utils.so
+//
+//===----------------------------------------------------------------------===//
+
+#include "SpecializedKernelCache.h"
+
+#include "TPP/Dialect/Check/BufferizableOpInterfaceImpl.h"
+#include "TPP/Dialect/Check/CheckDialect.h"
+#include "TPP/Dialect/LinalgX/BufferizableOpInterfaceImpl.h"
+#include "TPP/Dialect/LinalgX/LinalgXDialect.h"
+#include "TPP/Dialect/Tpp/TppDialect.h"
+#include "TPP/Dialect/VNNI/VNNIDialect.h"
+#include "TPP/Dialect/Xsmm/XsmmDialect.h"
+
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/InitAllDialects.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Target/LLVMIR/Dialect/All.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemAlloc.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace mlir;
+
+static llvm::cl::opt<std::string> inputFile(llvm::cl::Positional,
+                                            llvm::cl::desc("<input file>"),
+                                            llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    entryName("entry", llvm::cl::desc("The kernel to run"),
+              llvm::cl::init("entry"));
+
+static llvm::cl::list<std::string>
+    calls("call",
+          llvm::cl::desc("Shapes of the arguments of one call, e.g. "
+                         "4x16,16x8,4x8"));
+
+static llvm::cl::opt<bool>
+    aggressive("aggressive", llvm::cl::desc("Pack matmuls to BRGEMM"),
+               llvm::cl::init(false));
+
+static llvm::cl::list<std::string>
+    sharedLibs("shared-libs",
+               llvm::cl::desc("Libraries to link the kernel against"),
+               llvm::cl::CommaSeparated);
+
+/// Alignment of the buffers, in bytes
+static constexpr size_t kAlignment = 64;
+
+/// Deterministic inputs, small multiples of 1/8 that are exact in f32
+static void fill(float *buffer, int64_t elements, unsigned arg) {
+  for (int64_t i = 0; i < elements; i++)
+    buffer[i] = static_cast<float>((i + arg) % 8) / 8.0f;
+}
+
+/// Parses "4x16,16x8" into {{4, 16}, {16, 8}}
+static bool
+parseShapes(llvm::StringRef call,
+            llvm::SmallVectorImpl<llvm::SmallVector<int64_t>> &shapes) {
+  llvm::SmallVector<llvm::StringRef> args;
+  call.split(args, ',');
+  for (llvm::StringRef arg : args) {
+    llvm::SmallVector<llvm::StringRef> dims;
+    arg.split(dims, 'x');
+    llvm::SmallVector<int64_t> shape;
+    for (llvm::StringRef dim : dims) {
+      int64_t size;
+      if (dim.getAsInteger(10, size) || size <= 0)
+        return false;
+      shape.push_back(size);
+    }
+    shapes.push_back(std::move(shape));
+  }
+  return true;
+}
+
+/// A buffer and its memref descriptor: allocated and aligned pointers, the
+/// offset, then the sizes and strides, all 64 bits wide
+struct Argument {
+  float *data;
+  int64_t elements;
+  std::vector<int64_t> descriptor;
+
+  explicit Argument(llvm::ArrayRef<int64_t> shape) {
+    elements = 1;
+    for (int64_t size : shape)
+      elements *= size;
+    data = static_cast<float *>(
+        llvm::allocate_buffer(elements * sizeof(float), kAlignment));
+    descriptor.push_back(reinterpret_cast<intptr_t>(data));
+    descriptor.push_back(reinterpret_cast<intptr_t>(data));
+    descriptor.push_back(0);
+    descriptor.insert(descriptor.end(), shape.begin(), shape.end());
+    std::vector<int64_t> strides(shape.size());
+    int64_t stride = 1;
+    for (int64_t i = shape.size() - 1; i >= 0; i--) {
+      strides[i] = stride;
+      stride *= shape[i];
+    }
+    descriptor.insert(descriptor.end(), strides.begin(), strides.end());
+  }
+
+  ~Argument() {
+    llvm::deallocate_buffer(data, elements * sizeof(float), kAlignment);
+  }
+};
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  llvm::InitializeNativeTargetAsmParser();
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "TPP shape-specialized kernel runner\n");
+
+  DialectRegistry registry;
+  registry.insert<mlir::tpp::TppDialect>();
+  registry.insert<mlir::xsmm::XsmmDialect>();
+  registry.insert<mlir::linalgx::LinalgXDialect>();
+  registry.insert<mlir::check::CheckDialect>();
+  registry.insert<mlir::vnni::VNNIDialect>();
+  mlir::linalgx::registerBufferizableOpInterfaceExternalModels(registry);
+  mlir::check::registerBufferizableOpInterfaceExternalModels(registry);
+  registerAllDialects(registry);
+  registerAllToLLVMIRTranslations(registry);
+
+  MLIRContext context(registry);
+  context.loadAllAvailableDialects();
+  llvm::SourceMgr sourceMgr;
+  OwningOpRef<ModuleOp> module =
+      parseSourceFile<ModuleOp>(inputFile, sourceMgr, &context);
+  if (!module) {
+    llvm::errs() << "ERROR: Cannot parse '" << inputFile << "'\n";
+    return 1;
+  }
+
+  llvm::SmallVector<std::string> libs(sharedLibs.begin(), sharedLibs.end());
+  SpecializedKernelCache cache(*module, entryName, libs, aggressive);
+
+  for (auto en : llvm::enumerate(calls)) {
+    llvm::SmallVector<llvm::SmallVector<int64_t>> shapes;
+    if (!parseShapes(en.value(), shapes)) {
+      llvm::errs() << "ERROR: Invalid shapes '" << en.value() << "'\n";
+      return 1;
+    }
+
+    std::vector<std::unique_ptr<Argument>> arguments;
+    llvm::SmallVector<void *> descriptors;
+    for (auto shape : llvm::enumerate(shapes)) {
+      arguments.push_back(std::make_unique<Argument>(shape.value()));
+      fill(arguments.back()->data, arguments.back()->elements, shape.index());
+      descriptors.push_back(arguments.back()->descriptor.data());
+    }
+
+    if (auto error = cache.invoke(descriptors)) {
+      llvm::errs() << "ERROR: " << llvm::toString(std::move(error)) << "\n";
+      return 1;
+    }
+    const Argument &result = *arguments.back();
+    double sum = 0;
+    for (int64_t i = 0; i < result.elements; i++)
+      sum += result.data[i];
+    llvm::outs() << llvm::format("call %zu: sum %e, %zu specializations\n",
+                                 en.index(), sum, cache.size());
+  }
+  return 0;
+}